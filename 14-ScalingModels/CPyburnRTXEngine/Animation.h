@@ -30,6 +30,13 @@ namespace CPyburnRTXEngine
 			sword_withdraw = 18,
 		};
 
+		// a named frame gameplay wants to hear about, footsteps, the sword hit, the bow release
+		struct Event
+		{
+			float time = 0; // seconds, the same timeline as startTime and endTime
+			std::string name;
+		};
+
 		UINT id = 0;
 		UINT modelId = 0;
 		std::string animationName = "";
@@ -41,5 +48,32 @@ namespace CPyburnRTXEngine
 		UINT animationTypeId = 0;
 		Animation::AnimationType animationType = Animation::AnimationType::none;
 		std::string animationTypeName = "";
+		std::vector<Event> events; // sorted by time
+		std::vector<XMFLOAT3> rootMotion; // model space root position at every frame from startFrame to endFrame, relative to the first one
+
+		// where the root is at time, between frames it is interpolated and outside the clip it holds the end
+		XMVECTOR GetRootPosition(const float& time) const
+		{
+			if (rootMotion.empty())
+			{
+				return XMVectorZero();
+			}
+
+			const UINT lastFrame = static_cast<UINT>(rootMotion.size()) - 1;
+			float frame = std::clamp((time - startTime) * static_cast<float>(fps), 0.0f, static_cast<float>(lastFrame));
+			UINT index = static_cast<UINT>(frame);
+			UINT nextIndex = std::min(index + 1, lastFrame);
+			return XMVectorLerp(XMLoadFloat3(&rootMotion[index]), XMLoadFloat3(&rootMotion[nextIndex]), frame - static_cast<float>(index));
+		}
+
+		// appends every event in [from, to), one binary search and then only the events that fire
+		void CollectEvents(const float& from, const float& to, std::vector<const Event*>& fired) const
+		{
+			auto it = std::lower_bound(events.begin(), events.end(), from, [](const Event& event, const float& time) { return event.time < time; });
+			for (; it != events.end() && it->time < to; ++it)
+			{
+				fired.push_back(&*it);
+			}
+		}
 	};
 }
\ No newline at end of file
@@ -5,6 +5,12 @@
 
 namespace CPyburnRTXEngine
 {
+    namespace
+    {
+        // one per job system thread, a dual quaternion pose is sampled as matrices and converted on its way into the ring
+        thread_local std::vector<XMMATRIX> t_poseScratch;
+    }
+
     AnimationCompute::AnimationCompute()
     {
     }
@@ -13,11 +19,14 @@ namespace CPyburnRTXEngine
     {
     }
 
-    void AnimationCompute::CreateDeviceDependentResources(DX::DeviceResources* deviceResources)
+    void AnimationCompute::CreateDeviceDependentResources(DX::DeviceResources* deviceResources, const bool& dualQuaternion)
     {
         m_deviceResources = deviceResources;
+        m_dualQuaternion = dualQuaternion;
 
-        Microsoft::WRL::ComPtr<IDxcBlob> shaderBlob = GraphicsContexts::CompileHlslLibrary(m_deviceResources->GetD3DDevice(), L"skinnedCompute.hlsl", L"CS", L"cs_6_0");
+        // both kernels bind the same way, only the palette's element type differs
+        const WCHAR* shaderFile = m_dualQuaternion ? L"skinnedComputeDualQuaternion.hlsl" : L"skinnedCompute.hlsl";
+        Microsoft::WRL::ComPtr<IDxcBlob> shaderBlob = GraphicsContexts::CompileHlslLibrary(m_deviceResources->GetD3DDevice(), shaderFile, L"CS", L"cs_6_0");
 
         //CD3DX12_DESCRIPTOR_RANGE ranges[2];
         //ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 3, 0); // t0t2
@@ -30,15 +39,14 @@ namespace CPyburnRTXEngine
         //CD3DX12_ROOT_SIGNATURE_DESC desc;
         //desc.Init(2, params);
 
-        CD3DX12_DESCRIPTOR_RANGE ranges[3];
+        CD3DX12_DESCRIPTOR_RANGE ranges[2];
         ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 2, 0); // t0-t1
-        ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 2); // t2 because we have to buffer 
-        ranges[2].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0); // u0
+        ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0); // u0
 
         CD3DX12_ROOT_PARAMETER params[3];
         params[0].InitAsDescriptorTable(1, &ranges[0]);
-        params[1].InitAsDescriptorTable(1, &ranges[1]);
-        params[2].InitAsDescriptorTable(1, &ranges[2]);
+        params[1].InitAsShaderResourceView(2); // t2 the palette, a different spot on the upload ring every frame
+        params[2].InitAsDescriptorTable(1, &ranges[1]);
 
         CD3DX12_ROOT_SIGNATURE_DESC desc;
         desc.Init(3, params);
@@ -54,14 +62,10 @@ namespace CPyburnRTXEngine
 
         m_deviceResources->GetD3DDevice()->CreateComputePipelineState(&pso, IID_PPV_ARGS(&m_pso));
 
-        for (UINT i = 0; i < DX::DeviceResources::c_backBufferCount; i++)
-        {
-            m_boneMatricesBuffer[i].CreateDeviceDependentResources(m_deviceResources->GetD3DDevice());
-        }
 		m_outVertexBuffer.CreateDeviceDependentResources(m_deviceResources->GetD3DDevice());
     }
 
-    void AnimationCompute::CreateBuffers(ID3D12GraphicsCommandList4* commandList, BufferHeap<AssimpFactory::VSVertices>* baseVertices, BufferHeap<AssimpFactory::VertexBoneData>* boneData, const std::vector<XMMATRIX>& bones)
+    void AnimationCompute::CreateBuffers(ID3D12GraphicsCommandList4* commandList, BufferHeap<AssimpFactory::VSVertices>* baseVertices, const BufferSpan<const AssimpFactory::VSVertices>& baseVertexData, BufferHeap<AssimpFactory::VertexBoneData>* boneData)
     {
         //Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList4> commandList;
         //Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandAllocator;
@@ -72,15 +76,8 @@ namespace CPyburnRTXEngine
 
 		m_boneBufferPtr = boneData;
 
-        for (UINT i = 0; i < DX::DeviceResources::c_backBufferCount; i++)
-        {
-            m_boneMatricesBuffer[i].CpuData = bones;
-            m_boneMatricesBuffer[i].CreateOnUploadHeap(L"Bone Matrices Buffer");
-        }
-
-        // Output buffer
-        m_outVertexBuffer.CpuData = m_baseVertexBufferPtr->CpuData;
-        m_outVertexBuffer.CreateOnDefaultHeap(commandList, L"Out Vertices Buffer", D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+        // Output buffer, uploaded from the mesh's own vertices instead of a copy held per entity
+        m_outVertexBuffer.CreateOnDefaultHeap(commandList, baseVertexData, L"Out Vertices Buffer", D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
 
         //DX::ThrowIfFailed(commandList->Close());
         //ID3D12CommandList* ppCommandLists[] = { commandList.Get() };
@@ -94,23 +91,58 @@ namespace CPyburnRTXEngine
     void AnimationCompute::CreateShaderResources()
     {
         //m_boneBuffer.CreateShaderResourceView(); // t1
-        // since bones are small, going to use SRV upload heap like a constant buffer
-        for (UINT i = 0; i < DX::DeviceResources::c_backBufferCount; i++)
+        // t2 is bound straight from the upload ring in Dispatch, it has no view of its own
+        m_outVertexBuffer.CreateUnorderedAccessView(L"Output Vertices Buffer"); // U0
+    }
+
+    bool AnimationCompute::HasPalette() const
+    {
+        return m_paletteAllocation.IsValid() && m_paletteFrame == GraphicsContexts::GetUploadRing().GetFrameCount();
+    }
+
+    XMMATRIX* AnimationCompute::BeginPose()
+    {
+        UploadRing& uploadRing = GraphicsContexts::GetUploadRing();
+        const UINT stride = GetPaletteStride();
+        m_pendingAllocation = uploadRing.Allocate(static_cast<UINT64>(stride) * m_boneCount, stride);
+        if (!m_pendingAllocation.IsValid() || !m_pendingAllocation.cpu)
         {
-            m_boneMatricesBuffer[i].CreateShaderResourceView(true); // t2
+            // the clip still has to advance, the pose lands in the scratch and FinishPose reports it never reached the gpu
+            m_pendingAllocation = UploadRing::Allocation{};
         }
-        m_outVertexBuffer.CreateUnorderedAccessView(L"Output Vertices Buffer"); // U0
+        else if (!m_dualQuaternion)
+        {
+            return reinterpret_cast<XMMATRIX*>(m_pendingAllocation.cpu);
+        }
+
+        if (t_poseScratch.size() < m_boneCount)
+        {
+            t_poseScratch.resize(m_boneCount);
+        }
+        return t_poseScratch.data();
     }
 
-    void AnimationCompute::Update(const std::vector<XMMATRIX>& bones)
+    bool AnimationCompute::FinishPose()
     {
-        if (m_boneMatricesBuffer[m_deviceResources->GetCurrentFrameIndex()].CpuData.size() == 0 || bones.size() == 0)
+        m_paletteAllocation = m_pendingAllocation;
+        m_paletteFrame = GraphicsContexts::GetUploadRing().GetFrameCount();
+        m_pendingAllocation = UploadRing::Allocation{};
+        if (!m_paletteAllocation.IsValid())
         {
-            return;
+            return false;
         }
 
-        m_boneMatricesBuffer[m_deviceResources->GetCurrentFrameIndex()].CpuData = bones;
-        m_boneMatricesBuffer[m_deviceResources->GetCurrentFrameIndex()].CopyCpuDataToUploadHeap();
+        if (m_dualQuaternion)
+        {
+            // 32 bytes per bone go over the bus instead of 64
+            DualQuaternion* mapped = reinterpret_cast<DualQuaternion*>(m_paletteAllocation.cpu);
+            for (UINT b = 0; b < m_boneCount; b++)
+            {
+                // AssimpFactory turned dualQuaternionSkinning off at load for a model with scaled bones, so nothing is dropped here
+                mapped[b] = DualQuaternion::FromMatrix(t_poseScratch[b]);
+            }
+        }
+        return true;
     }
 
     void AnimationCompute::Dispatch(ID3D12GraphicsCommandList4* commandList)
@@ -125,12 +157,12 @@ namespace CPyburnRTXEngine
 
         // Root parameter 0: SRVs t0-t1
         commandList->SetComputeRootDescriptorTable(0, m_baseVertexBufferPtr->GpuHandle);
-        // Root parameter 1: SRVs t2 because we have to buffer
-        commandList->SetComputeRootDescriptorTable(1, m_boneMatricesBuffer[m_deviceResources->GetCurrentFrameIndex()].GpuHandle);
+        // Root parameter 1: SRV t2, this frame's palette on the upload ring
+        commandList->SetComputeRootShaderResourceView(1, m_paletteAllocation.gpu);
         // Root parameter 2: UAV u0
         commandList->SetComputeRootDescriptorTable(2, m_outVertexBuffer.GpuHandle);
 
-        const UINT groups = (static_cast<UINT>(m_baseVertexBufferPtr->CpuData.size()) + 255u) / 256u;
+        const UINT groups = (m_baseVertexBufferPtr->ElementCount + 255u) / 256u;
         commandList->Dispatch(groups, 1, 1);
 
         auto barrier = CD3DX12_RESOURCE_BARRIER::UAV(m_outVertexBuffer.DefaultHeapResource.Get());
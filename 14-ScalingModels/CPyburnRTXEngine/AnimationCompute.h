@@ -1,6 +1,8 @@
 #pragma once
 #include "AssimpFactory.h"
 #include "BufferHeap.h"
+#include "DualQuaternion.h"
+#include "UploadRing.h"
 
 namespace CPyburnRTXEngine
 {
@@ -9,7 +11,13 @@ namespace CPyburnRTXEngine
 	private:
 		BufferHeap<AssimpFactory::VSVertices>* m_baseVertexBufferPtr = nullptr;
 		BufferHeap<AssimpFactory::VertexBoneData>* m_boneBufferPtr = nullptr;
-		BufferHeap<XMMATRIX> m_boneMatricesBuffer[DX::DeviceResources::c_backBufferCount];
+		// the pose is written straight into the upload ring, a dualQuaternionSkinning pose goes through a per thread scratch first
+		// an unchanged pose isn't written at all, so there is no palette buffer per back buffer and no copy per entity
+		UINT m_boneCount = 0;
+		bool m_dualQuaternion = false;
+		UploadRing::Allocation m_pendingAllocation; // from BeginPose, only becomes the palette once FinishPose sees it written
+		UploadRing::Allocation m_paletteAllocation;
+		UINT64 m_paletteFrame = MAXUINT64; // the ring's frame count when m_paletteAllocation was made
 		BufferHeap<AssimpFactory::VSVertices> m_outVertexBuffer;
 
 		Microsoft::WRL::ComPtr<ID3D12RootSignature> m_rootSig;
@@ -19,15 +27,36 @@ namespace CPyburnRTXEngine
 
 	public:
 		const BufferHeap<AssimpFactory::VSVertices>& GetVertexOutputBuffer() const { return m_outVertexBuffer; }
+		// SkinningBatch reads these by heap index instead of binding them
+		const BufferHeap<AssimpFactory::VSVertices>* GetBaseVertexBuffer() const { return m_baseVertexBufferPtr; }
+		const BufferHeap<AssimpFactory::VertexBoneData>* GetBoneDataBuffer() const { return m_boneBufferPtr; }
+		bool IsDualQuaternion() const { return m_dualQuaternion; }
+		// bytes per bone on the ring, the palette is aligned to it so its offset is a whole number of elements
+		UINT GetPaletteStride() const { return m_dualQuaternion ? static_cast<UINT>(sizeof(DualQuaternion)) : static_cast<UINT>(sizeof(XMMATRIX)); }
+		// false when the pose didn't change this frame or the ring had no room for it
+		bool HasPalette() const;
+		// where this frame's palette starts in a structured view over the whole ring with GetPaletteStride sized elements
+		UINT GetPaletteFirstElement() const { return static_cast<UINT>(m_paletteAllocation.offset / GetPaletteStride()); }
 
 		AnimationCompute();
 		~AnimationCompute();
 
-		void CreateDeviceDependentResources(DX::DeviceResources* deviceResources);
-		void CreateBuffers(ID3D12GraphicsCommandList4* commandList, BufferHeap<AssimpFactory::VSVertices>* baseVertices, BufferHeap<AssimpFactory::VertexBoneData>* boneData, const std::vector<XMMATRIX>& bones);
+		// dualQuaternion comes from the model's dualQuaternionSkinning in Models.json, already off for a model whose bones AssimpFactory found scaled
+		void CreateDeviceDependentResources(DX::DeviceResources* deviceResources, const bool& dualQuaternion = false);
+		// baseVertexData is what baseVertices was created from, the output buffer starts as a copy of it
+		void CreateBuffers(ID3D12GraphicsCommandList4* commandList, BufferHeap<AssimpFactory::VSVertices>* baseVertices, const BufferSpan<const AssimpFactory::VSVertices>& baseVertexData, BufferHeap<AssimpFactory::VertexBoneData>* boneData);
 		void CreateShaderResources();
 		
-		void Update(const std::vector<XMMATRIX>& bones);
+		// the palette's size, set once the model is loaded, before the first pose and without a device
+		void SetBoneCount(const UINT& boneCount) { m_boneCount = boneCount; }
+		// takes this frame's slot on the upload ring and returns where the pose goes, a linear blend pose is written straight into it
+		// a dualQuaternionSkinning pose, or one the ring had no room for, is written to the calling thread's scratch instead
+		// every bone is written before it is read, the ring is write combined memory
+		XMMATRIX* BeginPose();
+		// call on the same thread once a changed pose is written to BeginPose's pointer, converts it for dualQuaternionSkinning models
+		// false when the ring was full, nothing is skinned this frame then and the caller has to pose again next frame
+		// an unchanged pose doesn't call it, its slot goes unused and HasPalette stays false
+		bool FinishPose();
 		void Dispatch(ID3D12GraphicsCommandList4* commandList);
 
 		void ReleaseUploadResources();
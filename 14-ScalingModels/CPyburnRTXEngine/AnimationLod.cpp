@@ -0,0 +1,121 @@
+#include "pchlib.h"
+#include "AnimationLod.h"
+
+#include "CameraBase.h"
+
+namespace CPyburnRTXEngine
+{
+	void AnimationLod::SetCamera(CameraBase* camera)
+	{
+		m_eye = camera->GetEye();
+		m_projectionScale = 1.0f / tanf(camera->GetFieldOfView() * 0.5f);
+	}
+
+	void AnimationLod::MoveSlot(const UINT& from, const UINT& to)
+	{
+		if (from < m_sizedLevels.size() && to < m_sizedLevels.size())
+		{
+			m_sizedLevels[to] = m_sizedLevels[from];
+			m_framesSincePose[to] = m_framesSincePose[from];
+			m_pendingSeconds[to] = m_pendingSeconds[from];
+			m_posed[to] = m_posed[from];
+		}
+	}
+
+	AnimationLod::Level AnimationLod::PickSizedLevel(Level level, const float& screenSize) const
+	{
+		UINT index = static_cast<UINT>(level);
+
+		// only step once the size is clear of the threshold by the hysteresis band, loops so a camera jump settles in one frame
+		while (index + 1 < c_sizedLevelCount && screenSize < m_screenSizes[index] * (1.0f - m_hysteresis))
+		{
+			index++;
+		}
+		while (index > 0 && screenSize > m_screenSizes[index - 1] * (1.0f + m_hysteresis))
+		{
+			index--;
+		}
+
+		return static_cast<Level>(index);
+	}
+
+	void AnimationLod::UpdateRange(const std::vector<UINT>& animatedSlots, const TransformStore& transforms, const FrustumCuller& frustumCuller, const float& elapsedSeconds, const UINT& begin, const UINT& end)
+	{
+		const float* boundsX = transforms.GetWorldBoundsX().data();
+		const float* boundsY = transforms.GetWorldBoundsY().data();
+		const float* boundsZ = transforms.GetWorldBoundsZ().data();
+		const float* boundsRadius = transforms.GetWorldBoundsRadius().data();
+
+		for (UINT i = begin; i < end; i++)
+		{
+			const UINT& slot = animatedSlots[i];
+
+			// the clip advances by everything since the last pose, whether it was one frame ago or eight
+			if (m_posed[slot])
+			{
+				m_pendingSeconds[slot] = 0.0f;
+			}
+			m_pendingSeconds[slot] += elapsedSeconds;
+			m_framesSincePose[slot] = static_cast<UINT8>(std::min<UINT>(m_framesSincePose[slot] + 1u, UINT8_MAX));
+			m_posed[slot] = 0;
+
+			if (!m_enabled)
+			{
+				m_sizedLevels[slot] = Level::Full;
+				m_posed[slot] = 1;
+				continue;
+			}
+
+			float dx = boundsX[slot] - m_eye.x;
+			float dy = boundsY[slot] - m_eye.y;
+			float dz = boundsZ[slot] - m_eye.z;
+			float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+			float screenSize = distance > boundsRadius[slot] ? boundsRadius[slot] * m_projectionScale / distance : FLT_MAX;
+
+			m_sizedLevels[slot] = PickSizedLevel(m_sizedLevels[slot], screenSize);
+
+			// frozen units keep their last pose, the catch up below gives them a fresh one the frame they come back
+			if (!frustumCuller.IsVisible(slot))
+			{
+				continue;
+			}
+
+			// intervals are powers of two, the slot offsets the phase so a level's units are spread across its frames
+			const UINT& interval = m_frameIntervals[static_cast<UINT>(m_sizedLevels[slot])];
+			bool onPhase = ((m_frame + slot) & (interval - 1)) == 0;
+			if (onPhase || m_framesSincePose[slot] > interval)
+			{
+				m_posed[slot] = 1;
+				m_framesSincePose[slot] = 0;
+			}
+		}
+	}
+
+	void AnimationLod::Update(const std::vector<UINT>& animatedSlots, const TransformStore& transforms, const FrustumCuller& frustumCuller, const float& elapsedSeconds, JobSystem& jobSystem)
+	{
+		const UINT count = transforms.GetCount();
+
+		// new slots start at full rate and are posed on their first frame
+		m_sizedLevels.resize(count, Level::Full);
+		m_framesSincePose.resize(count, UINT8_MAX);
+		m_pendingSeconds.resize(count, 0.0f);
+		m_posed.resize(count, 0);
+
+		// every range owns its own slots, animated slots are unique
+		jobSystem.ParallelFor(static_cast<UINT>(animatedSlots.size()), c_lodRangeSize, [this, &animatedSlots, &transforms, &frustumCuller, elapsedSeconds](UINT begin, UINT end)
+			{
+				UpdateRange(animatedSlots, transforms, frustumCuller, elapsedSeconds, begin, end);
+			});
+
+		m_posedSlots.clear();
+		for (const UINT& slot : animatedSlots)
+		{
+			if (m_posed[slot])
+			{
+				m_posedSlots.push_back(slot);
+			}
+		}
+
+		m_frame++;
+	}
+}
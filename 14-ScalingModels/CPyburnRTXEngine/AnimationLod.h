@@ -0,0 +1,79 @@
+#pragma once
+
+#include "pchlib.h"
+#include "TransformStore.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+
+namespace CPyburnRTXEngine
+{
+	class CameraBase; // forward declaration
+
+	// picks how often each skinned entity gets a new pose from how big its bounding sphere is on screen
+	// a skipped frame skips the pose, the skinning dispatch and the BLAS rebuild, the last skinned vertices and BLAS are reused as they are
+	class AnimationLod
+	{
+	public:
+		enum class Level : UINT8
+		{
+			Full, // every frame
+			Half, // every 2nd frame
+			Quarter, // every 4th frame, leaves of the skeleton keep their bind pose
+			Eighth, // every 8th frame, the two lowest levels of the skeleton keep their bind pose
+			Frozen, // not visible, the pose is left as it was until it comes back
+		};
+
+	private:
+		static constexpr UINT c_sizedLevelCount = 4; // every level but Frozen, which comes from the culler
+		static constexpr UINT c_lodRangeSize = 256;
+
+		bool m_enabled = true;
+		// projected radius over half the screen height, below m_screenSizes[i] a unit drops from level i to level i + 1
+		float m_screenSizes[c_sizedLevelCount - 1] = { 0.08f, 0.04f, 0.015f };
+		// a unit has to be this fraction past a threshold before it switches, so one standing on the line doesn't flicker between rates
+		float m_hysteresis = 0.15f;
+		UINT m_frameIntervals[c_sizedLevelCount] = { 1, 2, 4, 8 };
+		UINT m_minSampledHeights[c_sizedLevelCount] = { 0, 0, 1, 2 }; // Skeleton::GetHeight below this uses the bind transform
+
+		XMFLOAT3 m_eye = {};
+		float m_projectionScale = 1.0f; // 1 / tan(fov / 2)
+		UINT m_frame = 0; // staggers units on the same level so their poses don't all land on the same frame
+
+		// per slot, like the culler, so the state survives the animated slots being rebuilt
+		std::vector<Level> m_sizedLevels; // level from screen size alone, kept while frozen so hysteresis carries over
+		std::vector<UINT8> m_framesSincePose;
+		std::vector<float> m_pendingSeconds; // time the clip has to advance by at the next pose
+		std::vector<UINT8> m_posed;
+		std::vector<UINT> m_posedSlots;
+
+		void UpdateRange(const std::vector<UINT>& animatedSlots, const TransformStore& transforms, const FrustumCuller& frustumCuller, const float& elapsedSeconds, const UINT& begin, const UINT& end);
+		Level PickSizedLevel(Level level, const float& screenSize) const;
+
+	public:
+		AnimationLod() = default;
+		AnimationLod(const AnimationLod&) = delete;
+		AnimationLod& operator=(const AnimationLod&) = delete;
+		~AnimationLod() = default;
+
+		// disabled poses every animated entity every frame
+		void SetEnabled(const bool& enabled) { m_enabled = enabled; }
+		const bool& IsEnabled() const { return m_enabled; }
+		void SetScreenSize(const Level& level, const float& screenSize) { m_screenSizes[static_cast<UINT>(level)] = screenSize; }
+		void SetHysteresis(const float& hysteresis) { m_hysteresis = hysteresis; }
+		void SetMinSampledHeight(const Level& level, const UINT& minSampledHeight) { m_minSampledHeights[static_cast<UINT>(level)] = minSampledHeight; }
+
+		// call before Update, the camera is copied so it can keep moving
+		void SetCamera(CameraBase* camera);
+
+		// picks a level for every animated slot and collects the ones that get a new pose this frame, run it after the culler
+		void Update(const std::vector<UINT>& animatedSlots, const TransformStore& transforms, const FrustumCuller& frustumCuller, const float& elapsedSeconds, JobSystem& jobSystem);
+
+		// mirrors a TransformStore::Remove that moved the last slot into to, the vectors shrink on the next Update
+		void MoveSlot(const UINT& from, const UINT& to);
+
+		Level GetLevel(const UINT& slot, const FrustumCuller& frustumCuller) const { return frustumCuller.IsVisible(slot) ? m_sizedLevels[slot] : Level::Frozen; }
+		const UINT& GetMinSampledHeight(const UINT& slot) const { return m_minSampledHeights[static_cast<UINT>(m_sizedLevels[slot])]; }
+		const float& GetPendingSeconds(const UINT& slot) const { return m_pendingSeconds[slot]; }
+		const std::vector<UINT>& GetPosedSlots() const { return m_posedSlots; }
+	};
+}
@@ -2,6 +2,7 @@
 #include "AnimationPlayer.h"
 
 #include "AssimpAnimations.h"
+#include "PoseCache.h"
 
 namespace CPyburnRTXEngine
 {
@@ -9,11 +10,9 @@ namespace CPyburnRTXEngine
 	{
 		m_skinnedMesh = skinnedMesh;
 
-		m_currentClip.bones.resize(skinnedMesh->GetAssimpFactory()->GetNumBones());
 		m_currentClip.noGlobalBones.resize(skinnedMesh->GetAssimpFactory()->GetNumBones());
 		m_currentClip.global.resize(skinnedMesh->GetAssimpFactory()->GetNumBones());
 
-		m_targetClip.bones.resize(skinnedMesh->GetAssimpFactory()->GetNumBones());
 		m_targetClip.noGlobalBones.resize(skinnedMesh->GetAssimpFactory()->GetNumBones());
 		m_targetClip.global.resize(skinnedMesh->GetAssimpFactory()->GetNumBones());
 
@@ -29,11 +28,9 @@ namespace CPyburnRTXEngine
 
 	AnimationPlayer::~AnimationPlayer()
 	{
-		m_currentClip.bones.clear();
 		m_currentClip.noGlobalBones.clear();
 		m_currentClip.global.clear();
 
-		m_targetClip.bones.clear();
 		m_targetClip.noGlobalBones.clear();
 		m_targetClip.global.clear();
 	}
@@ -89,15 +86,97 @@ namespace CPyburnRTXEngine
 	//	BlendClip(animationName, repeat, forward);
 	//}
 
-	void AnimationPlayer::Update(DX::StepTimer const& timer)
+	bool AnimationPlayer::ChangePose(const PoseKey& pose)
 	{
+		m_poseChanged = !m_hasPose || !(pose == m_lastPose);
+
+		if (!m_hasPose || pose.current != m_lastPose.current || pose.target != m_lastPose.target)
+		{
+			m_poseDelta = FLT_MAX;
+		}
+		else
+		{
+			m_poseDelta = fabsf(pose.currentTime - m_lastPose.currentTime) + fabsf(pose.targetTime - m_lastPose.targetTime) + fabsf(pose.blendFactor - m_lastPose.blendFactor) * m_maxBlendTime;
+		}
+
+		m_lastPose = pose;
+		m_hasPose = true;
+		return m_poseChanged;
+	}
+
+	void AnimationPlayer::AccumulateClipWindow(const Animation& animation, const float& from, const float& to)
+	{
+		XMVECTOR delta = animation.GetRootPosition(to) - animation.GetRootPosition(from);
+		XMStoreFloat3(&m_rootMotionDelta, XMLoadFloat3(&m_rootMotionDelta) + delta);
+
+		if (from <= to)
+		{
+			animation.CollectEvents(from, to, m_firedEvents);
+		}
+		else
+		{
+			// backwards the window is [to, from), collected forwards and then flipped so they come out in playing order
+			size_t firstFired = m_firedEvents.size();
+			animation.CollectEvents(to, from, m_firedEvents);
+			std::reverse(m_firedEvents.begin() + firstFired, m_firedEvents.end());
+		}
+	}
+
+	float AnimationPlayer::AccumulateLoopWindow(const Animation& animation, float from, float to)
+	{
+		const float length = animation.endTime - animation.startTime;
+		if (length <= 0.0f)
+		{
+			return from <= to ? animation.startTime : animation.endTime;
+		}
+
+		// a LOD that skipped frames can be more than a whole loop behind, each pass over the seam is its own window
+		if (from <= to)
+		{
+			while (to >= animation.endTime)
+			{
+				AccumulateClipWindow(animation, from, animation.endTime);
+				from = animation.startTime;
+				to -= length;
+			}
+		}
+		else
+		{
+			while (to <= animation.startTime)
+			{
+				AccumulateClipWindow(animation, from, animation.startTime);
+				from = animation.endTime;
+				to += length;
+			}
+		}
+
+		AccumulateClipWindow(animation, from, to);
+		return to;
+	}
+
+	void AnimationPlayer::Update(const float& elapsedSeconds, const UINT& minSampledHeight, PoseCache* poseCache, XMMATRIX* bones)
+	{
+		m_rootMotionDelta = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		m_firedEvents.clear();
+
+		// the window the clip moves over this update, root motion and events are read from it instead of resampling bones
+		const Animation& currentAnimation = *m_currentClip.animation;
+		const float previousTime = m_currentClip.time;
 
 #pragma region currentClip
 		if (m_currentClip.forward)
 		{
 			if (m_currentClip.time < m_currentClip.animation->endTime)
 			{
-				m_currentClip.time += (float)timer.GetElapsedSeconds() * m_animationSpeed;
+				m_currentClip.time += elapsedSeconds * m_animationSpeed;
+				if (m_currentClip.repeat)
+				{
+					m_currentClip.time = AccumulateLoopWindow(currentAnimation, previousTime, m_currentClip.time);
+				}
+				else
+				{
+					AccumulateClipWindow(currentAnimation, previousTime, m_currentClip.time);
+				}
 			}
 			else if (m_currentClip.repeat)
 			{
@@ -114,7 +193,15 @@ namespace CPyburnRTXEngine
 		{
 			if (m_currentClip.time > (float)m_currentClip.animation->startTime)
 			{
-				m_currentClip.time -= (float)timer.GetElapsedSeconds() * m_animationSpeed;
+				m_currentClip.time -= elapsedSeconds * m_animationSpeed;
+				if (m_currentClip.repeat)
+				{
+					m_currentClip.time = AccumulateLoopWindow(currentAnimation, previousTime, m_currentClip.time);
+				}
+				else
+				{
+					AccumulateClipWindow(currentAnimation, previousTime, m_currentClip.time);
+				}
 			}
 			else if (m_currentClip.repeat)
 			{
@@ -130,7 +217,7 @@ namespace CPyburnRTXEngine
 
 		if (m_currentBlendTime < m_maxBlendTime)
 		{
-			m_currentBlendTime += (float)timer.GetElapsedSeconds();
+			m_currentBlendTime += elapsedSeconds;
 			float blendFactor = m_currentBlendTime / m_maxBlendTime;
 
 			if (blendFactor >= 1.0f)
@@ -141,14 +228,15 @@ namespace CPyburnRTXEngine
 				blendFactor = 1.0f;
 			}
 
-			m_skinnedMesh->BoneTransformBlended(blendFactor, m_currentClip.time, m_targetClip.time, &m_currentClip.bones[0], &m_currentClip.noGlobalBones[0], &m_currentClip.global[0]);
+			if (ChangePose(PoseKey{ m_currentClip.animation, m_currentClip.time, m_targetClip.animation, m_targetClip.time, blendFactor, minSampledHeight }))
+				m_skinnedMesh->BoneTransformBlended(blendFactor, m_currentClip.time, m_targetClip.time, minSampledHeight, bones, &m_currentClip.noGlobalBones[0], &m_currentClip.global[0]);
 
 #pragma region targetClip
 			if (m_targetClip.forward)
 			{
 				if (m_targetClip.time < (float)m_targetClip.animation->endTime)
 				{
-					m_targetClip.time += (float)timer.GetElapsedSeconds() * m_animationSpeed;
+					m_targetClip.time += elapsedSeconds * m_animationSpeed;
 				}
 				else if (m_targetClip.repeat)
 				{
@@ -159,7 +247,7 @@ namespace CPyburnRTXEngine
 			{
 				if (m_targetClip.time > (float)m_targetClip.animation->startTime)
 				{
-					m_targetClip.time -= (float)timer.GetElapsedSeconds() * m_animationSpeed;
+					m_targetClip.time -= elapsedSeconds * m_animationSpeed;
 				}
 				else if (m_targetClip.repeat)
 				{
@@ -199,7 +287,10 @@ namespace CPyburnRTXEngine
 			//	m_currentClip.bones[i] = finalGlobalMultM * finalMultM;
 			//}
 		}
-		else
-			m_skinnedMesh->BoneTransform(m_currentClip.time, &m_currentClip.bones[0], &m_currentClip.noGlobalBones[0], &m_currentClip.global[0]);
+		else if (ChangePose(PoseKey{ m_currentClip.animation, m_currentClip.time, nullptr, 0.0f, 1.0f, minSampledHeight }))
+		{
+			if (!poseCache || !poseCache->Pose(m_skinnedMesh, m_currentClip, minSampledHeight, bones))
+				m_skinnedMesh->BoneTransform(m_currentClip.time, minSampledHeight, bones, &m_currentClip.noGlobalBones[0], &m_currentClip.global[0]);
+		}
 	}
 }
\ No newline at end of file
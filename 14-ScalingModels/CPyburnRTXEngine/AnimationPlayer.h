@@ -6,6 +6,7 @@
 namespace CPyburnRTXEngine
 {
 	class AssimpAnimations; // forward declaration
+	class PoseCache; // forward declaration
 
 	class AnimationPlayer
 	{
@@ -16,7 +17,6 @@ namespace CPyburnRTXEngine
 			Animation::AnimationType animationType = Animation::AnimationType::none;
 			Animation* animation = nullptr; // pointer to anination
 			float time = 0;
-			std::vector<XMMATRIX> bones;
 			// used for animation blending
 			std::vector<XMMATRIX> noGlobalBones;
 			// used for animation blending
@@ -37,6 +37,40 @@ namespace CPyburnRTXEngine
 		AnimationClip m_currentClip;
 		AnimationClip m_targetClip;
 
+		// everything the pose depends on, when an Update lands on the same one the palette it wrote last time is still right
+		struct PoseKey
+		{
+			const Animation* current = nullptr;
+			float currentTime = 0;
+			const Animation* target = nullptr; // nullptr when not blending
+			float targetTime = 0;
+			float blendFactor = 1.0f;
+			UINT minSampledHeight = 0;
+
+			bool operator==(const PoseKey& other) const
+			{
+				return current == other.current && currentTime == other.currentTime && target == other.target && targetTime == other.targetTime && blendFactor == other.blendFactor && minSampledHeight == other.minSampledHeight;
+			}
+		};
+
+		PoseKey m_lastPose;
+		bool m_hasPose = false;
+		bool m_poseChanged = true;
+		float m_poseDelta = FLT_MAX;
+
+		// records pose as the latest one, false when it is the same as the one before
+		bool ChangePose(const PoseKey& pose);
+
+		// what the current clip's time moved over in the last Update
+		XMFLOAT3 m_rootMotionDelta = {};
+		std::vector<const Animation::Event*> m_firedEvents;
+
+		// from and to are clip times, to before from is playing backwards
+		void AccumulateClipWindow(const Animation& animation, const float& from, const float& to);
+		// to is where a repeating clip got to, past its end or before its start it carries on from the other end
+		// the window splits at the seam, [from, end) then [start, start + overshoot) forwards, returns the wrapped time
+		float AccumulateLoopWindow(const Animation& animation, float from, float to);
+
 		void PlayClip(const std::string& clipName, bool repeat = true, bool forward = true);
 		void BlendClip(const std::string& clipName, bool repeat = true, bool forward = true);
 
@@ -54,11 +88,30 @@ namespace CPyburnRTXEngine
 		//void PlayClipByAnimationTypeName(const string& animationTypeName, bool repeat = true, bool forward = true);
 		//void BlendClipByAnimationTypeName(const string& animationTypeName, bool repeat = true, bool forward = true);
 
-		void Update(DX::StepTimer const& timer);
-		const std::vector<XMMATRIX>& GetBones() { return m_currentClip.bones; }
+		// bones is where the final palette is written, AnimationCompute::BeginPose's slot on the upload ring, only written when the pose changed
+		// elapsedSeconds is everything since the last pose, more than one frame when the LOD skips frames
+		// minSampledHeight is the LOD's cut off, nodes closer to a leaf than that keep their bind transform
+		// poseCache is optional, when set a clip that isn't blending shares its pose with every unit on the same quantized time
+		void Update(const float& elapsedSeconds, const UINT& minSampledHeight, PoseCache* poseCache, XMMATRIX* bones);
 		AnimationClip* GetCurrentClip() { return &m_currentClip; }
+		// false when the last Update had nothing new to pose, paused, held on a finished clip's last frame or no time passed
+		// nothing was written to bones then, and the skinned vertices and BLAS from the last changed pose can stay
+		bool IsPoseChanged() const { return m_poseChanged; }
+		// the last pose never reached the gpu, the next Update counts as changed even when it lands on the same pose
+		void ForgetPose() { m_hasPose = false; }
+		// seconds of clip time the last Update moved the pose by, blends count their blend time, FLT_MAX when a clip started or ended
+		// the BLAS refit policy adds these up to know when a refit has drifted too far from its last full build
+		float GetPoseDelta() const { return m_poseDelta; }
+		// 0 pauses the clip where it is
+		void SetAnimationSpeed(const float& animationSpeed) { m_animationSpeed = animationSpeed; }
+		float GetAnimationSpeed() const { return m_animationSpeed; }
 		AnimationClip* GetTargetClip() { return &m_targetClip; }
 
+		// model space, scale it by the entity's world transform before moving the unit with it
+		const XMFLOAT3& GetRootMotionDelta() const { return m_rootMotionDelta; }
+		// the events the current clip passed over in the last Update, in the order it passed them
+		const std::vector<const Animation::Event*>& GetFiredEvents() const { return m_firedEvents; }
+
 		Animation* GetAnimation(const std::string& clipName)
 		{
 			for (std::unordered_map<UINT, std::unordered_map<std::string, Animation>>::iterator it = m_animationsByModelId->begin(); it != m_animationsByModelId->end(); ++it)
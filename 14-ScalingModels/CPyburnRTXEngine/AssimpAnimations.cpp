@@ -6,250 +6,59 @@ namespace CPyburnRTXEngine
 	std::unordered_map<UINT, std::string> AssimpAnimations::AnimationTypes;
 	std::unordered_map<UINT, std::unordered_map<UINT, std::unordered_map<std::string, Animation>>> AssimpAnimations::Animations;
 
-	XMVECTOR AssimpAnimations::CalcInterpolatedScalingXM(float animationTime, const aiNodeAnim* pNodeAnim)
+	void AssimpAnimations::ExtractRootMotion()
 	{
-		if (pNodeAnim->mNumScalingKeys == 1)
+		auto clipsByType = Animations.find(m_assimpFactory->GetModel()->modelId);
+		if (clipsByType == Animations.end())
 		{
-			const aiVector3D& scaling = pNodeAnim->mScalingKeys[0].mValue;
-			return { scaling.x, scaling.y, scaling.z };
-		}
-
-		int scalingIndex = FindScaling(animationTime, pNodeAnim);
-		unsigned int nextScalingIndex = (scalingIndex + 1);
-		float deltaTime = (float)(pNodeAnim->mScalingKeys[nextScalingIndex].mTime - pNodeAnim->mScalingKeys[scalingIndex].mTime);
-		float factor = (animationTime - (float)pNodeAnim->mScalingKeys[scalingIndex].mTime) / deltaTime;
-		const aiVector3D& start = pNodeAnim->mScalingKeys[scalingIndex].mValue;
-		XMVECTOR xmStart = { start.x, start.y, start.z };
-		const aiVector3D& end = pNodeAnim->mScalingKeys[nextScalingIndex].mValue;
-		XMVECTOR xmEnd = { end.x, end.y, end.z };
-		XMVECTOR xmDelta = xmEnd - xmStart;
-		return xmStart + factor * xmDelta;
-	}
-
-	XMVECTOR AssimpAnimations::CalcInterpolatedRotationXM(float animationTime, const aiNodeAnim* pNodeAnim)
-	{
-		if (pNodeAnim->mNumRotationKeys == 1)
-		{
-			const aiQuaternion& rotationQ = pNodeAnim->mRotationKeys[0].mValue;
-			return { rotationQ.x, rotationQ.y, rotationQ.z, rotationQ.w };
+			return;
 		}
 
-		int rotationIndex = FindRotation(animationTime, pNodeAnim);
-		unsigned int nextRotationIndex = (rotationIndex + 1);
-		float deltaTime = (float)(pNodeAnim->mRotationKeys[nextRotationIndex].mTime - pNodeAnim->mRotationKeys[rotationIndex].mTime);
-		float factor = (animationTime - (float)pNodeAnim->mRotationKeys[rotationIndex].mTime) / deltaTime;
-		const aiQuaternion& startRotationQ = pNodeAnim->mRotationKeys[rotationIndex].mValue;
-		XMVECTOR xmStartRotationQ = { startRotationQ.x, startRotationQ.y, startRotationQ.z, startRotationQ.w };
-		const aiQuaternion& endRotationQ = pNodeAnim->mRotationKeys[nextRotationIndex].mValue;
-		XMVECTOR xmEndRotationQ = { endRotationQ.x, endRotationQ.y, endRotationQ.z, endRotationQ.w };
-		return XMVector4Normalize(XMQuaternionSlerp(xmStartRotationQ, xmEndRotationQ, factor));
-	}
-
-	XMVECTOR AssimpAnimations::CalcInterpolatedPositionXM(float animationTime, const aiNodeAnim* pNodeAnim)
-	{
-		if (pNodeAnim->mNumPositionKeys == 1)
+		// the root motion bone is the top most animated bone, parents come first so it is the first one found
+		const Skeleton& skeleton = m_assimpFactory->GetSkeleton();
+		UINT rootNode = MAXUINT;
+		for (UINT node = 0; node < skeleton.GetNodeCount() && rootNode == MAXUINT; node++)
 		{
-			const aiVector3D& position = pNodeAnim->mPositionKeys[0].mValue;
-			return { position.x, position.y, position.z };
-		}
-
-		int positionIndex = FindPosition(animationTime, pNodeAnim);
-		unsigned int nextPositionIndex = (positionIndex + 1);
-		float deltaTime = (float)(pNodeAnim->mPositionKeys[nextPositionIndex].mTime - pNodeAnim->mPositionKeys[positionIndex].mTime);
-		float factor = (animationTime - (float)pNodeAnim->mPositionKeys[positionIndex].mTime) / deltaTime;
-		const aiVector3D& start = pNodeAnim->mPositionKeys[positionIndex].mValue;
-		XMVECTOR xmStart = { start.x, start.y, start.z };
-		const aiVector3D& end = pNodeAnim->mPositionKeys[nextPositionIndex].mValue;
-		XMVECTOR xmEnd = { end.x, end.y, end.z };
-		XMVECTOR xmDelta = xmEnd - xmStart;
-		return xmStart + factor * xmDelta;
-	}
-
-	int AssimpAnimations::FindScaling(float animationTime, const aiNodeAnim* pNodeAnim)
-	{
-		for (unsigned int i = 0; i < pNodeAnim->mNumScalingKeys - 1; i++)
-		{
-			if (animationTime < (float)pNodeAnim->mScalingKeys[i + 1].mTime)
+			if (skeleton.GetBoneIndex(node) != MAXUINT && skeleton.GetAnimationTrack(node) != MAXUINT)
 			{
-				return i;
+				rootNode = node;
 			}
 		}
-		return 0;
-	}
-
-	int AssimpAnimations::FindRotation(float animationTime, const aiNodeAnim* pNodeAnim)
-	{
-		for (unsigned int i = 0; i < pNodeAnim->mNumRotationKeys - 1; i++)
+		if (rootNode == MAXUINT)
 		{
-			if (animationTime < (float)pNodeAnim->mRotationKeys[i + 1].mTime)
-			{
-				return i;
-			}
+			return;
 		}
-		return 0;
-	}
 
-	int AssimpAnimations::FindPosition(float animationTime, const aiNodeAnim* pNodeAnim)
-	{
-		for (unsigned int i = 0; i < pNodeAnim->mNumPositionKeys - 1; i++)
-		{
-			if (animationTime < (float)pNodeAnim->mPositionKeys[i + 1].mTime)
-			{
-				return i;
-			}
-		}
-		return 0;
-	}
+		const UINT numBones = m_assimpFactory->GetNumBones();
+		std::vector<XMMATRIX> bones(numBones);
+		std::vector<XMMATRIX> noGlobalBones(numBones);
+		std::vector<XMMATRIX> global(numBones);
 
-	const aiNodeAnim* AssimpAnimations::FindNodeAnim(const aiAnimation* pAnimation, const std::string& nodeName)
-	{
-		for (unsigned int i = 0; i < pAnimation->mNumChannels; i++)
+		for (auto& [animationTypeId, clips] : clipsByType->second)
 		{
-			const aiNodeAnim* pNodeAnim = pAnimation->mChannels[i];
-
-			if (std::string(pNodeAnim->mNodeName.data) == nodeName)
+			for (auto& [clipName, clip] : clips)
 			{
-				return pNodeAnim;
-			}
-		}
-
-		return NULL;
-	}
-
-	void AssimpAnimations::CreateSkeletonBones(const aiNode* pNode, AssimpFactory::Bone* pBone)
-	{
-		pBone->nodeName = pNode->mName.data;
-		pBone->pNodeAnim = FindNodeAnim(m_assimpFactory->GetAiScene()->mAnimations[0], pBone->nodeName);
-		pBone->parentNodeTransformation = XMMatrixSet(pNode->mTransformation.a1, pNode->mTransformation.a2, pNode->mTransformation.a3, pNode->mTransformation.a4,
-			pNode->mTransformation.b1, pNode->mTransformation.b2, pNode->mTransformation.b3, pNode->mTransformation.b4,
-			pNode->mTransformation.c1, pNode->mTransformation.c2, pNode->mTransformation.c3, pNode->mTransformation.c4,
-			pNode->mTransformation.d1, pNode->mTransformation.d2, pNode->mTransformation.d3, pNode->mTransformation.d4);
-
-		//pBone->parentNodeTransformation = XMFLOAT4X4(pNode->mTransformation.a1, pNode->mTransformation.b1, pNode->mTransformation.c1, pNode->mTransformation.d1,
-		//											pNode->mTransformation.a2, pNode->mTransformation.b2, pNode->mTransformation.c2, pNode->mTransformation.d2,
-		//											pNode->mTransformation.a3, pNode->mTransformation.b3, pNode->mTransformation.c3, pNode->mTransformation.d3,
-		//											pNode->mTransformation.a4, pNode->mTransformation.b4, pNode->mTransformation.c4, pNode->mTransformation.d4);
-
-		// this is a good place to point the global transform to the ModelNodeInfo tranform, needed for giving skinned models weapons, emitting particles, and emitting sounds in the right position
-		//for (auto& emitter : m_emitters)
-		//{
-		//	std::string nodeNameToLower = stringToLowerReturned(pBone->nodeName);
-		//	std::string emittersNodeNameToLower = stringToLowerReturned(emitter.emitterInfo->nodeName);
-		//	if (nodeNameToLower.compare(emittersNodeNameToLower) == 0)
-		//	{
-		//		// store the address of the node to the emitter
-		//		emitter.pGlobalTransform = &pBone->globalNodeTransform;
-		//	}
-		//}
-
-		if (m_assimpFactory->GetBoneMapping().find(pBone->nodeName) != m_assimpFactory->GetBoneMapping().end())
-		{
-			pBone->hasBoneMapping = true;
-			pBone->nodeId = m_assimpFactory->GetBoneMapping().at(pBone->nodeName);
-
-			// store useful bones
-			m_globalBones.push_back(pBone);
-		}
-
-		for (unsigned int i = 0; i < pNode->mNumChildren; i++)
-		{
-			pBone->children.push_back(std::make_unique<AssimpFactory::Bone>());
-			CreateSkeletonBones(pNode->mChildren[i], pBone->children.back().get());
-		}
-	}
-
-	void AssimpAnimations::ReadSkeletonBonesBlended(float blendFactor, float animationTimeCurrent, float animationTimeTarget, AssimpFactory::Bone* pBone, const XMMATRIX& parent, XMMATRIX* bones, XMMATRIX* noGlobalBones, XMMATRIX* global)
-	{
-		XMMATRIX nodeTransformation = pBone->parentNodeTransformation;
-
-		if (pBone->pNodeAnim)
-		{
-			// scaling
-			XMVECTOR xmScalingCurrent = CalcInterpolatedScalingXM(animationTimeCurrent, pBone->pNodeAnim);
-			XMVECTOR xmScalingTarget = CalcInterpolatedScalingXM(animationTimeTarget, pBone->pNodeAnim);
-			XMVECTOR xmScaling = XMVectorLerp(xmScalingCurrent, xmScalingTarget, blendFactor);
-			XMMATRIX scalingBlendedM = XMMatrixScalingFromVector(xmScaling);
-
-			// rotation
-			XMVECTOR rotationCurrentQ = CalcInterpolatedRotationXM(animationTimeCurrent, pBone->pNodeAnim);
-			XMVECTOR rotationTargetQ = CalcInterpolatedRotationXM(animationTimeTarget, pBone->pNodeAnim);
-			XMVECTOR rotationBlendedQ = XMQuaternionSlerp(rotationCurrentQ, rotationTargetQ, blendFactor);
-
-			XMMATRIX rotationBlendedM = XMMatrixRotationQuaternion(rotationBlendedQ);
-
-			// translation
-			XMVECTOR xmTranslationCurrent = CalcInterpolatedPositionXM(animationTimeCurrent, pBone->pNodeAnim);
-			XMVECTOR xmTranslationTarget = CalcInterpolatedPositionXM(animationTimeTarget, pBone->pNodeAnim);
-
-			XMVECTOR xmTranslation = XMVectorLerp(xmTranslationCurrent, xmTranslationTarget, blendFactor);
-			XMMATRIX translationBlendedM = XMMatrixTranslationFromVector(xmTranslation);
-
-			nodeTransformation = scalingBlendedM * rotationBlendedM * translationBlendedM;
-		}
-
-		XMMATRIX xmTransposedNodeTransformation = XMMatrixTranspose(nodeTransformation);
-		XMMATRIX globalTransformation = parent * xmTransposedNodeTransformation;
-
-		if (pBone->hasBoneMapping)
-		{
-			noGlobalBones[pBone->nodeId] = xmTransposedNodeTransformation * m_assimpFactory->GetBoneInfo()[pBone->nodeId];
-			global[pBone->nodeId] = parent;
-
-			XMMATRIX finalTransformationConversion = parent * noGlobalBones[pBone->nodeId];
-			bones[pBone->nodeId] = XMMatrixTranspose(finalTransformationConversion); // if model is screwed up, you may have to remove transpose
-
-			// transpose this for easy math for modelNodes and LOD's
-			pBone->globalNodeTransform = XMMatrixTranspose(globalTransformation); //XMMatrixRotationRollPitchYaw(0.0f, 0.0f, 0.0f) * XMMatrixScaling(0.036f, 0.036f, 0.036f) * XMMatrixTranslation(0.09f, 0.04f, 0.0f)  // * XMMatrixTranspose(XMMatrixRotationRollPitchYaw(0.0f, 1.5708f, 1.5708f))
-		}
-		else if (pBone->pNodeAnim) // give the areas that don't have bones but do have animation the global transform
-		{
-			pBone->globalNodeTransform = XMMatrixTranspose(globalTransformation);
-		}
-
-		for (size_t i = 0; i < pBone->children.size(); i++)
-		{
-			ReadSkeletonBonesBlended(blendFactor, animationTimeCurrent, animationTimeTarget, pBone->children[i].get(), globalTransformation, bones, noGlobalBones, global);
-		}
-	}
-
-	void AssimpAnimations::ReadSkeletonBones(float animationTime, AssimpFactory::Bone* pBone, const XMMATRIX& parent, XMMATRIX* bones, XMMATRIX* noGlobalBones, XMMATRIX* global)
-	{
-		XMMATRIX nodeTransformation = pBone->parentNodeTransformation;
-
-		if (pBone->pNodeAnim)
-		{
-			XMVECTOR scaling = CalcInterpolatedScalingXM(animationTime, pBone->pNodeAnim);
-			XMMATRIX scalingM = XMMatrixScalingFromVector(scaling);
-			XMVECTOR rotationQ = CalcInterpolatedRotationXM(animationTime, pBone->pNodeAnim);
-			XMMATRIX rotationM = XMMatrixRotationQuaternion(rotationQ);
-			XMVECTOR translationV = CalcInterpolatedPositionXM(animationTime, pBone->pNodeAnim);
-			XMMATRIX translationM = XMMatrixTranslationFromVector(translationV);
-
-			nodeTransformation = scalingM * rotationM * translationM;
-		}
-
-		XMMATRIX xmTransposedNodeTransformation = XMMatrixTranspose(nodeTransformation);
-		XMMATRIX globalTransformation = parent * xmTransposedNodeTransformation;
-
-		if (pBone->hasBoneMapping)
-		{
-			noGlobalBones[pBone->nodeId] = xmTransposedNodeTransformation * m_assimpFactory->GetBoneInfo()[pBone->nodeId];
-			global[pBone->nodeId] = parent;
-
-			XMMATRIX finalTransformationConversion = parent * noGlobalBones[pBone->nodeId];
-			bones[pBone->nodeId] = XMMatrixTranspose(finalTransformationConversion); // if model is screwed up, you may have to remove transpose
+				if (!clip.rootMotion.empty() || clip.fps == 0 || clip.endFrame < clip.startFrame)
+					continue;
 
-			// transpose this for easy math for modelNodes and LOD's
-			pBone->globalNodeTransform = XMMatrixTranspose(globalTransformation); //XMMatrixRotationRollPitchYaw(0.0f, 0.0f, 0.0f) * XMMatrixScaling(0.036f, 0.036f, 0.036f) * XMMatrixTranslation(0.09f, 0.04f, 0.0f)  // * XMMatrixTranspose(XMMatrixRotationRollPitchYaw(0.0f, 1.5708f, 1.5708f))
-		}
-		else if (pBone->pNodeAnim) // give the areas that don't have bones but do have animation the global transform
-		{
-			pBone->globalNodeTransform = XMMatrixTranspose(globalTransformation);
-		}
+				// the same pose pass the palette uses, so the curve matches what is drawn
+				clip.rootMotion.resize(clip.endFrame - clip.startFrame + 1);
+				XMVECTOR firstPosition = XMVectorZero();
+				for (UINT frame = 0; frame < clip.rootMotion.size(); frame++)
+				{
+					BoneTransform(static_cast<float>(clip.startFrame + frame) / static_cast<float>(clip.fps), 0, bones.data(), noGlobalBones.data(), global.data());
 
-		for (size_t i = 0; i < pBone->children.size(); i++)
-		{
-			ReadSkeletonBones(animationTime, pBone->children[i].get(), globalTransformation, bones, noGlobalBones, global);
+					// global transforms are column vector, the translation is the last column
+					XMFLOAT4X4 rootTransform;
+					XMStoreFloat4x4(&rootTransform, m_pose.GetGlobalTransform(rootNode));
+					XMVECTOR position = XMVectorSet(rootTransform._14, rootTransform._24, rootTransform._34, 0.0f);
+					if (frame == 0)
+					{
+						firstPosition = position;
+					}
+					XMStoreFloat3(&clip.rootMotion[frame], position - firstPosition);
+				}
+			}
 		}
 	}
 
@@ -310,6 +119,18 @@ namespace CPyburnRTXEngine
 				animation.animationTypeName = GetAnimationTypeNameById(animation.animationTypeId);
 				animation.animationType = (Animation::AnimationType)animation.animationTypeId;
 
+				// optional, frames are in the same numbering as start and end
+				if (v.HasMember("events"))
+				{
+					for (auto& e : v["events"].GetArray())
+					{
+						std::string eventName = e["name"].GetString();
+						stringToLower(eventName);
+						animation.events.push_back(Animation::Event{ e["frame"].GetFloat() / framesPerSecond, eventName });
+					}
+					std::sort(animation.events.begin(), animation.events.end(), [](const Animation::Event& a, const Animation::Event& b) { return a.time < b.time; });
+				}
+
 				auto iterByModelId = Animations.find(animation.modelId);
 				if (iterByModelId != Animations.end())
 				{
@@ -345,13 +166,16 @@ namespace CPyburnRTXEngine
 
 		if (m_assimpFactory->GetNumBones() > 0)
 		{
-			const aiScene* pScene = m_assimpFactory->GetAiScene();
+			// baked once per model at import or read from the cache, every instance shares it
+			const BakedAnimation& animation = m_assimpFactory->GetBakedAnimation();
 			LoadJson(); // this only loads once, so it is ok to call this for every model that has bones
 
-			CreateSkeletonBones(pScene->mRootNode, &m_rootBone);
+			m_pose.Reset(m_assimpFactory->GetSkeleton());
+			m_animationCompute.SetBoneCount(m_assimpFactory->GetNumBones());
 
-			m_ticksPerSecond = (float)(pScene->mAnimations[0]->mTicksPerSecond != 0 ? pScene->mAnimations[0]->mTicksPerSecond : 25.0f);
-			m_duration = (float)pScene->mAnimations[0]->mDuration;
+			m_ticksPerSecond = animation.GetTicksPerSecond();
+			m_duration = animation.GetDuration();
+			ExtractRootMotion(); // once per model, the clips are shared
 
 			m_animationPlayer.SetAssimpAnimation(this);
 			// todo: remove after testing
@@ -373,28 +197,37 @@ namespace CPyburnRTXEngine
 	void AssimpAnimations::CreateDeviceDependentResources(DX::DeviceResources* deviceResources)
 	{
 		m_deviceResources = deviceResources;
-		m_animationCompute.CreateDeviceDependentResources(deviceResources);
+		m_animationCompute.CreateDeviceDependentResources(deviceResources, m_assimpFactory->GetModel()->dualQuaternionSkinning);
 	}
 
 	void AssimpAnimations::CreateBuffers(ID3D12GraphicsCommandList4* commandList)
 	{
-		m_assimpFactory->CreateBuffers(commandList);
-		m_animationCompute.CreateBuffers(commandList, m_assimpFactory->GetVertexBuffer(), m_assimpFactory->GetBoneBuffer(), m_assimpFactory->GetBoneInfo());
+		// the model's buffers are shared by every entity on it, only the first one creates them
+		if (!m_assimpFactory->GetVertexBuffer()->DefaultHeapResource)
+		{
+			m_assimpFactory->CreateBuffers(commandList);
+		}
+		const std::vector<AssimpFactory::VSVertices>& baseVertices = m_assimpFactory->GetMeshEntries()[0].vertices;
+		m_animationCompute.CreateBuffers(commandList, m_assimpFactory->GetVertexBuffer(), BufferSpan<const AssimpFactory::VSVertices>{ baseVertices.data(), static_cast<UINT>(baseVertices.size()) }, m_assimpFactory->GetBoneBuffer());
+	}
+
+	void AssimpAnimations::CreateBlas(ID3D12GraphicsCommandList4* commandList)
+	{
+		m_animationBlas.SetRefitPolicy(GraphicsContexts::GetBlasRefitPolicy());
 		m_animationBlas.InitBlas(m_deviceResources->GetD3DDevice(), static_cast<UINT>(m_assimpFactory->GetMeshEntries()[0].vertices.size()), m_animationCompute.GetVertexOutputBuffer().DefaultHeapResource, commandList, m_assimpFactory->GetIndexBuffer()->DefaultHeapResource, static_cast<UINT>(m_assimpFactory->GetMeshEntries()[0].indices.size()));
 		m_animationBlas.UpdateBlas(commandList);
 	}
 
 	void AssimpAnimations::CreateShaderResources()
 	{
-		m_assimpFactory->GetVertexBuffer()->CreateShaderResourceView(false); // t0 for compute shader
-		m_assimpFactory->GetBoneBuffer()->CreateShaderResourceView(false); // t1 for compute shader
-		m_animationCompute.CreateShaderResources(); // t2, u0 for compute shader, t0 rtx shader
+		m_assimpFactory->CreateSkinningShaderResources(); // t0-t1 for compute shader
+		m_animationCompute.CreateShaderResources(); // t2, u0 for compute shader
 
-		// put the indices heap position right after the vertices heap position since they are used together shader table
-		m_assimpFactory->GetIndexBuffer()->CreateShaderResourceView(false); // t1 for rtx shader
+		// the rtx shader finds it by heap index, so it can go anywhere
+		m_assimpFactory->GetIndexBuffer()->CreateShaderResourceView(false);
 	}
 
-	void AssimpAnimations::BoneTransformBlended(float blendFactor, float timeInSecondsCurrent, float timeInSecondsTarget, XMMATRIX* bones, XMMATRIX* noGlobalBones, XMMATRIX* global)
+	void AssimpAnimations::BoneTransformBlended(float blendFactor, float timeInSecondsCurrent, float timeInSecondsTarget, const UINT& minSampledHeight, XMMATRIX* bones, XMMATRIX* noGlobalBones, XMMATRIX* global)
 	{
 		float timeInTicksCurrent = timeInSecondsCurrent * m_ticksPerSecond;
 		float animationTimeCurrent = fmod(timeInTicksCurrent, m_duration);
@@ -402,23 +235,44 @@ namespace CPyburnRTXEngine
 		float timeInTicksTarget = timeInSecondsTarget * m_ticksPerSecond;
 		float animationTimeTarget = fmod(timeInTicksTarget, m_duration);
 
-		ReadSkeletonBonesBlended(blendFactor, animationTimeCurrent, animationTimeTarget, &m_rootBone, XMMatrixIdentity(), bones, noGlobalBones, global);
+		const CompressedAnimation& compressed = m_assimpFactory->GetCompressedAnimation();
+		if (!compressed.IsEmpty())
+		{
+			m_pose.ReadBlended(m_assimpFactory->GetSkeleton(), m_assimpFactory->GetBoneInfo(), compressed, blendFactor, animationTimeCurrent, animationTimeTarget, minSampledHeight, bones, noGlobalBones, global);
+		}
+		else
+		{
+			m_pose.ReadBlended(m_assimpFactory->GetSkeleton(), m_assimpFactory->GetBoneInfo(), m_assimpFactory->GetBakedAnimation(), blendFactor, animationTimeCurrent, animationTimeTarget, minSampledHeight, bones, noGlobalBones, global);
+		}
 	}
 
-	void AssimpAnimations::BoneTransform(float timeInSeconds, XMMATRIX* bones, XMMATRIX* noGlobalBones, XMMATRIX* global)
+	void AssimpAnimations::BoneTransform(float timeInSeconds, const UINT& minSampledHeight, XMMATRIX* bones, XMMATRIX* noGlobalBones, XMMATRIX* global)
 	{
 		float timeInTicks = timeInSeconds * m_ticksPerSecond;
 		float animationTime = fmod(timeInTicks, m_duration);
 
-		ReadSkeletonBones(animationTime, &m_rootBone, XMMatrixIdentity(), bones, noGlobalBones, global);
+		const CompressedAnimation& compressed = m_assimpFactory->GetCompressedAnimation();
+		if (!compressed.IsEmpty())
+		{
+			m_pose.Read(m_assimpFactory->GetSkeleton(), m_assimpFactory->GetBoneInfo(), compressed, animationTime, minSampledHeight, bones, noGlobalBones, global);
+		}
+		else
+		{
+			m_pose.Read(m_assimpFactory->GetSkeleton(), m_assimpFactory->GetBoneInfo(), m_assimpFactory->GetBakedAnimation(), animationTime, minSampledHeight, bones, noGlobalBones, global);
+		}
 	}
 
-	void AssimpAnimations::Update(DX::StepTimer const& timer)
+	void AssimpAnimations::Update(DX::StepTimer const& timer, const float& elapsedSeconds, const UINT& minSampledHeight, PoseCache* poseCache)
 	{
 		if (m_animationPlayer.GetAssimpAnimation())
 		{
-			m_animationPlayer.Update(timer);
-			m_animationCompute.Update(m_animationPlayer.GetBones());
+			// the palette is posed on the cpu straight into this frame's upload ring, only a changed one is finished and skinned
+			XMMATRIX* bones = m_animationCompute.BeginPose();
+			m_animationPlayer.Update(elapsedSeconds, minSampledHeight, poseCache, bones);
+			if (m_animationPlayer.IsPoseChanged() && !m_animationCompute.FinishPose())
+			{
+				m_animationPlayer.ForgetPose();
+			}
 
 			double time = timer.GetTotalSeconds();
 			if (time > 5.0 && played == false)
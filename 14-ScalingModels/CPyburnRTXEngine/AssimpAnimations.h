@@ -2,6 +2,7 @@
 
 #include "AssimpFactory.h"
 #include "Animation.h"
+#include "SkeletonPose.h"
 
 #include "AnimationPlayer.h"
 #include "AnimationCompute.h"
@@ -30,26 +31,12 @@ namespace CPyburnRTXEngine
 		float m_ticksPerSecond = 0;
 		float m_duration = 0;
 		
-		AssimpFactory::Bone m_rootBone;
-		// for now this is a string, but may be a map of <key, object holdind everything needed>
-		std::vector<AssimpFactory::Bone*> m_globalBones; // this is just a place for storing bones that are useful, have names, etc.
+		SkeletonPose m_pose; // per node of the model's Skeleton, everything else about the skeleton is shared
 
 		bool played = false;
 
-		XMVECTOR CalcInterpolatedScalingXM(float animationTime, const aiNodeAnim* pNodeAnim);
-		XMVECTOR CalcInterpolatedRotationXM(float animationTime, const aiNodeAnim* pNodeAnim);
-		XMVECTOR CalcInterpolatedPositionXM(float animationTime, const aiNodeAnim* pNodeAnim);
-
-		int FindScaling(float animationTime, const aiNodeAnim* pNodeAnim);
-		int FindRotation(float animationTime, const aiNodeAnim* pNodeAnim);
-		int FindPosition(float animationTime, const aiNodeAnim* pNodeAnim);
-
-		const aiNodeAnim* FindNodeAnim(const aiAnimation* pAnimation, const std::string& nodeName);
-		void CreateSkeletonBones(const aiNode* pNode, AssimpFactory::Bone* pBone);
-		void ReadSkeletonBonesBlended(float blendFactor, float animationTimeCurrent, float animationTimeTarget, AssimpFactory::Bone* pBone, const XMMATRIX& parent, XMMATRIX* bones, XMMATRIX* noGlobalBones, XMMATRIX* global);
-		void ReadSkeletonBones(float animationTime, AssimpFactory::Bone* pBone, const XMMATRIX& parent, XMMATRIX* bones, XMMATRIX* noGlobalBones, XMMATRIX* global);
-
-		void LoadJson();
+		// fills Animation::rootMotion for this model's clips that don't have it yet, by posing every frame once
+		void ExtractRootMotion();
 
 		static std::string GetAnimationTypeNameById(const UINT& modelId) { return AnimationTypes[modelId]; }
 		static UINT GetAnimationTypeIdByName(std::string name)
@@ -67,22 +54,39 @@ namespace CPyburnRTXEngine
 	public:
 		AssimpFactory* GetAssimpFactory() { return m_assimpFactory; }
 		AnimationCompute* GetAnimationCompute() { return &m_animationCompute; }
+		AnimationPlayer* GetAnimationPlayer() { return &m_animationPlayer; }
+		// false when the last Update landed on the same pose as the one before, its skinning and BLAS build can be skipped
+		// also false when the upload ring had no room for the new pose, it is posed again next frame
+		bool IsPoseChanged() const { return m_animationPlayer.IsPoseChanged() && m_animationCompute.HasPalette(); }
+		// the deformation the BLAS refit policy is given
+		float GetPoseDelta() const { return m_animationPlayer.GetPoseDelta(); }
 		BufferBlas<AssimpFactory::VSVertices>* GetAnimationBlasPtr() { return &m_animationBlas; }
 
 		static std::unordered_map<UINT, std::string> AnimationTypes;
 		static std::unordered_map<UINT, std::unordered_map<UINT, std::unordered_map<std::string, Animation>>> Animations;
 		
+		// fills AnimationTypes and Animations, only the first call reads the files
+		static void LoadJson();
+
 		AssimpAnimations(AssimpFactory* assimpFactory);
 		~AssimpAnimations();
 
 		void CreateDeviceDependentResources(DX::DeviceResources* deviceResources);
 		void CreateBuffers(ID3D12GraphicsCommandList4* commandList);
+		// builds from the skinned output and the model's index buffer, recorded after the staging arena's copies
+		void CreateBlas(ID3D12GraphicsCommandList4* commandList);
 		void CreateShaderResources();
 
-		void BoneTransformBlended(float blendFactor, float timeInSecondsCurrent, float timeInSecondsTarget, XMMATRIX* bones, XMMATRIX* noGlobalBones, XMMATRIX* global);
-		void BoneTransform(float timeInSeconds, XMMATRIX* bones, XMMATRIX* noGlobalBones, XMMATRIX* global);
+		void BoneTransformBlended(float blendFactor, float timeInSecondsCurrent, float timeInSecondsTarget, const UINT& minSampledHeight, XMMATRIX* bones, XMMATRIX* noGlobalBones, XMMATRIX* global);
+		void BoneTransform(float timeInSeconds, const UINT& minSampledHeight, XMMATRIX* bones, XMMATRIX* noGlobalBones, XMMATRIX* global);
+
+		// for a unit that took its pose from the PoseCache, so weapons and emitters follow the shared pose
+		void CopyNodeTransforms(const AssimpAnimations& source) { m_pose.CopyNodeTransforms(source.m_pose); }
+		// the node transforms the last BoneTransform or CopyNodeTransforms left
+		const SkeletonPose& GetPose() const { return m_pose; }
 
-		void Update(DX::StepTimer const& timer);
+		// elapsedSeconds and minSampledHeight come from AnimationLod, only called on frames the entity gets a new pose
+		void Update(DX::StepTimer const& timer, const float& elapsedSeconds, const UINT& minSampledHeight, PoseCache* poseCache);
 
 		void ReleaseUploadResources();
 		void Release();
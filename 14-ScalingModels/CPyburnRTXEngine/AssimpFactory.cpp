@@ -2,11 +2,66 @@
 #include "AssimpFactory.h"
 
 #include "AssimpAnimations.h"
+#include "ModelCache.h"
+#include "DualQuaternion.h"
 
 namespace CPyburnRTXEngine
 {
 	std::map<UINT, AssimpFactory::Model> AssimpFactory::Models;
 
+	void AssimpFactory::FlattenNodes(const aiNode* node, const UINT& parentIndex)
+	{
+		UINT nodeIndex = static_cast<UINT>(m_nodes.size());
+
+		Node flatNode;
+		flatNode.name = node->mName.data;
+		flatNode.parentIndex = parentIndex;
+		flatNode.transformation = XMFLOAT4X4(node->mTransformation.a1, node->mTransformation.a2, node->mTransformation.a3, node->mTransformation.a4,
+			node->mTransformation.b1, node->mTransformation.b2, node->mTransformation.b3, node->mTransformation.b4,
+			node->mTransformation.c1, node->mTransformation.c2, node->mTransformation.c3, node->mTransformation.c4,
+			node->mTransformation.d1, node->mTransformation.d2, node->mTransformation.d3, node->mTransformation.d4);
+		m_nodes.push_back(std::move(flatNode));
+
+		for (UINT i = 0; i < node->mNumChildren; i++)
+		{
+			FlattenNodes(node->mChildren[i], nodeIndex);
+		}
+	}
+
+	void AssimpFactory::BuildSkeleton()
+	{
+		m_skeleton.Clear();
+
+		// m_nodes is already parent before child, the skeleton keeps that order
+		for (const Node& node : m_nodes)
+		{
+			auto boneIter = m_boneMapping.find(node.name);
+			UINT boneIndex = boneIter != m_boneMapping.end() ? boneIter->second : MAXUINT;
+
+			m_skeleton.AddNode(node.parentIndex, node.transformation, boneIndex, m_bakedAnimation.FindTrack(node.name));
+		}
+	}
+
+	bool AssimpFactory::HasRigidBones() const
+	{
+		// the bind pose in assimp's layout, parent times child
+		std::vector<XMMATRIX> bindGlobals(m_skeleton.GetNodeCount());
+		for (UINT node = 0; node < m_skeleton.GetNodeCount(); node++)
+		{
+			const UINT& parent = m_skeleton.GetParent(node);
+			bindGlobals[node] = parent != MAXUINT ? XMMatrixMultiply(bindGlobals[parent], m_skeleton.GetBindTransform(node)) : m_skeleton.GetBindTransform(node);
+
+			// a uniform scale above the bones cancels against their offsets, anything left over is in every pose
+			const UINT& boneIndex = m_skeleton.GetBoneIndex(node);
+			if (boneIndex != MAXUINT && !DualQuaternion::IsRigid(XMMatrixTranspose(XMMatrixMultiply(bindGlobals[node], m_boneInfo[boneIndex]))))
+			{
+				return false;
+			}
+		}
+
+		return m_bakedAnimation.HasUnitScaling(DualQuaternion::c_rigidTolerance);
+	}
+
 	void AssimpFactory::DoMeshTransforms(aiNode* node, XMMATRIX parentTransform)
 	{
 		XMMATRIX nodeTransform = XMMatrixIdentity();
@@ -379,7 +434,47 @@ namespace CPyburnRTXEngine
 		m_pathDirectory = dir;
 		m_fileName = std::string(fname);
 
-		m_pScene = m_importer.ReadFile(m_pathFileName, customFlags);
+		m_importFlags = customFlags;
+
+		// the cache skips Assimp completely, when it is missing or stale import and write it for next time
+		if (!ModelCache::Load(*this))
+		{
+			ImportWithAssimp();
+
+			// compression needs the skeleton to weigh each joint's error, so it runs before the cache is written
+			if (m_numBones > 0)
+			{
+				BuildSkeleton();
+				m_compressedAnimation.Compress(m_bakedAnimation, m_skeleton, AnimationCompression);
+			}
+
+			ModelCache::Save(*this);
+		}
+		else if (m_numBones > 0)
+		{
+			BuildSkeleton();
+		}
+
+		// dual quaternions drop scale, a model that has any skins with linear blend rather than in the wrong shape
+		if (m_modelPtr->dualQuaternionSkinning && m_numBones > 0 && !HasRigidBones())
+		{
+			DebugTrace("%s has scaled bones, dualQuaternionSkinning is off for it and it skins with linear blend\n", m_fileName.c_str());
+			m_modelPtr->dualQuaternionSkinning = false;
+		}
+
+		if (!CompressAnimations)
+		{
+			m_compressedAnimation = CompressedAnimation{};
+		}
+		else if (!m_compressedAnimation.IsEmpty() && !KeepBakedKeys)
+		{
+			m_bakedAnimation.ReleaseKeys();
+		}
+	}
+
+	void AssimpFactory::ImportWithAssimp()
+	{
+		m_pScene = m_importer.ReadFile(m_pathFileName, m_importFlags);
 
 		if (!m_pScene || m_pScene->mNumMeshes == 0)
 		{
@@ -391,6 +486,7 @@ namespace CPyburnRTXEngine
 
 		m_meshEntries.resize(m_pScene->mNumMeshes);
 		DoMeshTransforms(m_pScene->mRootNode, XMMatrixIdentity());
+		FlattenNodes(m_pScene->mRootNode, MAXUINT);
 
 		for (UINT i = 0; i < m_pScene->mNumMeshes; i++)
 		{
@@ -408,6 +504,15 @@ namespace CPyburnRTXEngine
 				LoadBones(i, paiMesh, m_bones);
 			}
 		}
+
+		if (m_pScene->mNumAnimations > 0)
+		{
+			m_bakedAnimation.Bake(m_pScene->mAnimations[0]);
+		}
+
+		// everything needed later has been copied out, no reason to keep the whole scene around
+		m_importer.FreeScene();
+		m_pScene = nullptr;
 	}
 
 	AssimpFactory::~AssimpFactory()
@@ -426,23 +531,26 @@ namespace CPyburnRTXEngine
 
 	void AssimpFactory::CreateBuffers(ID3D12GraphicsCommandList4* commandList)
 	{
-		m_vertexBuffer.CpuData = m_meshEntries[0].vertices; // todo: index 0 is the first mesh, but the Models map will have the correct mesh to use as the main mesh
-		m_vertexBuffer.CreateOnDefaultHeap(commandList, L"Model Buffer");
-
-		m_indexBuffer.CpuData = m_meshEntries[0].indices;
-		m_indexBuffer.CreateOnDefaultHeap(commandList, L"Index Buffer");
+		// the mesh entries keep their copy, so the buffers upload straight from them and hold nothing on the cpu
+		// todo: index 0 is the first mesh, but the Models map will have the correct mesh to use as the main mesh
+		const MeshEntry& mesh = m_meshEntries[0];
+		m_vertexBuffer.CreateOnDefaultHeap(commandList, BufferSpan<const VSVertices>{ mesh.vertices.data(), static_cast<UINT>(mesh.vertices.size()) }, L"Model Buffer");
+		m_indexBuffer.CreateOnDefaultHeap(commandList, BufferSpan<const UINT>{ mesh.indices.data(), static_cast<UINT>(mesh.indices.size()) }, L"Index Buffer");
 
 		if (m_isSkinned)
 		{
 			m_boneBuffer = std::make_unique<BufferHeap<AssimpFactory::VertexBoneData>>();
 			m_boneBuffer->CreateDeviceDependentResources(m_deviceResources->GetD3DDevice());
-			m_boneBuffer->CpuData = m_bones;
-			m_boneBuffer->CreateOnDefaultHeap(commandList, L"Bone Data Buffer: " + static_cast<WCHAR>(m_modelPtr->modelId));
+			m_boneBuffer->CreateOnDefaultHeap(commandList, BufferSpan<const VertexBoneData>{ m_bones.data(), static_cast<UINT>(m_bones.size()) }, L"Bone Data Buffer: " + static_cast<WCHAR>(m_modelPtr->modelId));
 		}
-		else if (!m_modelPtr->GetBlasPtr()) // no bones
+	}
+
+	void AssimpFactory::CreateStaticBlas(ID3D12GraphicsCommandList4* commandList)
+	{
+		if (!m_isSkinned && !m_modelPtr->GetBlasPtr()) // no bones
 		{
 			m_modelPtr->CreateBlas();
-			m_modelPtr->GetBlasPtr()->InitBlas(m_deviceResources->GetD3DDevice(), static_cast<UINT>(m_meshEntries[0].vertices.size()), m_vertexBuffer.DefaultHeapResource, commandList, m_indexBuffer.DefaultHeapResource, static_cast<UINT>(m_meshEntries[0].indices.size()));
+			m_modelPtr->GetBlasPtr()->InitBlas(m_deviceResources->GetD3DDevice(), static_cast<UINT>(m_meshEntries[0].vertices.size()), m_vertexBuffer.DefaultHeapResource, commandList, m_indexBuffer.DefaultHeapResource, static_cast<UINT>(m_meshEntries[0].indices.size()), &StaticBlasPool);
 			m_modelPtr->GetBlasPtr()->UpdateBlas(commandList);
 		}
 	}
@@ -453,6 +561,20 @@ namespace CPyburnRTXEngine
 		m_indexBuffer.CreateShaderResourceView(false);
 	}
 
+	void AssimpFactory::CreateSkinningShaderResources()
+	{
+		// every entity on this model shares the views, only the first one needs the range
+		if (m_vertexBuffer.HeapIndex == MAXUINT || m_boneBuffer->HeapIndex != m_vertexBuffer.HeapIndex + 1)
+		{
+			GraphicsContexts::DescriptorRange range = GraphicsContexts::AllocateRange(GraphicsContexts::HeapRegion::ModelBuffers, 2);
+			m_vertexBuffer.SetHeapPosition(range.GetIndex(0));
+			m_boneBuffer->SetHeapPosition(range.GetIndex(1));
+		}
+
+		m_vertexBuffer.CreateShaderResourceView(false); // t0
+		m_boneBuffer->CreateShaderResourceView(false); // t1
+	}
+
 	void AssimpFactory::LoadJsonForAllModels()
 	{
 		// see if animations have already been loaded
@@ -473,6 +595,7 @@ namespace CPyburnRTXEngine
 				model.name = v["name"].GetString();
 				model.meshEntryLocation = v["meshEntryLocation"].GetInt();
 				model.contentLocation = v["contentLocation"].GetString();
+				model.dualQuaternionSkinning = v.HasMember("dualQuaternionSkinning") && v["dualQuaternionSkinning"].GetBool();
 
 				const auto& textures = v["textureBaseColorList"];
 				for (auto& tex : textures.GetArray()) {
@@ -517,6 +640,7 @@ namespace CPyburnRTXEngine
 		model.name = (*jsonIt)["name"].GetString();
 		model.meshEntryLocation = (*jsonIt)["meshEntryLocation"].GetInt();
 		model.contentLocation = (*jsonIt)["contentLocation"].GetString();
+		model.dualQuaternionSkinning = jsonIt->HasMember("dualQuaternionSkinning") && (*jsonIt)["dualQuaternionSkinning"].GetBool();
 
 		for (const auto& tex : (*jsonIt)["textureBaseColorList"].GetArray())
 		{
@@ -10,6 +10,9 @@
 #include "BufferHeap.h"
 #include "BufferBlas.h"
 #include "Texture.h"
+#include "BakedAnimation.h"
+#include "CompressedAnimation.h"
+#include "Skeleton.h"
 
 namespace CPyburnRTXEngine
 {
@@ -59,6 +62,7 @@ namespace CPyburnRTXEngine
 			std::vector<Texture::HeapTexture> texturesHeap;
 			std::vector<Texture::HeapTexture> texturesHeapNrm;
 			std::vector<Texture::HeapTexture> texturesHeapOrm;
+			bool dualQuaternionSkinning = false; // Models.json "dualQuaternionSkinning", keeps volume at twisting joints and halves the bone upload, turned off at load for a model with scaled bones
 
 		private:
 			std::unique_ptr<AssimpFactory> assimpFactoryOwner = nullptr; // pointer to the ONE copy of the static model and resources, everything should point here
@@ -81,6 +85,15 @@ namespace CPyburnRTXEngine
 				}
 			}
 
+			std::string GetAssetPath(const std::string& file) const { return "..\\..\\Assets\\Models\\" + contentLocation + file; }
+
+			// the normal and ORM maps sit next to the first base color, e.g. name_NRM.png
+			std::string GetTextureMapName(const std::string& suffix) const
+			{
+				std::string outExtension;
+				return RemoveExtension(textures[0], outExtension) + suffix + "." + outExtension;
+			}
+
 			AssimpFactory* GetAssimpFactoryPtr() { return assimpFactoryOwner.get(); }
 			BufferBlas<AssimpFactory::VSVertices>* GetBlasPtr() { return blasOwner.get(); } // owner but only for static objects, animation/vegitation will have their own blas if they are not static
 
@@ -126,30 +139,12 @@ namespace CPyburnRTXEngine
 			}
 		};
 
-		struct Bone
+		// scene node flattened in depth first order, so a parent always comes before its children
+		struct Node
 		{
-			std::string nodeName;
-			int nodeId = 0;
-			bool hasBoneMapping = false;
-			const aiNodeAnim* pNodeAnim = nullptr;
-			XMMATRIX parentNodeTransformation = XMMatrixIdentity();
-			XMMATRIX globalNodeTransform = XMMatrixIdentity();
-			std::vector<std::unique_ptr<Bone>> children;
-
-			Bone()
-			{
-
-			}
-
-			~Bone()
-			{
-				for (size_t i = 0; i < children.size(); i++)
-				{
-					children[i] = nullptr;
-				}
-
-				children.clear();
-			}
+			std::string name;
+			UINT parentIndex = MAXUINT; // MAXUINT for the root
+			XMFLOAT4X4 transformation; // aiNode::mTransformation as read, a1..d4
 		};
 	private:
 		struct LoadedMaterial
@@ -173,8 +168,14 @@ namespace CPyburnRTXEngine
 		std::string m_fileName;
 		std::string m_pathDirectory;
 
-		const aiScene* m_pScene = nullptr;
+		const aiScene* m_pScene = nullptr; // only valid during ImportWithAssimp, everything kept is copied out of it
 		Assimp::Importer m_importer;
+		unsigned int m_importFlags = 0;
+
+		std::vector<Node> m_nodes;
+		BakedAnimation m_bakedAnimation; // first animation in the file, Animations.json clips are frame ranges of it
+		Skeleton m_skeleton; // built from m_nodes after every load, it is cheap so the cache doesn't store it
+		CompressedAnimation m_compressedAnimation; // what the poses sample when it isn't empty, built once at import and stored in the model cache
 
 		//std::vector<XMFLOAT3> m_positions; // will be used for phsyx later
 		std::string m_textureDiffuse;
@@ -194,6 +195,13 @@ namespace CPyburnRTXEngine
 		
 		XMMATRIX m_boundingSphereRadiusTranslation;
 
+		friend class ModelCache; // fills and saves everything the import would have built
+
+		void ImportWithAssimp();
+		void FlattenNodes(const aiNode* node, const UINT& parentIndex);
+		void BuildSkeleton();
+		// bind pose palette and every scaling key close enough to unit scale for dual quaternion skinning, needs the baked keys
+		bool HasRigidBones() const;
 		void DoMeshTransforms(aiNode* node, XMMATRIX parentTransform);
 		void CreateSingleMeshEntry(const UINT& i, UINT& numVertices, UINT& numIndices, MeshEntry* mesh);
 		void InitializeMesh(const UINT& i, MeshEntry* meshEntry);
@@ -221,6 +229,7 @@ namespace CPyburnRTXEngine
 #else
 
 #endif
+		const BoundingSphere& GetBoundingSphere() { return m_boundingSphere; }
 		const std::vector<AssimpFactory::VertexBoneData>& GetBones() { return m_bones; }
 		const std::unordered_map<std::string, unsigned int>& GetBoneMapping() { return m_boneMapping; }
 		const std::vector<XMMATRIX>& GetBoneInfo() { return m_boneInfo; }
@@ -232,7 +241,15 @@ namespace CPyburnRTXEngine
 		BufferHeap<AssimpFactory::VSVertices>* GetVertexBuffer() { return &m_vertexBuffer; }
 		BufferHeap<UINT>* GetIndexBuffer() { return &m_indexBuffer; }
 		BufferHeap<AssimpFactory::VertexBoneData>* GetBoneBuffer() { return m_boneBuffer.get(); }
-		const aiScene* GetAiScene() { return m_pScene; }
+		const std::vector<Node>& GetNodes() { return m_nodes; }
+		const BakedAnimation& GetBakedAnimation() const { return m_bakedAnimation; }
+		const Skeleton& GetSkeleton() const { return m_skeleton; }
+		const CompressedAnimation& GetCompressedAnimation() const { return m_compressedAnimation; }
+
+		inline static bool CompressAnimations = true; // false samples the baked keys as they were imported
+		inline static bool KeepBakedKeys = false; // the baked keys are dropped once compressed, ModelCache::BakeAll keeps them to report against
+		inline static CompressedAnimation::Settings AnimationCompression;
+		inline static BlasPool StaticBlasPool; // every static model's BLAS once EntitiesManager has compacted them
 
 		AssimpFactory(Model* model, const std::string& fileName,
 			unsigned int customFlags = aiProcess_Triangulate
@@ -248,7 +265,11 @@ namespace CPyburnRTXEngine
 
 		void CreateDeviceDependentResources(DX::DeviceResources* deviceResources);
 		void CreateBuffers(ID3D12GraphicsCommandList4* commandList);
+		// reads the vertex and index buffers, so it is recorded after the staging arena's copies
+		void CreateStaticBlas(ID3D12GraphicsCommandList4* commandList);
 		void CreateShaderResources();
+		// the vertex and bone views from one range, the skinning compute binds them as a single t0-t1 table
+		void CreateSkinningShaderResources();
 
 		static void LoadJsonForAllModels();
 		static AssimpFactory::Model* LoadJsonByModelId(const UINT& id);
@@ -0,0 +1,167 @@
+#include "pchlib.h"
+#include "BakedAnimation.h"
+
+#include <assimp/scene.h>
+
+namespace CPyburnRTXEngine
+{
+	namespace
+	{
+		template <typename Key>
+		void AppendTimes(const Key* keys, const UINT& numKeys, std::vector<float>& times, std::vector<float>& spans)
+		{
+			for (UINT i = 0; i < numKeys; i++)
+			{
+				times.push_back((float)keys[i].mTime);
+				spans.push_back(i + 1 < numKeys ? (float)(keys[i + 1].mTime - keys[i].mTime) : 0.0f);
+			}
+		}
+	}
+
+	void BakedAnimation::Bake(const aiAnimation* animation)
+	{
+		m_ticksPerSecond = (float)(animation->mTicksPerSecond != 0 ? animation->mTicksPerSecond : 25.0f);
+		m_duration = (float)animation->mDuration;
+
+		m_trackNames.resize(animation->mNumChannels);
+		m_tracks.resize(animation->mNumChannels);
+
+		for (UINT i = 0; i < animation->mNumChannels; i++)
+		{
+			const aiNodeAnim* pNodeAnim = animation->mChannels[i];
+			Track& track = m_tracks[i];
+			m_trackNames[i] = pNodeAnim->mNodeName.data;
+
+			track.scaling = KeyRange{ static_cast<UINT>(m_scalingTimes.size()), pNodeAnim->mNumScalingKeys };
+			AppendTimes(pNodeAnim->mScalingKeys, pNodeAnim->mNumScalingKeys, m_scalingTimes, m_scalingSpans);
+			for (UINT key = 0; key < pNodeAnim->mNumScalingKeys; key++)
+			{
+				const aiVector3D& scaling = pNodeAnim->mScalingKeys[key].mValue;
+				m_scalingX.push_back(scaling.x);
+				m_scalingY.push_back(scaling.y);
+				m_scalingZ.push_back(scaling.z);
+			}
+
+			track.rotation = KeyRange{ static_cast<UINT>(m_rotationTimes.size()), pNodeAnim->mNumRotationKeys };
+			AppendTimes(pNodeAnim->mRotationKeys, pNodeAnim->mNumRotationKeys, m_rotationTimes, m_rotationSpans);
+			for (UINT key = 0; key < pNodeAnim->mNumRotationKeys; key++)
+			{
+				const aiQuaternion& rotationQ = pNodeAnim->mRotationKeys[key].mValue;
+				m_rotationX.push_back(rotationQ.x);
+				m_rotationY.push_back(rotationQ.y);
+				m_rotationZ.push_back(rotationQ.z);
+				m_rotationW.push_back(rotationQ.w);
+			}
+
+			track.position = KeyRange{ static_cast<UINT>(m_positionTimes.size()), pNodeAnim->mNumPositionKeys };
+			AppendTimes(pNodeAnim->mPositionKeys, pNodeAnim->mNumPositionKeys, m_positionTimes, m_positionSpans);
+			for (UINT key = 0; key < pNodeAnim->mNumPositionKeys; key++)
+			{
+				const aiVector3D& position = pNodeAnim->mPositionKeys[key].mValue;
+				m_positionX.push_back(position.x);
+				m_positionY.push_back(position.y);
+				m_positionZ.push_back(position.z);
+			}
+		}
+	}
+
+	size_t BakedAnimation::GetMemoryUsage() const
+	{
+		return m_tracks.size() * sizeof(Track)
+			+ (m_scalingTimes.size() + m_scalingSpans.size() + m_scalingX.size() + m_scalingY.size() + m_scalingZ.size()) * sizeof(float)
+			+ (m_rotationTimes.size() + m_rotationSpans.size() + m_rotationX.size() + m_rotationY.size() + m_rotationZ.size() + m_rotationW.size()) * sizeof(float)
+			+ (m_positionTimes.size() + m_positionSpans.size() + m_positionX.size() + m_positionY.size() + m_positionZ.size()) * sizeof(float);
+	}
+
+	void BakedAnimation::ReleaseKeys()
+	{
+		for (std::vector<float>* keys : { &m_scalingTimes, &m_scalingSpans, &m_scalingX, &m_scalingY, &m_scalingZ,
+			&m_rotationTimes, &m_rotationSpans, &m_rotationX, &m_rotationY, &m_rotationZ, &m_rotationW,
+			&m_positionTimes, &m_positionSpans, &m_positionX, &m_positionY, &m_positionZ })
+		{
+			std::vector<float>().swap(*keys);
+		}
+	}
+
+	bool BakedAnimation::HasUnitScaling(const float& tolerance) const
+	{
+		for (const std::vector<float>* keys : { &m_scalingX, &m_scalingY, &m_scalingZ })
+		{
+			for (const float& key : *keys)
+			{
+				if (fabsf(key - 1.0f) > tolerance)
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	UINT BakedAnimation::FindTrack(const std::string& nodeName) const
+	{
+		for (UINT i = 0; i < m_trackNames.size(); i++)
+		{
+			if (m_trackNames[i] == nodeName)
+			{
+				return i;
+			}
+		}
+
+		return MAXUINT;
+	}
+
+	XMVECTOR BakedAnimation::SampleScaling(const float& animationTime, const UINT& track, UINT& cursor) const
+	{
+		const KeyRange& keys = m_tracks[track].scaling;
+		const UINT first = keys.first;
+		if (keys.count == 1)
+		{
+			return XMVectorSet(m_scalingX[first], m_scalingY[first], m_scalingZ[first], 0.0f);
+		}
+
+		const UINT key = first + KeyframeSampler::FindKey(animationTime, &m_scalingTimes[first], keys.count, cursor);
+		const UINT nextKey = key + 1;
+		float factor = (animationTime - m_scalingTimes[key]) / m_scalingSpans[key];
+		XMVECTOR xmStart = XMVectorSet(m_scalingX[key], m_scalingY[key], m_scalingZ[key], 0.0f);
+		XMVECTOR xmEnd = XMVectorSet(m_scalingX[nextKey], m_scalingY[nextKey], m_scalingZ[nextKey], 0.0f);
+		XMVECTOR xmDelta = xmEnd - xmStart;
+		return xmStart + factor * xmDelta;
+	}
+
+	XMVECTOR BakedAnimation::SampleRotation(const float& animationTime, const UINT& track, UINT& cursor) const
+	{
+		const KeyRange& keys = m_tracks[track].rotation;
+		const UINT first = keys.first;
+		if (keys.count == 1)
+		{
+			return XMVectorSet(m_rotationX[first], m_rotationY[first], m_rotationZ[first], m_rotationW[first]);
+		}
+
+		const UINT key = first + KeyframeSampler::FindKey(animationTime, &m_rotationTimes[first], keys.count, cursor);
+		const UINT nextKey = key + 1;
+		float factor = (animationTime - m_rotationTimes[key]) / m_rotationSpans[key];
+		XMVECTOR xmStartRotationQ = XMVectorSet(m_rotationX[key], m_rotationY[key], m_rotationZ[key], m_rotationW[key]);
+		XMVECTOR xmEndRotationQ = XMVectorSet(m_rotationX[nextKey], m_rotationY[nextKey], m_rotationZ[nextKey], m_rotationW[nextKey]);
+		return XMVector4Normalize(XMQuaternionSlerp(xmStartRotationQ, xmEndRotationQ, factor));
+	}
+
+	XMVECTOR BakedAnimation::SamplePosition(const float& animationTime, const UINT& track, UINT& cursor) const
+	{
+		const KeyRange& keys = m_tracks[track].position;
+		const UINT first = keys.first;
+		if (keys.count == 1)
+		{
+			return XMVectorSet(m_positionX[first], m_positionY[first], m_positionZ[first], 0.0f);
+		}
+
+		const UINT key = first + KeyframeSampler::FindKey(animationTime, &m_positionTimes[first], keys.count, cursor);
+		const UINT nextKey = key + 1;
+		float factor = (animationTime - m_positionTimes[key]) / m_positionSpans[key];
+		XMVECTOR xmStart = XMVectorSet(m_positionX[key], m_positionY[key], m_positionZ[key], 0.0f);
+		XMVECTOR xmEnd = XMVectorSet(m_positionX[nextKey], m_positionY[nextKey], m_positionZ[nextKey], 0.0f);
+		XMVECTOR xmDelta = xmEnd - xmStart;
+		return xmStart + factor * xmDelta;
+	}
+}
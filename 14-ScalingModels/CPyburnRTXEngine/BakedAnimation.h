@@ -0,0 +1,79 @@
+#pragma once
+
+#include "pchlib.h"
+#include "KeyframeSampler.h"
+
+struct aiAnimation; // forward declaration
+
+namespace CPyburnRTXEngine
+{
+	// engine owned copy of an aiAnimation, so the aiScene can be freed once the model is loaded
+	// every key component lives in its own float array and a track is a range in them, sampling walks contiguous floats
+	// one per model, shared by every AssimpAnimations of that model and stored in the model cache
+	class BakedAnimation
+	{
+	public:
+		struct KeyRange
+		{
+			UINT first = 0;
+			UINT count = 0;
+		};
+
+		struct Track
+		{
+			KeyRange scaling;
+			KeyRange rotation;
+			KeyRange position;
+		};
+
+	private:
+		float m_ticksPerSecond = 25.0f;
+		float m_duration = 0;
+
+		std::vector<std::string> m_trackNames; // node each track animates, same order as the aiAnimation channels
+		std::vector<Track> m_tracks;
+
+		// span is (float)(next time - time) worked out in double like the aiNodeAnim path did, so poses stay bit for bit the same
+		std::vector<float> m_scalingTimes;
+		std::vector<float> m_scalingSpans;
+		std::vector<float> m_scalingX;
+		std::vector<float> m_scalingY;
+		std::vector<float> m_scalingZ;
+
+		std::vector<float> m_rotationTimes;
+		std::vector<float> m_rotationSpans;
+		std::vector<float> m_rotationX;
+		std::vector<float> m_rotationY;
+		std::vector<float> m_rotationZ;
+		std::vector<float> m_rotationW;
+
+		std::vector<float> m_positionTimes;
+		std::vector<float> m_positionSpans;
+		std::vector<float> m_positionX;
+		std::vector<float> m_positionY;
+		std::vector<float> m_positionZ;
+
+		friend class ModelCache; // saves and loads the arrays as they are
+		friend class CompressedAnimation; // reduces and quantizes the arrays
+
+	public:
+		void Bake(const aiAnimation* animation);
+
+		bool IsEmpty() const { return m_tracks.empty(); }
+		size_t GetMemoryUsage() const;
+		// drops the key arrays once a CompressedAnimation samples in their place, names, ticks and duration stay
+		void ReleaseKeys();
+		// every scaling key within tolerance of 1 on all three axes, what dual quaternion skinning needs since it can't carry scale
+		bool HasUnitScaling(const float& tolerance) const;
+		const float& GetTicksPerSecond() const { return m_ticksPerSecond; }
+		const float& GetDuration() const { return m_duration; }
+		UINT GetTrackCount() const { return static_cast<UINT>(m_tracks.size()); }
+
+		// MAXUINT when the node has no track
+		UINT FindTrack(const std::string& nodeName) const;
+
+		XMVECTOR SampleScaling(const float& animationTime, const UINT& track, UINT& cursor) const;
+		XMVECTOR SampleRotation(const float& animationTime, const UINT& track, UINT& cursor) const;
+		XMVECTOR SamplePosition(const float& animationTime, const UINT& track, UINT& cursor) const;
+	};
+}
@@ -0,0 +1,167 @@
+#include "pchlib.h"
+#include "BlasPool.h"
+
+namespace CPyburnRTXEngine
+{
+	void BlasPool::CreateDeviceDependentResources(DX::DeviceResources* deviceResources)
+	{
+		m_deviceResources = deviceResources;
+		ID3D12Device5* d3dDevice = m_deviceResources->GetD3DDevice();
+
+		const UINT64 sizesBytes = sizeof(UINT64) * c_maxPending;
+
+		auto heapPropertiesDefault = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+		CD3DX12_RESOURCE_DESC sizesDesc = CD3DX12_RESOURCE_DESC::Buffer(sizesBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+		DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(&heapPropertiesDefault, D3D12_HEAP_FLAG_NONE, &sizesDesc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(&m_compactedSizes)));
+		m_compactedSizes->SetName(L"BLAS Compacted Sizes");
+
+		auto heapPropertiesReadback = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
+		CD3DX12_RESOURCE_DESC readbackDesc = CD3DX12_RESOURCE_DESC::Buffer(sizesBytes);
+		DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(&heapPropertiesReadback, D3D12_HEAP_FLAG_NONE, &readbackDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&m_compactedSizesReadback)));
+		m_compactedSizesReadback->SetName(L"BLAS Compacted Sizes Readback");
+	}
+
+	UINT BlasPool::CreateArena(const UINT64& size)
+	{
+		ID3D12Device5* d3dDevice = m_deviceResources->GetD3DDevice();
+
+		const UINT64 alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+		const UINT64 arenaSize = GetArenaSize(size);
+
+		Arena arena;
+
+		D3D12_HEAP_DESC heapDesc = {};
+		heapDesc.SizeInBytes = arenaSize;
+		heapDesc.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+		heapDesc.Alignment = alignment;
+		heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+		DX::ThrowIfFailed(d3dDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&arena.heap)));
+
+		CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(arenaSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+		DX::ThrowIfFailed(d3dDevice->CreatePlacedResource(arena.heap.Get(), 0, &bufferDesc, D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE, nullptr, IID_PPV_ARGS(&arena.buffer)));
+		arena.buffer->SetName(L"BLAS Pool Arena");
+
+		arena.allocator.Reset(arenaSize);
+
+		m_arenas.push_back(std::move(arena));
+		return static_cast<UINT>(m_arenas.size() - 1);
+	}
+
+	bool BlasPool::Allocate(const UINT64& size, Allocation& allocation)
+	{
+		if (size == 0)
+			return false;
+
+		// every arena is tried once, then a new one made for it
+		const UINT arenaCount = static_cast<UINT>(m_arenas.size());
+		for (UINT a = 0; a <= arenaCount; a++)
+		{
+			UINT arenaIndex = a < arenaCount ? a : CreateArena(size);
+			Arena& arena = m_arenas[arenaIndex];
+
+			UINT64 offset = Suballocate(arena.allocator, size);
+			if (offset == RangeAllocator::c_invalidOffset)
+				continue;
+
+			allocation.arena = arenaIndex;
+			allocation.offset = offset;
+			allocation.size = size;
+			allocation.address = arena.buffer->GetGPUVirtualAddress() + offset;
+			return true;
+		}
+
+		return false;
+	}
+
+	bool BlasPool::RequestCompaction(Microsoft::WRL::ComPtr<ID3D12Resource>& source, Microsoft::WRL::ComPtr<ID3D12Resource>& scratch, const UINT64& uncompactedSize, Allocation* target, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC& postbuild)
+	{
+		if (!m_compactedSizes || m_pending.size() >= c_maxPending)
+			return false;
+
+		postbuild.InfoType = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE;
+		postbuild.DestBuffer = m_compactedSizes->GetGPUVirtualAddress() + sizeof(UINT64) * m_pending.size();
+
+		m_pending.push_back(Pending{ std::move(source), std::move(scratch), target, uncompactedSize, &source, &scratch });
+		return true;
+	}
+
+	void BlasPool::Compact()
+	{
+		if (m_pending.empty())
+			return;
+
+		const UINT64 sizesBytes = sizeof(UINT64) * m_pending.size();
+
+		// the sizes are only known once the builds ran
+		{
+			ID3D12GraphicsCommandList4* commandList = m_deviceResources->GetCurrentFrameResource()->ResetCommandList(0, nullptr);
+
+			auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_compactedSizes.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+			commandList->ResourceBarrier(1, &barrier);
+			commandList->CopyBufferRegion(m_compactedSizesReadback.Get(), 0, m_compactedSizes.Get(), 0, sizesBytes);
+			barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_compactedSizes.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+			commandList->ResourceBarrier(1, &barrier);
+
+			DX::ThrowIfFailed(commandList->Close());
+			ID3D12CommandList* ppCommandLists[] = { commandList };
+			m_deviceResources->GetCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+			m_deviceResources->WaitForGpu();
+		}
+
+		std::vector<UINT64> compactedSizes(m_pending.size());
+		{
+			UINT64* mapped = nullptr;
+			CD3DX12_RANGE readRange(0, sizesBytes);
+			DX::ThrowIfFailed(m_compactedSizesReadback->Map(0, &readRange, reinterpret_cast<void**>(&mapped)));
+			memcpy(compactedSizes.data(), mapped, sizesBytes);
+			CD3DX12_RANGE writeRange(0, 0);
+			m_compactedSizesReadback->Unmap(0, &writeRange);
+		}
+
+		{
+			ID3D12GraphicsCommandList4* commandList = m_deviceResources->GetCurrentFrameResource()->ResetCommandList(0, nullptr);
+
+			for (size_t i = 0; i < m_pending.size(); i++)
+			{
+				Pending& pending = m_pending[i];
+				if (!Allocate(compactedSizes[i], *pending.target))
+				{
+					// the build into source already ran, so it is a complete BLAS, just not a compacted one
+					DebugTrace("BlasPool could not place a compacted BLAS of %llu bytes, it keeps its uncompacted result", compactedSizes[i]);
+					*pending.owner = std::move(pending.source);
+					*pending.ownerScratch = std::move(pending.scratch);
+					*pending.target = Allocation{};
+					continue;
+				}
+
+				commandList->CopyRaytracingAccelerationStructure(pending.target->address, pending.source->GetGPUVirtualAddress(), D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT);
+
+				m_uncompactedBytes += pending.uncompactedSize;
+				m_compactedBytes += compactedSizes[i];
+			}
+
+			// every compacted BLAS has to be complete before the first TLAS build reads it
+			D3D12_RESOURCE_BARRIER uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
+			commandList->ResourceBarrier(1, &uavBarrier);
+
+			DX::ThrowIfFailed(commandList->Close());
+			ID3D12CommandList* ppCommandLists[] = { commandList };
+			m_deviceResources->GetCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+			m_deviceResources->WaitForGpu();
+		}
+
+		// the copies are done, so the uncompacted results and their scratch go
+		m_pending.clear();
+
+		DebugTrace("BlasPool %llu bytes of static BLAS compacted into %llu bytes in %u arenas", m_uncompactedBytes, m_compactedBytes, GetArenaCount());
+	}
+
+	void BlasPool::Free(Allocation& allocation)
+	{
+		if (allocation.arena < m_arenas.size())
+		{
+			m_arenas[allocation.arena].allocator.Free(allocation.offset, allocation.size);
+		}
+		allocation = Allocation{};
+	}
+}
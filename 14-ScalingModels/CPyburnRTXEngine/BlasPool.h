@@ -0,0 +1,94 @@
+#pragma once
+
+#include "pchlib.h"
+#include "RangeAllocator.h"
+
+namespace CPyburnRTXEngine
+{
+	// home of every compacted static BLAS, suballocated out of a few large placed buffers instead of a committed result each
+	// a static BLAS is built with ALLOW_COMPACTION into its own temporary result, writes its compacted size into the pool,
+	// and Compact() copies it into an arena and frees the temporary result and scratch
+	class BlasPool
+	{
+	public:
+		struct Allocation
+		{
+			UINT arena = MAXUINT;
+			UINT64 offset = RangeAllocator::c_invalidOffset;
+			UINT64 size = 0;
+			D3D12_GPU_VIRTUAL_ADDRESS address = 0; // 0 until Compact() has moved the BLAS in
+		};
+
+		static constexpr UINT64 c_arenaSize = 32ull * 1024 * 1024; // larger BLASes get an arena of their own size
+
+	private:
+		static constexpr UINT c_maxPending = 4096; // compactions one Compact() can take, past that a BLAS keeps its own result
+
+		struct Arena
+		{
+			Microsoft::WRL::ComPtr<ID3D12Heap> heap;
+			Microsoft::WRL::ComPtr<ID3D12Resource> buffer; // placed over the whole heap, every BLAS in the arena is an offset into it
+			RangeAllocator allocator;
+		};
+
+		struct Pending
+		{
+			Microsoft::WRL::ComPtr<ID3D12Resource> source; // the uncompacted result, freed once copied
+			Microsoft::WRL::ComPtr<ID3D12Resource> scratch;
+			Allocation* target = nullptr;
+			UINT64 uncompactedSize = 0;
+			// where source and scratch came from, they go back there when the compacted copy can't be placed
+			Microsoft::WRL::ComPtr<ID3D12Resource>* owner = nullptr;
+			Microsoft::WRL::ComPtr<ID3D12Resource>* ownerScratch = nullptr;
+		};
+
+		std::vector<Arena> m_arenas;
+		std::vector<Pending> m_pending;
+
+		Microsoft::WRL::ComPtr<ID3D12Resource> m_compactedSizes; // one UINT64 per pending build, written by the builds
+		Microsoft::WRL::ComPtr<ID3D12Resource> m_compactedSizesReadback;
+
+		UINT64 m_uncompactedBytes = 0;
+		UINT64 m_compactedBytes = 0;
+
+		DX::DeviceResources* m_deviceResources = nullptr;
+
+		// Allocate falls back to this when no arena has room
+		UINT CreateArena(const UINT64& size);
+		bool Allocate(const UINT64& size, Allocation& allocation);
+
+	public:
+		BlasPool() = default;
+		~BlasPool() = default;
+
+		BlasPool(const BlasPool&) = delete;
+		BlasPool& operator=(const BlasPool&) = delete;
+
+		void CreateDeviceDependentResources(DX::DeviceResources* deviceResources);
+
+		// called while recording the build, takes the temporary resources and fills postbuild with where the compacted size goes
+		// false when the pool is full, the caller keeps its resources and skips the postbuild info
+		// source and scratch are handed back through the same references if Compact() can't place the BLAS, so they have to outlive it like target
+		bool RequestCompaction(Microsoft::WRL::ComPtr<ID3D12Resource>& source, Microsoft::WRL::ComPtr<ID3D12Resource>& scratch, const UINT64& uncompactedSize, Allocation* target, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC& postbuild);
+
+		// after the command list with the builds has run, reads the sizes back, copies every pending BLAS into an arena and waits for it
+		// a BLAS that can't be placed keeps its uncompacted result, target stays unpooled
+		void Compact();
+
+		void Free(Allocation& allocation);
+
+		// the size of the arena a BLAS opens when none of the others has room
+		static UINT64 GetArenaSize(const UINT64& size)
+		{
+			const UINT64 alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+			return (std::max(size, c_arenaSize) + alignment - 1) & ~(alignment - 1);
+		}
+		// where a compacted BLAS of size goes in one arena, RangeAllocator::c_invalidOffset when it doesn't fit
+		static UINT64 Suballocate(RangeAllocator& allocator, const UINT64& size) { return allocator.Allocate(size, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT); }
+
+		UINT GetArenaCount() const { return static_cast<UINT>(m_arenas.size()); }
+		// what the compacted BLASes would have taken at ResultDataMaxSizeInBytes against what they take now
+		UINT64 GetUncompactedBytes() const { return m_uncompactedBytes; }
+		UINT64 GetCompactedBytes() const { return m_compactedBytes; }
+	};
+}
@@ -0,0 +1,26 @@
+#include "pchlib.h"
+#include "BlasRefitTracker.h"
+
+namespace CPyburnRTXEngine
+{
+	bool BlasRefitTracker::ChooseRebuild(const float& deformation)
+	{
+		// FLT_MAX is checked on its own, a policy with maxDeformation at FLT_MAX would never see it pass
+		m_deformationSinceBuild += deformation;
+		bool rebuild = !m_built || deformation == FLT_MAX || m_refitsSinceBuild >= m_policy.maxRefits || m_deformationSinceBuild > m_policy.maxDeformation;
+
+		if (rebuild)
+		{
+			m_built = true;
+			m_refitsSinceBuild = 0;
+			m_deformationSinceBuild = 0;
+			m_buildCount++;
+		}
+		else
+		{
+			m_refitsSinceBuild++;
+			m_refitCount++;
+		}
+		return rebuild;
+	}
+}
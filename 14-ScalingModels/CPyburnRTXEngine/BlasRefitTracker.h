@@ -0,0 +1,40 @@
+#pragma once
+
+#include "pchlib.h"
+
+namespace CPyburnRTXEngine
+{
+	// decides for a deforming BLAS whether the next build is a refit or a full build, no device so it can be tested on its own
+	// refitting keeps the tree of the last full build and only moves its boxes, cheap but the boxes loosen as the mesh deforms
+	class BlasRefitTracker
+	{
+	public:
+		// deformation is in whatever unit the caller passes to UpdateBlas, for animations it is seconds of pose change
+		// GraphicsContexts reads the defaults from blasMaxRefits and blasMaxDeformation in Graphics.json
+		struct Policy
+		{
+			UINT maxRefits = 30; // full rebuild after this many refits in a row
+			float maxDeformation = 0.5f; // or once the deformation since the last full build passes this
+		};
+
+	private:
+		Policy m_policy;
+		bool m_built = false;
+		UINT m_refitsSinceBuild = 0;
+		float m_deformationSinceBuild = 0;
+		UINT64 m_buildCount = 0;
+		UINT64 m_refitCount = 0;
+
+	public:
+		void SetPolicy(const Policy& policy) { m_policy = policy; }
+		const Policy& GetPolicy() const { return m_policy; }
+		UINT64 GetBuildCount() const { return m_buildCount; }
+		UINT64 GetRefitCount() const { return m_refitCount; }
+		UINT GetRefitsSinceBuild() const { return m_refitsSinceBuild; }
+		float GetDeformationSinceBuild() const { return m_deformationSinceBuild; }
+
+		// true means the next build has to be a full one, counts the build or refit it decides on
+		// the first call and a deformation of FLT_MAX always rebuild, whatever the policy
+		bool ChooseRebuild(const float& deformation);
+	};
+}
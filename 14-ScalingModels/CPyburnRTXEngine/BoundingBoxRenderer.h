@@ -7,18 +7,21 @@ namespace CPyburnRTXEngine
 	class BoundingBoxRenderer: public BoundingBox, public BoundingRendererParent
 	{
 	private:
-		D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView[DX::DeviceResources::c_backBufferCount] = {};
-		D3D12_INDEX_BUFFER_VIEW m_indexBufferView[DX::DeviceResources::c_backBufferCount] = {};
+		// vertices and indices are rewritten every frame, so they live in the upload ring and the views point at this frame's part of it
+		D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView = {};
+		D3D12_INDEX_BUFFER_VIEW m_indexBufferView = {};
 		D3D12_VERTEX_BUFFER_VIEW m_instanceBufferView = {};
 		
-		BufferHeap<BoundingRendererParent::VSVertices> m_vertexBuffer[DX::DeviceResources::c_backBufferCount];
-		BufferHeap<UINT> m_indexBuffer[DX::DeviceResources::c_backBufferCount];
 		BufferHeap<XMMATRIX> m_instanceBuffer;
 
-		UINT m_drawCount = 0;
+		UINT m_maxInstances = 1;
+		UINT m_indexCount = 0;
+		UINT64 m_uploadFrame = MAXUINT64; // the upload ring frame the views were written in
 
-		void FillVertices(const UINT& i, const DirectX::BoundingBox boundingBox);
-		void FillIndices(const UINT& i);
+		void FillVertices(VSVertices* vertices, const UINT& i, const DirectX::BoundingBox boundingBox);
+		void FillIndices(UINT* indices, const UINT& i);
+		// writes count boxes into the upload ring for this frame, nothing is drawn when it is full
+		void Upload(const DirectX::BoundingBox* boundingBoxes, const UINT& count);
 	public:
 		BoundingBoxRenderer();
 		~BoundingBoxRenderer();
@@ -36,8 +36,9 @@ namespace CPyburnRTXEngine
 				vertices[i].position = vertex.Position;
 				vertices[i].color = m_lineColor;
 			}
-			m_vertexBuffer.CpuData = vertices;
+			m_vertexBuffer.SetCpuData(std::move(vertices));
 			m_vertexBuffer.CreateOnDefaultHeap(commandList.Get(), L"Bounding Sphere Vertex Buffer");
+			m_vertexBuffer.ReleaseCpuData();
 
 			m_vertexBufferView.BufferLocation = m_vertexBuffer.DefaultHeapResource->GetGPUVirtualAddress();
 			m_vertexBufferView.StrideInBytes = sizeof(VSVertices);
@@ -47,8 +48,9 @@ namespace CPyburnRTXEngine
 		// index buffer
 		{
 			m_indexBuffer.CreateDeviceDependentResources(deviceResources->GetD3DDevice());
-			m_indexBuffer.CpuData = meshData.Indices32;
+			m_indexBuffer.SetCpuData(std::move(meshData.Indices32));
 			m_indexBuffer.CreateOnDefaultHeap(commandList.Get(), L"Bounding Sphere Index Buffer");
+			m_indexBuffer.ReleaseCpuData();
 
 			m_indexBufferView.BufferLocation = m_indexBuffer.DefaultHeapResource->GetGPUVirtualAddress();
 			m_indexBufferView.SizeInBytes = m_indexBuffer.BufferSize;
@@ -56,27 +58,8 @@ namespace CPyburnRTXEngine
 		}
 
 		// instance buffer (world0 in shader) not a Cbv
-		{
-			// as of right now, the instances should be relatively small < 10000, so use upload heap for updating per frame. Can always benchmark if performance is issue and decide to use default
-			for (UINT i = 0; i < DX::DeviceResources::c_backBufferCount; i++)
-			{
-				m_instanceBuffer[i].CreateDeviceDependentResources(deviceResources->GetD3DDevice());
-				m_instanceBuffer[i].CpuData.resize(maxInstances);
-
-				XMMATRIX transform = XMMatrixIdentity();
-				for (size_t x = 0; x < maxInstances; x++)
-				{
-					m_instanceBuffer[i].CpuData[x] = transform; // testing
-				}
-				
-				m_instanceBuffer[i].CreateOnUploadHeap(L"Bounding Sphere Instance Buffer");
-				m_instanceBuffer[i].CopyCpuDataToUploadHeap();
-
-				m_instanceBufferView[i].BufferLocation = m_instanceBuffer[i].UploadHeapResource->GetGPUVirtualAddress();
-				m_instanceBufferView[i].StrideInBytes = sizeof(XMFLOAT4X4);
-				m_instanceBufferView[i].SizeInBytes = m_instanceBuffer[i].BufferSize;
-			}
-		}
+		// rewritten every frame so it comes from the upload ring, maxInstances only caps how much a frame takes
+		m_maxInstances = maxInstances;
 
 		DX::ThrowIfFailed(commandList->Close());
 		ID3D12CommandList* ppCommandLists[] = { commandList.Get() };
@@ -90,6 +73,26 @@ namespace CPyburnRTXEngine
 		m_indexBuffer.ReleaseUploadResource();
 	}
 
+	void BoundingSphereRenderer::Upload(const XMMATRIX* instances, const UINT& count)
+	{
+		UploadRing& uploadRing = GraphicsContexts::GetUploadRing();
+		UploadRing::Allocation instanceAllocation = uploadRing.Allocate(sizeof(XMMATRIX) * count);
+		if (!instanceAllocation.cpu)
+		{
+			m_instanceCount = 0;
+			return;
+		}
+
+		memcpy(instanceAllocation.cpu, instances, static_cast<size_t>(instanceAllocation.size));
+
+		m_instanceBufferView.BufferLocation = instanceAllocation.gpu;
+		m_instanceBufferView.StrideInBytes = sizeof(XMFLOAT4X4);
+		m_instanceBufferView.SizeInBytes = static_cast<UINT>(instanceAllocation.size);
+
+		m_instanceCount = count;
+		m_uploadFrame = uploadRing.GetFrameCount();
+	}
+
 	void BoundingSphereRenderer::Update(const XMMATRIX& modelTransform, CameraBase* camera, const std::vector<XMMATRIX>* instances, const UINT& begin, const UINT& end)
 	{
 		if (instances)
@@ -109,22 +112,11 @@ namespace CPyburnRTXEngine
 				}
 			}
 
-			size_t capacity = m_instanceBuffer[m_deviceResources->GetCurrentFrameIndex()].CpuData.capacity();
-			size_t count = visibleInstances.size();
-
-			if (count <= capacity)
-			{
-				std::vector<XMMATRIX>& cpuData = m_instanceBuffer[m_deviceResources->GetCurrentFrameIndex()].CpuData;
-				cpuData.resize(count);
-				std::copy(visibleInstances.begin() + begin, visibleInstances.end(), cpuData.begin());
-				m_instanceBuffer[m_deviceResources->GetCurrentFrameIndex()].CopyCpuDataToUploadHeap();
-			}
-			else if (count > capacity)
+			// visibleInstances already starts at begin
+			UINT count = std::min(static_cast<UINT>(visibleInstances.size()), m_maxInstances);
+			if (count > 0)
 			{
-				std::vector<XMMATRIX>& cpuData = m_instanceBuffer[m_deviceResources->GetCurrentFrameIndex()].CpuData;
-				cpuData.resize(capacity);
-				std::copy(visibleInstances.begin() + begin, visibleInstances.begin() + begin + capacity, cpuData.begin());
-				m_instanceBuffer[m_deviceResources->GetCurrentFrameIndex()].CopyCpuDataToUploadHeap();
+				Upload(visibleInstances.data(), count);
 			}
 
 			return;
@@ -136,22 +128,22 @@ namespace CPyburnRTXEngine
 			this->Transform(worldSphere, modelTransform);
 			m_draw = this->Intersects(camera->GetBoundingFrustum());
 
-			m_instanceBuffer[m_deviceResources->GetCurrentFrameIndex()].CpuData[0] = modelTransform;
-			m_instanceBuffer[m_deviceResources->GetCurrentFrameIndex()].CopyCpuDataToUploadHeap();
+			Upload(&modelTransform, 1);
 		}
 	}
 
 	void BoundingSphereRenderer::Render(ID3D12GraphicsCommandList* commandList)
 	{
-		if (!m_draw)
+		// an instance view from an earlier frame points at a partition that has been handed out again
+		if (!m_draw || m_instanceCount == 0 || m_uploadFrame != GraphicsContexts::GetUploadRing().GetFrameCount())
 			return;
 
 		D3D12_VERTEX_BUFFER_VIEW vertexBufferViews[2];
 		vertexBufferViews[0] = m_vertexBufferView;
-		vertexBufferViews[1] = m_instanceBufferView[m_deviceResources->GetCurrentFrameIndex()];
+		vertexBufferViews[1] = m_instanceBufferView;
 
 		commandList->IASetVertexBuffers(0, _countof(vertexBufferViews), &vertexBufferViews[0]);
 		commandList->IASetIndexBuffer(&m_indexBufferView);
-		commandList->DrawIndexedInstanced(static_cast<UINT>(m_indexBuffer.CpuData.size()), static_cast<UINT>(m_instanceBuffer[m_deviceResources->GetCurrentFrameIndex()].CpuData.size()), 0, 0, 0);
+		commandList->DrawIndexedInstanced(m_indexBuffer.ElementCount, m_instanceCount, 0, 0, 0);
 	}
-}
\ No newline at end of file
+}
@@ -9,11 +9,17 @@ namespace CPyburnRTXEngine
 	private:
 		D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView = {};
 		D3D12_INDEX_BUFFER_VIEW m_indexBufferView = {};
-		D3D12_VERTEX_BUFFER_VIEW m_instanceBufferView[DX::DeviceResources::c_backBufferCount] = {};
+		D3D12_VERTEX_BUFFER_VIEW m_instanceBufferView = {}; // this frame's instances in the upload ring
 
 		BufferHeap<BoundingRendererParent::VSVertices> m_vertexBuffer;
 		BufferHeap<UINT> m_indexBuffer;
-		BufferHeap<XMMATRIX> m_instanceBuffer[DX::DeviceResources::c_backBufferCount];
+
+		UINT m_maxInstances = 1;
+		UINT m_instanceCount = 0;
+		UINT64 m_uploadFrame = MAXUINT64; // the upload ring frame the instance view was written in
+
+		// writes count transforms into the upload ring for this frame, nothing is drawn when it is full
+		void Upload(const XMMATRIX* instances, const UINT& count);
 	public:
 		BoundingSphereRenderer();
 		~BoundingSphereRenderer();
@@ -1,16 +1,29 @@
 #pragma once
 
 #include "pchlib.h"
+#include "BlasPool.h"
+#include "BlasRefitTracker.h"
 
 namespace CPyburnRTXEngine
 {
     template<typename T>
     class BufferBlas
     {
+    public:
+        using RefitPolicy = BlasRefitTracker::Policy;
+
     private:
+        BlasRefitTracker m_refitTracker;
+
         Microsoft::WRL::ComPtr<ID3D12Resource> m_scratch;
         Microsoft::WRL::ComPtr<ID3D12Resource> m_result;
 
+        // static BLASes built once and then moved into the pool, m_result and m_scratch go to the pool with the first build
+        // and come back if the pool can't place the compacted copy
+        BlasPool* m_compactionPool = nullptr;
+        BlasPool::Allocation m_pooled;
+        UINT64 m_resultMaxSize = 0;
+
         D3D12_RESOURCE_DESC m_bufDesc = {};
         std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> m_geomDescVector = {};
         D3D12_RAYTRACING_GEOMETRY_DESC m_geomDesc = {};
@@ -19,6 +32,14 @@ namespace CPyburnRTXEngine
 
     public:
         Microsoft::WRL::ComPtr<ID3D12Resource> GetResult() const { return m_result; }
+        // where the TLAS instances point, the pooled copy once compacted
+        D3D12_GPU_VIRTUAL_ADDRESS GetResultAddress() const { return m_pooled.address ? m_pooled.address : m_asDesc.DestAccelerationStructureData; }
+        bool IsPooled() const { return m_pooled.address != 0; }
+
+        void SetRefitPolicy(const RefitPolicy& refitPolicy) { m_refitTracker.SetPolicy(refitPolicy); }
+        const RefitPolicy& GetRefitPolicy() const { return m_refitTracker.GetPolicy(); }
+        UINT64 GetBuildCount() const { return m_refitTracker.GetBuildCount(); }
+        UINT64 GetRefitCount() const { return m_refitTracker.GetRefitCount(); }
 
         BufferBlas()
         {
@@ -30,8 +51,11 @@ namespace CPyburnRTXEngine
             Release();
         }
 
-        void InitBlas(ID3D12Device5* m_d3dDevice, const UINT& count, const Microsoft::WRL::ComPtr<ID3D12Resource> vertexBuffer, ID3D12GraphicsCommandList4* commandList, Microsoft::WRL::ComPtr<ID3D12Resource> indicesBuffer = nullptr, UINT indicesCount = 0)
+        // a compaction pool makes this a static BLAS, built once with ALLOW_COMPACTION and never refit
+        void InitBlas(ID3D12Device5* m_d3dDevice, const UINT& count, const Microsoft::WRL::ComPtr<ID3D12Resource> vertexBuffer, ID3D12GraphicsCommandList4* commandList, Microsoft::WRL::ComPtr<ID3D12Resource> indicesBuffer = nullptr, UINT indicesCount = 0, BlasPool* compactionPool = nullptr)
         {
+            m_compactionPool = compactionPool;
+
             m_bufDesc.Alignment = 0;
             m_bufDesc.DepthOrArraySize = 1;
             m_bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
@@ -65,7 +89,9 @@ namespace CPyburnRTXEngine
             // Get the size requirements for the scratch and AS buffers
             D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs = {};
             inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
-            inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS::D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE;
+            inputs.Flags = m_compactionPool
+                ? D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION | D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE
+                : D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE;
             inputs.NumDescs = static_cast<UINT>(m_geomDescVector.size());
             //inputs.pGeometryDescs = &geomDesc;
             inputs.pGeometryDescs = m_geomDescVector.data();
@@ -75,8 +101,10 @@ namespace CPyburnRTXEngine
             m_d3dDevice->GetRaytracingAccelerationStructurePrebuildInfo(&inputs, &info);
 
             // Create the buffers. They need to support UAV, and since we are going to immediately use them, we create them with an unordered-access state
+            // the scratch is shared by full builds and refits, so it has to fit either
             m_bufDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-            m_bufDesc.Width = info.ScratchDataSizeInBytes;
+            m_bufDesc.Width = std::max(info.ScratchDataSizeInBytes, info.UpdateScratchDataSizeInBytes);
+            m_resultMaxSize = info.ResultDataMaxSizeInBytes;
 
             auto heapPropertiesDefault = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
             if (!m_scratch.Get())
@@ -102,9 +130,39 @@ namespace CPyburnRTXEngine
             m_uavBarrier.UAV.pResource = m_result.Get();
         }
         
-        void UpdateBlas(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList4> commandList)
+        // records a full build or an in place refit without a barrier, for batches that put one barrier after all of their builds
+        // deformation is how far the geometry moved since the last call, FLT_MAX always rebuilds
+        void BuildBlas(ID3D12GraphicsCommandList4* commandList, const float& deformation = FLT_MAX)
+        {
+            // a static BLAS handed to the pool has no result of its own to build into anymore
+            if (m_compactionPool && !m_result)
+                return;
+
+            if (m_refitTracker.ChooseRebuild(deformation))
+            {
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC postbuild = {};
+                if (m_compactionPool && m_compactionPool->RequestCompaction(m_result, m_scratch, m_resultMaxSize, &m_pooled, postbuild))
+                {
+                    commandList->BuildRaytracingAccelerationStructure(&m_asDesc, 1, &postbuild);
+                    return;
+                }
+
+                commandList->BuildRaytracingAccelerationStructure(&m_asDesc, 0, nullptr);
+                return;
+            }
+
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC refitDesc = m_asDesc;
+            refitDesc.Inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+            refitDesc.SourceAccelerationStructureData = m_asDesc.DestAccelerationStructureData;
+            commandList->BuildRaytracingAccelerationStructure(&refitDesc, 0, nullptr);
+        }
+
+        void UpdateBlas(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList4> commandList, const float& deformation = FLT_MAX)
         {
-            commandList->BuildRaytracingAccelerationStructure(&m_asDesc, 0, nullptr);
+            if (m_compactionPool && !m_result)
+                return;
+
+            BuildBlas(commandList.Get(), deformation);
 
             // We need to insert a UAV barrier before using the acceleration structures in a raytracing operation
             commandList->ResourceBarrier(1, &m_uavBarrier);
@@ -24,17 +24,25 @@ namespace CPyburnRTXEngine
         // D3D12 requires 256-byte alignment for CBVs
         static constexpr UINT AlignedSize = (sizeof(T) + 255u) & ~255u;
 
-        // Per-frame descriptor heap positions
-        UINT HeapIndex[DX::DeviceResources::c_backBufferCount]{};
-
-        CD3DX12_CPU_DESCRIPTOR_HANDLE CpuHandle[DX::DeviceResources::c_backBufferCount]{};
-        CD3DX12_GPU_DESCRIPTOR_HANDLE GpuHandle[DX::DeviceResources::c_backBufferCount]{};
-
-        // Upload heap resource
+        // Upload heap resource, one slot per back buffer for when the upload ring has no room
         Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
 
+        // this frame's copy on the upload ring, only good while the ring's frame count is still RingFrame
+        D3D12_GPU_VIRTUAL_ADDRESS RingAddress = 0;
+        UINT64 RingFrame = MAXUINT64;
+
+        // the constants are bound as root CBVs, there are no descriptors for them
+        // a frame that didn't write CpuData uploads it here, the ring copy from an older frame may already be overwritten
         D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddressBuffered(UINT frameIndex)
         {
+            if (RingFrame != GraphicsContexts::GetUploadRing().GetFrameCount())
+            {
+                CopyToGpu(frameIndex);
+            }
+            if (RingFrame == GraphicsContexts::GetUploadRing().GetFrameCount())
+            {
+                return RingAddress;
+            }
             return Resource->GetGPUVirtualAddress() + frameIndex * AlignedSize;
         }
 
@@ -43,17 +51,6 @@ namespace CPyburnRTXEngine
 
         void CreateCbvOnUploadHeap(ID3D12Device* device, const WCHAR* name = L"CBV not named")
         {
-            // make sure descriptor heap is allocated
-            if (HeapIndex[0] == 0)
-            {
-                for (UINT n = 0; n < DX::DeviceResources::c_backBufferCount; n++)
-                {
-                    HeapIndex[n] = GraphicsContexts::GetAvailableHeapPosition();
-                    CpuHandle[n] = CD3DX12_CPU_DESCRIPTOR_HANDLE(GraphicsContexts::GetCpuHandle(HeapIndex[n]));
-                    GpuHandle[n] = CD3DX12_GPU_DESCRIPTOR_HANDLE(GraphicsContexts::GetGpuHandle(HeapIndex[n]));
-                }
-            }
-
             auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
             auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(AlignedSize * DX::DeviceResources::c_backBufferCount);
 
@@ -67,49 +64,38 @@ namespace CPyburnRTXEngine
 
             Resource->SetName(name);
 
-            // Create constant buffer views to access the upload buffer.
-            D3D12_GPU_VIRTUAL_ADDRESS cbvGpuAddress = Resource->GetGPUVirtualAddress();
-
-            for (UINT n = 0; n < DX::DeviceResources::c_backBufferCount; n++)
-            {
-                // Describe and create constant buffer views.
-                D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
-                cbvDesc.BufferLocation = cbvGpuAddress;
-                cbvDesc.SizeInBytes = AlignedSize;
-                device->CreateConstantBufferView(&cbvDesc, CpuHandle[n]);
-
-                cbvGpuAddress += AlignedSize;
-            }
-
             // Map and initialize the constant buffer. We don't unmap this until the
             // app closes. Keeping things mapped for the lifetime of the resource is okay.
             CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
             DX::ThrowIfFailed(Resource->Map(0, &readRange, reinterpret_cast<void**>(&MappedData)));
         }
 
-        // Convenience: write CPU data into mapped memory
+        // Convenience: write CPU data into this frame's upload ring, or the frame's own slot when the ring is full
         void CopyToGpu(UINT frameIndex)
         {
+            UploadRing& uploadRing = GraphicsContexts::GetUploadRing();
+            UploadRing::Allocation allocation = uploadRing.Allocate(AlignedSize, UploadRing::c_constantBufferAlignment);
+            if (allocation.IsValid() && allocation.cpu)
+            {
+                memcpy(allocation.cpu, &CpuData, sizeof(T));
+                RingAddress = allocation.gpu;
+                RingFrame = uploadRing.GetFrameCount();
+                return;
+            }
+
             memcpy(MappedData + AlignedSize * frameIndex, &CpuData, sizeof(T));
+            RingFrame = MAXUINT64;
         }
 
         void Release()
         {
-            // if heap is already been assigned
-            if (HeapIndex[0] > 0)
-            {
-                for (UINT n = 0; n < DX::DeviceResources::c_backBufferCount; n++)
-                {
-                    GraphicsContexts::RemoveHeapPosition(HeapIndex[n]);
-                }
-            }
-
             if (Resource)
             {
                 Resource->Unmap(0, nullptr); // reset should and probably does unmap, but we conver our tracks
                 Resource.Reset();
             }
             MappedData = nullptr;
+            RingFrame = MAXUINT64;
 		}
     };
 }
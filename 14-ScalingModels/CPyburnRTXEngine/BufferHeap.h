@@ -2,18 +2,166 @@
 
 #include "pchlib.h"
 
+#include <atomic>
+
 namespace CPyburnRTXEngine
 {
+    // one frame of BufferHeapStats
+    struct BufferHeapFrameStats
+    {
+        UINT64 resources = 0; // committed resources created
+        UINT64 copies = 0; // vectors copied into CpuData and CpuData copied into upload memory
+        UINT64 bytesCopied = 0;
+    };
+
+    // what every BufferHeap allocated and copied on the cpu, DeviceResources closes a frame in MoveToNextFrame
+    class BufferHeapStats
+    {
+    private:
+        inline static std::atomic<UINT64> m_resources = 0;
+        inline static std::atomic<UINT64> m_copies = 0;
+        inline static std::atomic<UINT64> m_bytesCopied = 0;
+        inline static BufferHeapFrameStats m_lastFrame;
+
+    public:
+        static void AddResource() { m_resources.fetch_add(1, std::memory_order_relaxed); }
+        static void AddCopy(const UINT64& bytes)
+        {
+            m_copies.fetch_add(1, std::memory_order_relaxed);
+            m_bytesCopied.fetch_add(bytes, std::memory_order_relaxed);
+        }
+
+        // the frame that ended becomes GetLastFrame, true when it differs from the one before so a steady state is reported once
+        // DeviceResources shows it in the window title, which Release builds have too
+        static bool EndFrame()
+        {
+            BufferHeapFrameStats frame;
+            frame.resources = m_resources.exchange(0, std::memory_order_relaxed);
+            frame.copies = m_copies.exchange(0, std::memory_order_relaxed);
+            frame.bytesCopied = m_bytesCopied.exchange(0, std::memory_order_relaxed);
+
+            const bool changed = frame.resources != m_lastFrame.resources || frame.copies != m_lastFrame.copies || frame.bytesCopied != m_lastFrame.bytesCopied;
+            m_lastFrame = frame;
+            return changed;
+        }
+
+        static const BufferHeapFrameStats& GetLastFrame() { return m_lastFrame; }
+    };
+
+    // a view over elements somebody else owns, mapped upload memory or a CpuData that outlives it
+    template<typename T>
+    struct BufferSpan
+    {
+        T* data = nullptr;
+        UINT count = 0;
+
+        T& operator[](const size_t& i) const { return data[i]; }
+        T* begin() const { return data; }
+        T* end() const { return data + count; }
+        UINT size() const { return count; }
+        bool empty() const { return count == 0; }
+    };
+
     template<typename T>
     class BufferHeap
     {
     private:
         ID3D12Device5* m_d3dDevice = nullptr;
         UINT m_reserveSizeOfCpuData = 0;
+
+        void CreateUploadResource(const UINT& elementCount, const WCHAR* name)
+        {
+            BufferSize = static_cast<UINT>(sizeof(T) * elementCount);
+            ElementCount = elementCount;
+
+            if (m_reserveSizeOfCpuData == 0)
+            {
+                m_reserveSizeOfCpuData = elementCount;
+            }
+
+            auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+            CD3DX12_RESOURCE_DESC bufferDescModel = CD3DX12_RESOURCE_DESC::Buffer(BufferSize);
+
+            DX::ThrowIfFailed(m_d3dDevice->CreateCommittedResource(
+                &heapProperties,
+                D3D12_HEAP_FLAG_NONE,
+                &bufferDescModel,
+                D3D12_RESOURCE_STATE_GENERIC_READ,
+                nullptr,
+                IID_PPV_ARGS(&UploadHeapResource)));
+            UploadHeapResource->SetName(name);
+            BufferHeapStats::AddResource();
+
+            // Map and initialize the constant buffer. We don't unmap this until the
+            // app closes. Keeping things mapped for the lifetime of the resource is okay.
+            CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
+            DX::ThrowIfFailed(UploadHeapResource->Map(0, &readRange, reinterpret_cast<void**>(&MappedData)));
+        }
+
+        void CreateDefaultResource(ID3D12GraphicsCommandList4* commandList, const T* data, const UINT& elementCount, const WCHAR* name, const D3D12_RESOURCE_FLAGS flags)
+        {
+            if (m_reserveSizeOfCpuData == 0)
+            {
+                m_reserveSizeOfCpuData = elementCount;
+            }
+
+            auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+            CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(static_cast<UINT64>(sizeof(T)) * elementCount, flags);
+
+            DX::ThrowIfFailed(m_d3dDevice->CreateCommittedResource(
+                &heapProperties,
+                D3D12_HEAP_FLAG_NONE,
+                &bufferDesc,
+                D3D12_RESOURCE_STATES::D3D12_RESOURCE_STATE_COMMON,
+                nullptr,
+                IID_PPV_ARGS(&DefaultHeapResource)));
+            DefaultHeapResource->SetName(name);
+            BufferHeapStats::AddResource();
+
+            // during a load phase the data goes into the shared staging arena, which records the copy and its barrier with every other one
+            BufferSize = static_cast<UINT>(sizeof(T) * elementCount);
+            ElementCount = elementCount;
+            if (GraphicsContexts::GetStagingArena().Stage(DefaultHeapResource.Get(), 0, data, BufferSize))
+            {
+                BufferHeapStats::AddCopy(BufferSize);
+                return;
+            }
+
+            std::wstring wname = L"" + std::wstring(name);
+            CreateUploadResource(elementCount, wname.c_str());
+
+            CopyToDefault(commandList, data);
+        }
+
+        // UpdateSubresources copies data into the upload resource while recording, so data only has to live until this returns
+        void CopyToDefault(ID3D12GraphicsCommandList4* commandList, const T* data)
+        {
+            // Upload the buffer to the GPU.
+            {
+                D3D12_SUBRESOURCE_DATA resourceData = {};
+                resourceData.pData = data;
+                resourceData.RowPitch = 0;
+                resourceData.SlicePitch = 0;
+
+                CD3DX12_RESOURCE_BARRIER indexBufferResourceBarrier =
+                    CD3DX12_RESOURCE_BARRIER::Transition(DefaultHeapResource.Get(), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_DEST);
+                commandList->ResourceBarrier(1, &indexBufferResourceBarrier);
+
+                UpdateSubresources(commandList, DefaultHeapResource.Get(), UploadHeapResource.Get(), 0, 0, 1, &resourceData);
+                BufferHeapStats::AddCopy(BufferSize);
+
+                indexBufferResourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(DefaultHeapResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ);
+                commandList->ResourceBarrier(1, &indexBufferResourceBarrier);
+            }
+        }
     public:
         // Per-frame descriptor heap positions
         UINT HeapIndex = MAXUINT;
+        // valid when CreateHeapPosition allocated the slot, invalid for a slot of someone else's range
+        DescriptorAllocator::Handle HeapHandle;
         UINT BufferSize = 0;
+        // elements the resource holds, stays right after CpuData is released
+        UINT ElementCount = 0;
 
         void CreateDeviceDependentResources(ID3D12Device5* d3dDevice)
         {
@@ -24,12 +172,22 @@ namespace CPyburnRTXEngine
         {
             if (HeapIndex == MAXUINT)
             {
-                HeapIndex = GraphicsContexts::GetAvailableHeapPosition();
+                HeapHandle = GraphicsContexts::AllocateDescriptor();
+                HeapIndex = HeapHandle.index;
                 CpuHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(GraphicsContexts::GetCpuHandle(HeapIndex));
                 GpuHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(GraphicsContexts::GetGpuHandle(HeapIndex));
             }
         }
 
+        // takes a slot the caller allocated, one of a range when the view has to sit next to another buffer's
+        void SetHeapPosition(const UINT& heapIndex)
+        {
+            ReleaseHeapPosition();
+            HeapIndex = heapIndex;
+            CpuHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(GraphicsContexts::GetCpuHandle(HeapIndex));
+            GpuHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(GraphicsContexts::GetGpuHandle(HeapIndex));
+        }
+
         void GetNewHeapPosition()
 		{
             ReleaseHeapPosition();
@@ -59,33 +217,39 @@ namespace CPyburnRTXEngine
         // Persistently mapped pointer
         T* MappedData = nullptr;
 
-        void CreateOnUploadHeap(const WCHAR* name = L"Upload buffer not named")
+        // moved in, producers that build a vector for the buffer hand it over instead of copying it
+        void SetCpuData(std::vector<T>&& data)
         {
-            BufferSize = static_cast<UINT>(sizeof(T) * CpuData.size());
+            CpuData = std::move(data);
+        }
 
-            if (m_reserveSizeOfCpuData == 0)
-            {
-                m_reserveSizeOfCpuData = static_cast<UINT>(CpuData.size());
-            }
+        // for data the caller keeps, a copy and counted as one
+        void SetCpuData(const std::vector<T>& data)
+        {
+            CpuData = data;
+            BufferHeapStats::AddCopy(static_cast<UINT64>(sizeof(T)) * data.size());
+        }
 
-            auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-            CD3DX12_RESOURCE_DESC bufferDescModel = CD3DX12_RESOURCE_DESC::Buffer(BufferSize);
+        // static buffers drop their cpu copy once it is on the gpu, ElementCount still has the size
+        void ReleaseCpuData()
+        {
+            std::vector<T>().swap(CpuData);
+        }
 
-            DX::ThrowIfFailed(m_d3dDevice->CreateCommittedResource(
-                &heapProperties,
-                D3D12_HEAP_FLAG_NONE,
-                &bufferDescModel,
-                D3D12_RESOURCE_STATE_GENERIC_READ,
-                nullptr,
-                IID_PPV_ARGS(&UploadHeapResource)));
-            UploadHeapResource->SetName(name);
+        void CreateOnUploadHeap(const WCHAR* name = L"Upload buffer not named")
+        {
+            CreateUploadResource(static_cast<UINT>(CpuData.size()), name);
+        }
 
-            // Map and initialize the constant buffer. We don't unmap this until the
-            // app closes. Keeping things mapped for the lifetime of the resource is okay.
-            CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
-            DX::ThrowIfFailed(UploadHeapResource->Map(0, &readRange, reinterpret_cast<void**>(&MappedData)));
+        // mapped only, CpuData stays empty and producers write through GetMapped
+        void CreateOnUploadHeap(const UINT& elementCount, const WCHAR* name = L"Upload buffer not named")
+        {
+            CreateUploadResource(elementCount, name);
         }
 
+        // the persistently mapped upload memory, written in place with no CpuData copy
+        BufferSpan<T> GetMapped() const { return BufferSpan<T>{ MappedData, MappedData ? ElementCount : 0 }; }
+
         void CopyCpuDataToUploadHeap()
 		{
             if (static_cast<UINT>(CpuData.size()) > m_reserveSizeOfCpuData)
@@ -94,42 +258,24 @@ namespace CPyburnRTXEngine
             }
 
 			memcpy(MappedData, CpuData.data(), BufferSize);
+            BufferHeapStats::AddCopy(BufferSize);
 		}
 
         void CreateOnDefaultHeap(ID3D12GraphicsCommandList4* commandList, const WCHAR* name = L"Default buffer not named", const D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAGS::D3D12_RESOURCE_FLAG_NONE)
         {
-            BufferSize = static_cast<UINT>(sizeof(T) * CpuData.capacity());
-
-            if (m_reserveSizeOfCpuData == 0)
+            // the resource gets the whole capacity, the part past size is value initialized rather than read past the end
+            const UINT capacity = static_cast<UINT>(CpuData.capacity());
+            if (CpuData.size() < capacity)
             {
-                m_reserveSizeOfCpuData = static_cast<UINT>(CpuData.size());
+                CpuData.resize(capacity);
             }
+            CreateDefaultResource(commandList, CpuData.data(), capacity, name, flags);
+        }
 
-            auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-            CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(BufferSize, flags);
-
-            DX::ThrowIfFailed(m_d3dDevice->CreateCommittedResource(
-                &heapProperties,
-                D3D12_HEAP_FLAG_NONE,
-                &bufferDesc,
-                D3D12_RESOURCE_STATES::D3D12_RESOURCE_STATE_COMMON,
-                nullptr,
-                IID_PPV_ARGS(&DefaultHeapResource)));
-            DefaultHeapResource->SetName(name);
-
-            std::wstring wname = L"" + std::wstring(name);
-            CreateOnUploadHeap(wname.c_str());
-
-            CopyUploadToDefault(commandList);
-
-            //// upload goes out of scope if we don't execute the command list and wait for the GPU to finish before exiting the function, so execute and wait here
-            //DX::ThrowIfFailed(commandList->Close());
-            //ID3D12CommandList* ppCommandLists[] = { commandList.Get() };
-            //m_deviceResources->GetCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
-            //m_deviceResources->WaitForGpu();
-
-            //DX::ThrowIfFailed(commandAllocator->Reset());
-            //DX::ThrowIfFailed(commandList->Reset(commandAllocator.Get(), nullptr));
+        // straight from data the caller owns, nothing lands in CpuData
+        void CreateOnDefaultHeap(ID3D12GraphicsCommandList4* commandList, const BufferSpan<const T>& data, const WCHAR* name = L"Default buffer not named", const D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAGS::D3D12_RESOURCE_FLAG_NONE)
+        {
+            CreateDefaultResource(commandList, data.data, data.count, name, flags);
         }
 
         void CreateUnorderedAccessView(const WCHAR* name = L"Upload buffer not named")
@@ -151,7 +297,7 @@ namespace CPyburnRTXEngine
             uav.Format = DXGI_FORMAT_UNKNOWN;
             uav.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
             uav.Buffer.FirstElement = 0;
-            uav.Buffer.NumElements = static_cast<UINT>(CpuData.capacity());
+            uav.Buffer.NumElements = ElementCount;
             uav.Buffer.StructureByteStride = stride;
             uav.Buffer.CounterOffsetInBytes = 0;
             uav.Buffer.Flags = D3D12_BUFFER_UAV_FLAG_NONE;
@@ -166,22 +312,7 @@ namespace CPyburnRTXEngine
                 DebugTrace("BufferHeap CpuData > reserved size");
             }
 
-            // Upload the buffer to the GPU.
-            {
-                D3D12_SUBRESOURCE_DATA resourceData = {};
-                resourceData.pData = &CpuData[0];
-                resourceData.RowPitch = 0;
-                resourceData.SlicePitch = 0;
-
-                CD3DX12_RESOURCE_BARRIER indexBufferResourceBarrier =
-                    CD3DX12_RESOURCE_BARRIER::Transition(DefaultHeapResource.Get(), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_DEST);
-                commandList->ResourceBarrier(1, &indexBufferResourceBarrier);
-
-                UpdateSubresources(commandList, DefaultHeapResource.Get(), UploadHeapResource.Get(), 0, 0, 1, &resourceData);
-
-                indexBufferResourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(DefaultHeapResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ);
-                commandList->ResourceBarrier(1, &indexBufferResourceBarrier);
-            }
+            CopyToDefault(commandList, CpuData.data());
         }
 
         void CreateShaderResourceView(bool useUploadHeap)
@@ -194,7 +325,7 @@ namespace CPyburnRTXEngine
             srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
             srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
             srvDesc.Buffer.StructureByteStride = static_cast < UINT>(sizeof(T)); // your vertex struct size goes here
-            srvDesc.Buffer.NumElements = static_cast<UINT>(CpuData.capacity()); // number of vertices go here
+            srvDesc.Buffer.NumElements = ElementCount; // number of vertices go here
             
             if (useUploadHeap)
             {
@@ -206,11 +337,16 @@ namespace CPyburnRTXEngine
 
         void ReleaseHeapPosition()
 		{
-			if (HeapIndex != MAXUINT)
+			if (HeapHandle.IsValid())
+			{
+				GraphicsContexts::FreeDescriptor(HeapHandle);
+			}
+			else if (HeapIndex != MAXUINT)
 			{
 				GraphicsContexts::RemoveHeapPosition(HeapIndex);
-				HeapIndex = MAXUINT;
 			}
+			HeapHandle = DescriptorAllocator::Handle{};
+			HeapIndex = MAXUINT;
 		}
 
         void ReleaseUploadResource()
@@ -224,10 +360,7 @@ namespace CPyburnRTXEngine
         void Release()
         {
             // if heap is already been assigned
-            if (HeapIndex != MAXUINT)
-            {
-                GraphicsContexts::RemoveHeapPosition(HeapIndex);
-            }
+            ReleaseHeapPosition();
 
 			ReleaseUploadResource();
 
@@ -40,6 +40,8 @@ namespace CPyburnRTXEngine
 	public:
 		const DX::DeviceResources* GetDeviceResources() { return m_deviceResources; }
 		const DirectX::BoundingFrustum& GetBoundingFrustum() { return m_boundingFrustum; }
+		const XMFLOAT3& GetEye() const { return m_eye; }
+		const float& GetFieldOfView() const { return m_fieldOfView; }
 
 		CameraBase();
 		virtual ~CameraBase() = default;
@@ -0,0 +1,358 @@
+#include "pchlib.h"
+#include "CompressedAnimation.h"
+
+namespace CPyburnRTXEngine
+{
+	namespace
+	{
+		constexpr float c_sqrt2 = 1.41421356f;
+		constexpr uint32_t c_rotationComponentMax = 0x7FFF; // 15 bits
+		constexpr float c_vectorComponentMax = 65535.0f; // 16 bits, scalings and positions
+
+		XMVECTOR DequantizeVector(const uint16_t* values, const XMFLOAT3& min, const XMFLOAT3& extent)
+		{
+			XMVECTOR unit = XMVectorSet(values[0], values[1], values[2], 0.0f) / c_vectorComponentMax;
+			return XMVectorMultiplyAdd(unit, XMLoadFloat3(&extent), XMLoadFloat3(&min));
+		}
+
+		// chord between two rotations at the end of an arm, what a vertex that far out actually moves by
+		float RotationError(FXMVECTOR a, FXMVECTOR b, const float& reach)
+		{
+			float cosHalfAngle = std::min(1.0f, fabsf(XMVectorGetX(XMQuaternionDot(a, b))));
+			return 2.0f * reach * sqrtf(1.0f - cosHalfAngle * cosHalfAngle);
+		}
+
+		// keys of one channel to keep, the first and the last always stay
+		// walks forward from the last kept key and keeps the key before the first span that can't rebuild everything it skips
+		// error(a, b, k, factor) is how far key k is from interpolating a and b by factor
+		template<typename Error>
+		std::vector<UINT> ReduceKeys(const UINT& count, const float* times, const float& tolerance, const Error& error)
+		{
+			std::vector<UINT> kept = { 0 };
+			if (count == 1)
+			{
+				return kept;
+			}
+
+			// a channel that never leaves its first key by more than the tolerance only needs that key
+			bool isConstant = true;
+			for (UINT key = 1; key < count && isConstant; key++)
+			{
+				isConstant = error(0, 0, key, 0.0f) <= tolerance;
+			}
+			if (isConstant)
+			{
+				return kept;
+			}
+
+			UINT anchor = 0;
+			for (UINT end = 2; end < count; end++)
+			{
+				const float span = times[end] - times[anchor];
+				for (UINT key = anchor + 1; key < end; key++)
+				{
+					float factor = span > 0.0f ? (times[key] - times[anchor]) / span : 0.0f;
+					if (error(anchor, end, key, factor) > tolerance)
+					{
+						anchor = end - 1;
+						kept.push_back(anchor);
+						break;
+					}
+				}
+			}
+			kept.push_back(count - 1);
+
+			return kept;
+		}
+
+		template<typename Value>
+		BakedAnimation::KeyRange AppendVectorKeys(const std::vector<UINT>& kept, const float* times, const Value& value, std::vector<float>& outTimes, std::vector<uint16_t>& outValues, XMFLOAT3& min, XMFLOAT3& extent)
+		{
+			XMVECTOR minV = value(kept[0]);
+			XMVECTOR maxV = minV;
+			for (const UINT& key : kept)
+			{
+				minV = XMVectorMin(minV, value(key));
+				maxV = XMVectorMax(maxV, value(key));
+			}
+			XMStoreFloat3(&min, minV);
+			XMStoreFloat3(&extent, maxV - minV);
+
+			// a flat component quantizes to 0 and comes back as min
+			XMVECTOR scale = XMVectorSelect(XMVectorReplicate(c_vectorComponentMax) / (maxV - minV), XMVectorZero(), XMVectorEqual(maxV, minV));
+
+			BakedAnimation::KeyRange range{ static_cast<UINT>(outTimes.size()), static_cast<UINT>(kept.size()) };
+			for (const UINT& key : kept)
+			{
+				XMFLOAT3 quantized;
+				XMStoreFloat3(&quantized, XMVectorRound(XMVectorClamp((value(key) - minV) * scale, XMVectorZero(), XMVectorReplicate(c_vectorComponentMax))));
+
+				outTimes.push_back(times[key]);
+				outValues.push_back(static_cast<uint16_t>(quantized.x));
+				outValues.push_back(static_cast<uint16_t>(quantized.y));
+				outValues.push_back(static_cast<uint16_t>(quantized.z));
+			}
+
+			return range;
+		}
+	}
+
+	CompressedAnimation::PackedRotation CompressedAnimation::PackRotation(FXMVECTOR rotationQ)
+	{
+		XMFLOAT4 q;
+		XMStoreFloat4(&q, XMQuaternionNormalize(rotationQ));
+		const float components[4] = { q.x, q.y, q.z, q.w };
+
+		// q and -q are the same rotation, so the largest can always be made positive and rebuilt from the other three
+		UINT largest = 0;
+		for (UINT i = 1; i < 4; i++)
+		{
+			if (fabsf(components[i]) > fabsf(components[largest]))
+			{
+				largest = i;
+			}
+		}
+		const float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+		// the other three are within +-1/sqrt(2)
+		uint64_t packed = largest;
+		for (UINT i = 0; i < 4; i++)
+		{
+			if (i == largest)
+				continue;
+
+			float unit = std::clamp(components[i] * sign * c_sqrt2 * 0.5f + 0.5f, 0.0f, 1.0f);
+			packed = (packed << 15) | static_cast<uint64_t>(lroundf(unit * c_rotationComponentMax));
+		}
+
+		PackedRotation rotation;
+		rotation.bits[0] = static_cast<uint16_t>(packed >> 32);
+		rotation.bits[1] = static_cast<uint16_t>(packed >> 16);
+		rotation.bits[2] = static_cast<uint16_t>(packed);
+		return rotation;
+	}
+
+	XMVECTOR CompressedAnimation::UnpackRotation(const PackedRotation& rotation)
+	{
+		uint64_t packed = (static_cast<uint64_t>(rotation.bits[0]) << 32) | (static_cast<uint64_t>(rotation.bits[1]) << 16) | rotation.bits[2];
+		const UINT largest = static_cast<UINT>(packed >> 45) & 3;
+
+		// packed in ascending order, so the last component is in the lowest bits
+		float components[4] = {};
+		float sumOfSquares = 0.0f;
+		for (int i = 3; i >= 0; i--)
+		{
+			if (static_cast<UINT>(i) == largest)
+				continue;
+
+			float unit = static_cast<float>(packed & c_rotationComponentMax) / c_rotationComponentMax;
+			packed >>= 15;
+			components[i] = (unit * 2.0f - 1.0f) / c_sqrt2;
+			sumOfSquares += components[i] * components[i];
+		}
+		components[largest] = sqrtf(std::max(0.0f, 1.0f - sumOfSquares));
+
+		return XMVectorSet(components[0], components[1], components[2], components[3]);
+	}
+
+	std::vector<float> CompressedAnimation::ComputeReaches(const Skeleton& skeleton, const UINT& trackCount, const float& shellDistance, float& extent)
+	{
+		const UINT nodeCount = skeleton.GetNodeCount();
+
+		// bind pose in model space, parents come first so one pass is enough
+		std::vector<XMMATRIX> globals(nodeCount);
+		std::vector<XMFLOAT3> positions(nodeCount);
+		extent = 0.0f;
+		for (UINT node = 0; node < nodeCount; node++)
+		{
+			const UINT& parent = skeleton.GetParent(node);
+			globals[node] = parent != MAXUINT ? XMMatrixMultiply(globals[parent], skeleton.GetBindTransform(node)) : skeleton.GetBindTransform(node);
+
+			// node transforms are assimp's column vector layout, the translation is the last column
+			XMFLOAT4X4 global;
+			XMStoreFloat4x4(&global, globals[node]);
+			positions[node] = XMFLOAT3(global._14, global._24, global._34);
+			extent = std::max(extent, XMVectorGetX(XMVector3Length(XMLoadFloat3(&positions[node]))));
+		}
+		if (extent <= 0.0f)
+		{
+			extent = 1.0f;
+		}
+
+		// every node pushes its distance up to all of its ancestors
+		std::vector<float> nodeReaches(nodeCount, 0.0f);
+		for (UINT node = 0; node < nodeCount; node++)
+		{
+			XMVECTOR position = XMLoadFloat3(&positions[node]);
+			for (UINT ancestor = skeleton.GetParent(node); ancestor != MAXUINT; ancestor = skeleton.GetParent(ancestor))
+			{
+				float distance = XMVectorGetX(XMVector3Length(position - XMLoadFloat3(&positions[ancestor])));
+				nodeReaches[ancestor] = std::max(nodeReaches[ancestor], distance);
+			}
+		}
+
+		const float shell = shellDistance * extent;
+		std::vector<float> reaches(trackCount, shell);
+		for (UINT node = 0; node < nodeCount; node++)
+		{
+			const UINT& track = skeleton.GetAnimationTrack(node);
+			if (track != MAXUINT && track < trackCount)
+			{
+				reaches[track] = nodeReaches[node] + shell;
+			}
+		}
+
+		return reaches;
+	}
+
+	void CompressedAnimation::Compress(const BakedAnimation& source, const Skeleton& skeleton, const Settings& settings)
+	{
+		*this = CompressedAnimation{};
+
+		const UINT trackCount = source.GetTrackCount();
+		if (trackCount == 0)
+		{
+			return;
+		}
+
+		float extent = 0.0f;
+		std::vector<float> reaches = ComputeReaches(skeleton, trackCount, settings.shellDistance, extent);
+		const float tolerance = settings.maxError * extent;
+
+		m_tracks.resize(trackCount);
+		for (UINT i = 0; i < trackCount; i++)
+		{
+			const BakedAnimation::Track& sourceTrack = source.m_tracks[i];
+			Track& track = m_tracks[i];
+			const float& reach = reaches[i];
+
+			// a scaling error stretches everything below the joint
+			{
+				const UINT first = sourceTrack.scaling.first;
+				auto value = [&source, first](const UINT& key) { return XMVectorSet(source.m_scalingX[first + key], source.m_scalingY[first + key], source.m_scalingZ[first + key], 0.0f); };
+				std::vector<UINT> kept = ReduceKeys(sourceTrack.scaling.count, &source.m_scalingTimes[first], tolerance, [&value, &reach](const UINT& a, const UINT& b, const UINT& key, const float& factor)
+					{
+						return XMVectorGetX(XMVector3Length(XMVectorLerp(value(a), value(b), factor) - value(key))) * reach;
+					});
+				track.scaling = AppendVectorKeys(kept, &source.m_scalingTimes[first], value, m_scalingTimes, m_scalingValues, track.scalingMin, track.scalingExtent);
+			}
+
+			// rebuilt the way SampleRotation does it, slerp and normalize
+			{
+				const UINT first = sourceTrack.rotation.first;
+				auto value = [&source, first](const UINT& key) { return XMVectorSet(source.m_rotationX[first + key], source.m_rotationY[first + key], source.m_rotationZ[first + key], source.m_rotationW[first + key]); };
+				std::vector<UINT> kept = ReduceKeys(sourceTrack.rotation.count, &source.m_rotationTimes[first], tolerance, [&value, &reach](const UINT& a, const UINT& b, const UINT& key, const float& factor)
+					{
+						return RotationError(XMVector4Normalize(XMQuaternionSlerp(value(a), value(b), factor)), value(key), reach);
+					});
+
+				track.rotation = BakedAnimation::KeyRange{ static_cast<UINT>(m_rotationTimes.size()), static_cast<UINT>(kept.size()) };
+				for (const UINT& key : kept)
+				{
+					m_rotationTimes.push_back(source.m_rotationTimes[first + key]);
+					m_rotations.push_back(PackRotation(value(key)));
+				}
+			}
+
+			// a position error moves everything below the joint by the same amount
+			{
+				const UINT first = sourceTrack.position.first;
+				auto value = [&source, first](const UINT& key) { return XMVectorSet(source.m_positionX[first + key], source.m_positionY[first + key], source.m_positionZ[first + key], 0.0f); };
+				std::vector<UINT> kept = ReduceKeys(sourceTrack.position.count, &source.m_positionTimes[first], tolerance, [&value](const UINT& a, const UINT& b, const UINT& key, const float& factor)
+					{
+						return XMVectorGetX(XMVector3Length(XMVectorLerp(value(a), value(b), factor) - value(key)));
+					});
+				track.position = AppendVectorKeys(kept, &source.m_positionTimes[first], value, m_positionTimes, m_positionValues, track.positionMin, track.positionExtent);
+			}
+		}
+	}
+
+	size_t CompressedAnimation::GetMemoryUsage() const
+	{
+		return m_tracks.size() * sizeof(Track)
+			+ (m_scalingTimes.size() + m_rotationTimes.size() + m_positionTimes.size()) * sizeof(float)
+			+ (m_scalingValues.size() + m_positionValues.size()) * sizeof(uint16_t)
+			+ m_rotations.size() * sizeof(PackedRotation);
+	}
+
+	float CompressedAnimation::MeasureMaxError(const BakedAnimation& source, const Skeleton& skeleton, const float& startTime, const float& endTime, const Settings& settings) const
+	{
+		const UINT trackCount = GetTrackCount();
+		float extent = 0.0f;
+		std::vector<float> reaches = ComputeReaches(skeleton, trackCount, settings.shellDistance, extent);
+
+		std::vector<KeyframeCursor> sourceCursors(trackCount);
+		std::vector<KeyframeCursor> cursors(trackCount);
+
+		// half a tick lands on every key and halfway between them, where a dropped key shows the most
+		float maxError = 0.0f;
+		for (float time = startTime; time <= endTime; time += 0.5f)
+		{
+			for (UINT track = 0; track < trackCount; track++)
+			{
+				const float& reach = reaches[track];
+
+				XMVECTOR scalingError = source.SampleScaling(time, track, sourceCursors[track].scaling) - SampleScaling(time, track, cursors[track].scaling);
+				maxError = std::max(maxError, XMVectorGetX(XMVector3Length(scalingError)) * reach);
+
+				maxError = std::max(maxError, RotationError(source.SampleRotation(time, track, sourceCursors[track].rotation), SampleRotation(time, track, cursors[track].rotation), reach));
+
+				XMVECTOR positionError = source.SamplePosition(time, track, sourceCursors[track].position) - SamplePosition(time, track, cursors[track].position);
+				maxError = std::max(maxError, XMVectorGetX(XMVector3Length(positionError)));
+			}
+		}
+
+		return maxError;
+	}
+
+	XMVECTOR CompressedAnimation::SampleScaling(const float& animationTime, const UINT& track, UINT& cursor) const
+	{
+		const Track& compressedTrack = m_tracks[track];
+		const BakedAnimation::KeyRange& keys = compressedTrack.scaling;
+		const UINT first = keys.first;
+		if (keys.count == 1)
+		{
+			return DequantizeVector(&m_scalingValues[first * 3], compressedTrack.scalingMin, compressedTrack.scalingExtent);
+		}
+
+		const UINT key = first + KeyframeSampler::FindKey(animationTime, &m_scalingTimes[first], keys.count, cursor);
+		const UINT nextKey = key + 1;
+		float factor = (animationTime - m_scalingTimes[key]) / (m_scalingTimes[nextKey] - m_scalingTimes[key]);
+		XMVECTOR xmStart = DequantizeVector(&m_scalingValues[key * 3], compressedTrack.scalingMin, compressedTrack.scalingExtent);
+		XMVECTOR xmEnd = DequantizeVector(&m_scalingValues[nextKey * 3], compressedTrack.scalingMin, compressedTrack.scalingExtent);
+		return XMVectorLerp(xmStart, xmEnd, factor);
+	}
+
+	XMVECTOR CompressedAnimation::SampleRotation(const float& animationTime, const UINT& track, UINT& cursor) const
+	{
+		const BakedAnimation::KeyRange& keys = m_tracks[track].rotation;
+		const UINT first = keys.first;
+		if (keys.count == 1)
+		{
+			return UnpackRotation(m_rotations[first]);
+		}
+
+		const UINT key = first + KeyframeSampler::FindKey(animationTime, &m_rotationTimes[first], keys.count, cursor);
+		const UINT nextKey = key + 1;
+		float factor = (animationTime - m_rotationTimes[key]) / (m_rotationTimes[nextKey] - m_rotationTimes[key]);
+		return XMVector4Normalize(XMQuaternionSlerp(UnpackRotation(m_rotations[key]), UnpackRotation(m_rotations[nextKey]), factor));
+	}
+
+	XMVECTOR CompressedAnimation::SamplePosition(const float& animationTime, const UINT& track, UINT& cursor) const
+	{
+		const Track& compressedTrack = m_tracks[track];
+		const BakedAnimation::KeyRange& keys = compressedTrack.position;
+		const UINT first = keys.first;
+		if (keys.count == 1)
+		{
+			return DequantizeVector(&m_positionValues[first * 3], compressedTrack.positionMin, compressedTrack.positionExtent);
+		}
+
+		const UINT key = first + KeyframeSampler::FindKey(animationTime, &m_positionTimes[first], keys.count, cursor);
+		const UINT nextKey = key + 1;
+		float factor = (animationTime - m_positionTimes[key]) / (m_positionTimes[nextKey] - m_positionTimes[key]);
+		XMVECTOR xmStart = DequantizeVector(&m_positionValues[key * 3], compressedTrack.positionMin, compressedTrack.positionExtent);
+		XMVECTOR xmEnd = DequantizeVector(&m_positionValues[nextKey * 3], compressedTrack.positionMin, compressedTrack.positionExtent);
+		return XMVectorLerp(xmStart, xmEnd, factor);
+	}
+}
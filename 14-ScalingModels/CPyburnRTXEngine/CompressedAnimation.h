@@ -0,0 +1,71 @@
+#pragma once
+
+#include "pchlib.h"
+#include "BakedAnimation.h"
+#include "Skeleton.h"
+
+namespace CPyburnRTXEngine
+{
+	// lossy copy of a BakedAnimation that samples the same way with the same track indices
+	// keys that interpolation can rebuild within the error budget are dropped, rotations are packed smallest three into 48 bits,
+	// scalings and positions are 16 bits per component inside the track's own range
+	// the error budget is a distance in model space, a joint's error is scaled by how far its farthest descendant reaches
+	class CompressedAnimation
+	{
+	public:
+		struct Settings
+		{
+			float maxError = 0.001f; // fraction of the bind pose extent of the skeleton
+			float shellDistance = 0.05f; // fraction of the extent, the reach a leaf gets so its skin still counts
+		};
+
+		struct PackedRotation
+		{
+			uint16_t bits[3] = {}; // 2 bits for the dropped component, then the other three at 15 bits each
+		};
+
+		struct Track
+		{
+			BakedAnimation::KeyRange scaling;
+			BakedAnimation::KeyRange rotation;
+			BakedAnimation::KeyRange position;
+			XMFLOAT3 scalingMin = {};
+			XMFLOAT3 scalingExtent = {};
+			XMFLOAT3 positionMin = {};
+			XMFLOAT3 positionExtent = {};
+		};
+
+	private:
+		std::vector<Track> m_tracks; // same order as the BakedAnimation tracks, so Skeleton's track indices work on both
+
+		std::vector<float> m_scalingTimes;
+		std::vector<uint16_t> m_scalingValues; // 3 per key
+		std::vector<float> m_rotationTimes;
+		std::vector<PackedRotation> m_rotations;
+		std::vector<float> m_positionTimes;
+		std::vector<uint16_t> m_positionValues; // 3 per key
+
+		friend class ModelCache; // saves and loads the arrays as they are
+
+		// per track, how far from its joint an error reaches, and the skeleton's bind pose extent
+		static std::vector<float> ComputeReaches(const Skeleton& skeleton, const UINT& trackCount, const float& shellDistance, float& extent);
+
+	public:
+		// smallest three, the largest component is dropped and rebuilt, q and -q come back the same
+		static PackedRotation PackRotation(FXMVECTOR rotationQ);
+		static XMVECTOR UnpackRotation(const PackedRotation& rotation);
+
+		void Compress(const BakedAnimation& source, const Skeleton& skeleton, const Settings& settings = Settings{});
+
+		bool IsEmpty() const { return m_tracks.empty(); }
+		UINT GetTrackCount() const { return static_cast<UINT>(m_tracks.size()); }
+		size_t GetMemoryUsage() const;
+
+		// largest model space error against source over [startTime, endTime] in ticks, used for the per clip reports
+		float MeasureMaxError(const BakedAnimation& source, const Skeleton& skeleton, const float& startTime, const float& endTime, const Settings& settings = Settings{}) const;
+
+		XMVECTOR SampleScaling(const float& animationTime, const UINT& track, UINT& cursor) const;
+		XMVECTOR SampleRotation(const float& animationTime, const UINT& track, UINT& cursor) const;
+		XMVECTOR SamplePosition(const float& animationTime, const UINT& track, UINT& cursor) const;
+	};
+}
@@ -0,0 +1,228 @@
+#include "pchlib.h"
+#include "CpuSkinning.h"
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#include <immintrin.h>
+#define CPYBURN_SKINNING_X86
+#endif
+
+namespace CPyburnRTXEngine
+{
+	namespace
+	{
+		// the palette is row vector, a point goes in on the left: out[c] = sum over r of in[r] * m[r][c]
+		void TransformScalar(const float* m, const XMFLOAT3& in, const float& w, float out[3])
+		{
+			for (UINT c = 0; c < 3; c++)
+			{
+				out[c] = in.x * m[c] + in.y * m[4 + c] + in.z * m[8 + c] + w * m[12 + c];
+			}
+		}
+
+		XMFLOAT3 NormalizeScalar(const float v[3])
+		{
+			float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+			float scale = length > 0.0f ? 1.0f / length : 0.0f;
+			return XMFLOAT3(v[0] * scale, v[1] * scale, v[2] * scale);
+		}
+
+		void StoreSkinned(const AssimpFactory::VSVertices& vertex, const XMMATRIX& blended, AssimpFactory::VSVertices& outVertex)
+		{
+			XMStoreFloat3(&outVertex.position, XMVector3Transform(XMLoadFloat3(&vertex.position), blended));
+			XMStoreFloat3(&outVertex.normal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&vertex.normal), blended)));
+			XMStoreFloat3(&outVertex.tangent, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&vertex.tangent), blended)));
+			outVertex.texture = vertex.texture;
+		}
+	}
+
+	CpuSkinning::Path CpuSkinning::GetBestPath()
+	{
+		static const Path bestPath = []()
+			{
+#ifdef CPYBURN_SKINNING_X86
+				int info[4] = {};
+				__cpuid(info, 0);
+				const int maxLeaf = info[0];
+
+				__cpuid(info, 1);
+				const bool hasFma = (info[2] & (1 << 12)) != 0;
+				const bool hasOsXsave = (info[2] & (1 << 27)) != 0;
+				const bool hasAvx = (info[2] & (1 << 28)) != 0;
+
+				// the os has to save the ymm registers on a context switch too
+				bool osSavesYmm = hasOsXsave && (_xgetbv(0) & 0x6) == 0x6;
+
+				bool hasAvx2 = false;
+				if (maxLeaf >= 7)
+				{
+					__cpuidex(info, 7, 0);
+					hasAvx2 = (info[1] & (1 << 5)) != 0;
+				}
+
+				if (hasAvx && hasAvx2 && hasFma && osSavesYmm)
+				{
+					return Path::Avx2;
+				}
+#endif
+				return Path::Simd;
+			}();
+
+		return bestPath;
+	}
+
+	void CpuSkinning::SkinScalar(const AssimpFactory::VSVertices* baseVertices, const AssimpFactory::VertexBoneData* boneData, const XMMATRIX* bones, AssimpFactory::VSVertices* outVertices, const UINT& begin, const UINT& end)
+	{
+		for (UINT v = begin; v < end; v++)
+		{
+			const AssimpFactory::VSVertices& vertex = baseVertices[v];
+			const AssimpFactory::VertexBoneData& influences = boneData[v];
+
+			// each influence transforms the vertex and the results are weighted, the order the compute shader adds them in
+			float position[3] = {};
+			float normal[3] = {};
+			float tangent[3] = {};
+			for (UINT i = 0; i < 4; i++)
+			{
+				const float* m = reinterpret_cast<const float*>(&bones[influences.IDs[i]]);
+				const float& weight = influences.Weights[i];
+
+				float transformed[3];
+				TransformScalar(m, vertex.position, 1.0f, transformed);
+				for (UINT c = 0; c < 3; c++)
+					position[c] += transformed[c] * weight;
+
+				TransformScalar(m, vertex.normal, 0.0f, transformed);
+				for (UINT c = 0; c < 3; c++)
+					normal[c] += transformed[c] * weight;
+
+				TransformScalar(m, vertex.tangent, 0.0f, transformed);
+				for (UINT c = 0; c < 3; c++)
+					tangent[c] += transformed[c] * weight;
+			}
+
+			AssimpFactory::VSVertices& outVertex = outVertices[v];
+			outVertex.position = XMFLOAT3(position[0], position[1], position[2]);
+			outVertex.normal = NormalizeScalar(normal);
+			outVertex.tangent = NormalizeScalar(tangent);
+			outVertex.texture = vertex.texture;
+		}
+	}
+
+	void CpuSkinning::SkinSimd(const AssimpFactory::VSVertices* baseVertices, const AssimpFactory::VertexBoneData* boneData, const XMMATRIX* bones, AssimpFactory::VSVertices* outVertices, const UINT& begin, const UINT& end)
+	{
+		for (UINT v = begin; v < end; v++)
+		{
+			const AssimpFactory::VertexBoneData& influences = boneData[v];
+
+			// skinning is linear, so blending the four matrices once is the same as blending four transformed vertices three times
+			XMMATRIX blended = bones[influences.IDs[0]] * influences.Weights[0];
+			for (UINT i = 1; i < 4; i++)
+			{
+				const XMMATRIX& m = bones[influences.IDs[i]];
+				XMVECTOR weight = XMVectorReplicate(influences.Weights[i]);
+				blended.r[0] = XMVectorMultiplyAdd(m.r[0], weight, blended.r[0]);
+				blended.r[1] = XMVectorMultiplyAdd(m.r[1], weight, blended.r[1]);
+				blended.r[2] = XMVectorMultiplyAdd(m.r[2], weight, blended.r[2]);
+				blended.r[3] = XMVectorMultiplyAdd(m.r[3], weight, blended.r[3]);
+			}
+
+			StoreSkinned(baseVertices[v], blended, outVertices[v]);
+		}
+	}
+
+	void CpuSkinning::SkinAvx2(const AssimpFactory::VSVertices* baseVertices, const AssimpFactory::VertexBoneData* boneData, const XMMATRIX* bones, AssimpFactory::VSVertices* outVertices, const UINT& begin, const UINT& end)
+	{
+#ifdef CPYBURN_SKINNING_X86
+		for (UINT v = begin; v < end; v++)
+		{
+			const AssimpFactory::VertexBoneData& influences = boneData[v];
+
+			// rows 0 and 1 in one register, rows 2 and 3 in the other, half the multiply adds of the 128 bit blend
+			__m256 rows01 = _mm256_setzero_ps();
+			__m256 rows23 = _mm256_setzero_ps();
+			for (UINT i = 0; i < 4; i++)
+			{
+				const float* m = reinterpret_cast<const float*>(&bones[influences.IDs[i]]);
+				__m256 weight = _mm256_set1_ps(influences.Weights[i]);
+				rows01 = _mm256_fmadd_ps(_mm256_loadu_ps(m), weight, rows01);
+				rows23 = _mm256_fmadd_ps(_mm256_loadu_ps(m + 8), weight, rows23);
+			}
+
+			XMMATRIX blended;
+			blended.r[0] = _mm256_castps256_ps128(rows01);
+			blended.r[1] = _mm256_extractf128_ps(rows01, 1);
+			blended.r[2] = _mm256_castps256_ps128(rows23);
+			blended.r[3] = _mm256_extractf128_ps(rows23, 1);
+
+			StoreSkinned(baseVertices[v], blended, outVertices[v]);
+		}
+
+		// leaving 256 bit code, avoids the transition penalty in the SSE code that follows
+		_mm256_zeroupper();
+#else
+		SkinSimd(baseVertices, boneData, bones, outVertices, begin, end);
+#endif
+	}
+
+	void CpuSkinning::Skin(const Path& path, const AssimpFactory::VSVertices* baseVertices, const AssimpFactory::VertexBoneData* boneData, const XMMATRIX* bones, AssimpFactory::VSVertices* outVertices, const UINT& begin, const UINT& end)
+	{
+		switch (path)
+		{
+		case Path::Scalar:
+			SkinScalar(baseVertices, boneData, bones, outVertices, begin, end);
+			break;
+		case Path::Avx2:
+			SkinAvx2(baseVertices, boneData, bones, outVertices, begin, end);
+			break;
+		default:
+			SkinSimd(baseVertices, boneData, bones, outVertices, begin, end);
+			break;
+		}
+	}
+
+	void CpuSkinning::SkinDualQuaternion(const AssimpFactory::VSVertices* baseVertices, const AssimpFactory::VertexBoneData* boneData, const DualQuaternion* bones, AssimpFactory::VSVertices* outVertices, const UINT& begin, const UINT& end)
+	{
+		for (UINT v = begin; v < end; v++)
+		{
+			const AssimpFactory::VSVertices& vertex = baseVertices[v];
+			const AssimpFactory::VertexBoneData& influences = boneData[v];
+
+			XMVECTOR firstReal = XMLoadFloat4(&bones[influences.IDs[0]].real);
+			XMVECTOR real = XMVectorZero();
+			XMVECTOR dual = XMVectorZero();
+			for (UINT i = 0; i < 4; i++)
+			{
+				const DualQuaternion& bone = bones[influences.IDs[i]];
+				XMVECTOR boneReal = XMLoadFloat4(&bone.real);
+
+				// q and -q are the same rotation, blending across the two would take the long way round
+				float weight = XMVectorGetX(XMVector4Dot(boneReal, firstReal)) < 0.0f ? -influences.Weights[i] : influences.Weights[i];
+				real += boneReal * weight;
+				dual += XMLoadFloat4(&bone.dual) * weight;
+			}
+			DualQuaternion::Normalize(real, dual);
+
+			AssimpFactory::VSVertices& outVertex = outVertices[v];
+			XMStoreFloat3(&outVertex.position, DualQuaternion::TransformPoint(XMLoadFloat3(&vertex.position), real, dual));
+			XMStoreFloat3(&outVertex.normal, XMVector3Normalize(XMVector3Rotate(XMLoadFloat3(&vertex.normal), real)));
+			XMStoreFloat3(&outVertex.tangent, XMVector3Normalize(XMVector3Rotate(XMLoadFloat3(&vertex.tangent), real)));
+			outVertex.texture = vertex.texture;
+		}
+	}
+
+	float CpuSkinning::MaxDifference(const AssimpFactory::VSVertices* a, const AssimpFactory::VSVertices* b, const UINT& count)
+	{
+		XMVECTOR maxDifference = XMVectorZero();
+		for (UINT v = 0; v < count; v++)
+		{
+			maxDifference = XMVectorMax(maxDifference, XMVectorAbs(XMLoadFloat3(&a[v].position) - XMLoadFloat3(&b[v].position)));
+			maxDifference = XMVectorMax(maxDifference, XMVectorAbs(XMLoadFloat3(&a[v].normal) - XMLoadFloat3(&b[v].normal)));
+			maxDifference = XMVectorMax(maxDifference, XMVectorAbs(XMLoadFloat3(&a[v].tangent) - XMLoadFloat3(&b[v].tangent)));
+		}
+
+		XMFLOAT3 difference;
+		XMStoreFloat3(&difference, maxDifference);
+		return std::max({ difference.x, difference.y, difference.z });
+	}
+}
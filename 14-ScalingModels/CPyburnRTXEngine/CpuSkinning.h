@@ -0,0 +1,42 @@
+#pragma once
+
+#include "pchlib.h"
+#include "AssimpFactory.h"
+#include "DualQuaternion.h"
+
+namespace CPyburnRTXEngine
+{
+	// the same four influence skinning skinnedCompute.hlsl does, on the cpu
+	// the scalar path is the reference the others and the compute shader are checked against, the others are for when there is no gpu to do it
+	// bones is the palette exactly as AnimationCompute uploads it
+	class CpuSkinning
+	{
+	public:
+		enum class Path
+		{
+			Scalar, // plain float math, no SIMD at all
+			Simd, // DirectXMath, SSE on x86 and x64
+			Avx2, // the four bone matrices are blended two rows per 256 bit register with FMA
+		};
+
+	private:
+		static void SkinScalar(const AssimpFactory::VSVertices* baseVertices, const AssimpFactory::VertexBoneData* boneData, const XMMATRIX* bones, AssimpFactory::VSVertices* outVertices, const UINT& begin, const UINT& end);
+		static void SkinSimd(const AssimpFactory::VSVertices* baseVertices, const AssimpFactory::VertexBoneData* boneData, const XMMATRIX* bones, AssimpFactory::VSVertices* outVertices, const UINT& begin, const UINT& end);
+		static void SkinAvx2(const AssimpFactory::VSVertices* baseVertices, const AssimpFactory::VertexBoneData* boneData, const XMMATRIX* bones, AssimpFactory::VSVertices* outVertices, const UINT& begin, const UINT& end);
+
+	public:
+		// the fastest path this cpu and os support, checked once
+		static Path GetBestPath();
+
+		// skins [begin, end) so a JobSystem::ParallelFor can split one mesh, position, normal and tangent are skinned and the texture coordinates copied
+		static void Skin(const Path& path, const AssimpFactory::VSVertices* baseVertices, const AssimpFactory::VertexBoneData* boneData, const XMMATRIX* bones, AssimpFactory::VSVertices* outVertices, const UINT& begin, const UINT& end);
+
+		// the dual quaternion palette a model with dualQuaternionSkinning uploads instead, the reference for its compute kernels
+		// with rigid bones a vertex on a single bone lands on Skin within float precision, so MaxDifference between the two checks the conversion
+		// blends of different rotations differ on purpose, that is the volume linear blending loses
+		static void SkinDualQuaternion(const AssimpFactory::VSVertices* baseVertices, const AssimpFactory::VertexBoneData* boneData, const DualQuaternion* bones, AssimpFactory::VSVertices* outVertices, const UINT& begin, const UINT& end);
+
+		// largest difference of any position, normal or tangent component, for checking one path or a compute shader read back against another
+		static float MaxDifference(const AssimpFactory::VSVertices* a, const AssimpFactory::VSVertices* b, const UINT& count);
+	};
+}
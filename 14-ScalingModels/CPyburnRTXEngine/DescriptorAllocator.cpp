@@ -0,0 +1,135 @@
+#include "pchlib.h"
+#include "DescriptorAllocator.h"
+
+namespace CPyburnRTXEngine
+{
+	void DescriptorAllocator::Reset(const UINT& capacity)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_capacity = capacity;
+		m_next = 0;
+		m_liveCount = 0;
+		m_resetCount++;
+
+		m_free.clear();
+		m_retired.clear();
+
+		// generations carry on so a handle from before the reset can't match a slot after it
+		m_generations.resize(capacity, 0);
+		for (UINT& generation : m_generations)
+		{
+			generation++;
+		}
+		m_live.assign(capacity, 0);
+	}
+
+	void DescriptorAllocator::Grow(const UINT& capacity)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (capacity <= m_capacity)
+			return;
+
+		m_capacity = capacity;
+		m_generations.resize(capacity, 0);
+		m_live.resize(capacity, 0);
+	}
+
+	DescriptorAllocator::Handle DescriptorAllocator::AllocateLocked()
+	{
+		UINT index = MAXUINT;
+		if (!m_free.empty())
+		{
+			index = m_free.back();
+			m_free.pop_back();
+		}
+		else if (m_next < m_capacity)
+		{
+			index = m_next++;
+		}
+		else
+		{
+			return Handle{};
+		}
+
+		m_live[index] = 1;
+		m_liveCount++;
+		return Handle{ index, m_generations[index] };
+	}
+
+	DescriptorAllocator::Handle DescriptorAllocator::Allocate()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return AllocateLocked();
+	}
+
+	UINT DescriptorAllocator::AllocateBatch(Handle* handles, const UINT& count)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		UINT allocated = 0;
+		for (; allocated < count; allocated++)
+		{
+			handles[allocated] = AllocateLocked();
+			if (!handles[allocated].IsValid())
+				break;
+		}
+		return allocated;
+	}
+
+	bool DescriptorAllocator::Free(const Handle& handle, const UINT64& fenceValue)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (handle.index >= m_capacity || !m_live[handle.index] || m_generations[handle.index] != handle.generation)
+			return false;
+
+		m_live[handle.index] = 0;
+		m_generations[handle.index]++;
+		m_liveCount--;
+		m_retired.push_back(Retired{ handle.index, fenceValue });
+		return true;
+	}
+
+	UINT DescriptorAllocator::Return(const Handle* handles, const UINT& count)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		UINT returned = 0;
+		for (UINT i = 0; i < count; i++)
+		{
+			const Handle& handle = handles[i];
+			if (handle.index >= m_capacity || !m_live[handle.index] || m_generations[handle.index] != handle.generation)
+				continue;
+
+			m_live[handle.index] = 0;
+			m_generations[handle.index]++;
+			m_liveCount--;
+			m_free.push_back(handle.index);
+			returned++;
+		}
+		return returned;
+	}
+
+	UINT DescriptorAllocator::Reclaim(const UINT64& completedFenceValue)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		size_t reclaimed = 0;
+		while (reclaimed < m_retired.size() && m_retired[reclaimed].fenceValue <= completedFenceValue)
+		{
+			m_free.push_back(m_retired[reclaimed].index);
+			reclaimed++;
+		}
+		m_retired.erase(m_retired.begin(), m_retired.begin() + reclaimed);
+
+		return static_cast<UINT>(reclaimed);
+	}
+
+	bool DescriptorAllocator::IsAlive(const Handle& handle) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return handle.index < m_capacity && m_live[handle.index] && m_generations[handle.index] == handle.generation;
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "pchlib.h"
+
+namespace CPyburnRTXEngine
+{
+	// hands out slots of a descriptor heap, knows nothing about the heap itself so it works without a device
+	// a freed slot is retired with the fence value of the frame that freed it and only goes back on the free list once that fence completes,
+	// so a slot the gpu can still read is never handed out again
+	// every slot carries a generation that moves on when it is freed, a handle from before that is stale
+	class DescriptorAllocator
+	{
+	public:
+		struct Handle
+		{
+			UINT index = MAXUINT;
+			UINT generation = 0;
+
+			bool IsValid() const { return index != MAXUINT; }
+		};
+
+	private:
+		struct Retired
+		{
+			UINT index = MAXUINT;
+			UINT64 fenceValue = 0;
+		};
+
+		UINT m_capacity = 0;
+		UINT m_next = 0; // every slot from here on has never been handed out
+		UINT m_liveCount = 0;
+		UINT m_resetCount = 0;
+
+		std::vector<UINT> m_free; // reclaimed slots, reused before new ones
+		std::vector<UINT> m_generations;
+		std::vector<UINT8> m_live;
+		std::vector<Retired> m_retired; // in fence order, fences only go up
+
+		mutable std::mutex m_mutex;
+
+		Handle AllocateLocked();
+
+	public:
+		DescriptorAllocator() = default;
+		explicit DescriptorAllocator(const UINT& capacity) { Reset(capacity); }
+
+		DescriptorAllocator(const DescriptorAllocator&) = delete;
+		DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+		// forgets every slot, handles from before are all stale
+		void Reset(const UINT& capacity);
+		// more slots at the end, what is already handed out stays where it is
+		void Grow(const UINT& capacity);
+
+		// an invalid handle when the heap is full
+		Handle Allocate();
+		// up to count handles under one lock, lowest slot first, returns how many it got
+		UINT AllocateBatch(Handle* handles, const UINT& count);
+
+		// false for a stale handle, a slot freed twice or never handed out
+		bool Free(const Handle& handle, const UINT64& fenceValue);
+		// handles that were allocated but never given to the gpu go straight back on the free list, returns how many were live
+		UINT Return(const Handle* handles, const UINT& count);
+
+		// every slot retired at or before completedFenceValue goes back on the free list, returns how many
+		UINT Reclaim(const UINT64& completedFenceValue);
+
+		bool IsAlive(const Handle& handle) const;
+
+		UINT GetCapacity() const { return m_capacity; }
+		UINT GetLiveCount() const { std::lock_guard<std::mutex> lock(m_mutex); return m_liveCount; }
+		UINT GetRetiredCount() const { std::lock_guard<std::mutex> lock(m_mutex); return static_cast<UINT>(m_retired.size()); }
+		// how far into the heap slots were ever handed out, the most the heap has needed at once
+		UINT GetHighWaterMark() const { std::lock_guard<std::mutex> lock(m_mutex); return m_next; }
+		// changes on Reset, per thread caches drop what they hold when it does
+		UINT GetResetCount() const { return m_resetCount; }
+	};
+}
@@ -4,6 +4,7 @@
 
 #include "pchlib.h"
 #include "DeviceResources.h"
+#include "BufferHeap.h"
 
 using namespace DirectX;
 using namespace DX;
@@ -93,6 +94,15 @@ DeviceResources::~DeviceResources()
 {
     // Ensure that the GPU is no longer referencing resources that are about to be destroyed.
     WaitForGpu();
+
+    if (m_srvheapIntermediateRenderTargetHandle.IsValid())
+    {
+        GraphicsContexts::FreeDescriptor(m_srvheapIntermediateRenderTargetHandle);
+    }
+    if (m_depthSrvHandle.IsValid())
+    {
+        GraphicsContexts::FreeDescriptor(m_depthSrvHandle);
+    }
 }
 
 // Configures the Direct3D device, and stores handles to it and the device context.
@@ -275,6 +285,8 @@ void DeviceResources::CreateDeviceResources()
 
     // Create device dependent resources for graphics contexts
     GraphicsContexts::CreateDeviceDependentResources(m_d3dDevice.Get());
+    GraphicsContexts::ReclaimHeapPositions(m_fence->GetCompletedValue(), m_fenceValues[m_backBufferIndex]);
+    GraphicsContexts::GetUploadRing().BeginFrame(m_backBufferIndex, m_fence->GetCompletedValue(), m_fenceValues[m_backBufferIndex]);
     GraphicsContexts::CreateRootSignaturesAndPipelines(this);
 
 #pragma region Fullscreen
@@ -380,9 +392,11 @@ void DeviceResources::CreateDeviceResources()
     // Reserve heap position for the post-process SRV.
     {
         m_rtvHeapIntermediateRenderTargetPosition = DeviceResources::c_backBufferCount; // RTV right after the swap chain RTVs. There shouldnt be a lot of RTVs in an engine, so we can keep track of these
-        m_srvheapIntermediateRenderTargetPosition = GraphicsContexts::GetAvailableHeapPosition(); // SRV in the heap
+        m_srvheapIntermediateRenderTargetHandle = GraphicsContexts::AllocateDescriptor(); // SRV in the heap
+        m_srvheapIntermediateRenderTargetPosition = m_srvheapIntermediateRenderTargetHandle.index;
         m_intermediateSrvHandleGpu = CD3DX12_GPU_DESCRIPTOR_HANDLE(GraphicsContexts::c_heap->GetGPUDescriptorHandleForHeapStart(), m_srvheapIntermediateRenderTargetPosition, GraphicsContexts::c_descriptorSize);
-        m_depthSrvPosition = GraphicsContexts::GetAvailableHeapPosition();
+        m_depthSrvHandle = GraphicsContexts::AllocateDescriptor();
+        m_depthSrvPosition = m_depthSrvHandle.index;
     }
 
     // Create/update the fullscreen quad vertex buffer.
@@ -770,6 +784,10 @@ void DeviceResources::WaitForGpu() noexcept
 
                 // Increment the fence value for the current frame.
                 m_fenceValues[m_backBufferIndex]++;
+
+                // the gpu is idle, every retired descriptor slot and staging chunk can be reused
+                GraphicsContexts::ReclaimHeapPositions(fenceValue, m_fenceValues[m_backBufferIndex]);
+                GraphicsContexts::GetStagingArena().Reclaim(fenceValue);
             }
         }
     }
@@ -794,6 +812,17 @@ void DeviceResources::MoveToNextFrame()
 
     // Set the fence value for the next frame.
     m_fenceValues[m_backBufferIndex] = currentFenceValue + 1;
+
+    // descriptor slots freed while recording the next frame wait for its fence
+    GraphicsContexts::ReclaimHeapPositions(m_fence->GetCompletedValue(), m_fenceValues[m_backBufferIndex]);
+    // and so does everything it writes to the upload ring
+    GraphicsContexts::GetUploadRing().BeginFrame(m_backBufferIndex, m_fence->GetCompletedValue(), m_fenceValues[m_backBufferIndex]);
+    GraphicsContexts::GetStagingArena().Reclaim(m_fence->GetCompletedValue());
+
+    if (BufferHeapStats::EndFrame())
+    {
+        UpdateTitle();
+    }
 }
 
 // This method acquires the first available hardware adapter that supports Direct3D 12.
@@ -1151,8 +1180,11 @@ void DeviceResources::LoadSceneResolutionDependentResources()
 void DeviceResources::UpdateTitle() noexcept
 {
     // Update resolutions shown in app title.
+    // the last frame's BufferHeap allocations and copies go with them, so they can be read in a Release build
+    const BufferHeapFrameStats& bufferHeapFrame = BufferHeapStats::GetLastFrame();
     wchar_t updatedTitle[256];
-    swprintf_s(updatedTitle, L"( %u x %u ) scaled to ( %u x %u )\n", m_resolutionOptions[m_resolutionIndex].Width, m_resolutionOptions[m_resolutionIndex].Height, m_outputSize.right, m_outputSize.bottom);
+    swprintf_s(updatedTitle, L"( %u x %u ) scaled to ( %u x %u ) BufferHeap frame: %llu resources, %llu copies, %llu bytes copied\n", m_resolutionOptions[m_resolutionIndex].Width, m_resolutionOptions[m_resolutionIndex].Height, m_outputSize.right, m_outputSize.bottom,
+        bufferHeapFrame.resources, bufferHeapFrame.copies, bufferHeapFrame.bytesCopied);
     DebugTrace(updatedTitle);
 
     SetWindowText(m_window, updatedTitle);
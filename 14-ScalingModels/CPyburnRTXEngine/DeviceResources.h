@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "DescriptorAllocator.h"
+
 namespace CPyburnRTXEngine
 {
     class FrameResource; // forward declaration
@@ -135,8 +137,10 @@ namespace DX
         UINT m_rtvHeapIntermediateRenderTargetPosition = 0;
         CD3DX12_CPU_DESCRIPTOR_HANDLE m_rtvHeapIntermediateRenderTargetHandleCpu;
         UINT m_srvheapIntermediateRenderTargetPosition = MAXUINT;
+        CPyburnRTXEngine::DescriptorAllocator::Handle m_srvheapIntermediateRenderTargetHandle;
         CD3DX12_GPU_DESCRIPTOR_HANDLE m_intermediateSrvHandleGpu;
         UINT m_depthSrvPosition = MAXUINT;
+        CPyburnRTXEngine::DescriptorAllocator::Handle m_depthSrvHandle;
         CD3DX12_GPU_DESCRIPTOR_HANDLE m_depthSrvHandleGpu;
 
         Microsoft::WRL::ComPtr<ID3D12PipelineState> m_postPipelineState;
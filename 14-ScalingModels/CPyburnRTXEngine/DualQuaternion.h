@@ -0,0 +1,61 @@
+#pragma once
+
+#include "pchlib.h"
+
+namespace CPyburnRTXEngine
+{
+	// rigid bone transform as a unit dual quaternion, half the size of a palette matrix and blends without the candy wrapper
+	// quaternions are xyzw and products are Hamilton, the same rotation DirectXMath's XMVector3Rotate does
+	// scale can't be stored, AssimpFactory puts a model with scaled bones back on linear blend skinning at load
+	struct DualQuaternion
+	{
+		XMFLOAT4 real = { 0.0f, 0.0f, 0.0f, 1.0f }; // rotation
+		XMFLOAT4 dual = { 0.0f, 0.0f, 0.0f, 0.0f }; // half the translation times the rotation
+
+		// a pose composed from interpolated keys is a little off unit scale, a scaled bone is off by far more
+		static constexpr float c_rigidTolerance = 0.01f;
+
+		// bone is a palette matrix as it goes to the gpu, a row vector transform whose scale is dropped
+		static DualQuaternion FromMatrix(const XMMATRIX& bone)
+		{
+			XMVECTOR scale, rotation, translation;
+			if (!XMMatrixDecompose(&scale, &rotation, &translation, bone))
+			{
+				rotation = XMQuaternionIdentity();
+				translation = bone.r[3];
+			}
+
+			// XMQuaternionMultiply(a, b) is the Hamilton product b * a
+			XMVECTOR dual = XMQuaternionMultiply(rotation, XMVectorSetW(translation, 0.0f)) * 0.5f;
+
+			DualQuaternion result;
+			XMStoreFloat4(&result.real, rotation);
+			XMStoreFloat4(&result.dual, dual);
+			return result;
+		}
+
+		// rows 0 to 2 unit length and the determinant 1, anything FromMatrix can convert without dropping scale or a mirror
+		static bool IsRigid(const XMMATRIX& bone, const float& tolerance = c_rigidTolerance)
+		{
+			XMVECTOR lengths = XMVectorSet(XMVectorGetX(XMVector3Length(bone.r[0])), XMVectorGetX(XMVector3Length(bone.r[1])), XMVectorGetX(XMVector3Length(bone.r[2])), XMVectorGetX(XMMatrixDeterminant(bone)));
+			return XMVector4NearEqual(lengths, XMVectorSplatOne(), XMVectorReplicate(tolerance));
+		}
+
+		// real and dual of an unnormalized blend, divided by the real length so the result is a rigid transform again
+		static void Normalize(XMVECTOR& real, XMVECTOR& dual)
+		{
+			XMVECTOR length = XMVector4Length(real);
+			real = XMVectorDivide(real, length);
+			dual = XMVectorDivide(dual, length);
+		}
+
+		// the point rotated by real, then moved by 2 * dual * conjugate(real)
+		static XMVECTOR TransformPoint(const XMVECTOR& point, const XMVECTOR& real, const XMVECTOR& dual)
+		{
+			XMVECTOR translation = XMQuaternionMultiply(XMQuaternionConjugate(real), dual) * 2.0f;
+			return XMVector3Rotate(point, real) + XMVectorSetW(translation, 0.0f);
+		}
+	};
+
+	static_assert(sizeof(DualQuaternion) == 32, "the compute shaders read 32 byte dual quaternions");
+}
@@ -3,32 +3,132 @@
 
 #include "Entity.h"
 
+#include <unordered_set>
+
 namespace CPyburnRTXEngine
 {
 	std::unordered_map<UINT, Entity> EntitiesManager::LoadedEntities;
+	std::vector<Entity*> EntitiesManager::m_entitiesBySlot;
+	std::vector<EntitiesManager::BatchEntry> EntitiesManager::m_batchEntryBySlot;
+	std::vector<UINT> EntitiesManager::m_animatedSlots;
 
 	std::unordered_map<UINT, size_t> EntitiesManager::m_batchIndexByModelIdStatic;
 	std::vector<EntitiesManager::Batch> EntitiesManager::m_visibleBatchesStatic;
 
-	void EntitiesManager::AddVisible(Entity* entity, AssimpFactory::Model* model, UINT modelId, const XMMATRIX& world)
+	std::vector<AssimpFactory::Model*> EntitiesManager::ImportAssets()
 	{
-		if (entity->GetAssimpFactoryModel()->GetAssimpFactoryPtr()->IsSkinned())
-			return;
+		// collect every unique model the entities use and every texture RtxScene::CreateBuffers will ask for
+		std::vector<AssimpFactory::Model*> models;
+		for (auto& loadedEntity : EntitiesManager::LoadedEntities)
+		{
+			const UINT& modelId = loadedEntity.second.GetEntityDescriptionCurrentState()->GetProperties()->GetModelId();
+
+			auto it = AssimpFactory::Models.find(modelId);
+			if (it != AssimpFactory::Models.end() && !it->second.GetAssimpFactoryPtr() && std::find(models.begin(), models.end(), &it->second) == models.end())
+			{
+				models.push_back(&it->second);
+			}
+		}
+
+		std::vector<std::string> texturePaths;
+		auto addTexturePath = [&texturePaths](const std::string& path)
+			{
+				if (std::find(texturePaths.begin(), texturePaths.end(), path) == texturePaths.end())
+				{
+					texturePaths.push_back(path);
+				}
+			};
+
+		for (auto& unorderedModel : AssimpFactory::Models)
+		{
+			const AssimpFactory::Model& model = unorderedModel.second;
+			if (model.textures.empty())
+				continue;
+
+			for (const std::string& texture : model.textures)
+			{
+				addTexturePath(model.GetAssetPath(texture));
+			}
+			addTexturePath(model.GetAssetPath(model.GetTextureMapName("_NRM")));
+			addTexturePath(model.GetAssetPath(model.GetTextureMapName("_ORM")));
+		}
+
+		// one job per asset so the load takes as long as the slowest one instead of all of them added up
+		// an import only writes its own factory and a decode only creates resources, the heap positions are handed out later in RtxScene::CreateBuffers
+		const UINT modelCount = static_cast<UINT>(models.size());
+		const UINT assetCount = modelCount + static_cast<UINT>(texturePaths.size());
+		m_jobSystem.ParallelFor(assetCount, 1, [&models, &texturePaths, modelCount](UINT begin, UINT end)
+			{
+				for (UINT i = begin; i < end; i++)
+				{
+					if (i < modelCount)
+					{
+						AssimpFactory::Model* model = models[i];
+						model->CreateAssimpFactory(model->GetAssetPath(model->name));
+					}
+					else
+					{
+						Texture::PrefetchTexture(texturePaths[i - modelCount]);
+					}
+				}
+			});
+
+		return models;
+	}
 
-		auto [it, inserted] = m_batchIndexByModelIdStatic.try_emplace(modelId, m_visibleBatchesStatic.size());
+	void EntitiesManager::BuildBatches()
+	{
+		m_batchIndexByModelIdStatic.clear();
+		m_visibleBatchesStatic.clear();
+		m_batchEntryBySlot.assign(Transforms.GetCount(), BatchEntry{});
+		m_animatedSlots.clear();
+		m_instanceCountStatic = 0;
 
-		if (inserted)
+		for (UINT slot = 0; slot < Transforms.GetCount(); slot++)
 		{
-			m_visibleBatchesStatic.push_back(Batch{ model, {} });
-			m_visibleBatchesStatic.back().instances.reserve(64);
-			m_visibleBatchesStatic.back().instanceIndices.reserve(64);
+			Entity* entity = m_entitiesBySlot[slot];
+
+			if (entity->GetAssimpAnimations())
+			{
+				m_animatedSlots.push_back(slot);
+			}
+
+			AssimpFactory* factory = entity->GetAssimpFactoryModel()->GetAssimpFactoryPtr();
+			Transforms.SetLocalBounds(Transforms.GetIdBySlot(slot), factory->GetBoundingSphere()); // culling needs the model loaded too
+
+			if (factory->IsSkinned())
+				continue;
+
+			AssimpFactory::Model* model = factory->GetModel();
+			auto [it, inserted] = m_batchIndexByModelIdStatic.try_emplace(model->modelId, m_visibleBatchesStatic.size());
+
+			if (inserted)
+			{
+				m_visibleBatchesStatic.push_back(Batch{ model, {} });
+				m_visibleBatchesStatic.back().instances.reserve(64);
+				m_visibleBatchesStatic.back().instanceIndices.reserve(64);
+			}
+
+			Batch& batch = m_visibleBatchesStatic[it->second];
+
+			m_batchEntryBySlot[slot] = BatchEntry{ static_cast<UINT>(it->second), static_cast<UINT>(batch.instances.size()) };
+			batch.instances.push_back(Transforms.GetWorldBySlot(slot));
+			batch.instanceIndices.push_back(GetInstanceIndex(slot));
+			m_instanceCountStatic++;
 		}
+	}
 
-		Batch& batch = m_visibleBatchesStatic[it->second];
+	void EntitiesManager::WriteInstance(const UINT& slot, const UINT& frameIndex)
+	{
+		const BatchEntry& entry = m_batchEntryBySlot[slot];
+		if (entry.batchIndex == MAXUINT)
+			return;
 
-		UINT instanceIndex = m_startingOffset + m_instanceCountStatic++;
+		Entity* entity = m_entitiesBySlot[slot];
+		const XMMATRIX& world = Transforms.GetWorldBySlot(slot);
+		UINT instanceIndex = GetInstanceIndex(slot);
 
-		D3D12_RAYTRACING_INSTANCE_DESC& instance = m_instanceDescGpuMapped[m_deviceResources->GetCurrentFrameIndex()][instanceIndex];
+		D3D12_RAYTRACING_INSTANCE_DESC& instance = m_instanceDescGpuMapped[frameIndex][instanceIndex];
 
 		instance.InstanceID = instanceIndex;
 		instance.InstanceContributionToHitGroupIndex = 0;
@@ -37,8 +137,8 @@ namespace CPyburnRTXEngine
 		XMMATRIX transpose = XMMatrixTranspose(world);
 		memcpy(instance.Transform, &transpose, sizeof(instance.Transform));
 
-		instance.AccelerationStructure = entity->GetAssimpFactoryModel()->GetBlasPtr()->GetResult()->GetGPUVirtualAddress();
-		instance.InstanceMask = 0xFF;
+		instance.AccelerationStructure = entity->GetAssimpFactoryModel()->GetBlasPtr()->GetResultAddress();
+		instance.InstanceMask = m_frustumCuller.IsVisible(slot) ? 0xFF : 0; // a zero mask hides the instance from every ray without moving any indices
 
 		RtxScene::RtxModelData data{};
 
@@ -59,10 +159,97 @@ namespace CPyburnRTXEngine
 		data.normalTexIndex = modelPtr->texturesHeapNrm[0].indexInMaterialBuffer;
 		data.ormTexIndex = modelPtr->texturesHeapOrm[0].indexInMaterialBuffer;
 
-		m_modelDataGpuMapped[instanceIndex] = data;
+		m_modelDataGpuMapped[instanceIndex] = data; // only one copy, but the data doesn't change per frame so writing it again is harmless
+
+		m_visibleBatchesStatic[entry.batchIndex].instances[entry.indexInBatch] = world;
+	}
+
+	void EntitiesManager::RemoveFromBatch(const UINT& slot)
+	{
+		if (slot >= m_batchEntryBySlot.size())
+			return;
+
+		BatchEntry entry = m_batchEntryBySlot[slot];
+		if (entry.batchIndex == MAXUINT)
+			return;
+
+		// swap and pop inside the batch too, the instance index says which slot owned the one that moved
+		Batch& batch = m_visibleBatchesStatic[entry.batchIndex];
+		const UINT lastInBatch = static_cast<UINT>(batch.instances.size() - 1);
+		if (entry.indexInBatch != lastInBatch)
+		{
+			batch.instances[entry.indexInBatch] = batch.instances[lastInBatch];
+			batch.instanceIndices[entry.indexInBatch] = batch.instanceIndices[lastInBatch];
+			m_batchEntryBySlot[batch.instanceIndices[lastInBatch] - m_startingOffset].indexInBatch = entry.indexInBatch;
+		}
+		batch.instances.pop_back();
+		batch.instanceIndices.pop_back();
+		m_instanceCountStatic--;
+
+		m_batchEntryBySlot[slot] = BatchEntry{};
+	}
+
+	void EntitiesManager::MoveSlot(const UINT& from, const UINT& to)
+	{
+		m_entitiesBySlot[to] = m_entitiesBySlot[from];
+
+		if (from < m_batchEntryBySlot.size())
+		{
+			m_batchEntryBySlot[to] = m_batchEntryBySlot[from];
+			const BatchEntry& entry = m_batchEntryBySlot[to];
+			if (entry.batchIndex != MAXUINT)
+			{
+				m_visibleBatchesStatic[entry.batchIndex].instanceIndices[entry.indexInBatch] = GetInstanceIndex(to);
+			}
+		}
+
+		std::replace(m_animatedSlots.begin(), m_animatedSlots.end(), from, to);
+		m_frustumCuller.MoveSlot(from, to);
+		m_animationLod.MoveSlot(from, to);
+	}
+
+	void EntitiesManager::RemoveEntity(const UINT& id)
+	{
+		auto it = LoadedEntities.find(id);
+		if (it == LoadedEntities.end() || !Transforms.Contains(id))
+			return;
+
+		// frames in flight still read the entity's vertices, palettes and BLAS, removing is rare enough to just wait
+		if (m_deviceResources)
+		{
+			m_deviceResources->WaitForGpu();
+		}
+
+		const UINT slot = Transforms.GetSlot(id);
+
+		// nothing is in flight after the wait, so every back buffer's copy of the instance can go now
+		// a static entity moved in rewrites it through its dirty bits, a skinned one has no instance to write
+		for (UINT frameIndex = 0; frameIndex < DX::DeviceResources::c_backBufferCount; frameIndex++)
+		{
+			if (m_instanceDescGpuMapped[frameIndex])
+			{
+				m_instanceDescGpuMapped[frameIndex][GetInstanceIndex(slot)] = D3D12_RAYTRACING_INSTANCE_DESC{};
+			}
+		}
+
+		RemoveFromBatch(slot);
+		std::erase(m_animatedSlots, slot);
+
+		// the moved entity lands on a new instance index, Remove already marked it dirty for every back buffer
+		// the old last index falls out of the TLAS, its instance count follows Transforms.GetCount()
+		const UINT movedSlot = Transforms.Remove(id);
+		if (movedSlot != MAXUINT)
+		{
+			MoveSlot(Transforms.GetCount(), movedSlot);
+		}
+
+		m_entitiesBySlot.pop_back();
+		if (m_batchEntryBySlot.size() > Transforms.GetCount())
+		{
+			m_batchEntryBySlot.pop_back();
+		}
 
-		batch.instances.push_back(world);
-		batch.instanceIndices.push_back(instanceIndex);
+		LoadedEntities.erase(it);
 	}
 
 	EntitiesManager::EntitiesManager()
@@ -78,6 +265,15 @@ namespace CPyburnRTXEngine
 	{
 		m_deviceResources = deviceResources;
 
+		// every static buffer of the load, the bounding renderers' included, goes through one staging arena and is copied in CreateBuffers
+		StagingArena& stagingArena = GraphicsContexts::GetStagingArena();
+		stagingArena.Begin();
+
+		for (AssimpFactory::Model* model : ImportAssets())
+		{
+			model->GetAssimpFactoryPtr()->CreateDeviceDependentResources(deviceResources);
+		}
+
 		for (auto& loadedEntity : EntitiesManager::LoadedEntities)
 		{
 			Entity* entity = &loadedEntity.second;
@@ -87,18 +283,13 @@ namespace CPyburnRTXEngine
 			if (it != AssimpFactory::Models.end())
 			{
 				AssimpFactory::Model* model = &it->second;
-				if (!model->GetAssimpFactoryPtr())
-				{
-					std::string modelPath = "..\\..\\Assets\\Models\\" + model->contentLocation + model->name;
-					model->CreateAssimpFactory(modelPath);
-					model->GetAssimpFactoryPtr()->CreateDeviceDependentResources(deviceResources);
-				}
-
 				entity->CreateAssimpAnimations(model->GetAssimpFactoryPtr());
 				entity->CreateDeviceDependentResources(deviceResources);
 			}
 		}
 
+		AssimpFactory::StaticBlasPool.CreateDeviceDependentResources(deviceResources);
+
 		// todo: move this eventually to game.cpp
 		{
 			// initialize Gpu resources
@@ -109,15 +300,29 @@ namespace CPyburnRTXEngine
 			DX::ThrowIfFailed(commandList->Close());
 			ID3D12CommandList* ppCommandLists[] = { commandList.Get() };
 			m_deviceResources->GetCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+			// WaitForGpu signals this fence, the arena's chunks are freed as soon as it completes
+			DebugTrace("StagingArena %u uploads, %llu bytes in %u chunks\n", stagingArena.GetStagedCount(), stagingArena.GetStagedBytes(), stagingArena.GetChunkCount());
+			stagingArena.End(GraphicsContexts::GetPendingFenceValue());
 			m_deviceResources->WaitForGpu();
 
 			//m_deviceResources->GetCurrentFrameResource()->ResetCommandList(0);
 		}
+
+		// the static builds above wrote their compacted sizes, move them into the pool before any TLAS points at them
+		AssimpFactory::StaticBlasPool.Compact();
+
+		// every model is loaded now, so skinned vs static is known
+		BuildBatches();
+
+		m_skinningBatch.CreateDeviceDependentResources(deviceResources);
+		m_skinningBatch.CreateBuffers(static_cast<UINT>(m_animatedSlots.size()));
 	}
 
 	// todo: not sure I want to keep this static, need to think about it
 	void EntitiesManager::CreateBuffers(ID3D12GraphicsCommandList4* commandList)
 	{
+		// buffers first, then every staged copy with one barrier batch, then the BLAS builds that read them
+		std::unordered_set<AssimpFactory*> createdFactories;
 		for (auto& loadedEntity : EntitiesManager::LoadedEntities)
 		{
 			Entity* entity = &loadedEntity.second;
@@ -127,38 +332,103 @@ namespace CPyburnRTXEngine
 				animation->CreateBuffers(commandList);
 				animation->CreateShaderResources();
 			}
-			else if(!entity->GetAssimpFactoryModel()->GetBlasPtr())
+			else if (!entity->GetAssimpFactoryModel()->GetBlasPtr() && createdFactories.insert(entity->GetAssimpFactoryModel()->GetAssimpFactoryPtr()).second)
 			{
 				entity->GetAssimpFactoryModel()->GetAssimpFactoryPtr()->CreateBuffers(commandList);
 				entity->GetAssimpFactoryModel()->GetAssimpFactoryPtr()->CreateShaderResources();
 			}
 		}
-	}
 
-	void EntitiesManager::Update(DX::StepTimer const& timer, CameraBase* camera)
-	{
-		m_instanceCountStatic = 0;
-		m_startingOffset = 1; // todo: make this dynamic based on terrain, right now 1 is fine
-		m_batchIndexByModelIdStatic.clear();
-		m_visibleBatchesStatic.clear();
+		GraphicsContexts::GetStagingArena().Record(commandList);
 
 		for (auto& loadedEntity : EntitiesManager::LoadedEntities)
 		{
 			Entity* entity = &loadedEntity.second;
-			entity->Update();
-
 			AssimpAnimations* animation = entity->GetAssimpAnimations();
 			if (animation)
 			{
-				animation->Update(timer);
+				animation->CreateBlas(commandList);
 			}
-			
-			AssimpFactory* model = entity->GetAssimpFactoryModel()->GetAssimpFactoryPtr();
-			model->GetBoundingBoxRenderer().Update(entity->GetEntityDescriptionCurrentState()->GetProperties()->GetXMTransform(), camera);
-			model->GetBoundingSphereRenderer().Update(entity->GetEntityDescriptionCurrentState()->GetProperties()->GetXMTransform(), camera);
+			else
+			{
+				entity->GetAssimpFactoryModel()->GetAssimpFactoryPtr()->CreateStaticBlas(commandList);
+			}
+		}
+	}
+
+	void EntitiesManager::Update(DX::StepTimer const& timer, CameraBase* camera)
+	{
+		// only entities that had a setter called since last frame get recomposed
+		Transforms.ComposeDirtyWorldMatrices(m_jobSystem);
+
+		// a visibility flip only changes the instance mask, but every back buffer's copy still needs it
+		m_frustumCuller.SetFrustum(camera->GetBoundingFrustum());
+		m_frustumCuller.Cull(Transforms, m_jobSystem);
+		for (const UINT& slot : m_frustumCuller.GetChangedSlots())
+		{
+			Transforms.MarkDirtyBySlot(slot);
+		}
+
+		// far units get a new pose every few frames and off screen units none, the rest keep last pose's skinned vertices and BLAS
+		m_animationLod.SetCamera(camera);
+		m_animationLod.Update(m_animatedSlots, Transforms, m_frustumCuller, static_cast<float>(timer.GetElapsedSeconds()), m_jobSystem);
+
+		// every animation owns its player and bone buffers, so the crowd is evaluated in batches side by side
+		// each pose lands straight in that entity's mapped bone buffer for this frame, units on the same clip and time share one evaluation
+		m_poseCache.BeginFrame();
+		const std::vector<UINT>& posedSlots = m_animationLod.GetPosedSlots();
+		m_jobSystem.ParallelFor(static_cast<UINT>(posedSlots.size()), c_animationRangeSize, [this, &timer, &posedSlots](UINT begin, UINT end)
+			{
+				for (UINT i = begin; i < end; i++)
+				{
+					const UINT& slot = posedSlots[i];
+					m_entitiesBySlot[slot]->GetAssimpAnimations()->Update(timer, m_animationLod.GetPendingSeconds(slot), m_animationLod.GetMinSampledHeight(slot), &m_poseCache);
+				}
+			});
+
+#ifdef _DEBUG
+		// debug only, the bounding renderers are shared per model so this stays on one thread
+		for (UINT slot = 0; slot < Transforms.GetCount(); slot++)
+		{
+			const XMMATRIX& world = Transforms.GetWorldBySlot(slot);
+			AssimpFactory* model = m_entitiesBySlot[slot]->GetAssimpFactoryModel()->GetAssimpFactoryPtr();
+			model->GetBoundingBoxRenderer().Update(world, camera);
+			model->GetBoundingSphereRenderer().Update(world, camera);
+		}
+#endif
 
-			AddVisible(entity, model->GetModel(), model->GetModel()->modelId, entity->GetEntityDescriptionCurrentState()->GetProperties()->GetXMTransform());
+		// each back buffer has its own instance descs, a change is written once per back buffer and then left alone
+		// instance index follows the slot, so every job writes its own part of the mapped buffers and needs no locking
+		UINT frameIndex = m_deviceResources->GetCurrentFrameIndex();
+		const std::vector<UINT>& pendingSlots = Transforms.GetPendingSlots();
+		if (pendingSlots.size() * 2 >= Transforms.GetCount())
+		{
+			// most of the scene changed, walk contiguous instance ranges
+			m_jobSystem.ParallelFor(Transforms.GetCount(), c_instanceRangeSize, [this, frameIndex](UINT begin, UINT end)
+				{
+					for (UINT slot = begin; slot < end; slot++)
+					{
+						if (Transforms.IsFrameDirty(slot, frameIndex))
+						{
+							WriteInstance(slot, frameIndex);
+						}
+					}
+				});
+		}
+		else
+		{
+			m_jobSystem.ParallelFor(static_cast<UINT>(pendingSlots.size()), c_instanceRangeSize, [this, frameIndex, &pendingSlots](UINT begin, UINT end)
+				{
+					for (UINT i = begin; i < end; i++)
+					{
+						if (Transforms.IsFrameDirty(pendingSlots[i], frameIndex))
+						{
+							WriteInstance(pendingSlots[i], frameIndex);
+						}
+					}
+				});
 		}
+		Transforms.ClearFrameDirty(frameIndex);
 	}
 
 	void EntitiesManager::RenderBounding(ID3D12GraphicsCommandList4* commandList)
@@ -175,31 +445,76 @@ namespace CPyburnRTXEngine
 
 	void EntitiesManager::DispatchAndUpdateBlas(ID3D12GraphicsCommandList4* commandList)
 	{
-		for (auto& loadedEntity : EntitiesManager::LoadedEntities)
+		// only what got a different pose this frame, the others' output vertices and BLAS are still the last pose's
+		// those are single resources, and a palette on the upload ring is only read by the dispatch of the frame that wrote it, so skipping leaves no back buffer stale
+		if (m_skinningBatch.IsEnabled())
 		{
-			Entity* entity = &loadedEntity.second;
-			AssimpAnimations* animation = loadedEntity.second.GetAssimpAnimations();
-			if (animation)
+			m_skinningBatch.Begin(m_deviceResources->GetCurrentFrameIndex());
+			for (const UINT& slot : m_animationLod.GetPosedSlots())
 			{
-				animation->GetAnimationCompute()->Dispatch(commandList);
+				AssimpAnimations* animation = m_entitiesBySlot[slot]->GetAssimpAnimations();
+				if (animation->IsPoseChanged())
+				{
+					m_skinningBatch.Add(animation);
+				}
+			}
+			m_skinningBatch.Record(commandList);
+			TraceBlasBuilds();
+			return;
+		}
 
-				D3D12_RESOURCE_BARRIER uavBarrier = {};
-				uavBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-				uavBarrier.UAV.pResource = animation->GetAnimationCompute()->GetVertexOutputBuffer().DefaultHeapResource.Get();
-				commandList->ResourceBarrier(1, &uavBarrier);
+		for (const UINT& slot : m_animationLod.GetPosedSlots())
+		{
+			AssimpAnimations* animation = m_entitiesBySlot[slot]->GetAssimpAnimations();
+			if (!animation->IsPoseChanged())
+				continue;
 
-				animation->GetAnimationBlasPtr()->UpdateBlas(commandList);
-			}
-			else if (entity->GetAssimpFactoryModel()->GetAssimpFactoryPtr())
-			{
-				//D3D12_RESOURCE_BARRIER uavBarrier = {};
-				//uavBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-				//uavBarrier.UAV.pResource = entity->GetAssimpFactoryModel()->GetAssimpFactoryPtr()->GetVertexBuffer()->DefaultHeapResource.Get();
-				//commandList->ResourceBarrier(1, &uavBarrier);
+			animation->GetAnimationCompute()->Dispatch(commandList);
 
-				//entity->GetAssimpFactoryModel()->GetBlasPtr()->UpdateBlas(commandList);
-			}
+			D3D12_RESOURCE_BARRIER uavBarrier = {};
+			uavBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+			uavBarrier.UAV.pResource = animation->GetAnimationCompute()->GetVertexOutputBuffer().DefaultHeapResource.Get();
+			commandList->ResourceBarrier(1, &uavBarrier);
+
+			animation->GetAnimationBlasPtr()->UpdateBlas(commandList, animation->GetPoseDelta()); // refits unless the policy wants a full build
 		}
+		TraceBlasBuilds();
+	}
+
+	void EntitiesManager::GetBlasBuildCounts(UINT64& builds, UINT64& refits) const
+	{
+		builds = 0;
+		refits = 0;
+		for (const UINT& slot : m_animatedSlots)
+		{
+			const BufferBlas<AssimpFactory::VSVertices>* blas = m_entitiesBySlot[slot]->GetAssimpAnimations()->GetAnimationBlasPtr();
+			builds += blas->GetBuildCount();
+			refits += blas->GetRefitCount();
+		}
+	}
+
+	void EntitiesManager::TraceBlasBuilds()
+	{
+		if (++m_blasTraceFrame < c_blasTraceFrames)
+			return;
+
+		UINT64 builds = 0;
+		UINT64 refits = 0;
+		GetBlasBuildCounts(builds, refits);
+
+		// a removed entity takes its counts with it, start over from the new totals then
+		if (builds >= m_blasTracedBuilds && refits >= m_blasTracedRefits)
+		{
+			DebugTrace("Animated BLAS over %u frames: %llu full builds, %llu refits\n", m_blasTraceFrame, builds - m_blasTracedBuilds, refits - m_blasTracedRefits);
+		}
+
+		// the pose cache alongside, one frame's sharing and the rate since the start
+		const PoseCache::Stats& poseStats = m_poseCache.GetLastFrameStats();
+		DebugTrace("Pose cache last frame: %u lookups, %u hits, %u poses evaluated, %.0f%% hits overall\n", poseStats.lookups, poseStats.hits, poseStats.poses, m_poseCache.GetTotalHitRate() * 100.0f);
+
+		m_blasTraceFrame = 0;
+		m_blasTracedBuilds = builds;
+		m_blasTracedRefits = refits;
 	}
 
 	void EntitiesManager::LoadJson()
@@ -210,6 +525,9 @@ namespace CPyburnRTXEngine
 			return;
 		}
 
+		Transforms.Reserve(m_maxEntities);
+		m_entitiesBySlot.reserve(m_maxEntities);
+
 		// load json
 		{
 			std::string filePath = "../../Assets/Json/Entities.json";
@@ -235,8 +553,19 @@ namespace CPyburnRTXEngine
 				AssimpFactory::Model* ptrModel = AssimpFactory::LoadJsonByModelId(entityProperties->GetModelId());
 				entity.SetAssimpFactoryModel(ptrModel);
 
-				LoadedEntities.emplace(entityProperties->GetId(), std::move(entity));
+				auto [it, inserted] = LoadedEntities.emplace(entityProperties->GetId(), std::move(entity));
+
+				// bind after the initial state is copied so only the current state writes to the store
+				it->second.GetEntityDescriptionCurrentState()->GetProperties()->BindTransformStore(&Transforms);
+				m_entitiesBySlot.resize(Transforms.GetCount());
+				m_entitiesBySlot[Transforms.GetSlot(it->first)] = &it->second;
 			}
 		}
+
+		// instance index is slot + m_startingOffset, the TLAS instance descs and the model data are sized for m_maxEntities of them
+		if (Transforms.GetCount() > m_maxEntities)
+		{
+			throw std::runtime_error("Entities.json has more entities than EntitiesManager::m_maxEntities");
+		}
 	}
 }
\ No newline at end of file
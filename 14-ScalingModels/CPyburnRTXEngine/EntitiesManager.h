@@ -2,6 +2,12 @@
 
 #include "AssimpFactory.h"
 #include "RtxScene.h"
+#include "TransformStore.h"
+#include "JobSystem.h"
+#include "FrustumCuller.h"
+#include "AnimationLod.h"
+#include "PoseCache.h"
+#include "SkinningBatch.h"
 
 namespace CPyburnRTXEngine
 {
@@ -29,14 +35,46 @@ namespace CPyburnRTXEngine
 		static std::unordered_map<UINT, size_t> m_batchIndexByModelIdStatic;
 		static std::vector<Batch> m_visibleBatchesStatic;
 		inline static UINT m_instanceCountStatic;
+		// instance index is stable for the life of the entity so unchanged instances can be left alone in the mapped buffers
+		static UINT GetInstanceIndex(const UINT& slot) { return m_startingOffset + slot; }
 		inline static RtxScene::RtxModelData* m_modelDataGpuMapped = nullptr;
 
 	private:
-		void AddVisible(Entity* entity, AssimpFactory::Model* model, UINT modelId, const XMMATRIX& world);
+		struct BatchEntry
+		{
+			UINT batchIndex = MAXUINT; // MAXUINT for skinned entities, they are not batched
+			UINT indexInBatch = 0;
+		};
+
+		std::vector<AssimpFactory::Model*> ImportAssets(); // returns the models it imported
+		void BuildBatches();
+		void WriteInstance(const UINT& slot, const UINT& frameIndex);
+		void RemoveFromBatch(const UINT& slot);
+		void MoveSlot(const UINT& from, const UINT& to);
+
+		static constexpr UINT c_instanceRangeSize = 128; // slots per job when writing instance descs
+		static constexpr UINT c_animationRangeSize = 4; // characters per job when evaluating poses, each one is a few hundred bones of work
+		static constexpr UINT c_blasTraceFrames = 600; // how often the animated BLAS builds and refits and the pose cache hits are traced
 
 		DX::DeviceResources* m_deviceResources = nullptr;
+		JobSystem m_jobSystem;
+		FrustumCuller m_frustumCuller;
+		AnimationLod m_animationLod;
+		PoseCache m_poseCache;
+		SkinningBatch m_skinningBatch;
+
+		// totals at the last trace, so the trace shows what happened since
+		UINT m_blasTraceFrame = 0;
+		UINT64 m_blasTracedBuilds = 0;
+		UINT64 m_blasTracedRefits = 0;
+		void TraceBlasBuilds();
+
+		static std::vector<Entity*> m_entitiesBySlot; // mirrors the dense slots in Transforms so the update loop walks memory in order
+		static std::vector<BatchEntry> m_batchEntryBySlot;
+		static std::vector<UINT> m_animatedSlots;
 	public:
 		static std::unordered_map<UINT, Entity> LoadedEntities;
+		inline static TransformStore Transforms;
 		
 		EntitiesManager();
 		~EntitiesManager();
@@ -47,6 +85,18 @@ namespace CPyburnRTXEngine
 		void RenderBounding(ID3D12GraphicsCommandList4* commandList);
 		void DispatchAndUpdateBlas(ID3D12GraphicsCommandList4* commandList);
 		void LoadJson();
+
+		// the store swaps the last slot into the removed one, every array kept per slot here follows it
+		// waits for the gpu first, the entity's buffers and BLAS go with it
+		void RemoveEntity(const UINT& id);
+
+		JobSystem* GetJobSystem() { return &m_jobSystem; }
+		FrustumCuller* GetFrustumCuller() { return &m_frustumCuller; }
+		AnimationLod* GetAnimationLod() { return &m_animationLod; }
+		PoseCache* GetPoseCache() { return &m_poseCache; }
+		SkinningBatch* GetSkinningBatch() { return &m_skinningBatch; }
+		// full builds and refits of every animated entity's BLAS since each was created
+		void GetBlasBuildCounts(UINT64& builds, UINT64& refits) const;
 	};
 }
 
@@ -15,11 +15,6 @@ namespace CPyburnRTXEngine
 	{
 		m_deviceResources = deviceResources;
 		m_EnvironmentCb.CreateCbvOnUploadHeap(m_deviceResources->GetD3DDevice(), L"Environment Cbv");
-
-		for (UINT i = 0; i < DX::DeviceResources::c_backBufferCount; i++)
-		{
-			m_EnvironmentCb.CopyToGpu(i);
-		}
 	}
 
 	void Environment::Update(DX::StepTimer const& timer, CameraBase* camera)
@@ -14,7 +14,8 @@ namespace CPyburnRTXEngine
 
 		DX::DeviceResources* m_deviceResources = nullptr;
 	public:
-		const BufferConstant<EnvironmentData>& GetEnvironmentConstantBuffer() { return m_EnvironmentCb; }
+		BufferConstant<EnvironmentData>& GetEnvironmentConstantBuffer() { return m_EnvironmentCb; }
+		const XMFLOAT3& GetLightDirection() { return m_EnvironmentCb.CpuData.lightDirection; }
 
 		Environment();
 		~Environment();
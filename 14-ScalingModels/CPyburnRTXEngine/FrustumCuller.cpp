@@ -0,0 +1,157 @@
+#include "pchlib.h"
+#include "FrustumCuller.h"
+
+namespace CPyburnRTXEngine
+{
+	void FrustumCuller::SetFrustum(const BoundingFrustum& frustum)
+	{
+		XMVECTOR planes[c_planeCount];
+		frustum.GetPlanes(&planes[0], &planes[1], &planes[2], &planes[3], &planes[4], &planes[5]);
+
+		for (UINT i = 0; i < c_planeCount; i++)
+		{
+			XMStoreFloat4(&m_planes[i], planes[i]);
+		}
+	}
+
+	void FrustumCuller::MoveSlot(const UINT& from, const UINT& to)
+	{
+		if (from < m_visible.size() && to < m_visible.size())
+		{
+			m_visible[to] = m_visible[from];
+			m_changed[to] = m_changed[from];
+		}
+	}
+
+	bool FrustumCuller::IsSphereVisible(const XMFLOAT3& center, const float& radius) const
+	{
+		XMVECTOR lightDirection = XMVector3Normalize(XMLoadFloat3(&m_lightDirection));
+
+		for (UINT i = 0; i < c_planeCount; i++)
+		{
+			const XMFLOAT4& plane = m_planes[i];
+			float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+			if (distance <= radius)
+			{
+				continue;
+			}
+
+			if (m_mode == Mode::CameraAndShadowCasters)
+			{
+				// the far end of the shadow, if it is back on the inside of this plane the caster has to stay
+				float planeDotLight = XMVectorGetX(XMVector3Dot(XMLoadFloat4(&plane), lightDirection));
+				if (distance - m_shadowExtrusion * planeDotLight <= radius)
+				{
+					continue;
+				}
+			}
+
+			return false;
+		}
+
+		return true;
+	}
+
+	void FrustumCuller::CullRange(const TransformStore& transforms, const UINT& begin, const UINT& end)
+	{
+		const float* boundsX = transforms.GetWorldBoundsX().data();
+		const float* boundsY = transforms.GetWorldBoundsY().data();
+		const float* boundsZ = transforms.GetWorldBoundsZ().data();
+		const float* boundsRadius = transforms.GetWorldBoundsRadius().data();
+
+		const bool keepShadowCasters = m_mode == Mode::CameraAndShadowCasters;
+		XMVECTOR lightDirection = XMVector3Normalize(XMLoadFloat3(&m_lightDirection));
+
+		// splat every plane once, each lane of the loop below is a different sphere
+		XMVECTOR planeX[c_planeCount], planeY[c_planeCount], planeZ[c_planeCount], planeW[c_planeCount], shadowOffset[c_planeCount];
+		for (UINT i = 0; i < c_planeCount; i++)
+		{
+			XMVECTOR plane = XMLoadFloat4(&m_planes[i]);
+			planeX[i] = XMVectorSplatX(plane);
+			planeY[i] = XMVectorSplatY(plane);
+			planeZ[i] = XMVectorSplatZ(plane);
+			planeW[i] = XMVectorSplatW(plane);
+			shadowOffset[i] = XMVectorReplicate(m_shadowExtrusion * XMVectorGetX(XMVector3Dot(plane, lightDirection)));
+		}
+
+		UINT slot = begin;
+		for (; slot + 4 <= end; slot += 4)
+		{
+			XMVECTOR centerX = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&boundsX[slot]));
+			XMVECTOR centerY = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&boundsY[slot]));
+			XMVECTOR centerZ = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&boundsZ[slot]));
+			XMVECTOR radius = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&boundsRadius[slot]));
+
+			XMVECTOR outside = XMVectorFalseInt();
+			for (UINT i = 0; i < c_planeCount; i++)
+			{
+				XMVECTOR distance = XMVectorMultiplyAdd(centerX, planeX[i], XMVectorMultiplyAdd(centerY, planeY[i], XMVectorMultiplyAdd(centerZ, planeZ[i], planeW[i])));
+				XMVECTOR planeOutside = XMVectorGreater(distance, radius);
+
+				if (keepShadowCasters)
+				{
+					planeOutside = XMVectorAndInt(planeOutside, XMVectorGreater(distance - shadowOffset[i], radius));
+				}
+
+				outside = XMVectorOrInt(outside, planeOutside);
+			}
+
+			uint32_t outsideLanes[4];
+			XMStoreInt4(outsideLanes, outside);
+			for (UINT lane = 0; lane < 4; lane++)
+			{
+				UINT8 visible = outsideLanes[lane] ? 0 : 1;
+				m_changed[slot + lane] = visible != m_visible[slot + lane];
+				m_visible[slot + lane] = visible;
+			}
+		}
+
+		// left overs that don't fill a full vector
+		for (; slot < end; slot++)
+		{
+			UINT8 visible = IsSphereVisible(XMFLOAT3(boundsX[slot], boundsY[slot], boundsZ[slot]), boundsRadius[slot]) ? 1 : 0;
+			m_changed[slot] = visible != m_visible[slot];
+			m_visible[slot] = visible;
+		}
+	}
+
+	void FrustumCuller::Cull(const TransformStore& transforms, JobSystem& jobSystem)
+	{
+		const UINT count = transforms.GetCount();
+
+		// new slots start visible, they are dirty anyway so their first write picks up whatever the cull says
+		m_visible.resize(count, 1);
+		m_changed.resize(count, 0);
+
+		if (m_mode == Mode::Disabled)
+		{
+			for (UINT slot = 0; slot < count; slot++)
+			{
+				m_changed[slot] = m_visible[slot] == 0;
+				m_visible[slot] = 1;
+			}
+		}
+		else
+		{
+			// every range owns its own slots in m_visible and m_changed
+			jobSystem.ParallelFor(count, c_cullRangeSize, [this, &transforms](UINT begin, UINT end)
+				{
+					CullRange(transforms, begin, end);
+				});
+		}
+
+		m_visibleSlots.clear();
+		m_changedSlots.clear();
+		for (UINT slot = 0; slot < count; slot++)
+		{
+			if (m_visible[slot])
+			{
+				m_visibleSlots.push_back(slot);
+			}
+			if (m_changed[slot])
+			{
+				m_changedSlots.push_back(slot);
+			}
+		}
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "pchlib.h"
+#include "TransformStore.h"
+#include "JobSystem.h"
+
+namespace CPyburnRTXEngine
+{
+	// tests the world space bounding spheres in a TransformStore against the camera frustum, 4 spheres per XMVECTOR
+	// rays don't stop at the screen edge, so the shadow mode keeps anything that could still shadow what is on screen
+	class FrustumCuller
+	{
+	public:
+		enum class Mode
+		{
+			Disabled, // everything is visible
+			Camera, // only what is inside the camera frustum
+			CameraAndShadowCasters, // camera frustum, plus spheres whose shadow (extruded away from the light) reaches it
+		};
+
+	private:
+		static constexpr UINT c_planeCount = 6;
+		static constexpr UINT c_cullRangeSize = 512; // multiple of 4 so ranges stay on the 4 wide path
+
+		Mode m_mode = Mode::CameraAndShadowCasters;
+		XMFLOAT4 m_planes[c_planeCount] = {}; // outward facing, a sphere is outside when dot(n, c) + d > r
+		XMFLOAT3 m_lightDirection = XMFLOAT3(0.5f, 0.5f, -0.5f); // direction shadow rays travel, matches Environment
+		float m_shadowExtrusion = 100.0f; // how far behind a caster its shadow can land
+
+		std::vector<UINT8> m_visible;
+		std::vector<UINT8> m_changed;
+		std::vector<UINT> m_visibleSlots;
+		std::vector<UINT> m_changedSlots;
+
+		void CullRange(const TransformStore& transforms, const UINT& begin, const UINT& end);
+		bool IsSphereVisible(const XMFLOAT3& center, const float& radius) const;
+
+	public:
+		FrustumCuller() = default;
+		FrustumCuller(const FrustumCuller&) = delete;
+		FrustumCuller& operator=(const FrustumCuller&) = delete;
+		~FrustumCuller() = default;
+
+		void SetMode(const Mode& mode) { m_mode = mode; }
+		const Mode& GetMode() const { return m_mode; }
+		void SetLightDirection(const XMFLOAT3& lightDirection) { m_lightDirection = lightDirection; }
+		void SetShadowExtrusion(const float& shadowExtrusion) { m_shadowExtrusion = shadowExtrusion; }
+
+		// call before Cull, the frustum is copied so the camera can keep moving
+		void SetFrustum(const BoundingFrustum& frustum);
+
+		// updates visibility for every slot and collects the slots that flipped since the last call
+		void Cull(const TransformStore& transforms, JobSystem& jobSystem);
+
+		// mirrors a TransformStore::Remove that moved the last slot into to, the vectors shrink on the next Cull
+		void MoveSlot(const UINT& from, const UINT& to);
+
+		bool IsVisible(const UINT& slot) const { return slot >= m_visible.size() || m_visible[slot] != 0; }
+		const std::vector<UINT>& GetVisibleSlots() const { return m_visibleSlots; }
+		const std::vector<UINT>& GetChangedSlots() const { return m_changedSlots; }
+	};
+}
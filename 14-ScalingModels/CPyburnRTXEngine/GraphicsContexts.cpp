@@ -6,11 +6,24 @@ using namespace CPyburnRTXEngine;
 UINT GraphicsContexts::c_descriptorSize;
 Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> GraphicsContexts::c_heap;
 
-UINT GraphicsContexts::m_heapPositionCounter;
-std::vector<UINT> GraphicsContexts::m_availableHeapPositions;
+DescriptorAllocator GraphicsContexts::m_descriptorAllocator;
+thread_local GraphicsContexts::ThreadCache GraphicsContexts::m_threadCache;
+std::atomic_uint64_t GraphicsContexts::m_pendingFenceValue = 0;
 std::unordered_map<UINT, UINT> GraphicsContexts::m_multiUseHeapPositions;
 std::mutex GraphicsContexts::m_mutexMultiUseHeapPositions;
 
+GraphicsContexts::Region GraphicsContexts::m_regions[static_cast<UINT>(GraphicsContexts::HeapRegion::Count)] =
+{
+	{ "frameConstantsRegionSize", 256 },
+	{ "textureRegionSize", 1024 },
+	{ "modelBufferRegionSize", 2048 },
+};
+std::vector<GraphicsContexts::RetiredRange> GraphicsContexts::m_retiredRanges;
+std::mutex GraphicsContexts::m_mutexRanges;
+UploadRing GraphicsContexts::m_uploadRing;
+StagingArena GraphicsContexts::m_stagingArena;
+BlasRefitTracker::Policy GraphicsContexts::m_blasRefitPolicy;
+
 Microsoft::WRL::ComPtr<ID3D12PipelineState> GraphicsContexts::m_pipelineStatePositionColorInstancedLine;
 Microsoft::WRL::ComPtr<ID3D12PipelineState> GraphicsContexts::m_pipelineStatePositionColorInstancedTriangle;
 Microsoft::WRL::ComPtr<ID3D12RootSignature> GraphicsContexts::m_rootSignaturePositionColorInstanced;
@@ -148,57 +161,237 @@ namespace CPyburnRTXEngine
 			{
 				// remove from multiheap if all are gone
 				m_multiUseHeapPositions.erase(iter);
-				DebugTrace("Heap position reclaimed: %s\n", (std::to_string(heapPosition)).c_str());
-				m_availableHeapPositions.push_back(heapPosition);
+				DebugTrace("Heap position released: %s\n", (std::to_string(heapPosition)).c_str());
+				ReleaseSlot(heapPosition);
 				didErase = true;
 			}
 		}
-		else
-			m_availableHeapPositions.push_back(heapPosition); // if it wasn't a multiuse then reuse
+		else if (!ReleaseSlot(heapPosition)) // if it wasn't a multiuse then reuse, once the gpu is done with it
+		{
+			DebugTrace("Heap position freed twice: %s\n", (std::to_string(heapPosition)).c_str());
+		}
 
 		m_mutexMultiUseHeapPositions.unlock();
 
 		return didErase;
 	}
 
-	UINT GraphicsContexts::GetAvailableHeapPosition()
+	GraphicsContexts::ThreadCache::~ThreadCache()
 	{
-		m_mutexMultiUseHeapPositions.lock();
-		// NOTE: was having issues tying to claim previously used heap so commented out for now, just incriments until it runs out for now but added a catch
-		assert(m_heapPositionCounter != UINT32_MAX);
-
-		UINT value = m_heapPositionCounter;
-		// chad: right now not reusing heap positions, not important, game will never be that big
-		//if (m_availableHeapPositions.size() > 0)
-		//{
-		//	value = m_availableHeapPositions[0];
-		//	DebugTrace("Heap position reused: %s\n", (std::to_string(value)).c_str());
-		//	m_availableHeapPositions.erase(m_availableHeapPositions.begin());
-		//}
-		//else
+		// slots cached for a heap that has since been recreated are stale, Return skips them
+		if (resetCount == m_descriptorAllocator.GetResetCount() && !handles.empty())
 		{
-			m_heapPositionCounter++;
-			DebugTrace("Heap position used: %s\n", (std::to_string(value)).c_str());
+			m_descriptorAllocator.Return(handles.data(), static_cast<UINT>(handles.size()));
 		}
+	}
 
-		m_mutexMultiUseHeapPositions.unlock();
+	DescriptorAllocator::Handle GraphicsContexts::AllocateDescriptor()
+	{
+		ThreadCache& cache = m_threadCache;
+
+		// the heap was recreated since this thread last allocated
+		if (cache.resetCount != m_descriptorAllocator.GetResetCount())
+		{
+			cache.handles.clear();
+			cache.resetCount = m_descriptorAllocator.GetResetCount();
+		}
+
+		if (cache.handles.empty())
+		{
+			DescriptorAllocator::Handle handles[c_threadCacheSize];
+			UINT count = m_descriptorAllocator.AllocateBatch(handles, c_threadCacheSize);
+			for (UINT i = count; i > 0; i--)
+			{
+				cache.handles.push_back(handles[i - 1]);
+			}
+		}
+
+		if (cache.handles.empty())
+		{
+			throw std::runtime_error("Descriptor heap is full, raise descriptorHeapSize in Graphics.json");
+		}
+
+		DescriptorAllocator::Handle handle = cache.handles.back();
+		cache.handles.pop_back();
+		DebugTrace("Heap position used: %s\n", (std::to_string(handle.index)).c_str());
+		return handle;
+	}
+
+	bool GraphicsContexts::FreeDescriptor(const DescriptorAllocator::Handle& handle)
+	{
+		bool didFree = m_descriptorAllocator.Free(handle, m_pendingFenceValue);
+		if (!didFree)
+		{
+			DebugTrace("Stale descriptor handle freed: %s\n", (std::to_string(handle.index)).c_str());
+		}
+		return didFree;
+	}
+
+	void GraphicsContexts::ReclaimHeapPositions(const UINT64& completedFenceValue, const UINT64& pendingFenceValue)
+	{
+		m_pendingFenceValue = pendingFenceValue;
+		m_descriptorAllocator.Reclaim(completedFenceValue);
+
+		std::lock_guard<std::mutex> lock(m_mutexRanges);
+		size_t reclaimed = 0;
+		while (reclaimed < m_retiredRanges.size() && m_retiredRanges[reclaimed].fenceValue <= completedFenceValue)
+		{
+			const DescriptorRange& range = m_retiredRanges[reclaimed].range;
+			Region& region = m_regions[static_cast<UINT>(range.region)];
+			if (!region.allocator.Free(range.start - region.start, range.count))
+			{
+				DebugTrace("Descriptor range freed twice: %u to %u\n", range.start, range.start + range.count - 1);
+			}
+			reclaimed++;
+		}
+		m_retiredRanges.erase(m_retiredRanges.begin(), m_retiredRanges.begin() + reclaimed);
+	}
+
+	GraphicsContexts::HeapRegion GraphicsContexts::FindRegion(const UINT& heapPosition)
+	{
+		for (UINT r = 0; r < static_cast<UINT>(HeapRegion::Count); r++)
+		{
+			const Region& region = m_regions[r];
+			if (heapPosition >= region.start && heapPosition < region.start + region.allocator.GetCapacity())
+				return static_cast<HeapRegion>(r);
+		}
+		return HeapRegion::Count;
+	}
+
+	bool GraphicsContexts::ReleaseSlot(const UINT& heapPosition)
+	{
+		HeapRegion region = FindRegion(heapPosition);
+		if (region == HeapRegion::Count)
+		{
+			// the index alone can't tell this slot's owner from whoever had it before, only FreeDescriptor can free it
+			DebugTrace("Single heap position %s has to be freed by its handle\n", (std::to_string(heapPosition)).c_str());
+			return false;
+		}
 
-		return value;
+		DescriptorRange range{ region, heapPosition, 1 };
+		return FreeRange(range);
+	}
+
+	GraphicsContexts::DescriptorRange GraphicsContexts::AllocateRange(const HeapRegion& region, const UINT& count)
+	{
+		std::lock_guard<std::mutex> lock(m_mutexRanges);
+
+		Region& heapRegion = m_regions[static_cast<UINT>(region)];
+		UINT64 offset = heapRegion.allocator.Allocate(count);
+		if (offset == RangeAllocator::c_invalidOffset)
+		{
+			throw std::runtime_error(std::string("Descriptor heap region is full, raise ") + heapRegion.configName + " in Graphics.json");
+		}
+
+		return DescriptorRange{ region, heapRegion.start + static_cast<UINT>(offset), count };
+	}
+
+	bool GraphicsContexts::FreeRange(DescriptorRange& range)
+	{
+		if (!range.IsValid())
+			return false;
+
+		bool didFree = false;
+		{
+			std::lock_guard<std::mutex> lock(m_mutexRanges);
+
+			// it has to be handed out now and not already waiting on a fence, otherwise it gets freed twice when the fence completes
+			const Region& region = m_regions[static_cast<UINT>(range.region)];
+			didFree = region.allocator.IsAllocated(range.start - region.start, range.count);
+			for (const RetiredRange& retired : m_retiredRanges)
+			{
+				if (!didFree)
+					break;
+
+				didFree = retired.range.region != range.region || retired.range.start + retired.range.count <= range.start || range.start + range.count <= retired.range.start;
+			}
+
+			if (didFree)
+			{
+				m_retiredRanges.push_back(RetiredRange{ range, m_pendingFenceValue });
+			}
+		}
+
+		range = DescriptorRange{};
+		return didFree;
 	}
 
 	void GraphicsContexts::CreateDeviceDependentResources(ID3D12Device* d3dDevice)
 	{
 		c_descriptorSize = d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
+		UINT heapSize = c_defaultHeapSize;
+		UINT uploadRingFrameSize = c_defaultUploadRingFrameSize;
+		UINT stagingChunkSize = c_defaultStagingChunkSize;
+		// the regions sit at the end of the heap, the single slots get what is in front of them
+		UINT regionTotal = 0;
+		UINT regionSizes[static_cast<UINT>(HeapRegion::Count)] = {};
+		{
+			rapidjson::Document doc = LoadJsonDocument("../../Assets/Json/Graphics.json");
+			if (doc.IsObject() && doc.HasMember("descriptorHeapSize") && doc["descriptorHeapSize"].IsUint())
+			{
+				heapSize = doc["descriptorHeapSize"].GetUint();
+			}
+
+			if (doc.IsObject() && doc.HasMember("uploadRingFrameSize") && doc["uploadRingFrameSize"].IsUint())
+			{
+				uploadRingFrameSize = doc["uploadRingFrameSize"].GetUint();
+			}
+
+			if (doc.IsObject() && doc.HasMember("stagingChunkSize") && doc["stagingChunkSize"].IsUint())
+			{
+				stagingChunkSize = doc["stagingChunkSize"].GetUint();
+			}
+
+			m_blasRefitPolicy = BlasRefitTracker::Policy{};
+			if (doc.IsObject() && doc.HasMember("blasMaxRefits") && doc["blasMaxRefits"].IsUint())
+			{
+				m_blasRefitPolicy.maxRefits = doc["blasMaxRefits"].GetUint();
+			}
+
+			if (doc.IsObject() && doc.HasMember("blasMaxDeformation") && doc["blasMaxDeformation"].IsNumber())
+			{
+				m_blasRefitPolicy.maxDeformation = doc["blasMaxDeformation"].GetFloat();
+			}
+
+			for (UINT r = 0; r < static_cast<UINT>(HeapRegion::Count); r++)
+			{
+				const char* name = m_regions[r].configName;
+				regionSizes[r] = doc.IsObject() && doc.HasMember(name) && doc[name].IsUint() ? doc[name].GetUint() : m_regions[r].defaultSize;
+				regionTotal += regionSizes[r];
+			}
+		}
+
+		if (regionTotal >= heapSize)
+		{
+			throw std::runtime_error("Descriptor heap regions in Graphics.json leave no room for single slots");
+		}
+
+		UINT regionStart = heapSize - regionTotal;
+		{
+			std::lock_guard<std::mutex> lock(m_mutexRanges);
+			m_retiredRanges.clear();
+			for (UINT r = 0; r < static_cast<UINT>(HeapRegion::Count); r++)
+			{
+				m_regions[r].start = regionStart;
+				m_regions[r].allocator.Reset(regionSizes[r]);
+				regionStart += regionSizes[r];
+			}
+		}
+
 		D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
-		heapDesc.NumDescriptors = DX::DeviceResources::c_backBufferCount // Vertex constant buffers per frame 
-			+ 100; // Arbitrary large number for now.
+		heapDesc.NumDescriptors = heapSize;
 		heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
 		// This flag indicates that this descriptor heap can be bound to the pipeline and that descriptors contained in it can be referenced by a root table.
 		heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 
 		DX::ThrowIfFailed(d3dDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&c_heap)));
 		c_heap->SetName(L"Descriptor Heap from GraphicsContexts");
+
+		m_descriptorAllocator.Reset(heapSize - regionTotal);
+
+		m_uploadRing.CreateDeviceDependentResources(d3dDevice, uploadRingFrameSize);
+		m_stagingArena.CreateDeviceDependentResources(d3dDevice, stagingChunkSize);
 	}
 
 	Microsoft::WRL::ComPtr<IDxcBlob> GraphicsContexts::CompileHlslLibrary(ID3D12Device* d3dDevice, std::wstring filename, std::wstring shaderEntry, std::wstring shaderVersion)
@@ -312,6 +505,8 @@ namespace CPyburnRTXEngine
 
 	void GraphicsContexts::Release()
 	{
+		m_uploadRing.Release();
+		m_stagingArena.Release();
 		c_heap.Reset();
 	}
 }
@@ -1,15 +1,87 @@
 #pragma once
 
+#include <atomic>
+
+#include "BlasRefitTracker.h"
+#include "DescriptorAllocator.h"
+#include "RangeAllocator.h"
+#include "StagingArena.h"
+#include "UploadRing.h"
+
 namespace CPyburnRTXEngine
 {
 	class GraphicsContexts
 	{
+	public:
+		// blocks of the heap set aside for descriptors that have to sit next to each other, the single slots come from what is left in front of them
+		enum class HeapRegion
+		{
+			FrameConstants, // CBVs that have to be in a table, BufferConstant binds root CBVs from the upload ring instead
+			Textures, // the bindless texture table, a texture's index in it is its position minus the region start
+			ModelBuffers, // per model SRVs bound as one table
+			Count
+		};
+
+		// what AllocateRange hands back, the slots are start to start + count - 1
+		struct DescriptorRange
+		{
+			HeapRegion region = HeapRegion::Count;
+			UINT start = MAXUINT;
+			UINT count = 0;
+
+			bool IsValid() const { return start != MAXUINT; }
+			UINT GetIndex(const UINT& i) const { return start + i; }
+		};
+
 	private:
-		static UINT m_heapPositionCounter;
-		static std::vector<UINT> m_availableHeapPositions;
+		static constexpr UINT c_defaultHeapSize = 16384; // when Graphics.json doesn't say
+		static constexpr UINT c_threadCacheSize = 16; // slots a thread takes from the allocator at a time
+		static constexpr UINT c_defaultUploadRingFrameSize = 4 * 1024 * 1024; // when Graphics.json doesn't say
+		static constexpr UINT c_defaultStagingChunkSize = 64 * 1024 * 1024; // when Graphics.json doesn't say
+
+		// a few slots per thread so allocating doesn't take the allocator's lock every time
+		// whatever a thread still holds goes back to the allocator when the thread exits
+		struct ThreadCache
+		{
+			std::vector<DescriptorAllocator::Handle> handles; // highest slot first, handed out from the back
+			UINT resetCount = 0;
+
+			~ThreadCache();
+		};
+
+		static DescriptorAllocator m_descriptorAllocator;
+		static thread_local ThreadCache m_threadCache;
+		static std::atomic_uint64_t m_pendingFenceValue; // what the frame being recorded will signal, slots freed now wait for it
 		static std::unordered_map<UINT, UINT> m_multiUseHeapPositions;
 		static std::mutex m_mutexMultiUseHeapPositions;
 
+		struct Region
+		{
+			const char* configName = nullptr; // its size in Graphics.json
+			UINT defaultSize = 0;
+			UINT start = 0;
+			RangeAllocator allocator; // offsets are from start
+		};
+
+		struct RetiredRange
+		{
+			DescriptorRange range;
+			UINT64 fenceValue = 0;
+		};
+
+		static Region m_regions[static_cast<UINT>(HeapRegion::Count)];
+		static std::vector<RetiredRange> m_retiredRanges; // in fence order like the single slots
+		static std::mutex m_mutexRanges;
+
+		static UploadRing m_uploadRing;
+		static StagingArena m_stagingArena;
+		static BlasRefitTracker::Policy m_blasRefitPolicy;
+
+		// the region a heap position falls in, Count for a single slot
+		static HeapRegion FindRegion(const UINT& heapPosition);
+		// a slot of a region back to its range allocator, false when it was already free or isn't in a region
+		static bool ReleaseSlot(const UINT& heapPosition);
+
 #pragma region Position Color
 	private:
 		static Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pipelineStatePositionColorInstancedLine;
@@ -33,9 +105,35 @@ namespace CPyburnRTXEngine
 
 		static CD3DX12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(const UINT& index);
 		static CD3DX12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(const UINT& index);
+		// for slots out of the regions, textures share theirs so they are counted
 		static void AddMultiHeapPosition(UINT heapPosition);
 		static bool RemoveHeapPosition(UINT heapPosition);
-		static UINT GetAvailableHeapPosition();
+
+		// a single slot, freed by its handle so a stale one is caught instead of freeing the slot's next owner
+		static DescriptorAllocator::Handle AllocateDescriptor();
+		static bool FreeDescriptor(const DescriptorAllocator::Handle& handle);
+		static bool IsDescriptorAlive(const DescriptorAllocator::Handle& handle) { return m_descriptorAllocator.IsAlive(handle); }
+		static const DescriptorAllocator& GetDescriptorAllocator() { return m_descriptorAllocator; }
+
+		// called by DeviceResources whenever it knows a fence completed, frees what was retired up to it
+		static void ReclaimHeapPositions(const UINT64& completedFenceValue, const UINT64& pendingFenceValue);
+
+		// count slots next to each other in region, throws when the region has no gap that big
+		static DescriptorRange AllocateRange(const HeapRegion& region, const UINT& count);
+		// waits for the fence like RemoveHeapPosition, the range is invalid afterwards
+		// false when some of it is already free or already waiting on a fence
+		static bool FreeRange(DescriptorRange& range);
+		static UINT GetRegionStart(const HeapRegion& region) { return m_regions[static_cast<UINT>(region)].start; }
+		static UINT GetRegionSize(const HeapRegion& region) { return static_cast<UINT>(m_regions[static_cast<UINT>(region)].allocator.GetCapacity()); }
+
+		// per frame dynamic data, DeviceResources moves it to the next partition in MoveToNextFrame
+		static UploadRing& GetUploadRing() { return m_uploadRing; }
+		// static uploads of a load phase, DeviceResources frees its chunks once the load's fence completes
+		static StagingArena& GetStagingArena() { return m_stagingArena; }
+		// what every animated BLAS starts with, blasMaxRefits and blasMaxDeformation in Graphics.json
+		static const BlasRefitTracker::Policy& GetBlasRefitPolicy() { return m_blasRefitPolicy; }
+		// what the frame being recorded will signal
+		static UINT64 GetPendingFenceValue() { return m_pendingFenceValue; }
 
 		static void CreateDeviceDependentResources(ID3D12Device* d3dDevice);
 		static Microsoft::WRL::ComPtr<IDxcBlob> CompileHlslLibrary(ID3D12Device* d3dDevice, std::wstring filename, std::wstring shaderType, std::wstring shaderVersion);
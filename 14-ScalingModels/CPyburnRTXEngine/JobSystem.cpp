@@ -0,0 +1,191 @@
+#include "pchlib.h"
+#include "JobSystem.h"
+
+namespace CPyburnRTXEngine
+{
+	namespace
+	{
+		// which queue the current thread owns, callers that are not workers share queue 0
+		thread_local UINT t_queueIndex = 0;
+	}
+
+	JobSystem::JobSystem(UINT workerCount)
+	{
+		if (workerCount == 0)
+		{
+			UINT hardwareThreads = std::thread::hardware_concurrency();
+			workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+		}
+
+		m_queues.reserve(static_cast<size_t>(workerCount) + 1);
+		for (UINT i = 0; i < workerCount + 1; i++)
+		{
+			m_queues.push_back(std::make_unique<WorkerQueue>());
+		}
+
+		m_threads.reserve(workerCount);
+		for (UINT i = 0; i < workerCount; i++)
+		{
+			m_threads.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_wakeMutex);
+			m_running = false;
+		}
+		m_wake.notify_all();
+
+		for (std::thread& thread : m_threads)
+		{
+			thread.join();
+		}
+	}
+
+	bool JobSystem::TryPop(const UINT& queueIndex, Job& job)
+	{
+		WorkerQueue& queue = *m_queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty())
+		{
+			return false;
+		}
+
+		job = std::move(queue.jobs.back());
+		queue.jobs.pop_back();
+		return true;
+	}
+
+	bool JobSystem::TrySteal(const UINT& thiefIndex, Job& job)
+	{
+		const UINT queueCount = GetThreadCount();
+		for (UINT offset = 1; offset < queueCount; offset++)
+		{
+			WorkerQueue& queue = *m_queues[(thiefIndex + offset) % queueCount];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.jobs.empty())
+			{
+				job = std::move(queue.jobs.front());
+				queue.jobs.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool JobSystem::TryRunOne(const UINT& queueIndex)
+	{
+		Job job;
+		if (!TryPop(queueIndex, job) && !TrySteal(queueIndex, job))
+		{
+			return false;
+		}
+
+		m_queuedCount.fetch_sub(1);
+		job();
+		return true;
+	}
+
+	void JobSystem::WorkerLoop(UINT queueIndex)
+	{
+		t_queueIndex = queueIndex;
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_wakeMutex);
+				m_wake.wait(lock, [this] { return !m_running || m_queuedCount.load() > 0; });
+				if (!m_running)
+				{
+					return;
+				}
+			}
+
+			// keep going until there is nothing left to steal, then go back to sleep
+			while (TryRunOne(queueIndex))
+			{
+			}
+		}
+	}
+
+	void JobSystem::ParallelFor(const UINT& count, const UINT& minRangeSize, const RangeJob& job)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		const UINT rangeAlignment = std::max(minRangeSize, 1u);
+
+		// a few ranges per thread so stealing can even out uneven ranges
+		const UINT targetRangeCount = GetThreadCount() * 4;
+		UINT rangeSize = (count + targetRangeCount - 1) / targetRangeCount;
+		rangeSize = ((rangeSize + rangeAlignment - 1) / rangeAlignment) * rangeAlignment;
+
+		const UINT rangeCount = (count + rangeSize - 1) / rangeSize;
+		if (rangeCount == 1 || GetThreadCount() == 1)
+		{
+			job(0, count);
+			return;
+		}
+
+		std::atomic<UINT> remaining = rangeCount;
+		std::exception_ptr exception = nullptr;
+		std::mutex exceptionMutex;
+
+		{
+			// counted before any job is visible, a worker popping one straight away must never take the count below zero
+			// under the lock so a worker can't miss the wake up between its check and its wait
+			std::lock_guard<std::mutex> lock(m_wakeMutex);
+			m_queuedCount.fetch_add(rangeCount);
+		}
+
+		// consecutive ranges go to the same queue, so unless something is stolen a thread walks one contiguous block
+		const UINT queueCount = GetThreadCount();
+		const UINT rangesPerQueue = (rangeCount + queueCount - 1) / queueCount;
+		for (UINT range = 0; range < rangeCount; range++)
+		{
+			UINT begin = range * rangeSize;
+			UINT end = std::min(begin + rangeSize, count);
+
+			WorkerQueue& queue = *m_queues[(t_queueIndex + range / rangesPerQueue) % queueCount];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			// push_front so the owner pops the lowest range first from the back of its own block
+			queue.jobs.push_front([&job, &remaining, &exception, &exceptionMutex, begin, end]()
+				{
+					try
+					{
+						job(begin, end);
+					}
+					catch (...)
+					{
+						std::lock_guard<std::mutex> lock(exceptionMutex);
+						if (!exception)
+						{
+							exception = std::current_exception();
+						}
+					}
+					remaining.fetch_sub(1);
+				});
+		}
+
+		m_wake.notify_all();
+
+		// help out instead of waiting, this also makes nested ParallelFor calls safe
+		while (remaining.load() > 0)
+		{
+			if (!TryRunOne(t_queueIndex))
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "pchlib.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <thread>
+
+namespace CPyburnRTXEngine
+{
+	// small work stealing job system, only std so it runs anywhere the engine does
+	// every worker owns a queue, it pops its own work from the back and steals from the front of the others
+	class JobSystem
+	{
+	public:
+		using Job = std::function<void()>;
+		using RangeJob = std::function<void(UINT begin, UINT end)>;
+
+	private:
+		struct WorkerQueue
+		{
+			std::mutex mutex;
+			std::deque<Job> jobs;
+		};
+
+		// queue 0 belongs to whichever thread calls ParallelFor, the rest belong to m_threads
+		std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+		std::vector<std::thread> m_threads;
+
+		std::mutex m_wakeMutex;
+		std::condition_variable m_wake;
+		std::atomic<UINT> m_queuedCount = 0;
+		bool m_running = true; // guarded by m_wakeMutex
+
+		bool TryPop(const UINT& queueIndex, Job& job);
+		bool TrySteal(const UINT& thiefIndex, Job& job);
+		bool TryRunOne(const UINT& queueIndex);
+		void WorkerLoop(UINT queueIndex);
+
+	public:
+		// 0 workers means one per hardware thread minus the calling thread
+		explicit JobSystem(UINT workerCount = 0);
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+		~JobSystem();
+
+		// threads that can run jobs, including the one calling ParallelFor
+		UINT GetThreadCount() const { return static_cast<UINT>(m_queues.size()); }
+
+		// splits [0, count) into contiguous ranges of at least minRangeSize and blocks until every range has run
+		// range starts are multiples of minRangeSize, so a multiple of 4 keeps ranges aligned for 4 wide math
+		// the calling thread works too, and any exception thrown by a range is rethrown here
+		void ParallelFor(const UINT& count, const UINT& minRangeSize, const RangeJob& job);
+	};
+}
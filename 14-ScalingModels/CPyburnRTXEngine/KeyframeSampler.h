@@ -0,0 +1,61 @@
+#pragma once
+
+#include "pchlib.h"
+
+namespace CPyburnRTXEngine
+{
+	// where the last lookup landed in each key track of one channel, kept per bone so steady playback never searches
+	struct KeyframeCursor
+	{
+		UINT scaling = 0;
+		UINT rotation = 0;
+		UINT position = 0;
+	};
+
+	class KeyframeSampler
+	{
+	private:
+		// true when key is the first key whose successor is later than animationTime, which is what the old linear scan returned
+		static bool IsKey(const float& animationTime, const float* times, const UINT& key)
+		{
+			return animationTime < times[key + 1] && (key == 0 || !(animationTime < times[key]));
+		}
+
+	public:
+		// times of one key track in ascending order, numKeys has to be at least 2
+		// returns the same key as scanning from key 0, including 0 once animationTime is past the last key
+		// the cursor's key and both its neighbours are tried first so playback in either direction stays O(1), seeks and loops fall back to a binary search
+		static UINT FindKey(const float& animationTime, const float* times, const UINT& numKeys, UINT& cursor)
+		{
+			const UINT lastKey = numKeys - 1;
+			if (!(animationTime < times[lastKey]))
+			{
+				return 0;
+			}
+
+			UINT key = cursor < lastKey ? cursor : 0;
+			if (IsKey(animationTime, times, key))
+			{
+				return key;
+			}
+
+			if (key + 1 < lastKey && IsKey(animationTime, times, key + 1))
+			{
+				cursor = key + 1;
+				return cursor;
+			}
+
+			if (key > 0 && IsKey(animationTime, times, key - 1))
+			{
+				cursor = key - 1;
+				return cursor;
+			}
+
+			// first key after animationTime, it exists because animationTime is before the last key
+			const float* next = std::upper_bound(times + 1, times + numKeys, animationTime);
+
+			cursor = static_cast<UINT>(next - (times + 1));
+			return cursor;
+		}
+	};
+}
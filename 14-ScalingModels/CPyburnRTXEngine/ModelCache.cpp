@@ -0,0 +1,610 @@
+#include "pchlib.h"
+#include "ModelCache.h"
+
+#include "AssimpFactory.h"
+#include "AssimpAnimations.h"
+#include <array>
+#include <chrono>
+
+namespace CPyburnRTXEngine
+{
+	namespace
+	{
+		// what BakeAll measures and reports is read off the console -bakemodels runs in, Release builds too, so it isn't left to DebugTrace
+		void Report(_In_z_ _Printf_format_string_ const char* format, ...)
+		{
+			va_list args;
+			va_start(args, format);
+			vprintf(format, args);
+			va_end(args);
+			fflush(stdout);
+		}
+
+		// read only view of the whole cache file, the loader copies straight out of the mapped pages
+		class MappedFile
+		{
+		private:
+			HANDLE m_file = INVALID_HANDLE_VALUE;
+			HANDLE m_mapping = nullptr;
+			const uint8_t* m_data = nullptr;
+			size_t m_size = 0;
+
+		public:
+			explicit MappedFile(const std::string& path)
+			{
+				m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+				if (m_file == INVALID_HANDLE_VALUE)
+				{
+					return;
+				}
+
+				LARGE_INTEGER fileSize = {};
+				if (!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart == 0)
+				{
+					return;
+				}
+
+				m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (!m_mapping)
+				{
+					return;
+				}
+
+				m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+				if (m_data)
+				{
+					m_size = static_cast<size_t>(fileSize.QuadPart);
+				}
+			}
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			~MappedFile()
+			{
+				if (m_data)
+					UnmapViewOfFile(m_data);
+				if (m_mapping)
+					CloseHandle(m_mapping);
+				if (m_file != INVALID_HANDLE_VALUE)
+					CloseHandle(m_file);
+			}
+
+			const uint8_t* GetData() const { return m_data; }
+			size_t GetSize() const { return m_size; }
+		};
+
+		// bounds checked cursor, any short read fails the whole load and Assimp takes over
+		class CacheReader
+		{
+		private:
+			const uint8_t* m_cursor = nullptr;
+			const uint8_t* m_end = nullptr;
+
+		public:
+			CacheReader(const uint8_t* data, const size_t& size) : m_cursor(data), m_end(data + size) {}
+
+			bool ReadBytes(void* destination, const size_t& size)
+			{
+				if (static_cast<size_t>(m_end - m_cursor) < size)
+				{
+					return false;
+				}
+
+				if (size > 0)
+				{
+					memcpy(destination, m_cursor, size);
+				}
+				m_cursor += size;
+				return true;
+			}
+
+			template<typename T>
+			bool Read(T& value)
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				return ReadBytes(&value, sizeof(T));
+			}
+
+			bool Read(std::string& value)
+			{
+				uint32_t length = 0;
+				if (!Read(length) || static_cast<size_t>(m_end - m_cursor) < length)
+				{
+					return false;
+				}
+
+				value.assign(reinterpret_cast<const char*>(m_cursor), length);
+				m_cursor += length;
+				return true;
+			}
+
+			template<typename T>
+			bool Read(std::vector<T>& values)
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				uint32_t count = 0;
+				if (!Read(count) || static_cast<size_t>(m_end - m_cursor) / sizeof(T) < count)
+				{
+					return false;
+				}
+
+				values.resize(count);
+				return ReadBytes(values.data(), sizeof(T) * count);
+			}
+
+			bool IsAtEnd() const { return m_cursor == m_end; }
+		};
+
+		class CacheWriter
+		{
+		private:
+			std::ofstream& m_stream;
+
+		public:
+			explicit CacheWriter(std::ofstream& stream) : m_stream(stream) {}
+
+			template<typename T>
+			void Write(const T& value)
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				m_stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+			}
+
+			void Write(const std::string& value)
+			{
+				Write(static_cast<uint32_t>(value.size()));
+				m_stream.write(value.data(), value.size());
+			}
+
+			template<typename T>
+			void Write(const std::vector<T>& values)
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				Write(static_cast<uint32_t>(values.size()));
+				m_stream.write(reinterpret_cast<const char*>(values.data()), sizeof(T) * values.size());
+			}
+		};
+	}
+
+	bool ModelCache::ReadSourceStamp(const std::string& sourcePath, uint64_t& sourceSize, uint64_t& sourceWriteTime)
+	{
+		std::error_code error;
+		sourceSize = static_cast<uint64_t>(std::filesystem::file_size(sourcePath, error));
+		if (error)
+		{
+			return false;
+		}
+
+		sourceWriteTime = static_cast<uint64_t>(std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count());
+		return !error;
+	}
+
+	template<typename Animation>
+	auto ModelCache::GetKeyArrays(Animation& animation)
+	{
+		return std::array{
+			&animation.m_scalingTimes, &animation.m_scalingSpans, &animation.m_scalingX, &animation.m_scalingY, &animation.m_scalingZ,
+			&animation.m_rotationTimes, &animation.m_rotationSpans, &animation.m_rotationX, &animation.m_rotationY, &animation.m_rotationZ, &animation.m_rotationW,
+			&animation.m_positionTimes, &animation.m_positionSpans, &animation.m_positionX, &animation.m_positionY, &animation.m_positionZ };
+	}
+
+	bool ModelCache::Load(AssimpFactory& factory)
+	{
+		Header expected;
+		expected.vertexStride = sizeof(AssimpFactory::VSVertices);
+		expected.boneDataStride = sizeof(AssimpFactory::VertexBoneData);
+		expected.importFlags = factory.m_importFlags;
+		expected.compressionMaxError = AssimpFactory::AnimationCompression.maxError;
+		expected.compressionShellDistance = AssimpFactory::AnimationCompression.shellDistance;
+		if (!ReadSourceStamp(factory.m_pathFileName, expected.sourceSize, expected.sourceWriteTime))
+		{
+			return false;
+		}
+
+		MappedFile file(GetCachePath(factory.m_pathFileName));
+		if (!file.GetData())
+		{
+			return false;
+		}
+
+		CacheReader reader(file.GetData(), file.GetSize());
+
+		Header header;
+		if (!reader.Read(header) || memcmp(&header, &expected, sizeof(Header)) != 0)
+		{
+			DebugTrace(("Model cache is stale, importing " + factory.m_pathFileName + "\n").c_str());
+			return false;
+		}
+
+		// meshes
+		uint32_t meshCount = 0;
+		if (!reader.Read(meshCount) || meshCount == 0)
+		{
+			return false;
+		}
+
+		std::vector<AssimpFactory::MeshEntry> meshEntries(meshCount);
+		for (AssimpFactory::MeshEntry& mesh : meshEntries)
+		{
+			XMFLOAT4X4 meshTransform;
+			bool ok = reader.Read(mesh.name)
+				&& reader.Read(mesh.isMissingTextures)
+				&& reader.Read(mesh.numIndices)
+				&& reader.Read(mesh.baseVertex)
+				&& reader.Read(mesh.baseIndex)
+				&& reader.Read(mesh.hasBones)
+				&& reader.Read(mesh.materialIndex)
+				&& reader.Read(mesh.numVerts)
+				&& reader.Read(meshTransform)
+				&& reader.Read(mesh.boundingBox)
+				&& reader.Read(mesh.boundingSphere)
+				&& reader.Read(mesh.vertices)
+				&& reader.Read(mesh.indices);
+			if (!ok)
+			{
+				return false;
+			}
+			mesh.meshTransform = XMLoadFloat4x4(&meshTransform);
+		}
+
+		// whole model
+		uint8_t isSkinned = 0;
+		BoundingBox boundingBox;
+		BoundingSphere boundingSphere;
+		std::string textureDiffuse, textureSpec, textureNrm, textureDisp;
+		bool ok = reader.Read(isSkinned)
+			&& reader.Read(boundingBox)
+			&& reader.Read(boundingSphere)
+			&& reader.Read(textureDiffuse)
+			&& reader.Read(textureSpec)
+			&& reader.Read(textureNrm)
+			&& reader.Read(textureDisp);
+		if (!ok)
+		{
+			return false;
+		}
+
+		// bones
+		uint32_t numBones = 0;
+		std::vector<AssimpFactory::VertexBoneData> bones;
+		std::vector<XMFLOAT4X4> boneInfo;
+		uint32_t boneMappingCount = 0;
+		if (!reader.Read(numBones) || !reader.Read(bones) || !reader.Read(boneInfo) || !reader.Read(boneMappingCount))
+		{
+			return false;
+		}
+
+		std::unordered_map<std::string, unsigned int> boneMapping;
+		boneMapping.reserve(boneMappingCount);
+		for (uint32_t i = 0; i < boneMappingCount; i++)
+		{
+			std::string boneName;
+			uint32_t boneIndex = 0;
+			if (!reader.Read(boneName) || !reader.Read(boneIndex))
+			{
+				return false;
+			}
+			boneMapping[boneName] = boneIndex;
+		}
+
+		// node hierarchy
+		uint32_t nodeCount = 0;
+		if (!reader.Read(nodeCount))
+		{
+			return false;
+		}
+
+		std::vector<AssimpFactory::Node> nodes(nodeCount);
+		for (AssimpFactory::Node& node : nodes)
+		{
+			if (!reader.Read(node.name) || !reader.Read(node.parentIndex) || !reader.Read(node.transformation))
+			{
+				return false;
+			}
+		}
+
+		// baked animation
+		BakedAnimation animation;
+		uint32_t trackCount = 0;
+		if (!reader.Read(animation.m_ticksPerSecond) || !reader.Read(animation.m_duration) || !reader.Read(trackCount))
+		{
+			return false;
+		}
+
+		animation.m_trackNames.resize(trackCount);
+		for (std::string& trackName : animation.m_trackNames)
+		{
+			if (!reader.Read(trackName))
+			{
+				return false;
+			}
+		}
+
+		if (!reader.Read(animation.m_tracks) || animation.m_tracks.size() != trackCount)
+		{
+			return false;
+		}
+
+		for (std::vector<float>* keys : GetKeyArrays(animation))
+		{
+			if (!reader.Read(*keys))
+			{
+				return false;
+			}
+		}
+
+		// sampling indexes straight into the arrays, so a range past the end means the file is bad
+		auto isInside = [](const BakedAnimation::KeyRange& range, const size_t& keyCount)
+			{
+				return range.count > 0 && static_cast<size_t>(range.first) + range.count <= keyCount;
+			};
+		for (const BakedAnimation::Track& track : animation.m_tracks)
+		{
+			bool inside = isInside(track.scaling, animation.m_scalingTimes.size()) && isInside(track.scaling, animation.m_scalingZ.size())
+				&& isInside(track.rotation, animation.m_rotationTimes.size()) && isInside(track.rotation, animation.m_rotationW.size())
+				&& isInside(track.position, animation.m_positionTimes.size()) && isInside(track.position, animation.m_positionZ.size());
+			if (!inside)
+			{
+				return false;
+			}
+		}
+
+		// compressed animation, empty when the model has no bones
+		CompressedAnimation compressed;
+		bool compressedOk = reader.Read(compressed.m_tracks)
+			&& reader.Read(compressed.m_scalingTimes)
+			&& reader.Read(compressed.m_scalingValues)
+			&& reader.Read(compressed.m_rotationTimes)
+			&& reader.Read(compressed.m_rotations)
+			&& reader.Read(compressed.m_positionTimes)
+			&& reader.Read(compressed.m_positionValues);
+		if (!compressedOk || (!compressed.m_tracks.empty() && compressed.m_tracks.size() != trackCount))
+		{
+			return false;
+		}
+
+		for (const CompressedAnimation::Track& track : compressed.m_tracks)
+		{
+			bool inside = isInside(track.scaling, compressed.m_scalingTimes.size()) && isInside(track.scaling, compressed.m_scalingValues.size() / 3)
+				&& isInside(track.rotation, compressed.m_rotationTimes.size()) && isInside(track.rotation, compressed.m_rotations.size())
+				&& isInside(track.position, compressed.m_positionTimes.size()) && isInside(track.position, compressed.m_positionValues.size() / 3);
+			if (!inside)
+			{
+				return false;
+			}
+		}
+
+		if (!reader.IsAtEnd())
+		{
+			return false;
+		}
+
+		// everything checked out, hand it over
+		factory.m_meshEntries.resize(meshCount);
+		for (uint32_t i = 0; i < meshCount; i++)
+		{
+			AssimpFactory::MeshEntry& source = meshEntries[i];
+			AssimpFactory::MeshEntry& destination = factory.m_meshEntries[i];
+			destination.name = std::move(source.name);
+			destination.isMissingTextures = source.isMissingTextures;
+			destination.numIndices = source.numIndices;
+			destination.baseVertex = source.baseVertex;
+			destination.baseIndex = source.baseIndex;
+			destination.hasBones = source.hasBones;
+			destination.materialIndex = source.materialIndex;
+			destination.numVerts = source.numVerts;
+			destination.meshTransform = source.meshTransform;
+			destination.boundingBox = source.boundingBox;
+			destination.boundingSphere = source.boundingSphere;
+			destination.vertices = std::move(source.vertices);
+			destination.indices = std::move(source.indices);
+		}
+
+		factory.m_isSkinned = isSkinned != 0;
+		static_cast<BoundingBox&>(factory.m_boundingBox) = boundingBox;
+		static_cast<BoundingSphere&>(factory.m_boundingSphere) = boundingSphere;
+		factory.m_boundingSphereRadiusTranslation = XMMatrixTranslation(0, boundingSphere.Radius, 0);
+		factory.m_textureDiffuse = std::move(textureDiffuse);
+		factory.m_textureSPEC = std::move(textureSpec);
+		factory.m_textureNRM = std::move(textureNrm);
+		factory.m_textureDISP = std::move(textureDisp);
+
+		factory.m_numBones = numBones;
+		factory.m_bones = std::move(bones);
+		factory.m_boneInfo.resize(boneInfo.size());
+		for (size_t i = 0; i < boneInfo.size(); i++)
+		{
+			factory.m_boneInfo[i] = XMLoadFloat4x4(&boneInfo[i]);
+		}
+		factory.m_boneMapping = std::move(boneMapping);
+		factory.m_nodes = std::move(nodes);
+		factory.m_bakedAnimation = std::move(animation);
+		factory.m_compressedAnimation = std::move(compressed);
+
+		return true;
+	}
+
+	bool ModelCache::Save(const AssimpFactory& factory)
+	{
+		Header header;
+		header.vertexStride = sizeof(AssimpFactory::VSVertices);
+		header.boneDataStride = sizeof(AssimpFactory::VertexBoneData);
+		header.importFlags = factory.m_importFlags;
+		header.compressionMaxError = AssimpFactory::AnimationCompression.maxError;
+		header.compressionShellDistance = AssimpFactory::AnimationCompression.shellDistance;
+		if (!ReadSourceStamp(factory.m_pathFileName, header.sourceSize, header.sourceWriteTime))
+		{
+			return false;
+		}
+
+		// write to a temp file first so a crash never leaves a half written cache that looks valid
+		std::string cachePath = GetCachePath(factory.m_pathFileName);
+		std::string tempPath = cachePath + ".tmp";
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+			if (!stream)
+			{
+				return false;
+			}
+
+			CacheWriter writer(stream);
+			writer.Write(header);
+
+			writer.Write(static_cast<uint32_t>(factory.m_meshEntries.size()));
+			for (const AssimpFactory::MeshEntry& mesh : factory.m_meshEntries)
+			{
+				XMFLOAT4X4 meshTransform;
+				XMStoreFloat4x4(&meshTransform, mesh.meshTransform);
+
+				writer.Write(mesh.name);
+				writer.Write(mesh.isMissingTextures);
+				writer.Write(mesh.numIndices);
+				writer.Write(mesh.baseVertex);
+				writer.Write(mesh.baseIndex);
+				writer.Write(mesh.hasBones);
+				writer.Write(mesh.materialIndex);
+				writer.Write(mesh.numVerts);
+				writer.Write(meshTransform);
+				writer.Write(mesh.boundingBox);
+				writer.Write(mesh.boundingSphere);
+				writer.Write(mesh.vertices);
+				writer.Write(mesh.indices);
+			}
+
+			writer.Write(static_cast<uint8_t>(factory.m_isSkinned ? 1 : 0));
+			writer.Write(static_cast<const BoundingBox&>(factory.m_boundingBox));
+			writer.Write(static_cast<const BoundingSphere&>(factory.m_boundingSphere));
+			writer.Write(factory.m_textureDiffuse);
+			writer.Write(factory.m_textureSPEC);
+			writer.Write(factory.m_textureNRM);
+			writer.Write(factory.m_textureDISP);
+
+			std::vector<XMFLOAT4X4> boneInfo(factory.m_boneInfo.size());
+			for (size_t i = 0; i < boneInfo.size(); i++)
+			{
+				XMStoreFloat4x4(&boneInfo[i], factory.m_boneInfo[i]);
+			}
+			writer.Write(static_cast<uint32_t>(factory.m_numBones));
+			writer.Write(factory.m_bones);
+			writer.Write(boneInfo);
+			writer.Write(static_cast<uint32_t>(factory.m_boneMapping.size()));
+			for (const auto& [boneName, boneIndex] : factory.m_boneMapping)
+			{
+				writer.Write(boneName);
+				writer.Write(static_cast<uint32_t>(boneIndex));
+			}
+
+			writer.Write(static_cast<uint32_t>(factory.m_nodes.size()));
+			for (const AssimpFactory::Node& node : factory.m_nodes)
+			{
+				writer.Write(node.name);
+				writer.Write(node.parentIndex);
+				writer.Write(node.transformation);
+			}
+
+			const BakedAnimation& animation = factory.m_bakedAnimation;
+			writer.Write(animation.m_ticksPerSecond);
+			writer.Write(animation.m_duration);
+			writer.Write(static_cast<uint32_t>(animation.m_trackNames.size()));
+			for (const std::string& trackName : animation.m_trackNames)
+			{
+				writer.Write(trackName);
+			}
+			writer.Write(animation.m_tracks);
+			for (const std::vector<float>* keys : GetKeyArrays(animation))
+			{
+				writer.Write(*keys);
+			}
+
+			const CompressedAnimation& compressed = factory.m_compressedAnimation;
+			writer.Write(compressed.m_tracks);
+			writer.Write(compressed.m_scalingTimes);
+			writer.Write(compressed.m_scalingValues);
+			writer.Write(compressed.m_rotationTimes);
+			writer.Write(compressed.m_rotations);
+			writer.Write(compressed.m_positionTimes);
+			writer.Write(compressed.m_positionValues);
+
+			if (!stream)
+			{
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, cachePath, error);
+		if (error)
+		{
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		return true;
+	}
+
+	void ModelCache::ReportAnimationCompression(const AssimpFactory& factory, const UINT& modelId)
+	{
+		const BakedAnimation& baked = factory.m_bakedAnimation;
+		const CompressedAnimation& compressed = factory.m_compressedAnimation;
+		if (compressed.IsEmpty())
+		{
+			return;
+		}
+
+		const CompressedAnimation::Settings& settings = AssimpFactory::AnimationCompression;
+		const size_t bakedBytes = baked.GetMemoryUsage();
+		const size_t compressedBytes = compressed.GetMemoryUsage();
+		Report("  animation: %.1f KB baked, %.1f KB compressed, %.1f%% saved, max error %f\n", bakedBytes / 1024.0, compressedBytes / 1024.0,
+			100.0 * (1.0 - static_cast<double>(compressedBytes) / static_cast<double>(bakedBytes)),
+			compressed.MeasureMaxError(baked, factory.m_skeleton, 0.0f, baked.GetDuration(), settings));
+
+		// clips are frame ranges of the one animation, in seconds, the samplers work in ticks
+		auto clipsByType = AssimpAnimations::Animations.find(modelId);
+		if (clipsByType != AssimpAnimations::Animations.end())
+		{
+			for (const auto& [animationTypeId, clips] : clipsByType->second)
+			{
+				for (const auto& [clipName, clip] : clips)
+				{
+					float maxError = compressed.MeasureMaxError(baked, factory.m_skeleton, clip.startTime * baked.GetTicksPerSecond(), clip.endTime * baked.GetTicksPerSecond(), settings);
+					Report("  clip %s: max error %f\n", clipName.c_str(), maxError);
+				}
+			}
+		}
+	}
+
+	void ModelCache::BakeAll()
+	{
+		AssimpFactory::LoadJsonForAllModels();
+		AssimpAnimations::LoadJson();
+
+		// the reports below need the baked keys next to the compressed ones
+		AssimpFactory::KeepBakedKeys = true;
+
+		for (auto& [modelId, model] : AssimpFactory::Models)
+		{
+			std::string modelPath = "..\\..\\Assets\\Models\\" + model.contentLocation + model.name;
+
+			// drop the old cache so the factory below has to go through Assimp
+			std::error_code error;
+			std::filesystem::remove(GetCachePath(modelPath), error);
+
+			auto importStart = std::chrono::steady_clock::now();
+			AssimpFactory imported(&model, modelPath);
+			auto importEnd = std::chrono::steady_clock::now();
+
+			// load it again the way the game will, straight from the new cache
+			AssimpFactory cached(&model, modelPath);
+			auto cachedEnd = std::chrono::steady_clock::now();
+
+			double importMs = std::chrono::duration<double, std::milli>(importEnd - importStart).count();
+			double cachedMs = std::chrono::duration<double, std::milli>(cachedEnd - importEnd).count();
+			Report("Baked %s: assimp %.2f ms, cache %.2f ms\n", modelPath.c_str(), importMs, cachedMs);
+
+			ReportAnimationCompression(cached, modelId);
+		}
+
+		AssimpFactory::KeepBakedKeys = false;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "pchlib.h"
+
+namespace CPyburnRTXEngine
+{
+	class AssimpFactory; // forward declaration
+
+	// binary copy of everything AssimpFactory builds from an import, stored next to the source as <source>.cpmc
+	// the cache is only used while the source file's size and write time, the import flags, the animation compression settings and the version all match
+	class ModelCache
+	{
+	private:
+		static constexpr uint32_t c_magic = 0x434D5043; // "CPMC"
+		static constexpr uint32_t c_version = 3; // bump when the layout below changes
+
+		struct Header
+		{
+			uint32_t magic = c_magic;
+			uint32_t version = c_version;
+			uint32_t vertexStride = 0; // sizeof(VSVertices), catches struct changes that forgot the version
+			uint32_t boneDataStride = 0; // sizeof(VertexBoneData)
+			uint32_t importFlags = 0;
+			uint32_t padding = 0;
+			float compressionMaxError = 0; // the compressed animation is stored, so other settings need a new one
+			float compressionShellDistance = 0;
+			uint64_t sourceSize = 0;
+			uint64_t sourceWriteTime = 0;
+		};
+
+		static bool ReadSourceStamp(const std::string& sourcePath, uint64_t& sourceSize, uint64_t& sourceWriteTime);
+		// memory and max error per Animations.json clip of the compressed animation against the baked one
+		// the sampling speed of the two is CompressedAnimationBenchmark in the test project
+		static void ReportAnimationCompression(const AssimpFactory& factory, const UINT& modelId);
+
+		// every key array of a BakedAnimation in the order they are stored, const or not
+		template<typename Animation>
+		static auto GetKeyArrays(Animation& animation);
+
+	public:
+		static std::string GetCachePath(const std::string& sourcePath) { return sourcePath + ".cpmc"; }
+
+		// fills the factory from the cache, false means the cache is missing or stale and Assimp has to run
+		static bool Load(AssimpFactory& factory);
+		// writes what the factory imported, a failed write only costs the next launch another import
+		static bool Save(const AssimpFactory& factory);
+
+		// re-imports every model in Models.json and rewrites its cache, used by TestGame -bakemodels
+		// prints the import against cache load times and the compression reports to stdout, the caller gives it a console to land in
+		static void BakeAll();
+	};
+}
@@ -0,0 +1,70 @@
+#include "pchlib.h"
+#include "PoseCache.h"
+
+#include "AssimpAnimations.h"
+
+namespace CPyburnRTXEngine
+{
+	void PoseCache::BeginFrame()
+	{
+		m_lastFrameStats = m_frameStats;
+		m_totalLookups += m_frameStats.lookups;
+		m_totalHits += m_frameStats.hits;
+		m_frameStats = Stats{};
+
+		m_entriesByKey.clear();
+		m_entries.clear();
+	}
+
+	bool PoseCache::Pose(AssimpAnimations* animations, AnimationPlayer::AnimationClip& clip, const UINT& minSampledHeight, XMMATRIX* bones)
+	{
+		if (!m_enabled || m_samplesPerSecond <= 0.0f)
+		{
+			return false;
+		}
+
+		Key key;
+		key.model = animations->GetAssimpFactory();
+		key.clip = clip.animation;
+		key.sample = static_cast<INT64>(floorf(clip.time * m_samplesPerSecond));
+		key.minSampledHeight = minSampledHeight;
+
+		Entry* entry = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_frameStats.lookups++;
+
+			auto [it, inserted] = m_entriesByKey.try_emplace(key, nullptr);
+			if (inserted)
+			{
+				it->second = &m_entries.emplace_back();
+				m_frameStats.poses++;
+			}
+			else
+			{
+				m_frameStats.hits++;
+			}
+			entry = it->second;
+		}
+
+		// everyone on the key evaluates at the same quantized time, so the shared pose doesn't depend on who got there first
+		// a follower that arrives while the pose is still being evaluated waits here for it
+		std::call_once(entry->evaluated, [entry, animations, &clip, &key, &minSampledHeight, this]()
+			{
+				const float sampleTime = static_cast<float>(key.sample) / m_samplesPerSecond;
+
+				entry->source = animations;
+				entry->bones.resize(animations->GetAssimpFactory()->GetNumBones());
+				animations->BoneTransform(sampleTime, minSampledHeight, entry->bones.data(), &clip.noGlobalBones[0], &clip.global[0]);
+			});
+
+		memcpy(bones, entry->bones.data(), entry->bones.size() * sizeof(XMMATRIX));
+
+		if (entry->source != animations)
+		{
+			animations->CopyNodeTransforms(*entry->source);
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "pchlib.h"
+#include "AnimationPlayer.h"
+#include <deque>
+
+namespace CPyburnRTXEngine
+{
+	class AssimpFactory; // forward declaration
+	class AssimpAnimations; // forward declaration
+
+	// units of the same model playing the same clip at the same quantized time get one evaluated palette per frame
+	// the first unit to ask evaluates it, everyone else on that key copies the palette and node transforms
+	class PoseCache
+	{
+	public:
+		struct Stats
+		{
+			UINT lookups = 0;
+			UINT hits = 0;
+			UINT poses = 0; // distinct keys, one evaluation each
+
+			float GetHitRate() const { return lookups ? static_cast<float>(hits) / static_cast<float>(lookups) : 0.0f; }
+		};
+
+	private:
+		struct Key
+		{
+			const AssimpFactory* model = nullptr; // one per modelId
+			const Animation* clip = nullptr;
+			INT64 sample = 0; // clip time in 1 / m_samplesPerSecond steps
+			UINT minSampledHeight = 0; // an LOD cut off changes the pose too
+
+			bool operator==(const Key& other) const { return model == other.model && clip == other.clip && sample == other.sample && minSampledHeight == other.minSampledHeight; }
+		};
+
+		struct KeyHash
+		{
+			size_t operator()(const Key& key) const
+			{
+				size_t hash = std::hash<const void*>()(key.model);
+				hash = hash * 31 + std::hash<const void*>()(key.clip);
+				hash = hash * 31 + std::hash<INT64>()(key.sample);
+				return hash * 31 + key.minSampledHeight;
+			}
+		};
+
+		struct Entry
+		{
+			std::once_flag evaluated;
+			AssimpAnimations* source = nullptr; // the unit that evaluated it, followers copy its node transforms
+			std::vector<XMMATRIX> bones;
+		};
+
+		bool m_enabled = true;
+		float m_samplesPerSecond = 30.0f; // the quantization knob, higher is smoother but fewer units share a key
+
+		std::mutex m_mutex;
+		std::deque<Entry> m_entries; // deque so entries never move while other threads hold them
+		std::unordered_map<Key, Entry*, KeyHash> m_entriesByKey;
+
+		Stats m_frameStats; // guarded by m_mutex
+		Stats m_lastFrameStats;
+		UINT64 m_totalLookups = 0;
+		UINT64 m_totalHits = 0;
+
+	public:
+		PoseCache() = default;
+		PoseCache(const PoseCache&) = delete;
+		PoseCache& operator=(const PoseCache&) = delete;
+		~PoseCache() = default;
+
+		void SetEnabled(const bool& enabled) { m_enabled = enabled; }
+		const bool& IsEnabled() const { return m_enabled; }
+		// 0 turns sharing off, every unit evaluates its exact time again
+		void SetSamplesPerSecond(const float& samplesPerSecond) { m_samplesPerSecond = samplesPerSecond; }
+		const float& GetSamplesPerSecond() const { return m_samplesPerSecond; }
+
+		// call once per frame before any Pose, poses only live for the frame they were evaluated in
+		void BeginFrame();
+
+		// writes the clip's pose at its quantized time into bones, evaluating it only if no unit has this frame
+		// returns false when the cache is off, the caller evaluates the pose itself then
+		bool Pose(AssimpAnimations* animations, AnimationPlayer::AnimationClip& clip, const UINT& minSampledHeight, XMMATRIX* bones);
+
+		const Stats& GetLastFrameStats() const { return m_lastFrameStats; }
+		float GetTotalHitRate() const { return m_totalLookups ? static_cast<float>(m_totalHits) / static_cast<float>(m_totalLookups) : 0.0f; }
+	};
+}
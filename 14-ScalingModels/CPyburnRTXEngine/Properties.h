@@ -1,6 +1,7 @@
 #pragma once
 
 #include "pchlib.h"
+#include "TransformStore.h"
 
 namespace CPyburnRTXEngine
 {
@@ -16,6 +17,8 @@ namespace CPyburnRTXEngine
 
 		XMMATRIX m_worldTransform;
 
+		TransformStore* m_transformStore = nullptr; // once bound, the store owns the live transform and the fields above are only the description
+
 	public:
 		const UINT& GetId() { return m_id; }
 		void SetId(UINT id) { m_id = id; }
@@ -24,15 +27,38 @@ namespace CPyburnRTXEngine
 		void SetName(std::string name) { m_name = name; }
 
 		XMVECTOR GetXMPosition() { return XMLoadFloat3(&m_position); }
-		void SetPosition(XMFLOAT3 position) { m_position = position; }
+		void SetPosition(XMFLOAT3 position)
+		{
+			m_position = position;
+			if (m_transformStore)
+				m_transformStore->SetPosition(m_id, position);
+		}
 
 		XMVECTOR GetXMScale() { return XMLoadFloat3(&m_scale); }
-		void SetScale(XMFLOAT3 scale) { m_scale = scale; }
+		void SetScale(XMFLOAT3 scale)
+		{
+			m_scale = scale;
+			if (m_transformStore)
+				m_transformStore->SetScale(m_id, scale);
+		}
 
 		XMVECTOR GetXMRotation() { return XMLoadFloat3(&m_rotation); }
-		void SetRotation(XMFLOAT3 rotation) { m_rotation = rotation; }
+		void SetRotation(XMFLOAT3 rotation)
+		{
+			m_rotation = rotation;
+			if (m_transformStore)
+				m_transformStore->SetRotation(m_id, rotation);
+		}
 
-		const XMMATRIX& GetXMTransform() { return m_worldTransform; }
+		const XMMATRIX& GetXMTransform() { return m_transformStore ? m_transformStore->GetWorld(m_id) : m_worldTransform; }
+
+		// adds this entity to the store, the store rebuilds the world matrix from then on
+		void BindTransformStore(TransformStore* transformStore)
+		{
+			m_transformStore = transformStore;
+			m_transformStore->Add(m_id, m_position, m_rotation, m_scale);
+		}
+		TransformStore* GetTransformStore() { return m_transformStore; }
 
 		const UINT& GetModelId() { return m_modelId; }
 		void SetModelId(UINT modelId) { m_modelId = modelId; }
@@ -44,6 +70,9 @@ namespace CPyburnRTXEngine
 
 		void Update() 
 		{
+			if (m_transformStore)
+				return; // composed in batches by the store
+
 			m_worldTransform = XMMatrixScalingFromVector(GetXMScale()) * XMMatrixRotationRollPitchYawFromVector(GetXMRotation()) * XMMatrixTranslationFromVector(GetXMPosition());
 		}
 	};
@@ -0,0 +1,112 @@
+#include "pchlib.h"
+#include "RangeAllocator.h"
+
+namespace CPyburnRTXEngine
+{
+	void RangeAllocator::Reset(const UINT64& capacity)
+	{
+		m_capacity = capacity;
+		m_usedBytes = 0;
+		m_freeRanges.clear();
+		if (capacity > 0)
+		{
+			m_freeRanges.push_back(Range{ 0, capacity });
+		}
+	}
+
+	UINT64 RangeAllocator::Allocate(const UINT64& size, const UINT64& alignment)
+	{
+		if (size == 0)
+			return c_invalidOffset;
+
+		for (size_t i = 0; i < m_freeRanges.size(); i++)
+		{
+			Range range = m_freeRanges[i];
+			UINT64 alignedOffset = (range.offset + alignment - 1) & ~(alignment - 1);
+			UINT64 padding = alignedOffset - range.offset;
+			if (padding + size > range.size)
+				continue;
+
+			// what is left behind the allocation replaces the range, the padding in front of it becomes its own range
+			UINT64 tailSize = range.size - padding - size;
+			if (tailSize > 0)
+			{
+				m_freeRanges[i] = Range{ alignedOffset + size, tailSize };
+			}
+			else
+			{
+				m_freeRanges.erase(m_freeRanges.begin() + i);
+			}
+
+			if (padding > 0)
+			{
+				m_freeRanges.insert(m_freeRanges.begin() + i, Range{ range.offset, padding });
+			}
+
+			m_usedBytes += size;
+			return alignedOffset;
+		}
+
+		return c_invalidOffset;
+	}
+
+	bool RangeAllocator::IsAllocated(const UINT64& offset, const UINT64& size) const
+	{
+		if (offset == c_invalidOffset || size == 0 || offset >= m_capacity || size > m_capacity - offset)
+			return false;
+
+		// the free ranges either side of offset are the only ones that can reach into it
+		auto next = std::lower_bound(m_freeRanges.begin(), m_freeRanges.end(), offset, [](const Range& range, const UINT64& value) { return range.offset < value; });
+		if (next != m_freeRanges.end() && next->offset < offset + size)
+			return false;
+
+		if (next != m_freeRanges.begin())
+		{
+			auto before = next - 1;
+			if (before->offset + before->size > offset)
+				return false;
+		}
+
+		return true;
+	}
+
+	bool RangeAllocator::Free(const UINT64& offset, const UINT64& size)
+	{
+		if (!IsAllocated(offset, size))
+			return false;
+
+		auto next = std::lower_bound(m_freeRanges.begin(), m_freeRanges.end(), offset, [](const Range& range, const UINT64& value) { return range.offset < value; });
+		auto inserted = m_freeRanges.insert(next, Range{ offset, size });
+		m_usedBytes -= size;
+
+		// merge with the range after it, then with the one before it
+		auto after = inserted + 1;
+		if (after != m_freeRanges.end() && inserted->offset + inserted->size == after->offset)
+		{
+			inserted->size += after->size;
+			m_freeRanges.erase(after);
+		}
+
+		if (inserted != m_freeRanges.begin())
+		{
+			auto before = inserted - 1;
+			if (before->offset + before->size == inserted->offset)
+			{
+				before->size += inserted->size;
+				m_freeRanges.erase(inserted);
+			}
+		}
+
+		return true;
+	}
+
+	UINT64 RangeAllocator::GetLargestFreeRange() const
+	{
+		UINT64 largest = 0;
+		for (const Range& range : m_freeRanges)
+		{
+			largest = std::max(largest, range.size);
+		}
+		return largest;
+	}
+}
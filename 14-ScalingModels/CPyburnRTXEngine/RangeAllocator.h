@@ -0,0 +1,45 @@
+#pragma once
+
+#include "pchlib.h"
+
+namespace CPyburnRTXEngine
+{
+	// first fit offset allocator over [0, capacity), knows nothing about what the offsets point into so it works without a device
+	// free ranges are kept sorted by offset and merged with their neighbours when freed
+	class RangeAllocator
+	{
+	public:
+		static constexpr UINT64 c_invalidOffset = MAXUINT64;
+
+	private:
+		struct Range
+		{
+			UINT64 offset = 0;
+			UINT64 size = 0;
+		};
+
+		std::vector<Range> m_freeRanges;
+		UINT64 m_capacity = 0;
+		UINT64 m_usedBytes = 0;
+
+	public:
+		RangeAllocator() = default;
+		explicit RangeAllocator(const UINT64& capacity) { Reset(capacity); }
+
+		// forgets every allocation
+		void Reset(const UINT64& capacity);
+
+		// alignment has to be a power of two, c_invalidOffset when no free range fits
+		// padding in front of an aligned offset stays free, so Free takes the same size that was asked for
+		UINT64 Allocate(const UINT64& size, const UINT64& alignment = 1);
+		// false and nothing changes when any of the range is already free or past the capacity, a double free can't corrupt the list
+		bool Free(const UINT64& offset, const UINT64& size);
+		// true when every byte of the range is handed out
+		bool IsAllocated(const UINT64& offset, const UINT64& size) const;
+
+		UINT64 GetCapacity() const { return m_capacity; }
+		UINT64 GetUsedBytes() const { return m_usedBytes; }
+		UINT64 GetLargestFreeRange() const;
+		UINT GetFreeRangeCount() const { return static_cast<UINT>(m_freeRanges.size()); }
+	};
+}
@@ -58,35 +58,34 @@ namespace CPyburnRTXEngine
         planeVertices[4] = XMFLOAT3(100, -1, -2);
         planeVertices[5] = XMFLOAT3(100, -1, 100);
 
-		m_planeVertexBuffer.CpuData = planeVertices;
+		m_planeVertexBuffer.SetCpuData(std::move(planeVertices));
 		m_planeVertexBuffer.CreateOnDefaultHeap(commandList.Get(), L"Plane Buffer");
+		m_planeVertexBuffer.ReleaseCpuData();
 
-        // create model data
-        // after all the buffers are created, create the shader resource views in the correct order for shader table
-        m_modelDataPerInstanceBuffer.CpuData.resize(64); // arbitary number to start testing
-        m_modelDataPerInstanceBuffer.CreateOnUploadHeap(L"ModelDataPerInstance Buffer");
+        // create model data, EntitiesManager writes it in place so there is no CpuData behind it
+        // one entry per instance index, the plane's included, so it matches the instance descs the TLAS reads
+        m_modelDataPerInstanceBuffer.CreateOnUploadHeap(EntitiesManager::GetInstanceIndex(EntitiesManager::m_maxEntities), L"ModelDataPerInstance Buffer");
         m_modelDataPerInstanceBuffer.CreateShaderResourceView(true); // t0 for rtx shader
         EntitiesManager::m_modelDataGpuMapped = m_modelDataPerInstanceBuffer.MappedData; // point to the gpu mapped data to skip unneeded iterating and updates
 
-        // create textures AFTER the last shader views
+        // textures go into their own heap region, the hit table points at its start
         for (auto& unorderedModel : AssimpFactory::Models)
         {
             AssimpFactory::Model& model = unorderedModel.second;
             for (size_t texIndex = 0; texIndex < model.textures.size(); texIndex++)
             {
                 std::string textureLocation = model.textures[texIndex];
-                model.texturesHeap.push_back(Texture::LoadTextureHeap("..\\..\\Assets\\Models\\" + model.contentLocation + textureLocation, commandList.Get()));
+                model.texturesHeap.push_back(Texture::LoadTextureHeap(model.GetAssetPath(textureLocation), commandList.Get()));
             }
 
-            // load the normal and the ORM
-            std::string outExtension;
-            std::string fileName = RemoveExtension(model.textures[0], outExtension) + "_NRM." + outExtension;
+            // load the normal and the ORM, EntitiesManager already decoded them so this only records the uploads
+            std::string fileName = model.GetTextureMapName("_NRM");
             model.texturesNrm.push_back(fileName);
-            model.texturesHeapNrm.push_back(Texture::LoadTextureHeap("..\\..\\Assets\\Models\\" + model.contentLocation + fileName, commandList.Get()));
+            model.texturesHeapNrm.push_back(Texture::LoadTextureHeap(model.GetAssetPath(fileName), commandList.Get()));
 
-            fileName = RemoveExtension(model.textures[0], outExtension) + "_ORM." + outExtension;
+            fileName = model.GetTextureMapName("_ORM");
             model.texturesOrm.push_back(fileName);
-            model.texturesHeapOrm.push_back(Texture::LoadTextureHeap("..\\..\\Assets\\Models\\" + model.contentLocation + fileName, commandList.Get()));
+            model.texturesHeapOrm.push_back(Texture::LoadTextureHeap(model.GetAssetPath(fileName), commandList.Get()));
         }
 
         // upload goes out of scope if we don't execute the command list and wait for the GPU to finish before exiting the function, so execute and wait here
@@ -150,11 +149,15 @@ namespace CPyburnRTXEngine
         D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs = {};
         inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
         inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE;
-        inputs.NumDescs = static_cast<UINT>(m_instanceData.size());
+        inputs.NumDescs = EntitiesManager::GetInstanceIndex(EntitiesManager::Transforms.GetCount()); // the plane and every entity slot, a slot nothing writes keeps a zeroed desc and a null BLAS is skipped by the build
         inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
 
+        // buffers are sized for every instance index there can be, so a change in the entity count rebuilds in place
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS maxInputs = inputs;
+        maxInputs.NumDescs = EntitiesManager::GetInstanceIndex(EntitiesManager::m_maxEntities);
+
         D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO info;
-        m_deviceResources->GetD3DDevice()->GetRaytracingAccelerationStructurePrebuildInfo(&inputs, &info);
+        m_deviceResources->GetD3DDevice()->GetRaytracingAccelerationStructurePrebuildInfo(&maxInputs, &info);
 
         D3D12_RESOURCE_DESC m_bufDesc = {};
         m_bufDesc.Alignment = 0;
@@ -190,7 +193,7 @@ namespace CPyburnRTXEngine
 
             // The instance desc should be inside a buffer, create and map the buffer
             m_bufDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-            m_bufDesc.Width = sizeof(D3D12_RAYTRACING_INSTANCE_DESC) * EntitiesManager::m_maxEntities;
+            m_bufDesc.Width = sizeof(D3D12_RAYTRACING_INSTANCE_DESC) * EntitiesManager::GetInstanceIndex(EntitiesManager::m_maxEntities);
             auto heapPropertiesUpload = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
             DX::ThrowIfFailed(m_deviceResources->GetD3DDevice()->CreateCommittedResource(&heapPropertiesUpload, D3D12_HEAP_FLAG_NONE, &m_bufDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&tlas.pInstanceDescResource)));
         
@@ -240,7 +243,7 @@ namespace CPyburnRTXEngine
                 //memcpy(instanceDescPtr[i].Transform, &transpose, sizeof(instanceDescPtr[i].Transform));
                 //pInstanceDesc[i].AccelerationStructure = entity->GetAssimpAnimations()->GetAnimationBlas()->GetResult()->GetGPUVirtualAddress(); // triangle blas
                 //assert(EntitiesManager::m_instanceDescGpuMapped[currentFrame][i].AccelerationStructure == entity->GetAssimpFactoryModel()->GetBlasPtr()->GetResult()->GetGPUVirtualAddress());
-                UINT64 test = entity->GetAssimpFactoryModel()->GetBlasPtr()->GetResult()->GetGPUVirtualAddress();
+                UINT64 test = entity->GetAssimpFactoryModel()->GetBlasPtr()->GetResultAddress();
                 //EntitiesManager::m_instanceDescGpuMapped[currentFrame][i].AccelerationStructure = test; // triangle blas
                 //instanceDescPtr[i].InstanceMask = 0xFF;
             }
@@ -258,8 +261,12 @@ namespace CPyburnRTXEngine
         asDesc.DestAccelerationStructureData = tlas.pResult->GetGPUVirtualAddress();
         asDesc.ScratchAccelerationStructureData = tlas.pScratch->GetGPUVirtualAddress();
 
+        // a refit has to keep the instance count of the build it starts from, an added or removed entity gets a full build instead
+        const bool refit = update && mTlasInstanceCount[currentFrame] == inputs.NumDescs;
+        mTlasInstanceCount[currentFrame] = inputs.NumDescs;
+
         // 14.1.e If this is an update operation, set the source buffer and the perform_update flag
-        if (update)
+        if (refit)
         {
             asDesc.Inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
             asDesc.SourceAccelerationStructureData = tlas.pResult->GetGPUVirtualAddress();
@@ -423,7 +430,7 @@ namespace CPyburnRTXEngine
         std::vector<D3D12_ROOT_PARAMETER> rootParamsHit;
 
         rangeHit.resize(1 + 1); // srv material + texture array (bindless)
-        rootParamsHit.resize(1); // (srv + diffuseSRV)
+        rootParamsHit.resize(2); // srv material table + texture region table
 
         // SRV materials
         rangeHit[0].BaseShaderRegister = 0; // gOutput used the first t() register in the shader
@@ -431,19 +438,23 @@ namespace CPyburnRTXEngine
         rangeHit[0].RegisterSpace = 1;
         rangeHit[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
         rangeHit[0].OffsetInDescriptorsFromTableStart = 0; // this has to match the shader table entries
-        // t4 - texture array (bindless)
+        // t1 - texture array (bindless), its own table over the whole texture region so it no longer has to follow the material srv
         rangeHit[1].BaseShaderRegister = 1;
-        rangeHit[1].NumDescriptors = 100; // todo: make it use cbv size
+        rangeHit[1].NumDescriptors = GraphicsContexts::GetRegionSize(GraphicsContexts::HeapRegion::Textures);
         rangeHit[1].RegisterSpace = 1;
         rangeHit[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-        rangeHit[1].OffsetInDescriptorsFromTableStart = 1; // this has to match the shader table entries
+        rangeHit[1].OffsetInDescriptorsFromTableStart = 0;
 
         // SRVs
         rootParamsHit[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-        rootParamsHit[0].DescriptorTable.NumDescriptorRanges = static_cast<UINT>(rangeHit.size());
-        rootParamsHit[0].DescriptorTable.pDescriptorRanges = rangeHit.data();
+        rootParamsHit[0].DescriptorTable.NumDescriptorRanges = 1;
+        rootParamsHit[0].DescriptorTable.pDescriptorRanges = &rangeHit[0];
 
-        descHit.NumParameters = 1; // (srv vertex + srv index + diffuseSRV)
+        rootParamsHit[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+        rootParamsHit[1].DescriptorTable.NumDescriptorRanges = 1;
+        rootParamsHit[1].DescriptorTable.pDescriptorRanges = &rangeHit[1];
+
+        descHit.NumParameters = static_cast<UINT>(rootParamsHit.size()); // (srv material + texture table)
         descHit.pParameters = rootParamsHit.data();
         descHit.Flags = D3D12_ROOT_SIGNATURE_FLAG_LOCAL_ROOT_SIGNATURE;
 
@@ -725,6 +736,7 @@ namespace CPyburnRTXEngine
         uint8_t* pEntry3 = shaderTableEntryHelper(3, pRtsoProps.Get(), pData, kHitGroup);
         //*(D3D12_GPU_DESCRIPTOR_HANDLE*)(pEntry3 + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES) = m_triangleVertexBuffer.GpuHandle;
         *(D3D12_GPU_DESCRIPTOR_HANDLE*)(pEntry3 + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES) = m_modelDataPerInstanceBuffer.GpuHandle;
+        *(D3D12_GPU_DESCRIPTOR_HANDLE*)(pEntry3 + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + kSrvSize * 1) = GraphicsContexts::GetGpuHandle(GraphicsContexts::GetRegionStart(GraphicsContexts::HeapRegion::Textures));
 
         // Entry 4 - Triangle 0, shadow ray. ProgramID only
         shaderTableEntryHelper(4, pRtsoProps.Get(), pData, kShadowHitGroup);
@@ -798,10 +810,12 @@ namespace CPyburnRTXEngine
         m_environment.CreateDeviceDependentResources(deviceResources);
 
         // reserve the uav position and srv position
-        mUavPosition = GraphicsContexts::GetAvailableHeapPosition();
+        mUavHandle = GraphicsContexts::AllocateDescriptor();
+        mUavPosition = mUavHandle.index;
         for (UINT i = 0; i < DX::DeviceResources::c_backBufferCount; i++)
         {
-            mTlasSrvPosition[i] = GraphicsContexts::GetAvailableHeapPosition();
+            mTlasSrvHandle[i] = GraphicsContexts::AllocateDescriptor();
+            mTlasSrvPosition[i] = mTlasSrvHandle[i].index;
         }
 
         m_modelDataPerInstanceBuffer.CreateDeviceDependentResources(deviceResources->GetD3DDevice());
@@ -829,6 +843,12 @@ namespace CPyburnRTXEngine
     void RtxScene::Update(DX::StepTimer const& timer, CameraBase* camera)
     {
         m_environment.Update(timer, camera);
+
+        // shadow casters outside the camera are kept by following the light
+        if (m_entitiesManagerPtr)
+        {
+            m_entitiesManagerPtr->GetFrustumCuller()->SetLightDirection(m_environment.GetLightDirection());
+        }
     }
 
     void RtxScene::Render(CameraBase* camera)
@@ -944,7 +964,7 @@ namespace CPyburnRTXEngine
                 // 6.4.e Bind the empty root signature
                 m_sceneCommandList->SetComputeRootSignature(mpEmptyRootSig.Get());
                 m_sceneCommandList->SetComputeRootConstantBufferView(0, camera->GetCbv()->GetGPUVirtualAddressBuffered(camera->GetDeviceResources()->GetCurrentFrameIndex()));
-                m_sceneCommandList->SetComputeRootConstantBufferView(1, m_environment.GetEnvironmentConstantBuffer().Resource->GetGPUVirtualAddress());
+                m_sceneCommandList->SetComputeRootConstantBufferView(1, m_environment.GetEnvironmentConstantBuffer().GetGPUVirtualAddressBuffered(camera->GetDeviceResources()->GetCurrentFrameIndex()));
                 m_sceneCommandList->SetComputeRootDescriptorTable(2, GraphicsContexts::GetGpuHandle(mUavPosition));
                 UINT tlasFrame = GetReadyFrameIndex();
                 m_sceneCommandList->SetComputeRootDescriptorTable(3, GraphicsContexts::GetGpuHandle(mTlasSrvPosition[tlasFrame]));
@@ -995,10 +1015,18 @@ namespace CPyburnRTXEngine
         mpShaderTable.Reset();
         mpOutputResource.Reset();
 
-        GraphicsContexts::RemoveHeapPosition(mUavPosition);
+        if (mUavHandle.IsValid())
+        {
+            GraphicsContexts::FreeDescriptor(mUavHandle);
+            mUavHandle = DescriptorAllocator::Handle{};
+        }
         for (UINT i = 0; i < DX::DeviceResources::c_backBufferCount; i++)
         {
-            GraphicsContexts::RemoveHeapPosition(mTlasSrvPosition[i]);
+            if (mTlasSrvHandle[i].IsValid())
+            {
+                GraphicsContexts::FreeDescriptor(mTlasSrvHandle[i]);
+                mTlasSrvHandle[i] = DescriptorAllocator::Handle{};
+            }
         }
     }
 }
@@ -58,6 +58,7 @@ namespace CPyburnRTXEngine
 		AccelerationStructureBuffers mpTopLevelAS[DX::DeviceResources::c_backBufferCount];
 		
 		UINT64 mTlasSize = 0;
+		UINT mTlasInstanceCount[DX::DeviceResources::c_backBufferCount] = {}; // NumDescs of the last build, a refit needs the same
 
 		BufferHeap<XMFLOAT3> m_planeVertexBuffer;
 
@@ -86,6 +87,8 @@ namespace CPyburnRTXEngine
 
 		UINT mUavPosition = MAXUINT;
 		UINT mTlasSrvPosition[DX::DeviceResources::c_backBufferCount] = {};
+		DescriptorAllocator::Handle mUavHandle;
+		DescriptorAllocator::Handle mTlasSrvHandle[DX::DeviceResources::c_backBufferCount];
 
 		struct InstanceData
 		{
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "pchlib.h"
+
+namespace CPyburnRTXEngine
+{
+	// the node hierarchy of a model flattened parent before child, so local to global is one pass over plain arrays
+	// only what never changes per instance lives here, one per model shared by every AssimpAnimations
+	class Skeleton
+	{
+	private:
+		std::vector<UINT> m_parents; // MAXUINT for the root
+		std::vector<XMMATRIX> m_bindTransforms; // node transform relative to its parent, used when the node has no track
+		std::vector<UINT> m_boneIndices; // slot in the bone palette, MAXUINT when the node isn't a bone
+		std::vector<UINT> m_animationTracks; // track in the model's BakedAnimation, MAXUINT when the node isn't animated
+		std::vector<UINT> m_heights; // levels of nodes below this one, 0 for a leaf, far LOD skips sampling the low ones (fingers, toes)
+
+	public:
+		void Clear()
+		{
+			m_parents.clear();
+			m_bindTransforms.clear();
+			m_boneIndices.clear();
+			m_animationTracks.clear();
+			m_heights.clear();
+		}
+
+		// nodes have to come in parent before child order
+		void AddNode(const UINT& parentIndex, const XMFLOAT4X4& bindTransform, const UINT& boneIndex, const UINT& animationTrack)
+		{
+			m_parents.push_back(parentIndex);
+			m_bindTransforms.push_back(XMLoadFloat4x4(&bindTransform));
+			m_boneIndices.push_back(boneIndex);
+			m_animationTracks.push_back(animationTrack);
+			m_heights.push_back(0);
+
+			// push the new leaf's height up the chain until a parent already has a deeper branch
+			UINT height = 1;
+			for (UINT parent = parentIndex; parent != MAXUINT && m_heights[parent] < height; parent = m_parents[parent])
+			{
+				m_heights[parent] = height++;
+			}
+		}
+
+		UINT GetNodeCount() const { return static_cast<UINT>(m_parents.size()); }
+		const UINT& GetParent(const UINT& node) const { return m_parents[node]; }
+		const XMMATRIX& GetBindTransform(const UINT& node) const { return m_bindTransforms[node]; }
+		const UINT& GetBoneIndex(const UINT& node) const { return m_boneIndices[node]; }
+		const UINT& GetAnimationTrack(const UINT& node) const { return m_animationTracks[node]; }
+		const UINT& GetHeight(const UINT& node) const { return m_heights[node]; }
+	};
+}
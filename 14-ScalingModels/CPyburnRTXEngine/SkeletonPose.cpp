@@ -0,0 +1,45 @@
+#include "pchlib.h"
+#include "SkeletonPose.h"
+
+namespace CPyburnRTXEngine
+{
+	void SkeletonPose::Reset(const Skeleton& skeleton)
+	{
+		// the skeleton itself is shared by the model, only what changes per instance is kept here
+		const UINT nodeCount = skeleton.GetNodeCount();
+		m_globalTransforms.assign(nodeCount, XMMatrixIdentity());
+		m_globalNodeTransforms.assign(nodeCount, XMMatrixIdentity());
+		m_cursors.assign(nodeCount, KeyframeCursor{});
+		m_targetCursors.assign(nodeCount, KeyframeCursor{});
+
+		// weapons, particle and sound emitters should point at m_globalNodeTransforms, the node index is the factory's GetNodes() index
+	}
+
+	void SkeletonPose::StoreNodeTransform(const Skeleton& skeleton, const std::vector<XMMATRIX>& boneInfo, const UINT& node, const XMMATRIX& nodeTransformation, XMMATRIX* bones, XMMATRIX* noGlobalBones, XMMATRIX* global)
+	{
+		// parents come first, so their global transform is already written for this pass
+		const UINT& parentIndex = skeleton.GetParent(node);
+		const XMMATRIX parent = parentIndex != MAXUINT ? m_globalTransforms[parentIndex] : XMMatrixIdentity();
+
+		XMMATRIX xmTransposedNodeTransformation = XMMatrixTranspose(nodeTransformation);
+		XMMATRIX globalTransformation = parent * xmTransposedNodeTransformation;
+		m_globalTransforms[node] = globalTransformation;
+
+		const UINT& boneIndex = skeleton.GetBoneIndex(node);
+		if (boneIndex != MAXUINT)
+		{
+			noGlobalBones[boneIndex] = xmTransposedNodeTransformation * boneInfo[boneIndex];
+			global[boneIndex] = parent;
+
+			XMMATRIX finalTransformationConversion = parent * noGlobalBones[boneIndex];
+			bones[boneIndex] = XMMatrixTranspose(finalTransformationConversion); // if model is screwed up, you may have to remove transpose
+
+			// transpose this for easy math for modelNodes and LOD's
+			m_globalNodeTransforms[node] = XMMatrixTranspose(globalTransformation); //XMMatrixRotationRollPitchYaw(0.0f, 0.0f, 0.0f) * XMMatrixScaling(0.036f, 0.036f, 0.036f) * XMMatrixTranslation(0.09f, 0.04f, 0.0f)  // * XMMatrixTranspose(XMMatrixRotationRollPitchYaw(0.0f, 1.5708f, 1.5708f))
+		}
+		else if (skeleton.GetAnimationTrack(node) != MAXUINT) // give the areas that don't have bones but do have animation the global transform
+		{
+			m_globalNodeTransforms[node] = XMMatrixTranspose(globalTransformation);
+		}
+	}
+}
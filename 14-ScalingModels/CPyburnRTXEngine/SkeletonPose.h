@@ -0,0 +1,99 @@
+#pragma once
+
+#include "pchlib.h"
+#include "KeyframeSampler.h"
+#include "Skeleton.h"
+
+namespace CPyburnRTXEngine
+{
+	// the per instance half of posing a Skeleton, one pass over it in parent before child order
+	// nodes with a Skeleton::GetHeight below minSampledHeight keep their bind transform instead of sampling the clip
+	// Sampler is the model's CompressedAnimation, or its BakedAnimation when compression is off
+	class SkeletonPose
+	{
+	private:
+		std::vector<XMMATRIX> m_globalTransforms; // parent * node as the pass builds it, what the children multiply into
+		std::vector<XMMATRIX> m_globalNodeTransforms; // transposed, for giving skinned models weapons, emitting particles, and emitting sounds in the right position
+		std::vector<KeyframeCursor> m_cursors; // keys last sampled for the playing clip
+		std::vector<KeyframeCursor> m_targetCursors; // keys last sampled for the clip being blended in
+
+		// boneInfo is the inverse bind pose per bone, AssimpFactory::GetBoneInfo
+		void StoreNodeTransform(const Skeleton& skeleton, const std::vector<XMMATRIX>& boneInfo, const UINT& node, const XMMATRIX& nodeTransformation, XMMATRIX* bones, XMMATRIX* noGlobalBones, XMMATRIX* global);
+
+	public:
+		// sized for the skeleton, every node at identity and every cursor at its first key
+		void Reset(const Skeleton& skeleton);
+
+		template<typename Sampler>
+		void Read(const Skeleton& skeleton, const std::vector<XMMATRIX>& boneInfo, const Sampler& animation, float animationTime, const UINT& minSampledHeight, XMMATRIX* bones, XMMATRIX* noGlobalBones, XMMATRIX* global)
+		{
+			for (UINT node = 0; node < skeleton.GetNodeCount(); node++)
+			{
+				XMMATRIX nodeTransformation = skeleton.GetBindTransform(node);
+
+				const UINT& track = skeleton.GetAnimationTrack(node);
+				if (track != MAXUINT && skeleton.GetHeight(node) >= minSampledHeight)
+				{
+					KeyframeCursor& cursor = m_cursors[node];
+
+					XMVECTOR scaling = animation.SampleScaling(animationTime, track, cursor.scaling);
+					XMMATRIX scalingM = XMMatrixScalingFromVector(scaling);
+					XMVECTOR rotationQ = animation.SampleRotation(animationTime, track, cursor.rotation);
+					XMMATRIX rotationM = XMMatrixRotationQuaternion(rotationQ);
+					XMVECTOR translationV = animation.SamplePosition(animationTime, track, cursor.position);
+					XMMATRIX translationM = XMMatrixTranslationFromVector(translationV);
+
+					nodeTransformation = scalingM * rotationM * translationM;
+				}
+
+				StoreNodeTransform(skeleton, boneInfo, node, nodeTransformation, bones, noGlobalBones, global);
+			}
+		}
+
+		template<typename Sampler>
+		void ReadBlended(const Skeleton& skeleton, const std::vector<XMMATRIX>& boneInfo, const Sampler& animation, float blendFactor, float animationTimeCurrent, float animationTimeTarget, const UINT& minSampledHeight, XMMATRIX* bones, XMMATRIX* noGlobalBones, XMMATRIX* global)
+		{
+			for (UINT node = 0; node < skeleton.GetNodeCount(); node++)
+			{
+				XMMATRIX nodeTransformation = skeleton.GetBindTransform(node);
+
+				const UINT& track = skeleton.GetAnimationTrack(node);
+				if (track != MAXUINT && skeleton.GetHeight(node) >= minSampledHeight)
+				{
+					KeyframeCursor& cursor = m_cursors[node];
+					KeyframeCursor& targetCursor = m_targetCursors[node];
+
+					// scaling
+					XMVECTOR xmScalingCurrent = animation.SampleScaling(animationTimeCurrent, track, cursor.scaling);
+					XMVECTOR xmScalingTarget = animation.SampleScaling(animationTimeTarget, track, targetCursor.scaling);
+					XMVECTOR xmScaling = XMVectorLerp(xmScalingCurrent, xmScalingTarget, blendFactor);
+					XMMATRIX scalingBlendedM = XMMatrixScalingFromVector(xmScaling);
+
+					// rotation
+					XMVECTOR rotationCurrentQ = animation.SampleRotation(animationTimeCurrent, track, cursor.rotation);
+					XMVECTOR rotationTargetQ = animation.SampleRotation(animationTimeTarget, track, targetCursor.rotation);
+					XMVECTOR rotationBlendedQ = XMQuaternionSlerp(rotationCurrentQ, rotationTargetQ, blendFactor);
+
+					XMMATRIX rotationBlendedM = XMMatrixRotationQuaternion(rotationBlendedQ);
+
+					// translation
+					XMVECTOR xmTranslationCurrent = animation.SamplePosition(animationTimeCurrent, track, cursor.position);
+					XMVECTOR xmTranslationTarget = animation.SamplePosition(animationTimeTarget, track, targetCursor.position);
+
+					XMVECTOR xmTranslation = XMVectorLerp(xmTranslationCurrent, xmTranslationTarget, blendFactor);
+					XMMATRIX translationBlendedM = XMMatrixTranslationFromVector(xmTranslation);
+
+					nodeTransformation = scalingBlendedM * rotationBlendedM * translationBlendedM;
+				}
+
+				StoreNodeTransform(skeleton, boneInfo, node, nodeTransformation, bones, noGlobalBones, global);
+			}
+		}
+
+		// column vector, the translation is the last column
+		const XMMATRIX& GetGlobalTransform(const UINT& node) const { return m_globalTransforms[node]; }
+		const std::vector<XMMATRIX>& GetGlobalNodeTransforms() const { return m_globalNodeTransforms; }
+		// for a unit that took its pose from the PoseCache, so weapons and emitters follow the shared pose
+		void CopyNodeTransforms(const SkeletonPose& source) { m_globalNodeTransforms = source.m_globalNodeTransforms; }
+	};
+}
@@ -0,0 +1,166 @@
+#include "pchlib.h"
+#include "SkinningBatch.h"
+
+#include "GraphicsContexts.h"
+#include "AssimpAnimations.h"
+
+namespace CPyburnRTXEngine
+{
+	SkinningBatch::SkinningBatch()
+	{
+	}
+
+	SkinningBatch::~SkinningBatch()
+	{
+		if (m_ringMatricesView.IsValid())
+		{
+			GraphicsContexts::FreeDescriptor(m_ringMatricesView);
+		}
+		if (m_ringDualQuaternionsView.IsValid())
+		{
+			GraphicsContexts::FreeDescriptor(m_ringDualQuaternionsView);
+		}
+	}
+
+	void SkinningBatch::CreateDeviceDependentResources(DX::DeviceResources* deviceResources)
+	{
+		m_deviceResources = deviceResources;
+
+		// every buffer is found through ResourceDescriptorHeap, so only the table and two constants are bound
+		Microsoft::WRL::ComPtr<IDxcBlob> shaderBlob = GraphicsContexts::CompileHlslLibrary(m_deviceResources->GetD3DDevice(), L"skinnedComputeBatched.hlsl", L"CS", L"cs_6_6");
+
+		CD3DX12_ROOT_PARAMETER params[2];
+		params[0].InitAsConstants(2, 0); // b0 entry count, group offset
+		params[1].InitAsShaderResourceView(0); // t0 entries
+
+		CD3DX12_ROOT_SIGNATURE_DESC desc;
+		desc.Init(_countof(params), params, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED);
+
+		Microsoft::WRL::ComPtr<ID3DBlob> sig, err;
+		HRESULT hr = D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &sig, &err);
+		if (FAILED(hr))
+		{
+			if (err) OutputDebugStringA((char*)err->GetBufferPointer());
+			throw std::runtime_error("Failed to serialize skinning batch root signature");
+		}
+
+		DX::ThrowIfFailed(m_deviceResources->GetD3DDevice()->CreateRootSignature(0, sig->GetBufferPointer(), sig->GetBufferSize(), IID_PPV_ARGS(&m_rootSig)));
+
+		D3D12_COMPUTE_PIPELINE_STATE_DESC pso = {};
+		pso.pRootSignature = m_rootSig.Get();
+		pso.CS = { shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize() };
+
+		DX::ThrowIfFailed(m_deviceResources->GetD3DDevice()->CreateComputePipelineState(&pso, IID_PPV_ARGS(&m_pso)));
+
+		for (UINT i = 0; i < DX::DeviceResources::c_backBufferCount; i++)
+		{
+			m_entries[i].CreateDeviceDependentResources(m_deviceResources->GetD3DDevice());
+		}
+
+		const UploadRing& uploadRing = GraphicsContexts::GetUploadRing();
+		if (!uploadRing.GetResource())
+		{
+			throw std::runtime_error("SkinningBatch needs the upload ring, create GraphicsContexts' device resources first");
+		}
+
+		// the ring never moves, so these are made once and each entry only says where its palette starts
+		auto createRingView = [this, &uploadRing](DescriptorAllocator::Handle& view, const UINT& stride)
+			{
+				if (!view.IsValid())
+				{
+					view = GraphicsContexts::AllocateDescriptor();
+				}
+
+				D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+				srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+				srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+				srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+				srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+				srvDesc.Buffer.StructureByteStride = stride;
+				srvDesc.Buffer.NumElements = static_cast<UINT>(uploadRing.GetSize() / stride);
+				m_deviceResources->GetD3DDevice()->CreateShaderResourceView(uploadRing.GetResource(), &srvDesc, GraphicsContexts::GetCpuHandle(view.index));
+			};
+		createRingView(m_ringMatricesView, static_cast<UINT>(sizeof(XMMATRIX)));
+		createRingView(m_ringDualQuaternionsView, static_cast<UINT>(sizeof(DualQuaternion)));
+	}
+
+	void SkinningBatch::CreateBuffers(const UINT& capacity)
+	{
+		m_animations.reserve(capacity);
+
+		for (UINT i = 0; i < DX::DeviceResources::c_backBufferCount; i++)
+		{
+			m_entries[i].CreateOnUploadHeap(std::max(capacity, 1u), L"Skinning Batch Entries");
+		}
+	}
+
+	void SkinningBatch::Begin(const UINT& frameIndex)
+	{
+		m_frameIndex = frameIndex;
+		m_animations.clear();
+		m_groupCount = 0;
+	}
+
+	void SkinningBatch::Add(AssimpAnimations* animation)
+	{
+		if (m_animations.size() >= m_entries[m_frameIndex].ElementCount)
+		{
+			DebugTrace("SkinningBatch more entities than its capacity");
+			return;
+		}
+
+		const AnimationCompute* compute = animation->GetAnimationCompute();
+
+		Entry entry;
+		entry.baseVerticesIndex = compute->GetBaseVertexBuffer()->HeapIndex;
+		entry.boneDataIndex = compute->GetBoneDataBuffer()->HeapIndex;
+		entry.boneMatricesIndex = compute->IsDualQuaternion() ? m_ringDualQuaternionsView.index : m_ringMatricesView.index;
+		entry.outVerticesIndex = compute->GetVertexOutputBuffer().HeapIndex;
+		entry.vertexCount = compute->GetBaseVertexBuffer()->ElementCount;
+		entry.dualQuaternion = compute->IsDualQuaternion() ? 1 : 0;
+		entry.paletteFirstElement = compute->GetPaletteFirstElement();
+
+		PlaceEntry(entry, m_groupCount);
+
+		m_entries[m_frameIndex].MappedData[m_animations.size()] = entry;
+		m_animations.push_back(animation);
+	}
+
+	void SkinningBatch::Record(ID3D12GraphicsCommandList4* commandList)
+	{
+		if (m_animations.empty())
+			return;
+
+		PIXBeginEvent(commandList, 0, L"Skinning Batch");
+
+		ID3D12DescriptorHeap* heaps[] = { GraphicsContexts::c_heap.Get() };
+		commandList->SetDescriptorHeaps(1, heaps);
+
+		commandList->SetPipelineState(m_pso.Get());
+		commandList->SetComputeRootSignature(m_rootSig.Get());
+		commandList->SetComputeRootShaderResourceView(1, m_entries[m_frameIndex].UploadHeapResource->GetGPUVirtualAddress());
+
+		const UINT entryCount = GetEntryCount();
+		const UINT dispatchCount = GetDispatchCount(m_groupCount);
+		for (UINT dispatch = 0; dispatch < dispatchCount; dispatch++)
+		{
+			const DispatchRange range = GetDispatchRange(m_groupCount, dispatch);
+			UINT constants[2] = { entryCount, range.groupOffset };
+			commandList->SetComputeRoot32BitConstants(0, _countof(constants), constants, 0);
+			commandList->Dispatch(range.groupCount, 1, 1);
+		}
+
+		// a null UAV barrier covers every output buffer at once
+		D3D12_RESOURCE_BARRIER uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
+		commandList->ResourceBarrier(1, &uavBarrier);
+
+		// each BLAS has its own scratch, so the builds can overlap until the last barrier, most of them are refits
+		for (AssimpAnimations* animation : m_animations)
+		{
+			animation->GetAnimationBlasPtr()->BuildBlas(commandList, animation->GetPoseDelta());
+		}
+		commandList->ResourceBarrier(1, &uavBarrier);
+
+		PIXEndEvent(commandList);
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "pchlib.h"
+#include "BufferHeap.h"
+
+namespace CPyburnRTXEngine
+{
+	class AssimpAnimations; // forward declaration
+
+	// skins every entity that got a new pose this frame in one compute pass instead of one dispatch and barrier each
+	// a table of heap indices says where each entity's vertices, bone data, palette and output are, the shader finds its entity by thread group
+	// then one barrier, every BLAS build, and one more barrier before the TLAS
+	class SkinningBatch
+	{
+	public:
+		// must match SkinningEntry in skinnedComputeBatched.hlsl
+		struct Entry
+		{
+			UINT baseVerticesIndex = MAXUINT;
+			UINT boneDataIndex = MAXUINT;
+			UINT boneMatricesIndex = MAXUINT; // a view over the whole upload ring, of dual quaternions when dualQuaternion is set
+			UINT outVerticesIndex = MAXUINT;
+			UINT vertexCount = 0;
+			UINT firstGroup = 0; // prefix of the groups before it, the shader's search key
+			UINT dualQuaternion = 0;
+			UINT paletteFirstElement = 0; // where the entity's palette starts in that view
+		};
+
+		static constexpr UINT c_groupSize = 256; // numthreads in skinnedComputeBatched.hlsl
+		static constexpr UINT c_maxGroupsPerDispatch = D3D12_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION;
+
+		// one of the dispatches Record splits the batch into, the shader adds groupOffset to its group id
+		struct DispatchRange
+		{
+			UINT groupOffset = 0;
+			UINT groupCount = 0;
+		};
+
+		// the table on its own, no device needed so the entry and dispatch layout can be tested without a gpu
+		static UINT GetGroupCount(const UINT& vertexCount) { return (vertexCount + c_groupSize - 1) / c_groupSize; }
+
+		// entry starts at the groups so far, groupCount grows by what it needs
+		static void PlaceEntry(Entry& entry, UINT& groupCount)
+		{
+			entry.firstGroup = groupCount;
+			groupCount += GetGroupCount(entry.vertexCount);
+		}
+
+		static UINT GetDispatchCount(const UINT& groupCount, const UINT& maxGroupsPerDispatch = c_maxGroupsPerDispatch)
+		{
+			return (groupCount + maxGroupsPerDispatch - 1) / maxGroupsPerDispatch;
+		}
+
+		static DispatchRange GetDispatchRange(const UINT& groupCount, const UINT& dispatch, const UINT& maxGroupsPerDispatch = c_maxGroupsPerDispatch)
+		{
+			DispatchRange range;
+			range.groupOffset = dispatch * maxGroupsPerDispatch;
+			range.groupCount = std::min(groupCount - range.groupOffset, maxGroupsPerDispatch);
+			return range;
+		}
+
+		// the entry a group works on, the same search as skinnedComputeBatched.hlsl, at least one entry and in firstGroup order
+		static UINT FindEntry(const Entry* entries, const UINT& entryCount, const UINT& group)
+		{
+			UINT low = 0;
+			UINT high = entryCount - 1;
+			while (low < high)
+			{
+				UINT mid = (low + high + 1) / 2;
+				if (entries[mid].firstGroup <= group)
+					low = mid;
+				else
+					high = mid - 1;
+			}
+			return low;
+		}
+
+	private:
+
+		BufferHeap<Entry> m_entries[DX::DeviceResources::c_backBufferCount]; // written through the mapped pointer, read as a root SRV
+		// the palettes are on the upload ring, one view per element type covers all of them
+		DescriptorAllocator::Handle m_ringMatricesView;
+		DescriptorAllocator::Handle m_ringDualQuaternionsView;
+		std::vector<AssimpAnimations*> m_animations; // this frame's, in entry order
+		UINT m_frameIndex = 0;
+		UINT m_groupCount = 0;
+		bool m_enabled = true;
+
+		Microsoft::WRL::ComPtr<ID3D12RootSignature> m_rootSig;
+		Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pso;
+
+		DX::DeviceResources* m_deviceResources = nullptr;
+
+	public:
+		SkinningBatch();
+		~SkinningBatch();
+
+		SkinningBatch(const SkinningBatch&) = delete;
+		SkinningBatch& operator=(const SkinningBatch&) = delete;
+
+		void CreateDeviceDependentResources(DX::DeviceResources* deviceResources);
+		// capacity is the most entities one frame can skin, every animated entity
+		void CreateBuffers(const UINT& capacity);
+
+		// when off EntitiesManager dispatches and builds per entity like before
+		void SetEnabled(const bool& enabled) { m_enabled = enabled; }
+		bool IsEnabled() const { return m_enabled; }
+
+		void Begin(const UINT& frameIndex);
+		// writes the entity's entry straight into this frame's mapped table
+		void Add(AssimpAnimations* animation);
+		// total thread groups of what was added since Begin
+		UINT GetGroupCount() const { return m_groupCount; }
+		UINT GetEntryCount() const { return static_cast<UINT>(m_animations.size()); }
+		const Entry* GetEntries() const { return m_entries[m_frameIndex].MappedData; }
+
+		// the skinning dispatch, one barrier, every BLAS build and one barrier, nothing is recorded when nothing was added
+		void Record(ID3D12GraphicsCommandList4* commandList);
+	};
+}
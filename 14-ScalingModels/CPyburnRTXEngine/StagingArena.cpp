@@ -0,0 +1,228 @@
+#include "pchlib.h"
+#include "StagingArena.h"
+
+#include <unordered_set>
+
+namespace CPyburnRTXEngine
+{
+	void StagingArena::CreateDeviceDependentResources(ID3D12Device* d3dDevice, const UINT64& chunkSize)
+	{
+		Release();
+
+		m_d3dDevice = d3dDevice;
+		SetChunkSize(chunkSize);
+	}
+
+	void StagingArena::Release()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// only called once the gpu is idle, nothing in flight copies out of these anymore
+		for (Chunk& chunk : m_chunks)
+		{
+			if (chunk.resource)
+				chunk.resource->Unmap(0, nullptr);
+		}
+		for (Chunk& chunk : m_retired)
+		{
+			if (chunk.resource)
+				chunk.resource->Unmap(0, nullptr);
+		}
+		m_chunks.clear();
+		m_retired.clear();
+		m_copies.clear();
+		m_open = false;
+	}
+
+	void StagingArena::Begin()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (m_open)
+		{
+			DebugTrace("StagingArena Begin while already open\n");
+			return;
+		}
+
+		m_open = true;
+		m_stagedBytes = 0;
+		m_stagedCount = 0;
+	}
+
+	UINT StagingArena::CreateChunk(const UINT64& size)
+	{
+		Chunk chunk;
+		chunk.size = std::max(size, m_chunkSize);
+
+		if (m_d3dDevice)
+		{
+			auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+			auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(chunk.size);
+			DX::ThrowIfFailed(m_d3dDevice->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &resourceDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&chunk.resource)));
+			chunk.resource->SetName(L"Staging Arena");
+
+			CD3DX12_RANGE readRange(0, 0);
+			DX::ThrowIfFailed(chunk.resource->Map(0, &readRange, reinterpret_cast<void**>(&chunk.mapped)));
+		}
+
+		m_chunks.push_back(std::move(chunk));
+		return static_cast<UINT>(m_chunks.size() - 1);
+	}
+
+	StagingArena::Region StagingArena::AllocateLocked(const UINT64& size, const UINT64& alignment)
+	{
+		if (!m_open || size == 0)
+			return Region{};
+
+		// only the last chunk takes more, the ones before it were full for an earlier upload and stay packed
+		UINT chunkIndex = MAXUINT;
+		UINT64 offset = 0;
+		if (!m_chunks.empty())
+		{
+			Chunk& last = m_chunks.back();
+			offset = (last.head + alignment - 1) & ~(alignment - 1);
+			if (offset + size <= last.size)
+			{
+				chunkIndex = static_cast<UINT>(m_chunks.size() - 1);
+			}
+		}
+
+		if (chunkIndex == MAXUINT)
+		{
+			chunkIndex = CreateChunk(size);
+			offset = 0;
+		}
+
+		Chunk& chunk = m_chunks[chunkIndex];
+		chunk.head = offset + size;
+
+		Region region;
+		region.chunk = chunkIndex;
+		region.offset = offset;
+		region.size = size;
+		if (chunk.mapped)
+		{
+			region.cpu = chunk.mapped + offset;
+		}
+		return region;
+	}
+
+	StagingArena::Region StagingArena::Allocate(const UINT64& size, const UINT64& alignment)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return AllocateLocked(size, alignment);
+	}
+
+	bool StagingArena::Stage(ID3D12Resource* destination, const UINT64& destinationOffset, const void* data, const UINT64& size, const D3D12_RESOURCE_STATES& after)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		Region region = AllocateLocked(size, c_copyAlignment);
+		if (!region.IsValid())
+			return false;
+
+		if (region.cpu && data)
+		{
+			memcpy(region.cpu, data, static_cast<size_t>(size));
+		}
+
+		Copy copy;
+		copy.destination = destination;
+		copy.destinationOffset = destinationOffset;
+		copy.source = region;
+		copy.after = after;
+		m_copies.push_back(copy);
+
+		m_stagedBytes += size;
+		m_stagedCount++;
+		return true;
+	}
+
+	std::vector<D3D12_RESOURCE_BARRIER> StagingArena::BuildBarriers() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return BuildBarriersLocked();
+	}
+
+	std::vector<D3D12_RESOURCE_BARRIER> StagingArena::BuildBarriersLocked() const
+	{
+		// in the order the destinations were first staged, a buffer filled by several copies still gets one transition
+		std::vector<D3D12_RESOURCE_BARRIER> barriers;
+		std::unordered_set<ID3D12Resource*> seen;
+		barriers.reserve(m_copies.size());
+		for (const Copy& copy : m_copies)
+		{
+			if (!seen.insert(copy.destination).second)
+				continue;
+
+			if (copy.after == D3D12_RESOURCE_STATE_COPY_DEST)
+				continue;
+
+			barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(copy.destination, D3D12_RESOURCE_STATE_COPY_DEST, copy.after));
+		}
+		return barriers;
+	}
+
+	void StagingArena::Record(ID3D12GraphicsCommandList* commandList)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_copies.empty())
+			return;
+
+		std::vector<D3D12_RESOURCE_BARRIER> barriers = BuildBarriersLocked();
+
+		PIXBeginEvent(commandList, 0, L"Staging Arena");
+
+		for (const Copy& copy : m_copies)
+		{
+			commandList->CopyBufferRegion(copy.destination, copy.destinationOffset, m_chunks[copy.source.chunk].resource.Get(), copy.source.offset, copy.source.size);
+		}
+
+		if (!barriers.empty())
+		{
+			commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+		}
+
+		PIXEndEvent(commandList);
+
+		m_copies.clear();
+	}
+
+	void StagingArena::End(const UINT64& fenceValue)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (!m_copies.empty())
+		{
+			DebugTrace("StagingArena ended with %u copies never recorded, those buffers stay empty\n", static_cast<UINT>(m_copies.size()));
+			m_copies.clear();
+		}
+
+		for (Chunk& chunk : m_chunks)
+		{
+			chunk.fenceValue = fenceValue;
+			m_retired.push_back(std::move(chunk));
+		}
+		m_chunks.clear();
+		m_open = false;
+	}
+
+	UINT StagingArena::Reclaim(const UINT64& completedFenceValue)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		size_t reclaimed = 0;
+		while (reclaimed < m_retired.size() && m_retired[reclaimed].fenceValue <= completedFenceValue)
+		{
+			Chunk& chunk = m_retired[reclaimed];
+			if (chunk.resource)
+			{
+				chunk.resource->Unmap(0, nullptr);
+			}
+			reclaimed++;
+		}
+		m_retired.erase(m_retired.begin(), m_retired.begin() + reclaimed);
+
+		return static_cast<UINT>(reclaimed);
+	}
+}
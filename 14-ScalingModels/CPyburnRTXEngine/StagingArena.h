@@ -0,0 +1,108 @@
+#pragma once
+
+#include "pchlib.h"
+
+#include <mutex>
+
+namespace CPyburnRTXEngine
+{
+	// gathers the static uploads of a load phase into a few large upload buffers instead of a committed upload resource per buffer
+	// BufferHeap stages into it while it is open, Record writes every copy as a CopyBufferRegion with one barrier batch after them,
+	// End tags the chunks with the fence of the command list carrying the copies and Reclaim frees them once that fence completed
+	// packing and barrier building don't touch the device, without CreateDeviceDependentResources the offsets and barriers still work
+	class StagingArena
+	{
+	public:
+		struct Region
+		{
+			UINT chunk = MAXUINT;
+			UINT64 offset = 0;
+			UINT64 size = 0;
+			uint8_t* cpu = nullptr; // nullptr when headless
+
+			bool IsValid() const { return chunk != MAXUINT; }
+		};
+
+		static constexpr UINT64 c_copyAlignment = 16; // CopyBufferRegion doesn't need any, this keeps the staged data aligned for the cpu
+
+	private:
+		struct Chunk
+		{
+			Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+			uint8_t* mapped = nullptr;
+			UINT64 size = 0;
+			UINT64 head = 0;
+			UINT64 fenceValue = 0; // set by End, the chunk is freed once it completes
+		};
+
+		struct Copy
+		{
+			ID3D12Resource* destination = nullptr;
+			UINT64 destinationOffset = 0;
+			Region source;
+			D3D12_RESOURCE_STATES after = D3D12_RESOURCE_STATE_GENERIC_READ;
+		};
+
+		UINT64 m_chunkSize = 0;
+		bool m_open = false;
+
+		std::vector<Chunk> m_chunks; // of the open load phase
+		std::vector<Chunk> m_retired; // in fence order, waiting for the gpu to finish copying out of them
+		std::vector<Copy> m_copies; // staged and not recorded yet
+
+		UINT64 m_stagedBytes = 0;
+		UINT m_stagedCount = 0;
+
+		ID3D12Device* m_d3dDevice = nullptr;
+
+		mutable std::mutex m_mutex;
+
+		// a new chunk when the last one has no room, one of the upload's own size when it is larger than a chunk
+		UINT CreateChunk(const UINT64& size);
+		Region AllocateLocked(const UINT64& size, const UINT64& alignment);
+		std::vector<D3D12_RESOURCE_BARRIER> BuildBarriersLocked() const;
+
+	public:
+		StagingArena() = default;
+		~StagingArena() { Release(); }
+
+		StagingArena(const StagingArena&) = delete;
+		StagingArena& operator=(const StagingArena&) = delete;
+
+		// size of each chunk, takes effect on the next Begin
+		void SetChunkSize(const UINT64& chunkSize) { m_chunkSize = chunkSize; }
+		// SetChunkSize plus the device the chunks come from
+		void CreateDeviceDependentResources(ID3D12Device* d3dDevice, const UINT64& chunkSize);
+		void Release();
+
+		// static uploads go through the arena until End
+		void Begin();
+		bool IsOpen() const { std::lock_guard<std::mutex> lock(m_mutex); return m_open; }
+
+		// packs size bytes into the open chunks, an invalid region when the arena is closed
+		Region Allocate(const UINT64& size, const UINT64& alignment = c_copyAlignment);
+
+		// copies data into the arena and queues the copy into destination, which has to be a buffer still in the common state
+		// false when the arena is closed, the caller uploads on its own then
+		bool Stage(ID3D12Resource* destination, const UINT64& destinationOffset, const void* data, const UINT64& size, const D3D12_RESOURCE_STATES& after = D3D12_RESOURCE_STATE_GENERIC_READ);
+
+		// one transition per destination out of COPY_DEST, however many copies went into it
+		// the copies need none before them, a buffer in the common state is promoted to COPY_DEST by the copy itself
+		std::vector<D3D12_RESOURCE_BARRIER> BuildBarriers() const;
+
+		// every staged copy so far, then the barriers from BuildBarriers in one call, anything that reads the buffers has to be recorded after this
+		void Record(ID3D12GraphicsCommandList* commandList);
+
+		// closes the load phase, fenceValue is what the command list Record went into will signal
+		void End(const UINT64& fenceValue);
+
+		// frees every chunk whose copies completed, returns how many
+		UINT Reclaim(const UINT64& completedFenceValue);
+
+		UINT GetChunkCount() const { std::lock_guard<std::mutex> lock(m_mutex); return static_cast<UINT>(m_chunks.size() + m_retired.size()); }
+		UINT GetPendingCopyCount() const { std::lock_guard<std::mutex> lock(m_mutex); return static_cast<UINT>(m_copies.size()); }
+		// of the current load phase, what went through the arena instead of a committed upload resource each
+		UINT64 GetStagedBytes() const { std::lock_guard<std::mutex> lock(m_mutex); return m_stagedBytes; }
+		UINT GetStagedCount() const { std::lock_guard<std::mutex> lock(m_mutex); return m_stagedCount; }
+	};
+}
@@ -943,10 +943,12 @@ namespace CPyburnRTXEngine
         m_deviceResources = deviceResources;
 
         // reserve the uav position and srv position
-        mUavPosition = GraphicsContexts::GetAvailableHeapPosition();
+        mUavHandle = GraphicsContexts::AllocateDescriptor();
+        mUavPosition = mUavHandle.index;
         for (UINT i = 0; i < DX::DeviceResources::c_backBufferCount; i++)
         {
-            mTlasSrvPosition[i] = GraphicsContexts::GetAvailableHeapPosition();
+            mTlasSrvHandle[i] = GraphicsContexts::AllocateDescriptor();
+            mTlasSrvPosition[i] = mTlasSrvHandle[i].index;
         }
 
         // want the heap positions to be contiguous, so load models after reserving the positions
@@ -1094,10 +1096,18 @@ namespace CPyburnRTXEngine
             m_EnvironmentCb.Release();
         }
 
-        GraphicsContexts::RemoveHeapPosition(mUavPosition);
+        if (mUavHandle.IsValid())
+        {
+            GraphicsContexts::FreeDescriptor(mUavHandle);
+            mUavHandle = DescriptorAllocator::Handle{};
+        }
         for (UINT i = 0; i < DX::DeviceResources::c_backBufferCount; i++)
         {
-            GraphicsContexts::RemoveHeapPosition(mTlasSrvPosition[i]);
+            if (mTlasSrvHandle[i].IsValid())
+            {
+                GraphicsContexts::FreeDescriptor(mTlasSrvHandle[i]);
+                mTlasSrvHandle[i] = DescriptorAllocator::Handle{};
+            }
         }
     }
 }
@@ -73,6 +73,8 @@ namespace CPyburnRTXEngine
 
 		UINT mUavPosition = 0;
 		UINT mTlasSrvPosition[DX::DeviceResources::c_backBufferCount] = {};
+		DescriptorAllocator::Handle mUavHandle;
+		DescriptorAllocator::Handle mTlasSrvHandle[DX::DeviceResources::c_backBufferCount];
 		AssimpFactory m_assimpFactory;
 		Texture::HeapTexture m_heapTextureDiffuse = {};
 
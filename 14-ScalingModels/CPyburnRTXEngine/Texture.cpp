@@ -6,11 +6,12 @@
 
 namespace CPyburnRTXEngine
 {
-	UINT Texture::m_textureStartOnHeap = 0;
     std::unordered_map<UINT, Microsoft::WRL::ComPtr<ID3D12Resource>> Texture::m_texturesUpload;
     std::unordered_map<UINT, Microsoft::WRL::ComPtr<ID3D12Resource>> Texture::m_textures;
     std::unordered_map<std::string, Texture::HeapTexture> Texture::m_loadedTextures;
     std::mutex Texture::m_mutex;
+	std::mutex Texture::m_decodedMutex;
+	std::unordered_map<std::wstring, Texture::DecodedTexture> Texture::m_decodedTextures;
 	ID3D12Device* Texture::m_d3dDevice = nullptr;
 
     bool Texture::TryGetTextureHeap(const std::string& spath, Texture::HeapTexture& textureHeap)
@@ -72,19 +73,10 @@ namespace CPyburnRTXEngine
 		}
 
 		// texture doesn't exist so load it
-		std::wstring wpath = std::wstring(spath.begin(), spath.end());
-
-		wchar_t drive[_MAX_DRIVE];
-		wchar_t dir[_MAX_DIR];
-		wchar_t fname[_MAX_FNAME];
-		wchar_t ext[_MAX_EXT];
-		_wsplitpath_s(wpath.c_str(), drive, dir, fname, ext);
-
-		// put extension to lower to check for type
-		std::wstring extension = (std::wstring)ext;
-		std::wstring wFileName = (std::wstring)fname + extension;
-		wFileName.erase(std::remove(wFileName.begin(), wFileName.end(), '\r'), wFileName.end());
-		transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+		std::wstring wFileName;
+		std::wstring szFile;
+		std::wstring extension;
+		bool found = ResolveTextureFile(spath, wFileName, szFile, extension);
 
 		//auto textureIter = LoadedTextures.find(wFileName);
 		//if (textureIter != LoadedTextures.end())
@@ -99,8 +91,6 @@ namespace CPyburnRTXEngine
 		UINT height = 1;
 		uint8_t* data = nullptr;
 		size_t rowPitch;
-		
-		std::wstring szFile = (std::wstring)dir + wFileName;
 
 		if (wFileName.compare(L"white") == 0)
 		{
@@ -126,14 +116,9 @@ namespace CPyburnRTXEngine
 		//}
 		else
 		{
-			struct _stat buffer;
-			if (_wstat(szFile.c_str(), &buffer) != 0)
+			if (!found)
 			{
-				szFile.append(L" not found, using test image instead.\n");
-				OutputDebugStringA(wstringToString(szFile).c_str());
-				extension = L".tga";
-				wFileName = L"test" + extension;
-				szFile = L"Assets\\" + wFileName;
+				OutputDebugStringA((spath + " not found, using test image instead.\n").c_str());
 
 				// also change the extension because that is used to call the correct file
 				HeapTexture testTextureHeap;
@@ -145,27 +130,11 @@ namespace CPyburnRTXEngine
 			}
 
 #pragma region Get Image
-			if (extension.compare(L".dds") == 0)
-			{
-				heapTexture = LoadCustomDDSTexture(commandList, szFile);
-			}
-			//else if (extension.compare(L".tga") == 0)
-			//{
-			//	DirectX::LoadFromTGAFile(szFile.c_str(), nullptr, image);
-			//}
-			else
-			{
-				heapTexture = LoadCustomWICTexture(commandList, szFile);
-			}
+			heapTexture = LoadCustomFileTexture(commandList, szFile, extension);
 #pragma endregion
 		}
 
-		if (m_textureStartOnHeap == 0)
-		{
-			m_textureStartOnHeap = heapTexture.heapPosition;
-		}
-
-		heapTexture.indexInMaterialBuffer = heapTexture.heapPosition - m_textureStartOnHeap;
+		heapTexture.indexInMaterialBuffer = heapTexture.heapPosition - GraphicsContexts::GetRegionStart(GraphicsContexts::HeapRegion::Textures);
 
 		m_mutex.unlock();
 
@@ -180,6 +149,9 @@ namespace CPyburnRTXEngine
 		Texture::m_loadedTextures.clear();
 		Texture::m_texturesUpload.clear();
 		m_mutex.unlock();
+
+		std::lock_guard<std::mutex> lock(m_decodedMutex);
+		m_decodedTextures.clear();
     }
 
     void Texture::ReleaseUploadByHeapPosition(UINT heapPosition)
@@ -189,40 +161,69 @@ namespace CPyburnRTXEngine
 		m_mutex.unlock();
     }
 
-	Texture::HeapTexture Texture::LoadCustomDDSTexture(ID3D12GraphicsCommandList* commandList, const std::wstring& wFileName)
+	bool Texture::ResolveTextureFile(const std::string& spath, std::wstring& wFileName, std::wstring& szFile, std::wstring& extension)
 	{
-		bool didLock = m_mutex.try_lock();
+		std::wstring wpath = std::wstring(spath.begin(), spath.end());
 
-		// check to see if texture exists
-		Texture::HeapTexture heapTexture;
-		if (Texture::TryGetTextureHeap(wstringToString(wFileName), heapTexture))
-		{
-			if (didLock)
-			{
-				m_mutex.unlock();
-			}
+		wchar_t drive[_MAX_DRIVE];
+		wchar_t dir[_MAX_DIR];
+		wchar_t fname[_MAX_FNAME];
+		wchar_t ext[_MAX_EXT];
+		_wsplitpath_s(wpath.c_str(), drive, dir, fname, ext);
 
-			// it does, so return it
-			return heapTexture;
+		// put extension to lower to check for type
+		extension = (std::wstring)ext;
+		wFileName = (std::wstring)fname + extension;
+		// paths read from a file written on windows can end in the \r of a line ending
+		wFileName.erase(std::remove(wFileName.begin(), wFileName.end(), '\r'), wFileName.end());
+		extension.erase(std::remove(extension.begin(), extension.end(), '\r'), extension.end());
+		transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+		szFile = (std::wstring)dir + wFileName;
+
+		struct _stat buffer;
+		if (wFileName.compare(L"white") == 0 || _wstat(szFile.c_str(), &buffer) == 0)
+		{
+			return true;
 		}
 
-		Microsoft::WRL::ComPtr<ID3D12Resource> tex;
-		std::unique_ptr<uint8_t[]> ddsData;
-		std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+		extension = L".tga";
+		wFileName = L"test" + extension;
+		szFile = L"Assets\\" + wFileName;
+		return false;
+	}
 
-		DX::ThrowIfFailed(
-			LoadDDSTextureFromFile(m_d3dDevice, wFileName.c_str(), tex.ReleaseAndGetAddressOf(),
-				ddsData, subresources));
+	Texture::DecodedTexture Texture::DecodeTexture(const std::wstring& szFile, const std::wstring& extension)
+	{
+		DecodedTexture decoded;
 
-		const UINT64 uploadBufferSize = GetRequiredIntermediateSize(tex.Get(), 0,
-			static_cast<UINT>(subresources.size()));
+		if (extension.compare(L".dds") == 0)
+		{
+			DX::ThrowIfFailed(
+				LoadDDSTextureFromFile(m_d3dDevice, szFile.c_str(), decoded.texture.ReleaseAndGetAddressOf(),
+					decoded.data, decoded.subresources));
+		}
+		//else if (extension.compare(L".tga") == 0)
+		//{
+		//	DirectX::LoadFromTGAFile(szFile.c_str(), nullptr, image);
+		//}
+		else
+		{
+			D3D12_SUBRESOURCE_DATA subresource;
+			DX::ThrowIfFailed(
+				LoadWICTextureFromFile(m_d3dDevice, szFile.c_str(), decoded.texture.ReleaseAndGetAddressOf(),
+					decoded.data, subresource));
+			decoded.subresources.push_back(subresource);
+		}
+
+		const UINT64 uploadBufferSize = GetRequiredIntermediateSize(decoded.texture.Get(), 0,
+			static_cast<UINT>(decoded.subresources.size()));
 
 		// Create the GPU upload buffer.
 		CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
 
 		auto desc = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
 
-		Microsoft::WRL::ComPtr<ID3D12Resource> uploadRes;
 		DX::ThrowIfFailed(
 			m_d3dDevice->CreateCommittedResource(
 				&heapProps,
@@ -230,51 +231,65 @@ namespace CPyburnRTXEngine
 				&desc,
 				D3D12_RESOURCE_STATE_GENERIC_READ,
 				nullptr,
-				IID_PPV_ARGS(uploadRes.GetAddressOf())));
+				IID_PPV_ARGS(decoded.upload.GetAddressOf())));
 
-		tex->SetName(wFileName.c_str());
-		uploadRes->SetName(wFileName.c_str());
+		decoded.texture->SetName(szFile.c_str());
+		decoded.upload->SetName(szFile.c_str());
 
-		// Upload the Shader Resource to the GPU.
-		{
-			UpdateSubresources(commandList, tex.Get(), uploadRes.Get(), 0, 0, static_cast<UINT>(subresources.size()), subresources.data());
+		return decoded;
+	}
 
-			CD3DX12_RESOURCE_BARRIER srvBufferResourceBarrier =
-				CD3DX12_RESOURCE_BARRIER::Transition(tex.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATES::D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-			commandList->ResourceBarrier(1, &srvBufferResourceBarrier);
+	bool Texture::TakeDecodedTexture(const std::wstring& szFile, DecodedTexture& decoded)
+	{
+		std::lock_guard<std::mutex> lock(m_decodedMutex);
 
-			// Describe and create a SRV for the texture.
-			D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-			srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-			srvDesc.Format = desc.Format;
-			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-			srvDesc.Texture2D.MipLevels = desc.MipLevels;
+		auto decodedIter = m_decodedTextures.find(szFile);
+		if (decodedIter == m_decodedTextures.end())
+		{
+			return false;
+		}
 
-			UINT heapPostion = GraphicsContexts::GetAvailableHeapPosition();
-			CD3DX12_CPU_DESCRIPTOR_HANDLE cbvCpuHandle(GraphicsContexts::c_heap->GetCPUDescriptorHandleForHeapStart(), heapPostion, GraphicsContexts::c_descriptorSize);
-			m_d3dDevice->CreateShaderResourceView(tex.Get(), &srvDesc, cbvCpuHandle);
+		decoded = std::move(decodedIter->second);
+		m_decodedTextures.erase(decodedIter);
+		return true;
+	}
 
-			HeapTexture heapTexture;
-			heapTexture.heapPosition = heapPostion;
-			UINT rowPitch = static_cast<UINT>(subresources[0].RowPitch);
-			UINT slicePitch = static_cast<UINT>(subresources[0].SlicePitch / subresources[0].RowPitch);
-			heapTexture.textureSize = XMINT2(rowPitch / 4 /*RGBA*/, slicePitch);
+	void Texture::PrefetchTexture(const std::string& spath)
+	{
+		std::wstring wFileName;
+		std::wstring szFile;
+		std::wstring extension;
+		ResolveTextureFile(spath, wFileName, szFile, extension);
 
-			Texture::m_loadedTextures.insert(std::pair<std::string, HeapTexture>(wstringToString(wFileName), heapTexture));
-			Texture::m_textures.insert(std::pair<UINT, Microsoft::WRL::ComPtr<ID3D12Resource> >(heapPostion, tex));
-			Texture::m_texturesUpload.insert(std::pair<UINT, Microsoft::WRL::ComPtr<ID3D12Resource> >(heapPostion, uploadRes));
-			if (didLock)
+		if (wFileName.compare(L"white") == 0)
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_decodedMutex);
+			if (m_decodedTextures.find(szFile) != m_decodedTextures.end())
 			{
-				m_mutex.unlock();
+				return;
 			}
+		}
 
-			GraphicsContexts::AddMultiHeapPosition(heapPostion);
+		// the WIC factory is created on first use, and that can happen on a worker
+		HRESULT comResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
 
-			return m_loadedTextures[wstringToString(wFileName)];
+		DecodedTexture decoded = DecodeTexture(szFile, extension);
+
+		if (SUCCEEDED(comResult))
+		{
+			CoUninitialize();
 		}
+
+		// two missing textures both land on the test image, the second decode is simply dropped
+		std::lock_guard<std::mutex> lock(m_decodedMutex);
+		m_decodedTextures.try_emplace(szFile, std::move(decoded));
 	}
 
-	Texture::HeapTexture Texture::LoadCustomWICTexture(ID3D12GraphicsCommandList* commandList, const std::wstring& wFileName)
+	Texture::HeapTexture Texture::LoadCustomFileTexture(ID3D12GraphicsCommandList* commandList, const std::wstring& wFileName, const std::wstring& extension)
 	{
 		bool didLock = m_mutex.try_lock();
 
@@ -291,40 +306,22 @@ namespace CPyburnRTXEngine
 			return heapTexture;
 		}
 
-		Microsoft::WRL::ComPtr<ID3D12Resource> tex;
-		std::unique_ptr<uint8_t[]> decodedData;
-		D3D12_SUBRESOURCE_DATA subresource;
-
-		DX::ThrowIfFailed(
-			LoadWICTextureFromFile(m_d3dDevice, wFileName.c_str(), tex.ReleaseAndGetAddressOf(),
-				decodedData, subresource));
-
-		const UINT64 uploadBufferSize = GetRequiredIntermediateSize(tex.Get(), 0, 1);
-
-		CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
-
-		auto desc = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
-
-		// Create the GPU upload buffer.
-		Microsoft::WRL::ComPtr<ID3D12Resource> uploadRes;
-		DX::ThrowIfFailed(
-			m_d3dDevice->CreateCommittedResource(
-				&heapProps,
-				D3D12_HEAP_FLAG_NONE,
-				&desc,
-				D3D12_RESOURCE_STATE_GENERIC_READ,
-				nullptr,
-				IID_PPV_ARGS(uploadRes.GetAddressOf())));
+		// most files were already decoded on the job system during the load, only the recording below has to be serial
+		DecodedTexture decoded;
+		if (!TakeDecodedTexture(wFileName, decoded))
+		{
+			decoded = DecodeTexture(wFileName, extension);
+		}
 
-		tex->SetName(wFileName.c_str());
-		uploadRes->SetName(wFileName.c_str());
+		ID3D12Resource* tex = decoded.texture.Get();
+		D3D12_RESOURCE_DESC desc = decoded.upload->GetDesc();
 
 		// Upload the Shader Resource to the GPU.
 		{
-			UpdateSubresources(commandList, tex.Get(), uploadRes.Get(), 0, 0, 1, &subresource);
+			UpdateSubresources(commandList, tex, decoded.upload.Get(), 0, 0, static_cast<UINT>(decoded.subresources.size()), decoded.subresources.data());
 
 			CD3DX12_RESOURCE_BARRIER srvBufferResourceBarrier =
-				CD3DX12_RESOURCE_BARRIER::Transition(tex.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATES::D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+				CD3DX12_RESOURCE_BARRIER::Transition(tex, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATES::D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 			commandList->ResourceBarrier(1, &srvBufferResourceBarrier);
 
 			// Describe and create a SRV for the texture.
@@ -334,19 +331,19 @@ namespace CPyburnRTXEngine
 			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
 			srvDesc.Texture2D.MipLevels = desc.MipLevels;
 
-			UINT heapPostion = GraphicsContexts::GetAvailableHeapPosition();
+			UINT heapPostion = GraphicsContexts::AllocateRange(GraphicsContexts::HeapRegion::Textures, 1).start;
 			CD3DX12_CPU_DESCRIPTOR_HANDLE cbvCpuHandle(GraphicsContexts::c_heap->GetCPUDescriptorHandleForHeapStart(), heapPostion, GraphicsContexts::c_descriptorSize);
-			m_d3dDevice->CreateShaderResourceView(tex.Get(), &srvDesc, cbvCpuHandle);
+			m_d3dDevice->CreateShaderResourceView(tex, &srvDesc, cbvCpuHandle);
 
 			HeapTexture heapTexture;
 			heapTexture.heapPosition = heapPostion;
-			UINT rowPitch = static_cast<UINT>(subresource.RowPitch);
-			UINT slicePitch = static_cast<UINT>(subresource.SlicePitch / subresource.RowPitch);
+			UINT rowPitch = static_cast<UINT>(decoded.subresources[0].RowPitch);
+			UINT slicePitch = static_cast<UINT>(decoded.subresources[0].SlicePitch / decoded.subresources[0].RowPitch);
 			heapTexture.textureSize = XMINT2(rowPitch / 4 /*RGBA*/, slicePitch);
 
 			Texture::m_loadedTextures.insert(std::pair<std::string, HeapTexture>(wstringToString(wFileName), heapTexture));
-			Texture::m_textures.insert(std::pair<UINT, Microsoft::WRL::ComPtr<ID3D12Resource> >(heapPostion, tex));
-			Texture::m_texturesUpload.insert(std::pair<UINT, Microsoft::WRL::ComPtr<ID3D12Resource> >(heapPostion, uploadRes));
+			Texture::m_textures.insert(std::pair<UINT, Microsoft::WRL::ComPtr<ID3D12Resource> >(heapPostion, decoded.texture));
+			Texture::m_texturesUpload.insert(std::pair<UINT, Microsoft::WRL::ComPtr<ID3D12Resource> >(heapPostion, decoded.upload));
 			if (didLock)
 			{
 				m_mutex.unlock();
@@ -425,7 +422,7 @@ namespace CPyburnRTXEngine
 			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
 			srvDesc.Texture2D.MipLevels = desc.MipLevels;
 
-			UINT heapPostion = GraphicsContexts::GetAvailableHeapPosition();
+			UINT heapPostion = GraphicsContexts::AllocateRange(GraphicsContexts::HeapRegion::Textures, 1).start;
 			CD3DX12_CPU_DESCRIPTOR_HANDLE cbvCpuHandle(GraphicsContexts::c_heap->GetCPUDescriptorHandleForHeapStart(), heapPostion, GraphicsContexts::c_descriptorSize);
 			m_d3dDevice->CreateShaderResourceView(tex.Get(), &srvDesc, cbvCpuHandle);
 
@@ -13,7 +13,6 @@ namespace CPyburnRTXEngine
 		};
 
 	private:
-		static UINT m_textureStartOnHeap;
 		static std::mutex m_mutex;
 
 		static ID3D12Device* m_d3dDevice;
@@ -22,12 +21,31 @@ namespace CPyburnRTXEngine
 		static std::unordered_map<UINT, Microsoft::WRL::ComPtr<ID3D12Resource>> m_textures;
 		static std::unordered_map<std::string, HeapTexture> m_loadedTextures;
 		static bool TryGetTextureHeap(const std::string& path, Texture::HeapTexture& textureHeap);
-		static Texture::HeapTexture LoadCustomDDSTexture(ID3D12GraphicsCommandList* commandList, const std::wstring& wFileName);
-		static Texture::HeapTexture LoadCustomWICTexture(ID3D12GraphicsCommandList* commandList, const std::wstring& wFileName);
+		static Texture::HeapTexture LoadCustomFileTexture(ID3D12GraphicsCommandList* commandList, const std::wstring& wFileName, const std::wstring& extension);
+
+		// a texture read off disk with its default and upload resources created, nothing recorded and no heap position yet
+		struct DecodedTexture
+		{
+			Microsoft::WRL::ComPtr<ID3D12Resource> texture;
+			Microsoft::WRL::ComPtr<ID3D12Resource> upload;
+			std::unique_ptr<uint8_t[]> data;
+			std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+		};
+		static std::mutex m_decodedMutex;
+		static std::unordered_map<std::wstring, DecodedTexture> m_decodedTextures; // filled by PrefetchTexture, keyed by the resolved file
+
+		// false when the file is missing and the test image is used instead
+		static bool ResolveTextureFile(const std::string& path, std::wstring& wFileName, std::wstring& szFile, std::wstring& extension);
+		static DecodedTexture DecodeTexture(const std::wstring& szFile, const std::wstring& extension);
+		static bool TakeDecodedTexture(const std::wstring& szFile, DecodedTexture& decoded);
+
+		friend class TextureTestAccess; // the test project resolves and decodes files without a command list
 
 	public:
 		static void CreateDeviceDependentResources(ID3D12Device* m_d3dDevice);
 		static HeapTexture LoadTextureHeap(const std::string& path, ID3D12GraphicsCommandList* commandList);
+		// decodes a texture ahead of LoadTextureHeap, safe to call from any thread because only the device is touched
+		static void PrefetchTexture(const std::string& path);
 		static void Release();
 		static void ReleaseUploadByHeapPosition(UINT heapPosition);
 
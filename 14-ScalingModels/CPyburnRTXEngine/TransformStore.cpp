@@ -0,0 +1,422 @@
+#include "pchlib.h"
+#include "TransformStore.h"
+
+namespace CPyburnRTXEngine
+{
+	void TransformStore::ComposeWorldMatrix(const UINT& slot)
+	{
+		XMVECTOR scale = XMVectorSet(m_scaleX[slot], m_scaleY[slot], m_scaleZ[slot], 0.0f);
+		XMVECTOR rotation = XMVectorSet(m_rotationX[slot], m_rotationY[slot], m_rotationZ[slot], 0.0f);
+		XMVECTOR position = XMVectorSet(m_positionX[slot], m_positionY[slot], m_positionZ[slot], 0.0f);
+
+		m_world[slot] = XMMatrixScalingFromVector(scale) * XMMatrixRotationRollPitchYawFromVector(rotation) * XMMatrixTranslationFromVector(position);
+
+		XMVECTOR localCenter = XMVectorSet(m_localBoundsX[slot], m_localBoundsY[slot], m_localBoundsZ[slot], 1.0f);
+		XMVECTOR center = XMVector3Transform(localCenter, m_world[slot]);
+		m_boundsX[slot] = XMVectorGetX(center);
+		m_boundsY[slot] = XMVectorGetY(center);
+		m_boundsZ[slot] = XMVectorGetZ(center);
+
+		// rotation keeps lengths, so only the largest scale grows the radius
+		float maxScale = std::max(std::max(fabsf(m_scaleX[slot]), fabsf(m_scaleY[slot])), fabsf(m_scaleZ[slot]));
+		m_boundsRadius[slot] = m_localBoundsRadius[slot] * maxScale;
+	}
+
+	void TransformStore::ComposeWorldMatrices4(const UINT& slot)
+	{
+		// every lane is a different entity, so one XMVectorSinCos handles 4 entities
+		XMVECTOR pitch = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_rotationX[slot]));
+		XMVECTOR yaw = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_rotationY[slot]));
+		XMVECTOR roll = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_rotationZ[slot]));
+
+		XMVECTOR sp, cp, sy, cy, sr, cr;
+		XMVectorSinCos(&sp, &cp, pitch);
+		XMVectorSinCos(&sy, &cy, yaw);
+		XMVectorSinCos(&sr, &cr, roll);
+
+		XMVECTOR scaleX = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_scaleX[slot]));
+		XMVECTOR scaleY = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_scaleY[slot]));
+		XMVECTOR scaleZ = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_scaleZ[slot]));
+
+		// same terms as XMMatrixRotationRollPitchYaw, with the scaling matrix folded into the rows
+		XMVECTOR m00 = (cr * cy + sr * sp * sy) * scaleX;
+		XMVECTOR m01 = (sr * cp) * scaleX;
+		XMVECTOR m02 = (sr * sp * cy - cr * sy) * scaleX;
+
+		XMVECTOR m10 = (cr * sp * sy - sr * cy) * scaleY;
+		XMVECTOR m11 = (cr * cp) * scaleY;
+		XMVECTOR m12 = (sr * sy + cr * sp * cy) * scaleY;
+
+		XMVECTOR m20 = (cp * sy) * scaleZ;
+		XMVECTOR m21 = XMVectorNegate(sp) * scaleZ;
+		XMVECTOR m22 = (cp * cy) * scaleZ;
+
+		XMVECTOR m30 = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_positionX[slot]));
+		XMVECTOR m31 = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_positionY[slot]));
+		XMVECTOR m32 = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_positionZ[slot]));
+
+		// transposing turns 4 lanes of one row into the same row of 4 matrices
+		XMMATRIX row0 = XMMatrixTranspose(XMMATRIX(m00, m01, m02, XMVectorZero()));
+		XMMATRIX row1 = XMMatrixTranspose(XMMATRIX(m10, m11, m12, XMVectorZero()));
+		XMMATRIX row2 = XMMatrixTranspose(XMMATRIX(m20, m21, m22, XMVectorZero()));
+		XMMATRIX row3 = XMMatrixTranspose(XMMATRIX(m30, m31, m32, XMVectorSplatOne()));
+
+		for (UINT lane = 0; lane < 4; lane++)
+		{
+			m_world[slot + lane] = XMMATRIX(row0.r[lane], row1.r[lane], row2.r[lane], row3.r[lane]);
+		}
+
+		// bounding spheres, center * world with the lanes still split per component
+		XMVECTOR localX = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_localBoundsX[slot]));
+		XMVECTOR localY = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_localBoundsY[slot]));
+		XMVECTOR localZ = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_localBoundsZ[slot]));
+		XMVECTOR localRadius = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_localBoundsRadius[slot]));
+
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&m_boundsX[slot]), XMVectorMultiplyAdd(localX, m00, XMVectorMultiplyAdd(localY, m10, XMVectorMultiplyAdd(localZ, m20, m30))));
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&m_boundsY[slot]), XMVectorMultiplyAdd(localX, m01, XMVectorMultiplyAdd(localY, m11, XMVectorMultiplyAdd(localZ, m21, m31))));
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&m_boundsZ[slot]), XMVectorMultiplyAdd(localX, m02, XMVectorMultiplyAdd(localY, m12, XMVectorMultiplyAdd(localZ, m22, m32))));
+
+		XMVECTOR maxScale = XMVectorMax(XMVectorMax(XMVectorAbs(scaleX), XMVectorAbs(scaleY)), XMVectorAbs(scaleZ));
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&m_boundsRadius[slot]), localRadius * maxScale);
+	}
+
+	void TransformStore::MarkWorldDirty(const UINT& slot)
+	{
+		if (!m_worldDirty[slot])
+		{
+			m_worldDirty[slot] = 1;
+			m_dirtyWorldSlots.push_back(slot);
+		}
+	}
+
+	void TransformStore::MarkFramesDirty(const UINT& slot)
+	{
+		if (!m_dirtyFrames[slot])
+		{
+			m_pendingSlots.push_back(slot);
+		}
+		m_dirtyFrames[slot] = c_allFramesDirty;
+	}
+
+	void TransformStore::MarkSlotDirty(const UINT& slot)
+	{
+		MarkWorldDirty(slot);
+		MarkFramesDirty(slot);
+	}
+
+	void TransformStore::ForgetSlot(const UINT& slot)
+	{
+		// only called from Remove, which is rare, so a linear search is fine
+		std::erase(m_dirtyWorldSlots, slot);
+		std::erase(m_pendingSlots, slot);
+		m_worldDirty[slot] = 0;
+		m_dirtyFrames[slot] = 0;
+	}
+
+	void TransformStore::Reserve(const UINT& count)
+	{
+		m_idBySlot.reserve(count);
+		m_positionX.reserve(count);
+		m_positionY.reserve(count);
+		m_positionZ.reserve(count);
+		m_rotationX.reserve(count);
+		m_rotationY.reserve(count);
+		m_rotationZ.reserve(count);
+		m_scaleX.reserve(count);
+		m_scaleY.reserve(count);
+		m_scaleZ.reserve(count);
+		m_world.reserve(count);
+		m_localBoundsX.reserve(count);
+		m_localBoundsY.reserve(count);
+		m_localBoundsZ.reserve(count);
+		m_localBoundsRadius.reserve(count);
+		m_boundsX.reserve(count);
+		m_boundsY.reserve(count);
+		m_boundsZ.reserve(count);
+		m_boundsRadius.reserve(count);
+		m_worldDirty.reserve(count);
+		m_dirtyFrames.reserve(count);
+		m_dirtyWorldSlots.reserve(count);
+		m_pendingSlots.reserve(count);
+	}
+
+	UINT TransformStore::Add(const UINT& id, const XMFLOAT3& position, const XMFLOAT3& rotation, const XMFLOAT3& scale)
+	{
+		if (Contains(id))
+		{
+			SetPosition(id, position);
+			SetRotation(id, rotation);
+			SetScale(id, scale);
+			return m_slotById[id];
+		}
+
+		if (id >= m_slotById.size())
+		{
+			m_slotById.resize(static_cast<size_t>(id) + 1, MAXUINT);
+		}
+
+		UINT slot = GetCount();
+		m_slotById[id] = slot;
+		m_idBySlot.push_back(id);
+
+		m_positionX.push_back(position.x);
+		m_positionY.push_back(position.y);
+		m_positionZ.push_back(position.z);
+		m_rotationX.push_back(rotation.x);
+		m_rotationY.push_back(rotation.y);
+		m_rotationZ.push_back(rotation.z);
+		m_scaleX.push_back(scale.x);
+		m_scaleY.push_back(scale.y);
+		m_scaleZ.push_back(scale.z);
+		m_world.push_back(XMMatrixIdentity());
+		m_localBoundsX.push_back(0.0f);
+		m_localBoundsY.push_back(0.0f);
+		m_localBoundsZ.push_back(0.0f);
+		m_localBoundsRadius.push_back(0.0f);
+		m_boundsX.push_back(0.0f);
+		m_boundsY.push_back(0.0f);
+		m_boundsZ.push_back(0.0f);
+		m_boundsRadius.push_back(0.0f);
+		m_worldDirty.push_back(0);
+		m_dirtyFrames.push_back(0);
+
+		ComposeWorldMatrix(slot); // valid straight away for anyone calling GetWorld before the next update
+		MarkSlotDirty(slot); // every back buffer still needs the new instance
+
+		return slot;
+	}
+
+	UINT TransformStore::Remove(const UINT& id)
+	{
+		if (!Contains(id))
+		{
+			return MAXUINT;
+		}
+
+		UINT slot = m_slotById[id];
+		UINT last = GetCount() - 1;
+		UINT movedSlot = MAXUINT;
+
+		ForgetSlot(slot);
+		ForgetSlot(last);
+
+		if (slot != last)
+		{
+			UINT movedId = m_idBySlot[last];
+			m_idBySlot[slot] = movedId;
+			m_slotById[movedId] = slot;
+
+			m_positionX[slot] = m_positionX[last];
+			m_positionY[slot] = m_positionY[last];
+			m_positionZ[slot] = m_positionZ[last];
+			m_rotationX[slot] = m_rotationX[last];
+			m_rotationY[slot] = m_rotationY[last];
+			m_rotationZ[slot] = m_rotationZ[last];
+			m_scaleX[slot] = m_scaleX[last];
+			m_scaleY[slot] = m_scaleY[last];
+			m_scaleZ[slot] = m_scaleZ[last];
+			m_world[slot] = m_world[last];
+			m_localBoundsX[slot] = m_localBoundsX[last];
+			m_localBoundsY[slot] = m_localBoundsY[last];
+			m_localBoundsZ[slot] = m_localBoundsZ[last];
+			m_localBoundsRadius[slot] = m_localBoundsRadius[last];
+			m_boundsX[slot] = m_boundsX[last];
+			m_boundsY[slot] = m_boundsY[last];
+			m_boundsZ[slot] = m_boundsZ[last];
+			m_boundsRadius[slot] = m_boundsRadius[last];
+
+			// the moved entity lands on a different instance index, so all of its copies are stale
+			MarkSlotDirty(slot);
+
+			movedSlot = slot;
+		}
+
+		m_slotById[id] = MAXUINT;
+		m_idBySlot.pop_back();
+		m_positionX.pop_back();
+		m_positionY.pop_back();
+		m_positionZ.pop_back();
+		m_rotationX.pop_back();
+		m_rotationY.pop_back();
+		m_rotationZ.pop_back();
+		m_scaleX.pop_back();
+		m_scaleY.pop_back();
+		m_scaleZ.pop_back();
+		m_world.pop_back();
+		m_localBoundsX.pop_back();
+		m_localBoundsY.pop_back();
+		m_localBoundsZ.pop_back();
+		m_localBoundsRadius.pop_back();
+		m_boundsX.pop_back();
+		m_boundsY.pop_back();
+		m_boundsZ.pop_back();
+		m_boundsRadius.pop_back();
+		m_worldDirty.pop_back();
+		m_dirtyFrames.pop_back();
+
+		return movedSlot;
+	}
+
+	void TransformStore::SetPosition(const UINT& id, const XMFLOAT3& position)
+	{
+		UINT slot = m_slotById[id];
+		m_positionX[slot] = position.x;
+		m_positionY[slot] = position.y;
+		m_positionZ[slot] = position.z;
+		MarkSlotDirty(slot);
+	}
+
+	void TransformStore::SetRotation(const UINT& id, const XMFLOAT3& rotation)
+	{
+		UINT slot = m_slotById[id];
+		m_rotationX[slot] = rotation.x;
+		m_rotationY[slot] = rotation.y;
+		m_rotationZ[slot] = rotation.z;
+		MarkSlotDirty(slot);
+	}
+
+	void TransformStore::SetScale(const UINT& id, const XMFLOAT3& scale)
+	{
+		UINT slot = m_slotById[id];
+		m_scaleX[slot] = scale.x;
+		m_scaleY[slot] = scale.y;
+		m_scaleZ[slot] = scale.z;
+		MarkSlotDirty(slot);
+	}
+
+	void TransformStore::SetLocalBounds(const UINT& id, const BoundingSphere& bounds)
+	{
+		UINT slot = m_slotById[id];
+		m_localBoundsX[slot] = bounds.Center.x;
+		m_localBoundsY[slot] = bounds.Center.y;
+		m_localBoundsZ[slot] = bounds.Center.z;
+		m_localBoundsRadius[slot] = bounds.Radius;
+		MarkWorldDirty(slot);
+	}
+
+	void TransformStore::MarkDirty(const UINT& id)
+	{
+		if (Contains(id))
+		{
+			MarkFramesDirty(m_slotById[id]);
+		}
+	}
+
+	XMFLOAT3 TransformStore::GetPosition(const UINT& id) const
+	{
+		UINT slot = m_slotById[id];
+		return XMFLOAT3(m_positionX[slot], m_positionY[slot], m_positionZ[slot]);
+	}
+
+	XMFLOAT3 TransformStore::GetRotation(const UINT& id) const
+	{
+		UINT slot = m_slotById[id];
+		return XMFLOAT3(m_rotationX[slot], m_rotationY[slot], m_rotationZ[slot]);
+	}
+
+	XMFLOAT3 TransformStore::GetScale(const UINT& id) const
+	{
+		UINT slot = m_slotById[id];
+		return XMFLOAT3(m_scaleX[slot], m_scaleY[slot], m_scaleZ[slot]);
+	}
+
+	void TransformStore::ComposeWorldMatrices()
+	{
+		ComposeWorldMatrices(0, GetCount());
+	}
+
+	void TransformStore::ComposeWorldMatrices(const UINT& begin, const UINT& end)
+	{
+		UINT slot = begin;
+
+		for (; slot + 4 <= end; slot += 4)
+		{
+			ComposeWorldMatrices4(slot);
+		}
+
+		// left overs that don't fill a full vector
+		for (; slot < end; slot++)
+		{
+			ComposeWorldMatrix(slot);
+		}
+	}
+
+	void TransformStore::ClearDirtyWorld()
+	{
+		for (const UINT& slot : m_dirtyWorldSlots)
+		{
+			m_worldDirty[slot] = 0;
+		}
+		m_dirtyWorldSlots.clear();
+	}
+
+	void TransformStore::ComposeDirtyWorldMatrices()
+	{
+		if (m_dirtyWorldSlots.empty())
+		{
+			return;
+		}
+
+		// when most of the scene moved, the 4 wide pass over everything is cheaper than hopping around
+		if (m_dirtyWorldSlots.size() * 2 >= GetCount())
+		{
+			ComposeWorldMatrices();
+		}
+		else
+		{
+			for (const UINT& slot : m_dirtyWorldSlots)
+			{
+				ComposeWorldMatrix(slot);
+			}
+		}
+
+		ClearDirtyWorld();
+	}
+
+	void TransformStore::ComposeDirtyWorldMatrices(JobSystem& jobSystem)
+	{
+		if (m_dirtyWorldSlots.empty())
+		{
+			return;
+		}
+
+		// same choice as the serial version, every range only touches its own slots
+		if (m_dirtyWorldSlots.size() * 2 >= GetCount())
+		{
+			jobSystem.ParallelFor(GetCount(), c_composeRangeSize, [this](UINT begin, UINT end)
+				{
+					ComposeWorldMatrices(begin, end);
+				});
+		}
+		else
+		{
+			jobSystem.ParallelFor(static_cast<UINT>(m_dirtyWorldSlots.size()), c_composeRangeSize, [this](UINT begin, UINT end)
+				{
+					for (UINT i = begin; i < end; i++)
+					{
+						ComposeWorldMatrix(m_dirtyWorldSlots[i]);
+					}
+				});
+		}
+
+		ClearDirtyWorld();
+	}
+
+	void TransformStore::ClearFrameDirty(const UINT& frameIndex)
+	{
+		const UINT8 frameBit = static_cast<UINT8>(1 << frameIndex);
+
+		// drop slots once every back buffer has caught up
+		size_t write = 0;
+		for (size_t read = 0; read < m_pendingSlots.size(); read++)
+		{
+			UINT slot = m_pendingSlots[read];
+			m_dirtyFrames[slot] &= ~frameBit;
+			if (m_dirtyFrames[slot])
+			{
+				m_pendingSlots[write++] = slot;
+			}
+		}
+		m_pendingSlots.resize(write);
+	}
+}
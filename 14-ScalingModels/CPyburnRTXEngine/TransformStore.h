@@ -0,0 +1,112 @@
+#pragma once
+
+#include "pchlib.h"
+#include "JobSystem.h"
+
+namespace CPyburnRTXEngine
+{
+	// structure of arrays transform storage for every entity, indexed by a dense slot
+	// the entity id -> slot map is sparse so ids can stay whatever the json says they are
+	class TransformStore
+	{
+	private:
+		std::vector<UINT> m_slotById; // sparse, MAXUINT means not in the store
+		std::vector<UINT> m_idBySlot; // dense
+
+		// split per component so 4 entities can be loaded into one XMVECTOR
+		std::vector<float> m_positionX;
+		std::vector<float> m_positionY;
+		std::vector<float> m_positionZ;
+		std::vector<float> m_rotationX; // pitch
+		std::vector<float> m_rotationY; // yaw
+		std::vector<float> m_rotationZ; // roll
+		std::vector<float> m_scaleX;
+		std::vector<float> m_scaleY;
+		std::vector<float> m_scaleZ;
+
+		std::vector<XMMATRIX> m_world;
+
+		// bounding sphere of the model in model space, and the same sphere in world space after composing
+		std::vector<float> m_localBoundsX;
+		std::vector<float> m_localBoundsY;
+		std::vector<float> m_localBoundsZ;
+		std::vector<float> m_localBoundsRadius;
+		std::vector<float> m_boundsX;
+		std::vector<float> m_boundsY;
+		std::vector<float> m_boundsZ;
+		std::vector<float> m_boundsRadius;
+
+		// dirty tracking, a change marks the world matrix and every back buffer's copy of the instance
+		static constexpr UINT c_composeRangeSize = 256; // multiple of 4 so parallel ranges stay on the 4 wide path
+		static constexpr UINT8 c_allFramesDirty = (1 << DX::DeviceResources::c_backBufferCount) - 1;
+		std::vector<UINT8> m_worldDirty; // 1 until the world matrix is recomposed
+		std::vector<UINT8> m_dirtyFrames; // one bit per back buffer that still has a stale copy
+		std::vector<UINT> m_dirtyWorldSlots; // slots waiting on ComposeDirtyWorldMatrices
+		std::vector<UINT> m_pendingSlots; // slots with at least one bit in m_dirtyFrames
+
+		void ComposeWorldMatrix(const UINT& slot);
+		void ComposeWorldMatrices4(const UINT& slot);
+		void MarkWorldDirty(const UINT& slot);
+		void MarkFramesDirty(const UINT& slot);
+		void MarkSlotDirty(const UINT& slot);
+		void ForgetSlot(const UINT& slot);
+		void ClearDirtyWorld();
+
+	public:
+		TransformStore() = default;
+		TransformStore(const TransformStore&) = delete;
+		TransformStore& operator=(const TransformStore&) = delete;
+		~TransformStore() = default;
+
+		void Reserve(const UINT& count);
+
+		// returns the dense slot, adding an id that already exists just overwrites its transform
+		UINT Add(const UINT& id, const XMFLOAT3& position, const XMFLOAT3& rotation, const XMFLOAT3& scale);
+		// swap and pop, returns the slot that now holds a different id (MAXUINT if nothing moved) so parallel arrays can mirror it
+		// the id that moved came from the old last slot, GetCount() after the call
+		// entities go through EntitiesManager::RemoveEntity, which mirrors the move in every array it keeps per slot
+		UINT Remove(const UINT& id);
+
+		bool Contains(const UINT& id) const { return id < m_slotById.size() && m_slotById[id] != MAXUINT; }
+		UINT GetSlot(const UINT& id) const { return Contains(id) ? m_slotById[id] : MAXUINT; }
+		UINT GetIdBySlot(const UINT& slot) const { return m_idBySlot[slot]; }
+		UINT GetCount() const { return static_cast<UINT>(m_idBySlot.size()); }
+
+		// setters mark the entity dirty, untouched entities cost nothing per frame
+		void SetPosition(const UINT& id, const XMFLOAT3& position);
+		void SetRotation(const UINT& id, const XMFLOAT3& rotation);
+		void SetScale(const UINT& id, const XMFLOAT3& scale);
+
+		XMFLOAT3 GetPosition(const UINT& id) const;
+		XMFLOAT3 GetRotation(const UINT& id) const;
+		XMFLOAT3 GetScale(const UINT& id) const;
+
+		const XMMATRIX& GetWorld(const UINT& id) const { return m_world[m_slotById[id]]; }
+		const XMMATRIX& GetWorldBySlot(const UINT& slot) const { return m_world[slot]; }
+
+		// model space bounding sphere, moved into world space with the world matrix
+		void SetLocalBounds(const UINT& id, const BoundingSphere& bounds);
+		BoundingSphere GetWorldBoundsBySlot(const UINT& slot) const { return BoundingSphere(XMFLOAT3(m_boundsX[slot], m_boundsY[slot], m_boundsZ[slot]), m_boundsRadius[slot]); }
+		const std::vector<float>& GetWorldBoundsX() const { return m_boundsX; }
+		const std::vector<float>& GetWorldBoundsY() const { return m_boundsY; }
+		const std::vector<float>& GetWorldBoundsZ() const { return m_boundsZ; }
+		const std::vector<float>& GetWorldBoundsRadius() const { return m_boundsRadius; }
+
+		// for changes that are not a transform but still need the instance rewritten, like a new blas or visibility
+		void MarkDirty(const UINT& id);
+		void MarkDirtyBySlot(const UINT& slot) { MarkFramesDirty(slot); }
+
+		// rebuilds scale * rotation(pitch, yaw, roll) * translation, 4 slots at a time
+		void ComposeWorldMatrices();
+		void ComposeWorldMatrices(const UINT& begin, const UINT& end);
+		// only rebuilds what changed since the last call
+		void ComposeDirtyWorldMatrices();
+		void ComposeDirtyWorldMatrices(JobSystem& jobSystem);
+
+		// slots whose instance still has to be written for some back buffer, check IsFrameDirty for the one being recorded
+		const std::vector<UINT>& GetPendingSlots() const { return m_pendingSlots; }
+		bool IsFrameDirty(const UINT& slot, const UINT& frameIndex) const { return (m_dirtyFrames[slot] & (1 << frameIndex)) != 0; }
+		// call once the instances for frameIndex have been written
+		void ClearFrameDirty(const UINT& frameIndex);
+	};
+}
@@ -0,0 +1,114 @@
+#include "pchlib.h"
+#include "UploadRing.h"
+
+namespace CPyburnRTXEngine
+{
+	void UploadRing::Reset(const UINT64& partitionSize, const UINT& frameCount)
+	{
+		m_partitionSize = partitionSize;
+		m_partitions.assign(frameCount, Partition{});
+		m_frameIndex = 0;
+		m_frameCount = 0;
+		m_head = 0;
+		m_failedCount = 0;
+	}
+
+	void UploadRing::CreateDeviceDependentResources(ID3D12Device* d3dDevice, const UINT64& partitionSize, const UINT& frameCount)
+	{
+		Release();
+
+		// every partition starts on a constant buffer boundary so aligned offsets in it are aligned in the buffer too
+		const UINT64 alignedPartitionSize = (partitionSize + c_constantBufferAlignment - 1) & ~(c_constantBufferAlignment - 1);
+		Reset(alignedPartitionSize, frameCount);
+
+		auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+		auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(alignedPartitionSize * frameCount);
+		DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &resourceDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_resource)));
+		m_resource->SetName(L"Upload Ring");
+
+		// mapped for the lifetime of the ring like the constant buffers
+		CD3DX12_RANGE readRange(0, 0);
+		DX::ThrowIfFailed(m_resource->Map(0, &readRange, reinterpret_cast<void**>(&m_mappedData)));
+		m_gpuAddress = m_resource->GetGPUVirtualAddress();
+	}
+
+	void UploadRing::Release()
+	{
+		if (m_resource)
+		{
+			m_resource->Unmap(0, nullptr);
+			m_resource.Reset();
+		}
+		m_mappedData = nullptr;
+		m_gpuAddress = 0;
+	}
+
+	bool UploadRing::BeginFrame(const UINT& frameIndex, const UINT64& completedFenceValue, const UINT64& pendingFenceValue)
+	{
+		// the frame that is ending is the only one that wrote m_head, so its peak is known now
+		if (m_frameIndex < m_partitions.size())
+		{
+			m_partitions[m_frameIndex].highWater = std::max(m_partitions[m_frameIndex].highWater, m_head.load());
+		}
+
+		if (m_failedCount > 0)
+		{
+			DebugTrace("UploadRing %u allocations did not fit last frame, raise uploadRingFrameSize in Graphics.json", m_failedCount.load());
+		}
+
+		// whatever happens the last frame's allocations are done with
+		m_frameCount++;
+		m_failedCount = 0;
+
+		if (frameIndex >= m_partitions.size() || m_partitions[frameIndex].fenceValue > completedFenceValue)
+		{
+			DebugTrace("UploadRing partition %u is still in use by the gpu", frameIndex);
+			// no partition refuses everything until the next BeginFrame, the last frame's may still be in flight too
+			m_frameIndex = MAXUINT;
+			return false;
+		}
+
+		m_partitions[frameIndex].fenceValue = pendingFenceValue;
+		m_frameIndex = frameIndex;
+		m_head = 0;
+		return true;
+	}
+
+	UploadRing::Allocation UploadRing::Allocate(const UINT64& size, const UINT64& alignment)
+	{
+		if (m_frameIndex >= m_partitions.size())
+			return Allocation{};
+
+		UINT64 head = m_head.load(std::memory_order_relaxed);
+		UINT64 aligned = 0;
+		do
+		{
+			aligned = (head + alignment - 1) & ~(alignment - 1);
+			if (aligned + size > m_partitionSize)
+			{
+				m_failedCount.fetch_add(1, std::memory_order_relaxed);
+				return Allocation{};
+			}
+		} while (!m_head.compare_exchange_weak(head, aligned + size, std::memory_order_relaxed));
+
+		Allocation allocation;
+		allocation.offset = m_partitionSize * m_frameIndex + aligned;
+		allocation.size = size;
+		if (m_mappedData)
+		{
+			allocation.cpu = m_mappedData + allocation.offset;
+			allocation.gpu = m_gpuAddress + allocation.offset;
+		}
+		return allocation;
+	}
+
+	UINT64 UploadRing::GetHighWater() const
+	{
+		UINT64 highWater = 0;
+		for (const Partition& partition : m_partitions)
+		{
+			highWater = std::max(highWater, partition.highWater);
+		}
+		return highWater;
+	}
+}
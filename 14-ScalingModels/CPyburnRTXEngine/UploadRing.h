@@ -0,0 +1,79 @@
+#pragma once
+
+#include "pchlib.h"
+
+#include <atomic>
+
+namespace CPyburnRTXEngine
+{
+	// one persistently mapped upload buffer for data that is rewritten every frame, split into a partition per back buffer
+	// a frame bumps through its own partition and the partition is only reused once the fence of the frame that last filled it completed
+	// the resource is optional, without CreateDeviceDependentResources the offsets and fencing still work so the ring can run headless
+	class UploadRing
+	{
+	public:
+		struct Allocation
+		{
+			uint8_t* cpu = nullptr; // nullptr when headless
+			D3D12_GPU_VIRTUAL_ADDRESS gpu = 0;
+			UINT64 offset = MAXUINT64; // from the start of the whole ring
+			UINT64 size = 0;
+
+			bool IsValid() const { return offset != MAXUINT64; }
+		};
+
+		static constexpr UINT64 c_constantBufferAlignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT; // 256
+		static constexpr UINT64 c_instanceDescAlignment = D3D12_RAYTRACING_INSTANCE_DESCS_BYTE_ALIGNMENT; // 16
+		static constexpr UINT64 c_structuredAlignment = 16;
+
+	private:
+		struct Partition
+		{
+			UINT64 fenceValue = 0; // what the frame that last used it signals
+			UINT64 highWater = 0; // the most this partition has held in one frame
+		};
+
+		UINT64 m_partitionSize = 0;
+		std::vector<Partition> m_partitions;
+		UINT m_frameIndex = 0;
+		UINT64 m_frameCount = 0; // frames begun, unlike the index it never repeats
+		std::atomic<UINT64> m_head = 0; // bytes used in the current partition
+		std::atomic<UINT> m_failedCount = 0; // allocations this frame that did not fit
+
+		Microsoft::WRL::ComPtr<ID3D12Resource> m_resource;
+		uint8_t* m_mappedData = nullptr;
+		D3D12_GPU_VIRTUAL_ADDRESS m_gpuAddress = 0;
+
+	public:
+		UploadRing() = default;
+		~UploadRing() { Release(); }
+
+		UploadRing(const UploadRing&) = delete;
+		UploadRing& operator=(const UploadRing&) = delete;
+
+		// partitionSize bytes for each of frameCount frames, forgets every allocation
+		void Reset(const UINT64& partitionSize, const UINT& frameCount);
+		// Reset plus the upload buffer it hands out pointers into
+		void CreateDeviceDependentResources(ID3D12Device* d3dDevice, const UINT64& partitionSize, const UINT& frameCount = DX::DeviceResources::c_backBufferCount);
+		void Release();
+
+		// switches to frameIndex's partition and tags it with the fence this frame will signal
+		// false when the fence of the partition's last frame hasn't completed, nothing is handed out until the next BeginFrame then
+		bool BeginFrame(const UINT& frameIndex, const UINT64& completedFenceValue, const UINT64& pendingFenceValue);
+
+		// lock free, any thread can allocate during the frame, alignment has to be a power of two
+		// an invalid allocation when the partition is full, the caller skips its upload for the frame
+		Allocation Allocate(const UINT64& size, const UINT64& alignment = c_structuredAlignment);
+
+		UINT64 GetPartitionSize() const { return m_partitionSize; }
+		// every partition, what a view over the whole resource covers
+		UINT64 GetSize() const { return m_partitionSize * m_partitions.size(); }
+		UINT GetFrameIndex() const { return m_frameIndex; }
+		// an allocation is only good while this still returns what it did when it was made
+		UINT64 GetFrameCount() const { return m_frameCount; }
+		UINT64 GetUsedBytes() const { return m_head.load(std::memory_order_relaxed); }
+		UINT GetFailedCount() const { return m_failedCount.load(std::memory_order_relaxed); }
+		UINT64 GetHighWater() const;
+		ID3D12Resource* GetResource() const { return m_resource.Get(); }
+	};
+}
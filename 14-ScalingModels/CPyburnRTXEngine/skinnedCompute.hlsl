@@ -28,9 +28,11 @@ void CS(uint3 id : SV_DispatchThreadID)
 
     float4 pos = float4(vin.position, 1.0);
     float3 nrm = vin.normal;
+    float3 tng = vin.tangent;
 
     float4 skinnedPos = 0;
     float3 skinnedNrm = 0;
+    float3 skinnedTan = 0;
 
     [unroll]
     for (int i = 0; i < 4; i++)
@@ -38,10 +40,12 @@ void CS(uint3 id : SV_DispatchThreadID)
         float4x4 m = BoneMatrices[bin.IDs[i]];
         skinnedPos += mul(m, pos) * bin.Weights[i];
         skinnedNrm += mul((float3x3) m, nrm) * bin.Weights[i];
+        skinnedTan += mul((float3x3) m, tng) * bin.Weights[i];
     }
 
     vin.position = skinnedPos.xyz;
     vin.normal = normalize(skinnedNrm);
+    vin.tangent = normalize(skinnedTan);
 
     OutVertices[v] = vin;
 }
\ No newline at end of file
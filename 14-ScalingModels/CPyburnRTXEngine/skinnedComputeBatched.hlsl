@@ -0,0 +1,141 @@
+struct VSVertices
+{
+    float3 position;
+    float2 tex;
+    float3 normal;
+    float3 tangent;
+};
+
+struct VertexBoneData
+{
+    unsigned int IDs[4];
+    float Weights[4];
+};
+
+// must match DualQuaternion in DualQuaternion.h, xyzw quaternions
+struct DualQuaternion
+{
+    float4 real;
+    float4 dual;
+};
+
+// one per skinned entity, must match SkinningBatch::Entry
+struct SkinningEntry
+{
+    uint baseVerticesIndex;
+    uint boneDataIndex;
+    uint boneMatricesIndex;
+    uint outVerticesIndex;
+    uint vertexCount;
+    uint firstGroup;
+    uint dualQuaternion; // the view at boneMatricesIndex holds DualQuaternions instead of matrices
+    uint paletteFirstElement; // the view covers the whole upload ring, this entry's palette starts here
+};
+
+cbuffer BatchConstants : register(b0)
+{
+    uint EntryCount;
+    uint GroupOffset; // when the batch needs more groups than one dispatch allows
+};
+
+StructuredBuffer<SkinningEntry> Entries : register(t0);
+
+// q v q* for a unit quaternion
+float3 RotateByQuaternion(float4 q, float3 v)
+{
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+// same blend as skinnedComputeDualQuaternion.hlsl
+void SkinDualQuaternion(inout VSVertices vin, VertexBoneData bin, uint paletteIndex, uint paletteFirstElement)
+{
+    StructuredBuffer<DualQuaternion> boneDualQuaternions = ResourceDescriptorHeap[paletteIndex];
+
+    float4 firstReal = boneDualQuaternions[paletteFirstElement + bin.IDs[0]].real;
+
+    float4 real = 0;
+    float4 dual = 0;
+
+    [unroll]
+    for (int i = 0; i < 4; i++)
+    {
+        DualQuaternion dq = boneDualQuaternions[paletteFirstElement + bin.IDs[i]];
+        float weight = dot(dq.real, firstReal) < 0.0 ? -bin.Weights[i] : bin.Weights[i];
+        real += dq.real * weight;
+        dual += dq.dual * weight;
+    }
+
+    float realLength = sqrt(dot(real, real));
+    real /= realLength;
+    dual /= realLength;
+
+    float3 translation = 2.0 * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));
+
+    vin.position = RotateByQuaternion(real, vin.position) + translation;
+    vin.normal = normalize(RotateByQuaternion(real, vin.normal));
+    vin.tangent = normalize(RotateByQuaternion(real, vin.tangent));
+}
+
+void SkinLinear(inout VSVertices vin, VertexBoneData bin, uint paletteIndex, uint paletteFirstElement)
+{
+    StructuredBuffer<float4x4> boneMatrices = ResourceDescriptorHeap[paletteIndex];
+
+    float4 pos = float4(vin.position, 1.0);
+    float3 nrm = vin.normal;
+    float3 tng = vin.tangent;
+
+    float4 skinnedPos = 0;
+    float3 skinnedNrm = 0;
+    float3 skinnedTan = 0;
+
+    [unroll]
+    for (int i = 0; i < 4; i++)
+    {
+        float4x4 m = boneMatrices[paletteFirstElement + bin.IDs[i]];
+        skinnedPos += mul(m, pos) * bin.Weights[i];
+        skinnedNrm += mul((float3x3) m, nrm) * bin.Weights[i];
+        skinnedTan += mul((float3x3) m, tng) * bin.Weights[i];
+    }
+
+    vin.position = skinnedPos.xyz;
+    vin.normal = normalize(skinnedNrm);
+    vin.tangent = normalize(skinnedTan);
+}
+
+[numthreads(256, 1, 1)]
+void CS(uint3 groupId : SV_GroupID, uint3 groupThreadId : SV_GroupThreadID)
+{
+    uint group = groupId.x + GroupOffset;
+
+    // entries are in firstGroup order, find the last one starting at or before this group, SkinningBatch::FindEntry does the same on the cpu
+    uint low = 0;
+    uint high = EntryCount - 1;
+    while (low < high)
+    {
+        uint mid = (low + high + 1) / 2;
+        if (Entries[mid].firstGroup <= group)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+
+    SkinningEntry entry = Entries[low];
+    uint v = (group - entry.firstGroup) * 256 + groupThreadId.x;
+    if (v >= entry.vertexCount)
+        return;
+
+    // the whole group works on one entry, so the indices are uniform
+    StructuredBuffer<VSVertices> baseVertices = ResourceDescriptorHeap[entry.baseVerticesIndex];
+    StructuredBuffer<VertexBoneData> boneData = ResourceDescriptorHeap[entry.boneDataIndex];
+    RWStructuredBuffer<VSVertices> outVertices = ResourceDescriptorHeap[entry.outVerticesIndex];
+
+    VSVertices vin = baseVertices[v];
+    VertexBoneData bin = boneData[v];
+
+    if (entry.dualQuaternion)
+        SkinDualQuaternion(vin, bin, entry.boneMatricesIndex, entry.paletteFirstElement);
+    else
+        SkinLinear(vin, bin, entry.boneMatricesIndex, entry.paletteFirstElement);
+
+    outVertices[v] = vin;
+}
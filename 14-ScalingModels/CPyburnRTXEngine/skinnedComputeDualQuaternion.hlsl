@@ -0,0 +1,69 @@
+struct VSVertices
+{
+    float3 position;
+    float2 tex;
+    float3 normal;
+    float3 tangent;
+};
+
+struct VertexBoneData
+{
+    unsigned int IDs[4];
+    float Weights[4];
+};
+
+// must match DualQuaternion in DualQuaternion.h, xyzw quaternions
+struct DualQuaternion
+{
+    float4 real;
+    float4 dual;
+};
+
+StructuredBuffer<VSVertices> BaseVertices : register(t0);
+StructuredBuffer<VertexBoneData> BoneData : register(t1);
+StructuredBuffer<DualQuaternion> BoneDualQuaternions : register(t2);
+
+RWStructuredBuffer<VSVertices> OutVertices : register(u0);
+
+// q v q* for a unit quaternion
+float3 RotateByQuaternion(float4 q, float3 v)
+{
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+[numthreads(256, 1, 1)]
+void CS(uint3 id : SV_DispatchThreadID)
+{
+    uint v = id.x;
+
+    VSVertices vin = BaseVertices[v];
+    VertexBoneData bin = BoneData[v];
+
+    // q and -q are the same rotation, keep every influence on the first one's side so the blend takes the short way
+    float4 firstReal = BoneDualQuaternions[bin.IDs[0]].real;
+
+    float4 real = 0;
+    float4 dual = 0;
+
+    [unroll]
+    for (int i = 0; i < 4; i++)
+    {
+        DualQuaternion dq = BoneDualQuaternions[bin.IDs[i]];
+        float weight = dot(dq.real, firstReal) < 0.0 ? -bin.Weights[i] : bin.Weights[i];
+        real += dq.real * weight;
+        dual += dq.dual * weight;
+    }
+
+    float realLength = sqrt(dot(real, real));
+    real /= realLength;
+    dual /= realLength;
+
+    // 2 * dual * conjugate(real)
+    float3 translation = 2.0 * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));
+
+    vin.position = RotateByQuaternion(real, vin.position) + translation;
+    vin.normal = normalize(RotateByQuaternion(real, vin.normal));
+    vin.tangent = normalize(RotateByQuaternion(real, vin.tangent));
+
+    OutVertices[v] = vin;
+}
\ No newline at end of file
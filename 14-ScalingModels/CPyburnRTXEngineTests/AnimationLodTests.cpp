@@ -0,0 +1,234 @@
+#include "pch.h"
+
+#include <AnimationLod.h>
+#include <CameraBase.h>
+
+using namespace CPyburnRTXEngine;
+
+namespace
+{
+	// EntitiesManager's order for one frame, the culler then the LOD, driven with units placed at a chosen screen size
+	// the default camera sits at (0, 1, -5) looking down +z, units in front of it are visible and units behind it are culled
+	class LodScene
+	{
+	private:
+		CameraBase m_camera;
+		float m_projectionScale = 1.0f;
+		JobSystem m_jobSystem;
+
+	public:
+		static constexpr float c_elapsedSeconds = 1.0f / 60.0f;
+
+		TransformStore transforms;
+		FrustumCuller culler;
+		AnimationLod lod;
+		std::vector<UINT> animatedSlots;
+
+		explicit LodScene(const UINT& count) : m_jobSystem(2)
+		{
+			m_projectionScale = 1.0f / tanf(m_camera.GetFieldOfView() * 0.5f);
+
+			const XMFLOAT3& eye = m_camera.GetEye();
+			XMMATRIX projection = XMMatrixPerspectiveFovLH(m_camera.GetFieldOfView(), 16.0f / 9.0f, 0.1f, 1000.0f);
+			BoundingFrustum viewSpace;
+			BoundingFrustum::CreateFromMatrix(viewSpace, projection);
+			XMMATRIX view = XMMatrixLookToLH(XMLoadFloat3(&eye), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+			BoundingFrustum world;
+			viewSpace.Transform(world, XMMatrixInverse(nullptr, view));
+			culler.SetMode(FrustumCuller::Mode::Camera);
+			culler.SetFrustum(world);
+
+			// ids are added in order and nothing is removed, so every id is its own slot
+			transforms.Reserve(count);
+			for (UINT id = 0; id < count; id++)
+			{
+				transforms.Add(id, eye, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+				transforms.SetLocalBounds(id, BoundingSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), 1.0f));
+				animatedSlots.push_back(id);
+				Place(id, 1.0f);
+			}
+		}
+
+		// a unit bounds radius 1 straight ahead, far enough that its projected radius over half the screen height is screenSize
+		void Place(const UINT& id, const float& screenSize, const bool& visible = true)
+		{
+			const XMFLOAT3& eye = m_camera.GetEye();
+			const float distance = m_projectionScale / screenSize;
+			transforms.SetPosition(id, XMFLOAT3(eye.x, eye.y, visible ? eye.z + distance : eye.z - distance));
+		}
+
+		void Frame()
+		{
+			transforms.ComposeWorldMatrices();
+			culler.Cull(transforms, m_jobSystem);
+			lod.SetCamera(&m_camera);
+			lod.Update(animatedSlots, transforms, culler, c_elapsedSeconds, m_jobSystem);
+		}
+
+		AnimationLod::Level GetLevel(const UINT& slot) const { return lod.GetLevel(slot, culler); }
+
+		bool IsPosed(const UINT& slot) const
+		{
+			const std::vector<UINT>& posed = lod.GetPosedSlots();
+			return std::find(posed.begin(), posed.end(), slot) != posed.end();
+		}
+	};
+}
+
+TEST_CASE(AnimationLodHysteresis)
+{
+	// thresholds 0.08, 0.04 and 0.015 with a 15% band, a unit has to clear a threshold by the band before it switches
+	LodScene scene(1);
+	scene.Frame();
+	CHECK(scene.GetLevel(0) == AnimationLod::Level::Full);
+
+	// under 0.08 but inside the band stays, past it drops
+	scene.Place(0, 0.075f);
+	scene.Frame();
+	CHECK(scene.GetLevel(0) == AnimationLod::Level::Full);
+	scene.Place(0, 0.065f);
+	scene.Frame();
+	CHECK(scene.GetLevel(0) == AnimationLod::Level::Half);
+
+	// coming back over 0.08 isn't enough either, it has to clear 0.092
+	scene.Place(0, 0.085f);
+	scene.Frame();
+	CHECK(scene.GetLevel(0) == AnimationLod::Level::Half);
+	scene.Place(0, 0.075f);
+	scene.Frame();
+	CHECK(scene.GetLevel(0) == AnimationLod::Level::Half);
+	scene.Place(0, 0.095f);
+	scene.Frame();
+	CHECK(scene.GetLevel(0) == AnimationLod::Level::Full);
+
+	// no band, the threshold itself decides
+	scene.lod.SetHysteresis(0.0f);
+	scene.Place(0, 0.075f);
+	scene.Frame();
+	CHECK(scene.GetLevel(0) == AnimationLod::Level::Half);
+	scene.Place(0, 0.085f);
+	scene.Frame();
+	CHECK(scene.GetLevel(0) == AnimationLod::Level::Full);
+}
+
+TEST_CASE(AnimationLodJumpsLevelsInOneFrame)
+{
+	// a camera cut moves units several levels at once, they settle the same frame instead of stepping one level a frame
+	LodScene scene(1);
+	scene.Frame();
+	CHECK(scene.GetLevel(0) == AnimationLod::Level::Full);
+	CHECK(scene.lod.GetMinSampledHeight(0) == 0);
+
+	scene.Place(0, 0.005f);
+	scene.Frame();
+	CHECK(scene.GetLevel(0) == AnimationLod::Level::Eighth);
+	CHECK(scene.lod.GetMinSampledHeight(0) == 2);
+
+	scene.Place(0, 0.5f);
+	scene.Frame();
+	CHECK(scene.GetLevel(0) == AnimationLod::Level::Full);
+
+	// between the middle thresholds, down two from Full and up one from Eighth
+	scene.Place(0, 0.02f);
+	scene.Frame();
+	CHECK(scene.GetLevel(0) == AnimationLod::Level::Quarter);
+	CHECK(scene.lod.GetMinSampledHeight(0) == 1);
+	scene.Place(0, 0.005f);
+	scene.Frame();
+	scene.Place(0, 0.02f);
+	scene.Frame();
+	CHECK(scene.GetLevel(0) == AnimationLod::Level::Quarter);
+
+	// a camera inside the bounds counts as as big as it gets
+	const XMFLOAT3 position = scene.transforms.GetPosition(0);
+	scene.transforms.SetLocalBounds(0, BoundingSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), position.z + 10.0f));
+	scene.Frame();
+	CHECK(scene.GetLevel(0) == AnimationLod::Level::Full);
+}
+
+TEST_CASE(AnimationLodStaggersPhases)
+{
+	// 16 units on Quarter, a new pose every 4th frame each, spread so a quarter of them are posed every frame
+	static constexpr UINT c_count = 16;
+	LodScene scene(c_count);
+	for (UINT id = 0; id < c_count; id++)
+	{
+		scene.Place(id, 0.02f);
+	}
+
+	// new slots are all posed on their first frame whatever their phase
+	scene.Frame();
+	CHECK(scene.lod.GetPosedSlots().size() == c_count);
+
+	std::vector<UINT> lastPosed(c_count, 0);
+	std::vector<UINT> posedCount(c_count, 0);
+	bool spread = true;
+	bool evenGaps = true;
+	bool fullPending = true;
+	for (UINT frame = 1; frame <= 16; frame++)
+	{
+		scene.Frame();
+		spread = spread && scene.lod.GetPosedSlots().size() == c_count / 4;
+		for (UINT slot = 0; slot < c_count; slot++)
+		{
+			CHECK(scene.GetLevel(slot) == AnimationLod::Level::Quarter);
+			if (!scene.IsPosed(slot))
+				continue;
+
+			// after the first pose every gap is the whole interval, and the clip advances by all of it
+			if (posedCount[slot] > 0)
+			{
+				evenGaps = evenGaps && frame - lastPosed[slot] == 4;
+			}
+			fullPending = fullPending && fabsf(scene.lod.GetPendingSeconds(slot) - (frame - lastPosed[slot]) * LodScene::c_elapsedSeconds) < 1e-6f;
+			lastPosed[slot] = frame;
+			posedCount[slot]++;
+		}
+	}
+	CHECK(spread);
+	CHECK(evenGaps);
+	CHECK(fullPending);
+	CHECK(std::all_of(posedCount.begin(), posedCount.end(), [](const UINT& count) { return count == 4; }));
+
+	// neighbouring slots are a frame apart
+	for (UINT slot = 1; slot < c_count; slot++)
+	{
+		CHECK(lastPosed[slot] != lastPosed[slot - 1]);
+	}
+}
+
+TEST_CASE(AnimationLodCatchesUpFrozenUnits)
+{
+	// starts behind the camera at an Eighth size, on Eighth its phase comes round on frames 0, 8, 16 and so on
+	static constexpr UINT c_frozenFrames = 13;
+	static_assert(c_frozenFrames % 8 != 0, "the unit has to come back off its phase");
+	LodScene scene(1);
+	scene.Place(0, 0.005f, false);
+
+	// frozen units are never posed, not even as new slots, their level is still sized so it is right when they come back
+	bool neverPosed = true;
+	for (UINT frame = 0; frame < c_frozenFrames; frame++)
+	{
+		scene.Frame();
+		neverPosed = neverPosed && !scene.IsPosed(0);
+		CHECK(scene.GetLevel(0) == AnimationLod::Level::Frozen);
+	}
+	CHECK(neverPosed);
+
+	// back in view off its phase, it still gets a pose this frame and the clip catches up on all the time it missed
+	scene.Place(0, 0.005f);
+	scene.Frame();
+	CHECK(scene.GetLevel(0) == AnimationLod::Level::Eighth);
+	CHECK(scene.lod.GetMinSampledHeight(0) == 2);
+	CHECK(scene.IsPosed(0));
+	CHECK_NEAR(scene.lod.GetPendingSeconds(0), (c_frozenFrames + 1) * LodScene::c_elapsedSeconds, 1e-5f);
+
+	// then it falls into step with its level, once in the next 8 frames
+	UINT posed = 0;
+	for (UINT frame = 0; frame < 8; frame++)
+	{
+		scene.Frame();
+		posed += scene.IsPosed(0) ? 1 : 0;
+	}
+	CHECK(posed == 1);
+}
@@ -0,0 +1,216 @@
+#include "pch.h"
+
+#include <AssimpAnimations.h>
+
+#include "TestAssets.h"
+
+using namespace CPyburnRTXEngine;
+
+namespace
+{
+	// Animations.json has no events on the elf's clips, these are put on the shared clip for one test and taken off again
+	class ScopedEvents
+	{
+	private:
+		Animation* m_clip;
+		std::vector<Animation::Event> m_saved;
+
+	public:
+		ScopedEvents(Animation* clip, const std::vector<Animation::Event>& events) : m_clip(clip), m_saved(clip->events) { m_clip->events = events; }
+		~ScopedEvents() { m_clip->events = m_saved; }
+	};
+
+	std::vector<std::string> FiredNames(AnimationPlayer* player)
+	{
+		std::vector<std::string> names;
+		for (const Animation::Event* event : player->GetFiredEvents())
+		{
+			names.push_back(event->name);
+		}
+		return names;
+	}
+
+	bool NearlyEqual(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVector3NearEqual(a, b, XMVectorReplicate(1e-4f));
+	}
+}
+
+// the update that crosses a looping clip's end moves on into the next loop, root motion and events from both sides of the seam
+TEST_CASE(AnimationPlayerLoopSplitsItsWindow)
+{
+	AssimpAnimations unit(CPyburnRTXEngineTests::GetAnimatedModel());
+	AnimationPlayer* player = unit.GetAnimationPlayer();
+	AnimationPlayer::AnimationClip* clip = player->GetCurrentClip();
+	const Animation& run = *clip->animation;
+	const float length = run.endTime - run.startTime;
+	const ScopedEvents events(clip->animation, { { run.startTime, "start" }, { run.startTime + length * 0.5f, "middle" }, { run.endTime - 0.005f, "last" } });
+	DX::StepTimer timer;
+
+	// forwards, 10 ms short of the end and a 30 ms step
+	float previous = run.endTime - 0.01f;
+	clip->time = previous;
+	unit.Update(timer, 0.03f, 0, nullptr);
+	CHECK_NEAR(clip->time, run.startTime + 0.02f, 1e-4f);
+	XMVECTOR expected = run.GetRootPosition(run.endTime) - run.GetRootPosition(previous) + run.GetRootPosition(clip->time) - run.GetRootPosition(run.startTime);
+	CHECK(NearlyEqual(XMLoadFloat3(&player->GetRootMotionDelta()), expected));
+	CHECK((FiredNames(player) == std::vector<std::string>{ "last", "start" }));
+
+	// a skipped LOD frame longer than the clip goes round more than once, every pass fires its events
+	previous = clip->time;
+	unit.Update(timer, length * 1.5f, 0, nullptr);
+	CHECK_NEAR(clip->time, previous + length * 0.5f, 1e-3f);
+	CHECK((FiredNames(player) == std::vector<std::string>{ "middle", "last", "start", "middle" }));
+
+	// backwards the seam is at the start, the window runs down to it and on down from the end
+	player->PlayClipByAnimationType(Animation::AnimationType::run, true, false);
+	previous = run.startTime + 0.01f;
+	clip->time = previous;
+	unit.Update(timer, 0.03f, 0, nullptr);
+	CHECK_NEAR(clip->time, run.endTime - 0.02f, 1e-4f);
+	expected = run.GetRootPosition(run.startTime) - run.GetRootPosition(previous) + run.GetRootPosition(clip->time) - run.GetRootPosition(run.endTime);
+	CHECK(NearlyEqual(XMLoadFloat3(&player->GetRootMotionDelta()), expected));
+	CHECK((FiredNames(player) == std::vector<std::string>{ "start", "last" }));
+}
+
+// the pose the player reports as changed, and how far it moved, is what decides whether skinning and the BLAS run at all
+TEST_CASE(AnimationPlayerReportsPoseChanges)
+{
+	AssimpAnimations unit(CPyburnRTXEngineTests::GetAnimatedModel());
+	AnimationPlayer* player = unit.GetAnimationPlayer();
+	CHECK(player->DoesAnimationTypeExist(Animation::AnimationType::walk));
+	const Animation* run = player->GetCurrentClip()->animation;
+	const float step = 0.01f;
+
+	// a palette Update has to leave alone when nothing changed
+	const std::vector<XMMATRIX> marker(unit.GetAssimpFactory()->GetNumBones(), XMMatrixScaling(7.0f, 7.0f, 7.0f));
+	std::vector<XMMATRIX> bones = marker;
+	auto untouched = [&bones, &marker]() { return memcmp(bones.data(), marker.data(), marker.size() * sizeof(XMMATRIX)) == 0; };
+
+	// the first pose has nothing to be measured against
+	player->Update(step, 0, nullptr, bones.data());
+	CHECK(player->IsPoseChanged());
+	CHECK(player->GetPoseDelta() == FLT_MAX);
+	CHECK(!untouched());
+
+	player->Update(step, 0, nullptr, bones.data());
+	CHECK(player->IsPoseChanged());
+	CHECK_NEAR(player->GetPoseDelta(), step, 1e-4f);
+
+	// paused, the clip stays where it is and nothing is written
+	player->SetAnimationSpeed(0.0f);
+	bones = marker;
+	player->Update(step, 0, nullptr, bones.data());
+	CHECK(!player->IsPoseChanged());
+	CHECK(player->GetPoseDelta() == 0.0f);
+	CHECK(untouched());
+
+	// still paused, but the LOD cut off moved, the same time is a different pose
+	player->Update(step, 1, nullptr, bones.data());
+	CHECK(player->IsPoseChanged());
+	CHECK(player->GetPoseDelta() == 0.0f);
+	CHECK(!untouched());
+
+	player->SetAnimationSpeed(1.0f);
+	player->Update(step, 1, nullptr, bones.data());
+	CHECK(player->IsPoseChanged());
+	CHECK_NEAR(player->GetPoseDelta(), step, 1e-4f);
+
+	// a clip that doesn't repeat runs a little past its end, settles on it and then holds the last frame
+	player->PlayClipByAnimationType(Animation::AnimationType::run, false);
+	AnimationPlayer::AnimationClip* clip = player->GetCurrentClip();
+	clip->time = run->endTime - step * 0.5f;
+	player->Update(step, 1, nullptr, bones.data());
+	CHECK(player->IsPoseChanged());
+	player->Update(step, 1, nullptr, bones.data());
+	CHECK(player->IsPoseChanged());
+	CHECK(clip->time == run->endTime);
+	CHECK_NEAR(player->GetPoseDelta(), step * 0.5f, 1e-4f);
+	bones = marker;
+	player->Update(step, 1, nullptr, bones.data());
+	CHECK(!player->IsPoseChanged());
+	CHECK(player->GetPoseDelta() == 0.0f);
+	CHECK(clip->animationType == Animation::AnimationType::none);
+	CHECK(untouched());
+
+	// another clip is a jump, however close the times
+	player->PlayClipByAnimationType(Animation::AnimationType::walk, true);
+	player->Update(step, 1, nullptr, bones.data());
+	CHECK(player->IsPoseChanged());
+	CHECK(player->GetPoseDelta() == FLT_MAX);
+
+	// starting a blend is too, then every update moves both clips and the blend factor, the blend weighted by its length
+	player->BlendClipByAnimationType(Animation::AnimationType::run, true);
+	player->Update(step, 1, nullptr, bones.data());
+	CHECK(player->GetPoseDelta() == FLT_MAX);
+	bool blendDeltas = true;
+	UINT updates = 0;
+	while (player->GetCurrentClip()->animation != run && updates < 100)
+	{
+		player->Update(step, 1, nullptr, bones.data());
+		updates++;
+		blendDeltas = blendDeltas && (player->GetCurrentClip()->animation == run || fabsf(player->GetPoseDelta() - step * 3.0f) < 1e-4f);
+	}
+	CHECK(blendDeltas);
+	CHECK(updates > 10 && updates < 100);
+
+	// the target taking over is a jump, and so is dropping the finished blend's target the update after
+	CHECK(player->GetPoseDelta() == FLT_MAX);
+	player->Update(step, 1, nullptr, bones.data());
+	CHECK(player->GetPoseDelta() == FLT_MAX);
+	player->Update(step, 1, nullptr, bones.data());
+	CHECK_NEAR(player->GetPoseDelta(), step, 1e-4f);
+}
+
+// a pose the upload ring had no room for never reached the gpu, the next update poses again even when nothing moved
+TEST_CASE(AnimationPlayerForgetsRefusedPoses)
+{
+	AssimpFactory* factory = CPyburnRTXEngineTests::GetAnimatedModel();
+	AssimpAnimations unit(factory);
+	AnimationPlayer* player = unit.GetAnimationPlayer();
+	DX::StepTimer timer;
+
+	// a warp device gives the ring real upload memory, room for one palette a frame
+	Microsoft::WRL::ComPtr<ID3D12Device5> device = CPyburnRTXEngineTests::CreateWarpDevice();
+	UploadRing& uploadRing = GraphicsContexts::GetUploadRing();
+	uploadRing.CreateDeviceDependentResources(device.Get(), static_cast<UINT64>(factory->GetNumBones()) * sizeof(XMMATRIX), 3);
+	UINT64 frame = 0;
+	auto beginFrame = [&uploadRing, &frame]()
+		{
+			uploadRing.BeginFrame(static_cast<UINT>(frame % 3), frame, frame + 1);
+			frame++;
+		};
+
+	beginFrame();
+	unit.Update(timer, 0.01f, 0, nullptr);
+	CHECK(unit.IsPoseChanged());
+
+	beginFrame();
+	player->SetAnimationSpeed(0.0f);
+	unit.Update(timer, 0.01f, 0, nullptr);
+	CHECK(!unit.IsPoseChanged());
+
+	// the partition is full, the clip still moves but its pose goes nowhere
+	beginFrame();
+	CHECK(uploadRing.Allocate(uploadRing.GetPartitionSize()).IsValid());
+	player->SetAnimationSpeed(1.0f);
+	unit.Update(timer, 0.01f, 0, nullptr);
+	CHECK(player->IsPoseChanged());
+	CHECK(!unit.IsPoseChanged());
+
+	// paused on the pose that was refused, it is posed again and measured as a jump since the gpu's last pose is unknown
+	beginFrame();
+	player->SetAnimationSpeed(0.0f);
+	unit.Update(timer, 0.01f, 0, nullptr);
+	CHECK(player->IsPoseChanged());
+	CHECK(player->GetPoseDelta() == FLT_MAX);
+	CHECK(unit.IsPoseChanged());
+
+	// once it is up, holding still is free again
+	beginFrame();
+	unit.Update(timer, 0.01f, 0, nullptr);
+	CHECK(!player->IsPoseChanged());
+	CHECK(!unit.IsPoseChanged());
+
+	uploadRing.Release();
+}
@@ -0,0 +1,94 @@
+#include "pch.h"
+
+#include <Animation.h>
+
+using namespace CPyburnRTXEngine;
+
+namespace
+{
+	// a second long clip from 1 to 2 at 10 fps, the root walks 1 along x and rises on a curve in y
+	Animation MakeClip()
+	{
+		Animation clip;
+		clip.startFrame = 10;
+		clip.endFrame = 20;
+		clip.fps = 10;
+		clip.startTime = 1.0f;
+		clip.endTime = 2.0f;
+		for (UINT frame = 0; frame <= 10; frame++)
+		{
+			clip.rootMotion.push_back(XMFLOAT3(frame * 0.1f, frame * frame * 0.01f, 0.0f));
+		}
+		clip.events = { { 1.0f, "start" }, { 1.5f, "left foot" }, { 1.5f, "swing" }, { 2.0f, "end" } };
+		return clip;
+	}
+
+	std::vector<std::string> Collect(const Animation& clip, const float& from, const float& to)
+	{
+		std::vector<const Animation::Event*> fired;
+		clip.CollectEvents(from, to, fired);
+		std::vector<std::string> names;
+		for (const Animation::Event* event : fired)
+		{
+			names.push_back(event->name);
+		}
+		return names;
+	}
+
+	bool NearlyEqual(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVector3NearEqual(a, b, XMVectorReplicate(1e-5f));
+	}
+}
+
+TEST_CASE(AnimationRootPositionInterpolatesAndHolds)
+{
+	const Animation clip = MakeClip();
+	CHECK(NearlyEqual(clip.GetRootPosition(1.0f), XMVectorZero()));
+	CHECK(NearlyEqual(clip.GetRootPosition(1.3f), XMVectorSet(0.3f, 0.09f, 0.0f, 0.0f)));
+
+	// a quarter of the way from frame 2 to frame 3, y is the straight line between the keys, not the curve
+	CHECK(NearlyEqual(clip.GetRootPosition(1.225f), XMVectorSet(0.225f, 0.04f + 0.25f * 0.05f, 0.0f, 0.0f)));
+
+	// outside the clip the ends hold
+	CHECK(NearlyEqual(clip.GetRootPosition(2.0f), XMVectorSet(1.0f, 1.0f, 0.0f, 0.0f)));
+	CHECK(NearlyEqual(clip.GetRootPosition(2.5f), XMVectorSet(1.0f, 1.0f, 0.0f, 0.0f)));
+	CHECK(NearlyEqual(clip.GetRootPosition(0.5f), XMVectorZero()));
+
+	// a clip ExtractRootMotion never filled doesn't move the unit
+	Animation empty = MakeClip();
+	empty.rootMotion.clear();
+	CHECK(NearlyEqual(empty.GetRootPosition(1.5f), XMVectorZero()));
+
+	// one frame is enough to hold
+	Animation single = MakeClip();
+	single.rootMotion.resize(1);
+	CHECK(NearlyEqual(single.GetRootPosition(1.5f), XMVectorZero()));
+}
+
+TEST_CASE(AnimationEventsAreHalfOpen)
+{
+	const Animation clip = MakeClip();
+
+	// [from, to), so an event on a window's edge fires in exactly one of two windows that meet there
+	CHECK((Collect(clip, 1.0f, 1.5f) == std::vector<std::string>{ "start" }));
+	CHECK((Collect(clip, 1.5f, 2.0f) == std::vector<std::string>{ "left foot", "swing" }));
+	CHECK((Collect(clip, 2.0f, 2.5f) == std::vector<std::string>{ "end" }));
+	CHECK((Collect(clip, 0.0f, 3.0f) == std::vector<std::string>{ "start", "left foot", "swing", "end" }));
+
+	// an empty window and one between events fire nothing
+	CHECK(Collect(clip, 1.5f, 1.5f).empty());
+	CHECK(Collect(clip, 1.6f, 1.9f).empty());
+	// backwards windows are AnimationPlayer's to flip, given one as is it fires nothing
+	CHECK(Collect(clip, 1.9f, 1.1f).empty());
+
+	// appended after what is already there, AnimationPlayer collects both halves of a loop into one list
+	std::vector<const Animation::Event*> fired;
+	clip.CollectEvents(1.5f, 2.0f, fired);
+	clip.CollectEvents(1.0f, 1.5f, fired);
+	CHECK(fired.size() == 3 && fired[0]->name == "left foot" && fired[2]->name == "start");
+
+	Animation quiet = MakeClip();
+	quiet.events.clear();
+	CHECK(Collect(quiet, 0.0f, 3.0f).empty());
+}
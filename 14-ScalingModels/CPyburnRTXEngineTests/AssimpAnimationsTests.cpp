@@ -0,0 +1,73 @@
+#include "pch.h"
+
+#include <AssimpAnimations.h>
+#include <PoseCache.h>
+#include <Random.h>
+#include <thread>
+
+#include "TestAssets.h"
+
+using namespace CPyburnRTXEngine;
+
+namespace
+{
+	// units on the elf's run clip spread over it, the way EntitiesManager::LoadJson leaves a crowd of one model
+	std::vector<std::unique_ptr<AssimpAnimations>> MakeCrowd(AssimpFactory* factory, const UINT& count, const UINT& seed)
+	{
+		RandomNumberGenerator random;
+		random.SetSeed(seed);
+		DX::StepTimer timer;
+		std::vector<std::unique_ptr<AssimpAnimations>> units;
+		for (UINT i = 0; i < count; i++)
+		{
+			units.push_back(std::make_unique<AssimpAnimations>(factory));
+			units.back()->Update(timer, random.NextFloat(0.0f, 2.0f), 0, nullptr);
+		}
+		return units;
+	}
+}
+
+// one frame of EntitiesManager::Update's pose pass, every unit posed straight into the upload ring on every worker
+// a warp device gives the ring real upload memory, so the palettes are written where the gpu would read them
+BENCHMARK_CASE(AssimpAnimationsCrowdBenchmark)
+{
+	AssimpFactory* factory = CPyburnRTXEngineTests::GetAnimatedModel();
+	const UINT unitCounts[] = { 100, 1000, 5000 };
+
+	Microsoft::WRL::ComPtr<ID3D12Device5> device = CPyburnRTXEngineTests::CreateWarpDevice();
+	UploadRing& uploadRing = GraphicsContexts::GetUploadRing();
+	uploadRing.CreateDeviceDependentResources(device.Get(), static_cast<UINT64>(unitCounts[_countof(unitCounts) - 1]) * factory->GetNumBones() * sizeof(XMMATRIX), 3);
+
+	JobSystem jobSystem(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+	DX::StepTimer timer;
+	UINT64 frame = 0;
+	for (const UINT& count : unitCounts)
+	{
+		std::vector<std::unique_ptr<AssimpAnimations>> units = MakeCrowd(factory, count, 51);
+
+		PoseCache poseCache;
+		auto poseFrame = [&](PoseCache* cache)
+			{
+				// nothing waits on the gpu here, every partition is free again by the time it comes round
+				uploadRing.BeginFrame(static_cast<UINT>(frame % 3), frame, frame + 1);
+				frame++;
+				poseCache.BeginFrame();
+
+				// 4 units per job like EntitiesManager's c_animationRangeSize
+				jobSystem.ParallelFor(count, 4, [&](UINT begin, UINT end)
+					{
+						for (UINT i = begin; i < end; i++)
+						{
+							units[i]->Update(timer, 1.0f / 60.0f, 0, cache);
+						}
+					});
+			};
+
+		const double uncached = CPyburnRTXEngineTests::MeasureMilliseconds(20, [&]() { poseFrame(nullptr); });
+		const double cached = CPyburnRTXEngineTests::MeasureMilliseconds(20, [&]() { poseFrame(&poseCache); });
+		poseCache.BeginFrame();
+		printf("    %u units, %u bones, %u threads: %.3f ms per frame, %.3f ms with the pose cache (%.0f%% hits)\n", count, factory->GetNumBones(), jobSystem.GetThreadCount(), uncached, cached, poseCache.GetTotalHitRate() * 100.0f);
+	}
+
+	uploadRing.Release();
+}
@@ -0,0 +1,141 @@
+#include "pch.h"
+
+#include <BakedAnimation.h>
+
+#include "TestAnimation.h"
+
+using namespace CPyburnRTXEngine;
+
+namespace
+{
+	// what AssimpAnimations sampled straight from the aiNodeAnim before the baked arrays, a linear scan and the same float math
+	template<typename Key>
+	UINT FindKeyByScan(const float& animationTime, const Key* keys, const UINT& numKeys)
+	{
+		for (UINT i = 0; i < numKeys - 1; i++)
+		{
+			if (animationTime < (float)keys[i + 1].mTime)
+			{
+				return i;
+			}
+		}
+		return 0;
+	}
+
+	XMVECTOR InterpolateVector(const float& animationTime, const aiVectorKey* keys, const UINT& numKeys)
+	{
+		if (numKeys == 1)
+		{
+			return XMVectorSet(keys[0].mValue.x, keys[0].mValue.y, keys[0].mValue.z, 0.0f);
+		}
+
+		const UINT key = FindKeyByScan(animationTime, keys, numKeys);
+		const UINT nextKey = key + 1;
+		float deltaTime = (float)(keys[nextKey].mTime - keys[key].mTime);
+		float factor = (animationTime - (float)keys[key].mTime) / deltaTime;
+		XMVECTOR xmStart = XMVectorSet(keys[key].mValue.x, keys[key].mValue.y, keys[key].mValue.z, 0.0f);
+		XMVECTOR xmEnd = XMVectorSet(keys[nextKey].mValue.x, keys[nextKey].mValue.y, keys[nextKey].mValue.z, 0.0f);
+		XMVECTOR xmDelta = xmEnd - xmStart;
+		return xmStart + factor * xmDelta;
+	}
+
+	XMVECTOR CalcInterpolatedRotation(const float& animationTime, const aiNodeAnim* nodeAnim)
+	{
+		const aiQuatKey* keys = nodeAnim->mRotationKeys;
+		if (nodeAnim->mNumRotationKeys == 1)
+		{
+			return XMVectorSet(keys[0].mValue.x, keys[0].mValue.y, keys[0].mValue.z, keys[0].mValue.w);
+		}
+
+		const UINT key = FindKeyByScan(animationTime, keys, nodeAnim->mNumRotationKeys);
+		const UINT nextKey = key + 1;
+		float deltaTime = (float)(keys[nextKey].mTime - keys[key].mTime);
+		float factor = (animationTime - (float)keys[key].mTime) / deltaTime;
+		XMVECTOR xmStartRotationQ = XMVectorSet(keys[key].mValue.x, keys[key].mValue.y, keys[key].mValue.z, keys[key].mValue.w);
+		XMVECTOR xmEndRotationQ = XMVectorSet(keys[nextKey].mValue.x, keys[nextKey].mValue.y, keys[nextKey].mValue.z, keys[nextKey].mValue.w);
+		return XMVector4Normalize(XMQuaternionSlerp(xmStartRotationQ, xmEndRotationQ, factor));
+	}
+
+	bool SameBits(FXMVECTOR a, FXMVECTOR b)
+	{
+		XMFLOAT4 fa;
+		XMFLOAT4 fb;
+		XMStoreFloat4(&fa, a);
+		XMStoreFloat4(&fb, b);
+		return memcmp(&fa, &fb, sizeof(XMFLOAT4)) == 0;
+	}
+
+	// every channel at every time against the reference, one cursor per channel and key track carried from time to time like a unit's
+	UINT CountMismatches(const aiAnimation& animation, const BakedAnimation& baked, const std::vector<float>& times)
+	{
+		UINT mismatches = 0;
+		for (UINT channel = 0; channel < animation.mNumChannels; channel++)
+		{
+			const aiNodeAnim* nodeAnim = animation.mChannels[channel];
+			const UINT track = baked.FindTrack(nodeAnim->mNodeName.C_Str());
+			if (track == MAXUINT)
+			{
+				mismatches++;
+				continue;
+			}
+
+			UINT scalingCursor = 0;
+			UINT rotationCursor = 0;
+			UINT positionCursor = 0;
+			for (const float& time : times)
+			{
+				mismatches += SameBits(baked.SampleScaling(time, track, scalingCursor), InterpolateVector(time, nodeAnim->mScalingKeys, nodeAnim->mNumScalingKeys)) ? 0 : 1;
+				mismatches += SameBits(baked.SampleRotation(time, track, rotationCursor), CalcInterpolatedRotation(time, nodeAnim)) ? 0 : 1;
+				mismatches += SameBits(baked.SamplePosition(time, track, positionCursor), InterpolateVector(time, nodeAnim->mPositionKeys, nodeAnim->mNumPositionKeys)) ? 0 : 1;
+			}
+		}
+		return mismatches;
+	}
+}
+
+TEST_CASE(BakedAnimationMatchesNodeAnimSampling)
+{
+	// the keys the importer left are what the baked arrays have to give back, bit for bit, so a cached model poses the same as an imported one
+	const CPyburnRTXEngineTests::SyntheticAnimation synthetic = CPyburnRTXEngineTests::MakeSyntheticAnimation(15, 33, 81);
+	const aiAnimation& animation = *synthetic.animation;
+	BakedAnimation baked;
+	baked.Bake(&animation);
+	CHECK(baked.GetTrackCount() == animation.mNumChannels);
+	CHECK(baked.GetTicksPerSecond() == static_cast<float>(animation.mTicksPerSecond));
+	CHECK(baked.GetDuration() == static_cast<float>(animation.mDuration));
+	CHECK(baked.FindTrack("not a node") == MAXUINT);
+
+	// playing forwards, in between keys, exactly on them and past both ends where the scan falls back to the first key
+	const float duration = static_cast<float>(animation.mDuration);
+	std::vector<float> forwards;
+	for (float time = -1.0f; time < duration + 2.0f; time += 0.37f)
+	{
+		forwards.push_back(time);
+	}
+	for (UINT tick = 0; tick <= static_cast<UINT>(duration); tick++)
+	{
+		forwards.push_back(static_cast<float>(tick));
+	}
+	std::sort(forwards.begin(), forwards.end());
+	CHECK(CountMismatches(animation, baked, forwards) == 0);
+
+	// backwards, and seeks all over the clip the way a loop or a new unit lands on it
+	std::vector<float> backwards(forwards.rbegin(), forwards.rend());
+	CHECK(CountMismatches(animation, baked, backwards) == 0);
+
+	RandomNumberGenerator random;
+	random.SetSeed(82);
+	std::vector<float> seeks;
+	for (UINT i = 0; i < 500; i++)
+	{
+		seeks.push_back(random.NextFloat(0.0f, duration));
+	}
+	CHECK(CountMismatches(animation, baked, seeks) == 0);
+
+	// 3 keys leaves one scaling and one position key, the single key path
+	const CPyburnRTXEngineTests::SyntheticAnimation sparse = CPyburnRTXEngineTests::MakeSyntheticAnimation(7, 3, 83);
+	CHECK(sparse.animation->mChannels[0]->mNumScalingKeys == 1 && sparse.animation->mChannels[0]->mNumPositionKeys == 1);
+	BakedAnimation sparseBaked;
+	sparseBaked.Bake(sparse.animation.get());
+	CHECK(CountMismatches(*sparse.animation, sparseBaked, forwards) == 0);
+}
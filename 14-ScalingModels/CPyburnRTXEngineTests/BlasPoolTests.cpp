@@ -0,0 +1,78 @@
+#include "pch.h"
+
+#include <BlasPool.h>
+#include <Random.h>
+
+using namespace CPyburnRTXEngine;
+
+TEST_CASE(BlasPoolArenaSize)
+{
+	// small BLASes share the default arena, a larger one gets an arena of its own rounded up to the placement alignment
+	CHECK(BlasPool::GetArenaSize(1) == BlasPool::c_arenaSize);
+	CHECK(BlasPool::GetArenaSize(BlasPool::c_arenaSize) == BlasPool::c_arenaSize);
+	CHECK(BlasPool::GetArenaSize(BlasPool::c_arenaSize + 1) == BlasPool::c_arenaSize + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+	CHECK(BlasPool::GetArenaSize(BlasPool::c_arenaSize + 1) % D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT == 0);
+}
+
+TEST_CASE(BlasPoolSuballocatePacksAligned)
+{
+	RandomNumberGenerator random;
+	random.SetSeed(3);
+	RangeAllocator arena(BlasPool::GetArenaSize(1));
+
+	// compacted sizes are arbitrary multiples of 8, every one has to land on the acceleration structure alignment without overlapping
+	std::vector<std::pair<UINT64, UINT64>> placed;
+	UINT64 size = 0;
+	while (true)
+	{
+		size = static_cast<UINT64>(random.NextInt(1, 64 * 1024)) * 8;
+		UINT64 offset = BlasPool::Suballocate(arena, size);
+		if (offset == RangeAllocator::c_invalidOffset)
+			break;
+		placed.push_back({ offset, size });
+	}
+
+	bool aligned = true;
+	bool disjoint = true;
+	std::sort(placed.begin(), placed.end());
+	for (size_t i = 0; i < placed.size(); i++)
+	{
+		aligned = aligned && placed[i].first % D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT == 0;
+		disjoint = disjoint && (i == 0 || placed[i - 1].first + placed[i - 1].second <= placed[i].first);
+	}
+	CHECK(aligned);
+	CHECK(disjoint);
+	CHECK(placed.back().first + placed.back().second <= arena.GetCapacity());
+	// what is left is only the alignment padding and the tail the last BLAS didn't fit in
+	CHECK(arena.GetCapacity() - arena.GetUsedBytes() < size + placed.size() * D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT);
+
+	// the one that didn't fit always fits in the arena Allocate opens for it
+	RangeAllocator next(BlasPool::GetArenaSize(size));
+	CHECK(BlasPool::Suballocate(next, size) == 0);
+
+	// freed BLASes leave room that the next ones reuse
+	for (size_t i = 0; i < placed.size(); i += 2)
+	{
+		CHECK(arena.Free(placed[i].first, placed[i].second));
+	}
+	CHECK(BlasPool::Suballocate(arena, placed[0].second) == placed[0].first);
+}
+
+TEST_CASE(BlasPoolSuballocateOversized)
+{
+	// a BLAS bigger than the default arena only fits in an arena sized for it
+	const UINT64 size = BlasPool::c_arenaSize + 1000;
+	RangeAllocator shared(BlasPool::GetArenaSize(1));
+	CHECK(BlasPool::Suballocate(shared, size) == RangeAllocator::c_invalidOffset);
+
+	RangeAllocator own(BlasPool::GetArenaSize(size));
+	CHECK(BlasPool::Suballocate(own, size) == 0);
+}
+
+TEST_CASE(BlasPoolSuballocateZeroSize)
+{
+	// a compacted size of 0 means the size never came back, Compact() leaves that BLAS with its uncompacted result
+	RangeAllocator arena(BlasPool::GetArenaSize(1));
+	CHECK(BlasPool::Suballocate(arena, 0) == RangeAllocator::c_invalidOffset);
+	CHECK(arena.GetUsedBytes() == 0);
+}
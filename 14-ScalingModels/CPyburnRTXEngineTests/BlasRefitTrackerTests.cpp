@@ -0,0 +1,76 @@
+#include "pch.h"
+
+#include <BlasRefitTracker.h>
+
+using namespace CPyburnRTXEngine;
+
+TEST_CASE(BlasRefitTrackerFirstBuildIsFull)
+{
+	BlasRefitTracker tracker;
+	CHECK(tracker.ChooseRebuild(0.0f)); // nothing to refit yet, even with no deformation
+	CHECK(!tracker.ChooseRebuild(0.0f));
+	CHECK(tracker.GetBuildCount() == 1);
+	CHECK(tracker.GetRefitCount() == 1);
+}
+
+TEST_CASE(BlasRefitTrackerMaxRefitsRollover)
+{
+	BlasRefitTracker tracker;
+	tracker.SetPolicy(BlasRefitTracker::Policy{ 3, 100.0f });
+	CHECK(tracker.ChooseRebuild(0.01f));
+
+	// three refits in a row, the fourth call is a full build and the count starts over
+	for (UINT round = 0; round < 4; round++)
+	{
+		CHECK(!tracker.ChooseRebuild(0.01f));
+		CHECK(!tracker.ChooseRebuild(0.01f));
+		CHECK(!tracker.ChooseRebuild(0.01f));
+		CHECK(tracker.GetRefitsSinceBuild() == 3);
+		CHECK(tracker.ChooseRebuild(0.01f));
+		CHECK(tracker.GetRefitsSinceBuild() == 0);
+	}
+	CHECK(tracker.GetBuildCount() == 5);
+	CHECK(tracker.GetRefitCount() == 12);
+
+	// 0 refits means every build is a full one
+	tracker.SetPolicy(BlasRefitTracker::Policy{ 0, 100.0f });
+	CHECK(tracker.ChooseRebuild(0.0f));
+	CHECK(tracker.ChooseRebuild(0.0f));
+}
+
+TEST_CASE(BlasRefitTrackerDeformationThreshold)
+{
+	BlasRefitTracker tracker;
+	tracker.SetPolicy(BlasRefitTracker::Policy{ 1000, 0.5f });
+	CHECK(tracker.ChooseRebuild(0.0f));
+
+	// deformation adds up across refits, the call that takes it past the threshold rebuilds
+	CHECK(!tracker.ChooseRebuild(0.2f));
+	CHECK(!tracker.ChooseRebuild(0.2f));
+	CHECK_NEAR(tracker.GetDeformationSinceBuild(), 0.4f, 1e-6f);
+	CHECK(tracker.ChooseRebuild(0.2f));
+	CHECK(tracker.GetDeformationSinceBuild() == 0.0f);
+
+	// reaching it exactly is still a refit, only passing it rebuilds
+	CHECK(!tracker.ChooseRebuild(0.5f));
+	CHECK(tracker.ChooseRebuild(0.001f));
+
+	// one large step on its own
+	CHECK(tracker.ChooseRebuild(0.6f));
+}
+
+TEST_CASE(BlasRefitTrackerFltMaxRebuilds)
+{
+	BlasRefitTracker tracker;
+	CHECK(tracker.ChooseRebuild(FLT_MAX));
+	CHECK(tracker.ChooseRebuild(FLT_MAX)); // a clip that started or ended, every time
+
+	// even when the policy never rebuilds on its own
+	tracker.SetPolicy(BlasRefitTracker::Policy{ MAXUINT, FLT_MAX });
+	CHECK(!tracker.ChooseRebuild(1.0f));
+	CHECK(!tracker.ChooseRebuild(1000.0f));
+	CHECK(tracker.ChooseRebuild(FLT_MAX));
+	CHECK(!tracker.ChooseRebuild(1.0f));
+	CHECK(tracker.GetBuildCount() == 3);
+	CHECK(tracker.GetRefitCount() == 3);
+}
@@ -0,0 +1,118 @@
+#include "pch.h"
+
+#include <BufferHeap.h>
+
+#include "TestAssets.h"
+
+using namespace CPyburnRTXEngine;
+
+namespace
+{
+	// a pose written into bones, what AnimationPlayer does to whatever palette it is handed
+	void WritePalette(XMMATRIX* bones, const UINT& boneCount, const UINT& frame)
+	{
+		for (UINT b = 0; b < boneCount; b++)
+		{
+			bones[b] = XMMatrixRotationY(0.01f * frame) * XMMatrixTranslation(static_cast<float>(b), 0.0f, 0.0f);
+		}
+	}
+
+	// closes whatever earlier tests left counted, the next EndFrame starts from an empty frame
+	void ClearStats()
+	{
+		BufferHeapStats::EndFrame();
+		BufferHeapStats::EndFrame();
+	}
+}
+
+TEST_CASE(BufferHeapStatsCountsCopies)
+{
+	ClearStats();
+	CHECK(!BufferHeapStats::EndFrame());
+	CHECK(BufferHeapStats::GetLastFrame().copies == 0 && BufferHeapStats::GetLastFrame().bytesCopied == 0 && BufferHeapStats::GetLastFrame().resources == 0);
+
+	// a vector the caller keeps is copied and counted, one handed over is moved and isn't
+	BufferHeap<XMFLOAT4> buffer;
+	const std::vector<XMFLOAT4> kept(10);
+	auto frame = [&buffer, &kept]()
+		{
+			buffer.SetCpuData(kept);
+			buffer.SetCpuData(std::vector<XMFLOAT4>(20));
+		};
+
+	frame();
+	CHECK(BufferHeapStats::EndFrame());
+	CHECK(BufferHeapStats::GetLastFrame().copies == 1);
+	CHECK(BufferHeapStats::GetLastFrame().bytesCopied == 10 * sizeof(XMFLOAT4));
+	CHECK(BufferHeapStats::GetLastFrame().resources == 0);
+	CHECK(buffer.CpuData.size() == 20);
+
+	// the same frame again is a steady state, reported once
+	frame();
+	CHECK(!BufferHeapStats::EndFrame());
+	CHECK(BufferHeapStats::GetLastFrame().copies == 1);
+
+	buffer.ReleaseCpuData();
+	CHECK(buffer.CpuData.capacity() == 0);
+	CHECK(BufferHeapStats::EndFrame());
+	CHECK(BufferHeapStats::GetLastFrame().copies == 0);
+}
+
+// a frame of bone palettes uploaded the way they were before the in place mode and the way they are now
+// copying builds the pose in a vector, copies it into CpuData and CpuData into the mapped buffer, in place writes the mapped buffer
+// the counts are BufferHeapStats::GetLastFrame for one steady frame, the same numbers the game's window title shows
+BENCHMARK_CASE(BufferHeapPaletteUploadBenchmark)
+{
+	Microsoft::WRL::ComPtr<ID3D12Device5> device = CPyburnRTXEngineTests::CreateWarpDevice();
+	static constexpr UINT c_boneCount = 64;
+	const UINT paletteCounts[] = { 100, 1000 };
+	for (const UINT& count : paletteCounts)
+	{
+		ClearStats();
+		std::vector<std::unique_ptr<BufferHeap<XMMATRIX>>> copying;
+		std::vector<std::unique_ptr<BufferHeap<XMMATRIX>>> inPlace;
+		std::vector<XMMATRIX> palette(c_boneCount, XMMatrixIdentity());
+		for (UINT i = 0; i < count; i++)
+		{
+			copying.push_back(std::make_unique<BufferHeap<XMMATRIX>>());
+			copying.back()->CreateDeviceDependentResources(device.Get());
+			copying.back()->SetCpuData(std::vector<XMMATRIX>(palette));
+			copying.back()->CreateOnUploadHeap(L"Copied palette");
+
+			inPlace.push_back(std::make_unique<BufferHeap<XMMATRIX>>());
+			inPlace.back()->CreateDeviceDependentResources(device.Get());
+			inPlace.back()->CreateOnUploadHeap(c_boneCount, L"In place palette");
+		}
+		BufferHeapStats::EndFrame();
+
+		UINT frame = 0;
+		const double copyingMs = CPyburnRTXEngineTests::MeasureMilliseconds(20, [&]()
+			{
+				for (const std::unique_ptr<BufferHeap<XMMATRIX>>& buffer : copying)
+				{
+					WritePalette(palette.data(), c_boneCount, frame);
+					buffer->SetCpuData(palette);
+					buffer->CopyCpuDataToUploadHeap();
+				}
+				BufferHeapStats::EndFrame();
+				frame++;
+			});
+		const BufferHeapFrameStats copyingFrame = BufferHeapStats::GetLastFrame();
+
+		const double inPlaceMs = CPyburnRTXEngineTests::MeasureMilliseconds(20, [&]()
+			{
+				for (const std::unique_ptr<BufferHeap<XMMATRIX>>& buffer : inPlace)
+				{
+					WritePalette(buffer->GetMapped().data, c_boneCount, frame);
+				}
+				BufferHeapStats::EndFrame();
+				frame++;
+			});
+		const BufferHeapFrameStats inPlaceFrame = BufferHeapStats::GetLastFrame();
+
+		CHECK(copyingFrame.copies == 2ull * count);
+		CHECK(inPlaceFrame.copies == 0 && inPlaceFrame.bytesCopied == 0);
+		printf("    %u palettes of %u bones: copying %.3f ms, %llu copies, %llu bytes a frame, in place %.3f ms, %llu copies, %llu bytes a frame\n",
+			count, c_boneCount, copyingMs, copyingFrame.copies, copyingFrame.bytesCopied, inPlaceMs, inPlaceFrame.copies, inPlaceFrame.bytesCopied);
+	}
+}
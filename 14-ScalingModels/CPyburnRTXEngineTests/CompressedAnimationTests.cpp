@@ -0,0 +1,151 @@
+#include "pch.h"
+
+#include <AssimpFactory.h>
+#include <CompressedAnimation.h>
+
+#include "TestAnimation.h"
+#include "TestAssets.h"
+
+using namespace CPyburnRTXEngine;
+
+namespace
+{
+	// the bind pose extent Settings::maxError is a fraction of, the farthest node from the origin
+	float BindExtent(const Skeleton& skeleton)
+	{
+		std::vector<XMMATRIX> globals(skeleton.GetNodeCount());
+		float extent = 0.0f;
+		for (UINT node = 0; node < skeleton.GetNodeCount(); node++)
+		{
+			const UINT& parent = skeleton.GetParent(node);
+			globals[node] = parent != MAXUINT ? XMMatrixMultiply(globals[parent], skeleton.GetBindTransform(node)) : skeleton.GetBindTransform(node);
+
+			XMFLOAT4X4 global;
+			XMStoreFloat4x4(&global, globals[node]);
+			extent = std::max(extent, XMVectorGetX(XMVector3Length(XMVectorSet(global._14, global._24, global._34, 0.0f))));
+		}
+		return extent > 0.0f ? extent : 1.0f;
+	}
+
+	// q and -q are the same rotation
+	float AngleBetween(FXMVECTOR a, FXMVECTOR b)
+	{
+		return 2.0f * acosf(std::min(1.0f, fabsf(XMVectorGetX(XMQuaternionDot(a, b)))));
+	}
+
+	bool SameBits(const CompressedAnimation::PackedRotation& a, const CompressedAnimation::PackedRotation& b)
+	{
+		return a.bits[0] == b.bits[0] && a.bits[1] == b.bits[1] && a.bits[2] == b.bits[2];
+	}
+
+	// 15 bits over +-1/sqrt(2) is a step of about 4e-5 per component, a few of those stays well under this
+	static constexpr float c_rotationTolerance = 0.001f; // radians
+}
+
+TEST_CASE(CompressedAnimationRotationRoundTrip)
+{
+	RandomNumberGenerator random;
+	random.SetSeed(61);
+	float worst = 0.0f;
+	for (UINT i = 0; i < 10000; i++)
+	{
+		const XMVECTOR axis = XMVector3Normalize(XMVectorSet(random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f), 0.0f) + XMVectorSet(0.0f, 0.01f, 0.0f, 0.0f));
+		const XMVECTOR rotationQ = XMQuaternionRotationAxis(axis, random.NextFloat(-XM_PI, XM_PI));
+		worst = std::max(worst, AngleBetween(rotationQ, CompressedAnimation::UnpackRotation(CompressedAnimation::PackRotation(rotationQ))));
+	}
+	CHECK(worst < c_rotationTolerance);
+
+	// the largest component at every index and both signs, ties go to the first, and an unnormalized one
+	const XMVECTOR edges[] =
+	{
+		XMQuaternionIdentity(),
+		XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f),
+		XMVectorSet(0.0f, -1.0f, 0.0f, 0.0f),
+		XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f),
+		XMVectorSet(0.0f, 0.0f, 0.0f, -1.0f),
+		XMVectorSet(0.5f, 0.5f, 0.5f, 0.5f),
+		XMVectorSet(-0.5f, 0.5f, -0.5f, 0.5f),
+		XMVectorSet(0.0f, 2.0f, 0.0f, 2.0f),
+	};
+	for (const XMVECTOR& edge : edges)
+	{
+		const CompressedAnimation::PackedRotation packed = CompressedAnimation::PackRotation(edge);
+		const XMVECTOR unpacked = CompressedAnimation::UnpackRotation(packed);
+		CHECK(AngleBetween(XMQuaternionNormalize(edge), unpacked) < c_rotationTolerance);
+		CHECK_NEAR(XMVectorGetX(XMVector4Length(unpacked)), 1.0f, 1e-4f);
+		CHECK(SameBits(packed, CompressedAnimation::PackRotation(-edge)));
+	}
+}
+
+TEST_CASE(CompressedAnimationStaysWithinMaxError)
+{
+	const CPyburnRTXEngineTests::SyntheticAnimation synthetic = CPyburnRTXEngineTests::MakeSyntheticAnimation(31, 121, 62);
+	BakedAnimation baked;
+	baked.Bake(synthetic.animation.get());
+	const float extent = BindExtent(synthetic.skeleton);
+
+	// keys are dropped against the budget before they are quantized, the 15 bit rotations add about 1e-4 radians on top
+	// at the end of an arm that reaches at most twice the extent plus the shell
+	const float quantization = 2.5e-4f * extent;
+
+	const float maxErrors[] = { 0.01f, 0.001f, 0.0001f };
+	size_t looserBytes = 0;
+	for (const float& maxError : maxErrors)
+	{
+		CompressedAnimation::Settings settings;
+		settings.maxError = maxError;
+		CompressedAnimation compressed;
+		compressed.Compress(baked, synthetic.skeleton, settings);
+		CHECK(compressed.GetTrackCount() == baked.GetTrackCount());
+
+		const float measured = compressed.MeasureMaxError(baked, synthetic.skeleton, 0.0f, baked.GetDuration(), settings);
+		CHECK(measured <= maxError * extent + quantization);
+
+		// the curves are smooth enough that even the tightest budget drops keys, and a tighter one never keeps fewer
+		const size_t bytes = compressed.GetMemoryUsage();
+		CHECK(bytes < baked.GetMemoryUsage());
+		CHECK(bytes >= looserBytes);
+		looserBytes = bytes;
+	}
+}
+
+// every track of the elf over its whole animation a tick at a time, the walk a playing clip does, baked keys against compressed
+BENCHMARK_CASE(CompressedAnimationBenchmark)
+{
+	// a factory of its own, the shared one has already dropped its baked keys
+	AssimpFactory::Model model;
+	CPyburnRTXEngineTests::DescribeAnimatedModel(model);
+	AssimpFactory::KeepBakedKeys = true;
+	AssimpFactory factory(&model, model.GetAssetPath(model.name));
+	AssimpFactory::KeepBakedKeys = false;
+
+	const BakedAnimation& baked = factory.GetBakedAnimation();
+	const CompressedAnimation& compressed = factory.GetCompressedAnimation();
+	if (compressed.IsEmpty())
+	{
+		printf("    AssimpFactory::CompressAnimations is off, nothing to compare\n");
+		return;
+	}
+
+	const UINT trackCount = baked.GetTrackCount();
+	XMVECTOR sum = XMVectorZero(); // printed so the loops aren't optimised away
+	auto sampleAll = [&](const auto& animation)
+		{
+			std::vector<KeyframeCursor> cursors(trackCount);
+			for (float time = 0.0f; time < baked.GetDuration(); time += 1.0f)
+			{
+				for (UINT track = 0; track < trackCount; track++)
+				{
+					sum += animation.SampleScaling(time, track, cursors[track].scaling);
+					sum += animation.SampleRotation(time, track, cursors[track].rotation);
+					sum += animation.SamplePosition(time, track, cursors[track].position);
+				}
+			}
+		};
+
+	const double bakedMs = CPyburnRTXEngineTests::MeasureMilliseconds(16, [&]() { sampleAll(baked); });
+	const double compressedMs = CPyburnRTXEngineTests::MeasureMilliseconds(16, [&]() { sampleAll(compressed); });
+	const double samples = std::ceil(baked.GetDuration()) * trackCount;
+	printf("    %u tracks, %.0f ticks: baked %.1f ns, compressed %.1f ns per track sample, %.1f KB against %.1f KB (%d)\n", trackCount, std::ceil(baked.GetDuration()),
+		bakedMs * 1e6 / samples, compressedMs * 1e6 / samples, baked.GetMemoryUsage() / 1024.0, compressed.GetMemoryUsage() / 1024.0, XMVectorGetX(sum) > 0.0f ? 1 : 0);
+}
@@ -0,0 +1,100 @@
+#include "pch.h"
+
+#include <CpuSkinning.h>
+
+#include "TestSkinning.h"
+
+using namespace CPyburnRTXEngine;
+using CPyburnRTXEngineTests::MakeMesh;
+using CPyburnRTXEngineTests::SyntheticMesh;
+
+namespace
+{
+	std::vector<AssimpFactory::VSVertices> Skin(const SyntheticMesh& mesh, const CpuSkinning::Path& path)
+	{
+		std::vector<AssimpFactory::VSVertices> skinned(mesh.vertices.size());
+		CpuSkinning::Skin(path, mesh.vertices.data(), mesh.boneData.data(), mesh.bones.data(), skinned.data(), 0, static_cast<UINT>(skinned.size()));
+		return skinned;
+	}
+
+	// the paths only differ in the order they add, positions are a few units so this is a handful of ulps
+	static constexpr float c_tolerance = 1e-4f;
+}
+
+TEST_CASE(CpuSkinningPathsMatchScalar)
+{
+	// scaled bones too, linear blend skinning has to handle whatever the palette holds
+	const SyntheticMesh mesh = MakeMesh(64, 10001, 21, true);
+	const UINT count = static_cast<UINT>(mesh.vertices.size());
+	const std::vector<AssimpFactory::VSVertices> scalar = Skin(mesh, CpuSkinning::Path::Scalar);
+	const std::vector<AssimpFactory::VSVertices> simd = Skin(mesh, CpuSkinning::Path::Simd);
+	CHECK(CpuSkinning::MaxDifference(scalar.data(), simd.data(), count) < c_tolerance);
+
+	// the avx2 path is only ever picked on a cpu that runs it, the same goes for the test
+	if (CpuSkinning::GetBestPath() == CpuSkinning::Path::Avx2)
+	{
+		const std::vector<AssimpFactory::VSVertices> avx2 = Skin(mesh, CpuSkinning::Path::Avx2);
+		CHECK(CpuSkinning::MaxDifference(scalar.data(), avx2.data(), count) < c_tolerance);
+	}
+
+	// texture coordinates are copied, not skinned
+	bool copied = true;
+	for (size_t v = 0; v < mesh.vertices.size(); v++)
+	{
+		copied = copied && simd[v].texture.x == mesh.vertices[v].texture.x && simd[v].texture.y == mesh.vertices[v].texture.y;
+	}
+	CHECK(copied);
+}
+
+TEST_CASE(CpuSkinningIdentityPalette)
+{
+	SyntheticMesh mesh = MakeMesh(8, 1001, 22, false);
+	std::fill(mesh.bones.begin(), mesh.bones.end(), XMMatrixIdentity());
+
+	// the bind pose comes back out, the normals already were unit length
+	const std::vector<AssimpFactory::VSVertices> skinned = Skin(mesh, CpuSkinning::GetBestPath());
+	CHECK(CpuSkinning::MaxDifference(mesh.vertices.data(), skinned.data(), static_cast<UINT>(mesh.vertices.size())) < c_tolerance);
+}
+
+TEST_CASE(CpuSkinningRangesSplitAMesh)
+{
+	// what a JobSystem::ParallelFor over one mesh does, every range writes only its own vertices
+	const SyntheticMesh mesh = MakeMesh(32, 1000, 23, true);
+	const std::vector<AssimpFactory::VSVertices> whole = Skin(mesh, CpuSkinning::Path::Simd);
+
+	std::vector<AssimpFactory::VSVertices> split(mesh.vertices.size());
+	const UINT bounds[] = { 0, 3, 250, 777, 1000 };
+	for (UINT r = 0; r + 1 < _countof(bounds); r++)
+	{
+		CpuSkinning::Skin(CpuSkinning::Path::Simd, mesh.vertices.data(), mesh.boneData.data(), mesh.bones.data(), split.data(), bounds[r], bounds[r + 1]);
+	}
+	CHECK(CpuSkinning::MaxDifference(whole.data(), split.data(), static_cast<UINT>(mesh.vertices.size())) == 0.0f);
+}
+
+// one mesh on one thread, the same palette and vertices through every path this cpu has
+BENCHMARK_CASE(CpuSkinningBenchmark)
+{
+	const SyntheticMesh mesh = MakeMesh(128, 100000, 24, true);
+	const UINT count = static_cast<UINT>(mesh.vertices.size());
+	std::vector<AssimpFactory::VSVertices> skinned(count);
+
+	auto measure = [&](const CpuSkinning::Path& path)
+		{
+			return CPyburnRTXEngineTests::MeasureMilliseconds(20, [&]()
+				{
+					CpuSkinning::Skin(path, mesh.vertices.data(), mesh.boneData.data(), mesh.bones.data(), skinned.data(), 0, count);
+				});
+		};
+
+	const double scalar = measure(CpuSkinning::Path::Scalar);
+	const double simd = measure(CpuSkinning::Path::Simd);
+	if (CpuSkinning::GetBestPath() == CpuSkinning::Path::Avx2)
+	{
+		const double avx2 = measure(CpuSkinning::Path::Avx2);
+		printf("    %u vertices, %zu bones: scalar %.3f ms, simd %.3f ms, avx2 %.3f ms\n", count, mesh.bones.size(), scalar, simd, avx2);
+	}
+	else
+	{
+		printf("    %u vertices, %zu bones: scalar %.3f ms, simd %.3f ms, no avx2 on this cpu\n", count, mesh.bones.size(), scalar, simd);
+	}
+}
@@ -0,0 +1,165 @@
+#include "pch.h"
+
+#include <DescriptorAllocator.h>
+#include <thread>
+
+using namespace CPyburnRTXEngine;
+
+TEST_CASE(DescriptorAllocatorWaitsForFence)
+{
+	DescriptorAllocator allocator(8);
+	DescriptorAllocator::Handle first = allocator.Allocate();
+	DescriptorAllocator::Handle second = allocator.Allocate();
+	CHECK(first.index == 0);
+	CHECK(second.index == 1);
+
+	CHECK(allocator.Free(first, 5));
+	CHECK(!allocator.IsAlive(first));
+	CHECK(allocator.GetRetiredCount() == 1);
+
+	// the gpu may still read slot 0 until fence 5, so a new slot comes from the untouched ones
+	CHECK(allocator.Allocate().index == 2);
+	CHECK(allocator.Reclaim(4) == 0);
+	CHECK(allocator.Reclaim(5) == 1);
+
+	DescriptorAllocator::Handle reused = allocator.Allocate();
+	CHECK(reused.index == 0);
+	CHECK(reused.generation != first.generation);
+	CHECK(allocator.IsAlive(reused));
+	CHECK(allocator.GetLiveCount() == 3);
+	CHECK(allocator.GetHighWaterMark() == 3);
+}
+
+TEST_CASE(DescriptorAllocatorRejectsStaleHandles)
+{
+	DescriptorAllocator allocator(4);
+	DescriptorAllocator::Handle old = allocator.Allocate();
+	CHECK(allocator.Free(old, 1));
+	CHECK(!allocator.Free(old, 1)); // freed twice
+	allocator.Reclaim(1);
+
+	// the slot has a new owner, the old handle must not free it from under them
+	DescriptorAllocator::Handle owner = allocator.Allocate();
+	CHECK(owner.index == old.index);
+	CHECK(!allocator.Free(old, 2));
+	CHECK(allocator.IsAlive(owner));
+
+	CHECK(!allocator.Free(DescriptorAllocator::Handle{}, 2)); // never handed out
+	CHECK(!allocator.Free(DescriptorAllocator::Handle{ 3, 0 }, 2));
+
+	// every handle from before a reset is stale
+	allocator.Reset(4);
+	CHECK(!allocator.IsAlive(owner));
+	CHECK(!allocator.Free(owner, 3));
+	CHECK(allocator.Allocate().index == 0);
+}
+
+TEST_CASE(DescriptorAllocatorBatchAndGrow)
+{
+	DescriptorAllocator allocator(8);
+	DescriptorAllocator::Handle handles[10];
+	CHECK(allocator.AllocateBatch(handles, 10) == 8);
+	CHECK(handles[0].index == 0);
+	CHECK(handles[7].index == 7);
+	CHECK(!allocator.Allocate().IsValid());
+
+	allocator.Grow(10);
+	CHECK(allocator.Allocate().index == 8);
+	CHECK(allocator.IsAlive(handles[3])); // growing keeps what was handed out
+}
+
+TEST_CASE(DescriptorAllocatorReturnSkipsFence)
+{
+	DescriptorAllocator allocator(4);
+	DescriptorAllocator::Handle handles[4];
+	CHECK(allocator.AllocateBatch(handles, 4) == 4);
+	CHECK(allocator.Free(handles[0], 9));
+
+	// never used slots come straight back, the freed one is stale and skipped
+	CHECK(allocator.Return(handles, 3) == 2);
+	CHECK(allocator.GetLiveCount() == 1);
+	CHECK(allocator.GetRetiredCount() == 1);
+	CHECK(!allocator.IsAlive(handles[1]));
+
+	DescriptorAllocator::Handle again = allocator.Allocate();
+	CHECK(again.index == 2); // the free list hands out the last one returned first
+	CHECK(again.generation != handles[again.index].generation);
+}
+
+TEST_CASE(DescriptorAllocatorThreadExitReturnsCache)
+{
+	// what GraphicsContexts' per thread cache does: take a batch, use a few, hand the rest back when the thread ends
+	DescriptorAllocator allocator(64);
+	std::vector<std::thread> threads;
+	for (UINT t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&allocator]()
+			{
+				DescriptorAllocator::Handle handles[16];
+				UINT count = allocator.AllocateBatch(handles, 16);
+				allocator.Free(handles[0], 1);
+				allocator.Return(handles + 1, count - 1);
+			});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	CHECK(allocator.GetLiveCount() == 0);
+	CHECK(allocator.GetRetiredCount() == 4);
+	CHECK(allocator.Reclaim(1) == 4);
+
+	// nothing leaked, the whole heap can be handed out again
+	DescriptorAllocator::Handle handles[64];
+	CHECK(allocator.AllocateBatch(handles, 64) == 64);
+}
+
+// threads allocating and freeing at once, one lock per slot against one lock per batch of 16 like the per thread cache
+BENCHMARK_CASE(DescriptorAllocatorContentionBenchmark)
+{
+	static constexpr UINT perThread = 20000;
+	static constexpr UINT batchSize = 16;
+	const UINT threadCounts[] = { 1, 2, 4, 8 };
+
+	for (const UINT& threadCount : threadCounts)
+	{
+		DescriptorAllocator allocator(threadCount * batchSize * 4);
+
+		auto run = [&](bool batched)
+			{
+				std::vector<std::thread> threads;
+				for (UINT t = 0; t < threadCount; t++)
+				{
+					threads.emplace_back([&allocator, batched]()
+						{
+							DescriptorAllocator::Handle handles[batchSize];
+							for (UINT i = 0; i < perThread; i += batchSize)
+							{
+								UINT count = 0;
+								if (batched)
+								{
+									count = allocator.AllocateBatch(handles, batchSize);
+								}
+								else
+								{
+									for (; count < batchSize; count++)
+									{
+										handles[count] = allocator.Allocate();
+									}
+								}
+								allocator.Return(handles, count);
+							}
+						});
+				}
+				for (std::thread& thread : threads)
+				{
+					thread.join();
+				}
+			};
+
+		const double single = CPyburnRTXEngineTests::MeasureMilliseconds(5, [&]() { run(false); });
+		const double batched = CPyburnRTXEngineTests::MeasureMilliseconds(5, [&]() { run(true); });
+		printf("    %u threads x %u slots: one at a time %.3f ms, batches of %u %.3f ms\n", threadCount, perThread, single, batchSize, batched);
+	}
+}
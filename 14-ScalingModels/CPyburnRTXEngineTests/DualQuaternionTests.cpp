@@ -0,0 +1,93 @@
+#include "pch.h"
+
+#include <BakedAnimation.h>
+#include <CpuSkinning.h>
+#include <DualQuaternion.h>
+
+#include "TestAnimation.h"
+#include "TestSkinning.h"
+
+using namespace CPyburnRTXEngine;
+using CPyburnRTXEngineTests::MakeMesh;
+using CPyburnRTXEngineTests::SyntheticMesh;
+
+namespace
+{
+	std::vector<DualQuaternion> Convert(const std::vector<XMMATRIX>& bones)
+	{
+		std::vector<DualQuaternion> dualQuaternions(bones.size());
+		for (size_t b = 0; b < bones.size(); b++)
+		{
+			dualQuaternions[b] = DualQuaternion::FromMatrix(bones[b]);
+		}
+		return dualQuaternions;
+	}
+
+	// positions are a few units, so float precision after a decompose is a few ulps of that
+	static constexpr float c_tolerance = 1e-4f;
+}
+
+TEST_CASE(DualQuaternionMatchesLinearBlendOnRigidBones)
+{
+	const SyntheticMesh mesh = MakeMesh(64, 10000, 31, false, true);
+	const UINT count = static_cast<UINT>(mesh.vertices.size());
+
+	// the palette the way AnimationCompute::FinishPose converts it for a dualQuaternionSkinning model
+	const std::vector<DualQuaternion> dualQuaternions = Convert(mesh.bones);
+
+	std::vector<AssimpFactory::VSVertices> linear(count);
+	std::vector<AssimpFactory::VSVertices> dual(count);
+	CpuSkinning::Skin(CpuSkinning::Path::Scalar, mesh.vertices.data(), mesh.boneData.data(), mesh.bones.data(), linear.data(), 0, count);
+	CpuSkinning::SkinDualQuaternion(mesh.vertices.data(), mesh.boneData.data(), dualQuaternions.data(), dual.data(), 0, count);
+	CHECK(CpuSkinning::MaxDifference(linear.data(), dual.data(), count) < c_tolerance);
+}
+
+TEST_CASE(DualQuaternionBlendIgnoresSign)
+{
+	// q and -q are the same bone, a blend of them must not cancel out
+	// influences on different bones this time, both palettes describe the same pose so the blends have to agree
+	const SyntheticMesh mesh = MakeMesh(16, 1000, 32, false);
+	const UINT count = static_cast<UINT>(mesh.vertices.size());
+	const std::vector<DualQuaternion> dualQuaternions = Convert(mesh.bones);
+	std::vector<DualQuaternion> flipped = dualQuaternions;
+	for (size_t b = 1; b < flipped.size(); b += 2)
+	{
+		XMStoreFloat4(&flipped[b].real, -XMLoadFloat4(&flipped[b].real));
+		XMStoreFloat4(&flipped[b].dual, -XMLoadFloat4(&flipped[b].dual));
+	}
+
+	std::vector<AssimpFactory::VSVertices> original(count);
+	std::vector<AssimpFactory::VSVertices> signFlipped(count);
+	CpuSkinning::SkinDualQuaternion(mesh.vertices.data(), mesh.boneData.data(), dualQuaternions.data(), original.data(), 0, count);
+	CpuSkinning::SkinDualQuaternion(mesh.vertices.data(), mesh.boneData.data(), flipped.data(), signFlipped.data(), 0, count);
+	CHECK(CpuSkinning::MaxDifference(original.data(), signFlipped.data(), count) < c_tolerance);
+}
+
+TEST_CASE(DualQuaternionRejectsScaledBones)
+{
+	// what AssimpFactory checks the bind pose palette with at load, a dualQuaternionSkinning model with one of these goes back to linear blend
+	RandomNumberGenerator random;
+	random.SetSeed(33);
+	bool rigid = true;
+	for (UINT b = 0; b < 100; b++)
+	{
+		rigid = rigid && DualQuaternion::IsRigid(CPyburnRTXEngineTests::RandomBone(random, false));
+	}
+	CHECK(rigid);
+
+	const XMMATRIX bone = CPyburnRTXEngineTests::RandomBone(random, false);
+	CHECK(!DualQuaternion::IsRigid(XMMatrixScaling(1.1f, 1.1f, 1.1f) * bone)); // uniform, an fbx in centimetres
+	CHECK(!DualQuaternion::IsRigid(XMMatrixScaling(1.0f, 0.5f, 1.0f) * bone));
+	CHECK(!DualQuaternion::IsRigid(XMMatrixScaling(-1.0f, 1.0f, 1.0f) * bone)); // mirrored, unit rows but the determinant is -1
+	CHECK(DualQuaternion::IsRigid(XMMatrixScaling(1.001f, 1.0f, 1.0f) * bone)); // interpolation noise is let through
+}
+
+TEST_CASE(DualQuaternionRigidityCheckSeesScalingKeys)
+{
+	// the other half of the load time check, the synthetic clip breathes 2% on every scaling key
+	const CPyburnRTXEngineTests::SyntheticAnimation synthetic = CPyburnRTXEngineTests::MakeSyntheticAnimation(7, 17, 34);
+	BakedAnimation baked;
+	baked.Bake(synthetic.animation.get());
+	CHECK(!baked.HasUnitScaling(DualQuaternion::c_rigidTolerance));
+	CHECK(baked.HasUnitScaling(0.05f));
+}
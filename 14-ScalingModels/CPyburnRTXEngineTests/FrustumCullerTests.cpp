@@ -0,0 +1,199 @@
+#include "pch.h"
+
+#include <FrustumCuller.h>
+#include <Random.h>
+#include <thread>
+
+using namespace CPyburnRTXEngine;
+
+namespace
+{
+	// the camera the way CameraBase builds its culling frustum, looking down +z from a little above the origin
+	BoundingFrustum MakeFrustum()
+	{
+		XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 200.0f);
+		BoundingFrustum viewSpace;
+		BoundingFrustum::CreateFromMatrix(viewSpace, projection);
+
+		XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 5.0f, -10.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 50.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		BoundingFrustum world;
+		viewSpace.Transform(world, XMMatrixInverse(nullptr, view));
+		return world;
+	}
+
+	// random spheres in a box around the frustum, count is not a multiple of 4 so the left over path runs too
+	void AddRandomSpheres(TransformStore& transforms, const UINT& count, const UINT& seed)
+	{
+		RandomNumberGenerator random;
+		random.SetSeed(seed);
+		transforms.Reserve(count);
+		for (UINT id = 0; id < count; id++)
+		{
+			XMFLOAT3 position(random.NextFloat(-250.0f, 250.0f), random.NextFloat(-100.0f, 100.0f), random.NextFloat(-100.0f, 300.0f));
+			transforms.Add(id, position, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+			transforms.SetLocalBounds(id, BoundingSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), random.NextFloat(0.1f, 10.0f)));
+		}
+		transforms.ComposeWorldMatrices();
+	}
+
+	// the largest dot(n, c) + d - r over the planes, above 0 means outside, the same test the culler makes 4 spheres at a time
+	float PlaneMargin(const BoundingFrustum& frustum, const BoundingSphere& sphere)
+	{
+		XMVECTOR planes[6];
+		frustum.GetPlanes(&planes[0], &planes[1], &planes[2], &planes[3], &planes[4], &planes[5]);
+		float margin = -FLT_MAX;
+		for (const XMVECTOR& plane : planes)
+		{
+			margin = std::max(margin, XMVectorGetX(XMPlaneDotCoord(plane, XMLoadFloat3(&sphere.Center))) - sphere.Radius);
+		}
+		return margin;
+	}
+
+	// spheres closer than this to a plane can land on either side depending on how the multiply adds round
+	static constexpr float c_tolerance = 0.001f;
+
+	BoundingSphere Shrink(const BoundingSphere& sphere)
+	{
+		return BoundingSphere(sphere.Center, sphere.Radius - c_tolerance);
+	}
+}
+
+TEST_CASE(FrustumCullerMatchesBoundingFrustum)
+{
+	const BoundingFrustum frustum = MakeFrustum();
+	TransformStore transforms;
+	AddRandomSpheres(transforms, 10003, 11);
+
+	JobSystem jobSystem(3);
+	FrustumCuller culler;
+	culler.SetMode(FrustumCuller::Mode::Camera);
+	culler.SetFrustum(frustum);
+	culler.Cull(transforms, jobSystem);
+
+	// the plane test is conservative, a sphere near a corner can be outside the frustum but inside every plane
+	// so nothing that touches the frustum may be culled, and whatever is kept has to pass the plane test
+	UINT missed = 0;
+	UINT mismatched = 0;
+	UINT visible = 0;
+	for (UINT slot = 0; slot < transforms.GetCount(); slot++)
+	{
+		const BoundingSphere sphere = transforms.GetWorldBoundsBySlot(slot);
+		const float margin = PlaneMargin(frustum, sphere);
+		missed += frustum.Intersects(Shrink(sphere)) && !culler.IsVisible(slot) ? 1 : 0;
+		mismatched += std::abs(margin) > c_tolerance && (margin <= 0.0f) != culler.IsVisible(slot) ? 1 : 0;
+		visible += culler.IsVisible(slot) ? 1 : 0;
+	}
+	CHECK(missed == 0);
+	CHECK(mismatched == 0);
+	CHECK(visible > 0 && visible < transforms.GetCount()); // the box is big enough that both sides are exercised
+	CHECK(culler.GetVisibleSlots().size() == visible);
+}
+
+TEST_CASE(FrustumCullerKeepsShadowCasters)
+{
+	const BoundingFrustum frustum = MakeFrustum();
+	TransformStore transforms;
+	AddRandomSpheres(transforms, 4001, 12);
+
+	const XMFLOAT3 lightDirection(0.5f, 0.5f, -0.5f);
+	const float extrusion = 100.0f;
+
+	JobSystem jobSystem(3);
+	FrustumCuller camera;
+	camera.SetMode(FrustumCuller::Mode::Camera);
+	camera.SetFrustum(frustum);
+	camera.Cull(transforms, jobSystem);
+
+	FrustumCuller shadows;
+	shadows.SetMode(FrustumCuller::Mode::CameraAndShadowCasters);
+	shadows.SetLightDirection(lightDirection);
+	shadows.SetShadowExtrusion(extrusion);
+	shadows.SetFrustum(frustum);
+	shadows.Cull(transforms, jobSystem);
+
+	// the shadow lands away from the light, anywhere along the sphere swept that far has to keep the caster
+	const XMVECTOR awayFromLight = XMVectorScale(XMVector3Normalize(XMLoadFloat3(&lightDirection)), -extrusion);
+	UINT lostCasters = 0;
+	UINT lostVisible = 0;
+	UINT extraCasters = 0;
+	for (UINT slot = 0; slot < transforms.GetCount(); slot++)
+	{
+		lostVisible += camera.IsVisible(slot) && !shadows.IsVisible(slot) ? 1 : 0;
+		extraCasters += !camera.IsVisible(slot) && shadows.IsVisible(slot) ? 1 : 0;
+
+		const BoundingSphere sphere = Shrink(transforms.GetWorldBoundsBySlot(slot));
+		bool castsOnScreen = false;
+		for (UINT step = 0; step <= 32 && !castsOnScreen; step++)
+		{
+			BoundingSphere swept = sphere;
+			XMStoreFloat3(&swept.Center, XMVectorMultiplyAdd(awayFromLight, XMVectorReplicate(step / 32.0f), XMLoadFloat3(&sphere.Center)));
+			castsOnScreen = frustum.Intersects(swept);
+		}
+		lostCasters += castsOnScreen && !shadows.IsVisible(slot) ? 1 : 0;
+	}
+	CHECK(lostCasters == 0);
+	CHECK(lostVisible == 0); // the shadow mode only ever adds to what the camera sees
+	CHECK(extraCasters > 0);
+}
+
+TEST_CASE(FrustumCullerReportsChangedSlots)
+{
+	TransformStore transforms;
+	AddRandomSpheres(transforms, 1001, 13);
+
+	JobSystem jobSystem(3);
+	FrustumCuller culler;
+	culler.SetMode(FrustumCuller::Mode::Camera);
+	culler.SetFrustum(MakeFrustum());
+	culler.Cull(transforms, jobSystem);
+	const std::vector<UINT> visibleBefore = culler.GetVisibleSlots();
+
+	// nothing moved, nothing flipped
+	culler.Cull(transforms, jobSystem);
+	CHECK(culler.GetChangedSlots().empty());
+
+	// turning culling off brings back exactly what was culled
+	culler.SetMode(FrustumCuller::Mode::Disabled);
+	culler.Cull(transforms, jobSystem);
+	CHECK(culler.GetVisibleSlots().size() == transforms.GetCount());
+	CHECK(culler.GetChangedSlots().size() == transforms.GetCount() - visibleBefore.size());
+}
+
+// the 4 wide plane test against one sphere at a time, there is no AVX path, XMVECTOR is 4 lanes on every target
+BENCHMARK_CASE(FrustumCullerBenchmark)
+{
+	const BoundingFrustum frustum = MakeFrustum();
+	TransformStore transforms;
+	AddRandomSpheres(transforms, 100000, 14);
+	const UINT count = transforms.GetCount();
+	std::vector<UINT8> visible(count);
+
+	const double intersects = CPyburnRTXEngineTests::MeasureMilliseconds(20, [&]()
+		{
+			for (UINT slot = 0; slot < count; slot++)
+			{
+				visible[slot] = frustum.Intersects(transforms.GetWorldBoundsBySlot(slot)) ? 1 : 0;
+			}
+		});
+	const double scalar = CPyburnRTXEngineTests::MeasureMilliseconds(20, [&]()
+		{
+			for (UINT slot = 0; slot < count; slot++)
+			{
+				visible[slot] = PlaneMargin(frustum, transforms.GetWorldBoundsBySlot(slot)) <= 0.0f ? 1 : 0;
+			}
+		});
+	printf("    %u spheres, 1 thread: BoundingFrustum::Intersects %.3f ms, scalar planes %.3f ms\n", count, intersects, scalar);
+
+	// Cull always goes through the job system, the smallest one is the caller and one worker
+	const UINT hardwareThreads = std::max(std::thread::hardware_concurrency(), 2u);
+	const UINT workerCounts[] = { 1, hardwareThreads - 1 };
+	for (const UINT& workers : workerCounts)
+	{
+		JobSystem jobSystem(workers);
+		FrustumCuller culler;
+		culler.SetMode(FrustumCuller::Mode::Camera);
+		culler.SetFrustum(frustum);
+		const double soa = CPyburnRTXEngineTests::MeasureMilliseconds(20, [&]() { culler.Cull(transforms, jobSystem); });
+		printf("    %u threads: 4 wide Cull %.3f ms\n", jobSystem.GetThreadCount(), soa);
+	}
+}
@@ -0,0 +1,127 @@
+#include "pch.h"
+
+#include <JobSystem.h>
+
+using namespace CPyburnRTXEngine;
+
+TEST_CASE(JobSystemParallelForCoversEveryIndexOnce)
+{
+	JobSystem jobSystem(3);
+	const UINT counts[] = { 1, 3, 4, 100, 1000, 4097 };
+	for (const UINT& count : counts)
+	{
+		std::vector<std::atomic<UINT>> hits(count);
+		for (std::atomic<UINT>& hit : hits)
+		{
+			hit.store(0);
+		}
+
+		std::atomic<bool> aligned = true;
+		jobSystem.ParallelFor(count, 4, [&hits, &aligned](UINT begin, UINT end)
+			{
+				if (begin % 4 != 0)
+				{
+					aligned = false; // range starts stay on multiples of minRangeSize
+				}
+				for (UINT i = begin; i < end; i++)
+				{
+					hits[i].fetch_add(1);
+				}
+			});
+		CHECK(aligned.load());
+
+		bool once = true;
+		for (const std::atomic<UINT>& hit : hits)
+		{
+			once = once && hit.load() == 1;
+		}
+		CHECK(once);
+	}
+}
+
+TEST_CASE(JobSystemNestedParallelFor)
+{
+	JobSystem jobSystem(3);
+	std::atomic<UINT> total = 0;
+	jobSystem.ParallelFor(16, 1, [&jobSystem, &total](UINT begin, UINT end)
+		{
+			for (UINT i = begin; i < end; i++)
+			{
+				jobSystem.ParallelFor(64, 1, [&total](UINT innerBegin, UINT innerEnd)
+					{
+						total.fetch_add(innerEnd - innerBegin);
+					});
+			}
+		});
+	CHECK(total.load() == 16 * 64);
+}
+
+TEST_CASE(JobSystemRethrowsFromRange)
+{
+	JobSystem jobSystem(3);
+	bool caught = false;
+	try
+	{
+		jobSystem.ParallelFor(1000, 1, [](UINT begin, UINT end)
+			{
+				if (begin <= 500 && 500 < end)
+				{
+					throw std::runtime_error("range 500");
+				}
+			});
+	}
+	catch (const std::runtime_error&)
+	{
+		caught = true;
+	}
+	CHECK(caught);
+
+	// still usable afterwards
+	std::atomic<UINT> total = 0;
+	jobSystem.ParallelFor(1000, 1, [&total](UINT begin, UINT end) { total.fetch_add(end - begin); });
+	CHECK(total.load() == 1000);
+}
+
+TEST_CASE(JobSystemManySmallCalls)
+{
+	// workers wake and pop while the caller is still pushing, thousands of short calls run that window over and over
+	JobSystem jobSystem(7);
+	std::atomic<UINT64> total = 0;
+	for (UINT call = 0; call < 20000; call++)
+	{
+		jobSystem.ParallelFor(64, 1, [&total](UINT begin, UINT end) { total.fetch_add(end - begin); });
+	}
+	CHECK(total.load() == 20000ull * 64);
+}
+
+// the same ParallelFor with 1 to N threads, 1 is the plain loop the job system falls back to
+BENCHMARK_CASE(JobSystemScalingBenchmark)
+{
+	const UINT count = 1 << 20;
+	std::vector<float> input(count);
+	std::vector<float> output(count);
+	for (UINT i = 0; i < count; i++)
+	{
+		input[i] = static_cast<float>(i % 1000) * 0.01f;
+	}
+
+	auto work = [&input, &output](UINT begin, UINT end)
+		{
+			for (UINT i = begin; i < end; i++)
+			{
+				float x = input[i];
+				output[i] = sqrtf(x * x + 1.0f) * sinf(x) + cosf(x * 0.5f);
+			}
+		};
+
+	const double single = CPyburnRTXEngineTests::MeasureMilliseconds(20, [&]() { work(0, count); });
+	printf("    %u elements, 1 thread: %.3f ms\n", count, single);
+
+	const UINT hardwareThreads = std::max(std::thread::hardware_concurrency(), 2u);
+	for (UINT workers = 1; workers < hardwareThreads; workers++)
+	{
+		JobSystem jobSystem(workers);
+		const double parallel = CPyburnRTXEngineTests::MeasureMilliseconds(20, [&]() { jobSystem.ParallelFor(count, 256, work); });
+		printf("    %u threads: %.3f ms, %.2fx\n", jobSystem.GetThreadCount(), parallel, single / parallel);
+	}
+}
@@ -0,0 +1,108 @@
+#include "pch.h"
+
+#include <KeyframeSampler.h>
+#include <Random.h>
+
+using namespace CPyburnRTXEngine;
+
+namespace
+{
+	// the linear scan FindKey replaced, the reference every lookup has to agree with
+	UINT ScanKey(const float& animationTime, const std::vector<float>& times)
+	{
+		for (UINT key = 0; key + 1 < times.size(); key++)
+		{
+			if (animationTime < times[key + 1])
+			{
+				return key;
+			}
+		}
+		return 0;
+	}
+
+	std::vector<float> RandomTimes(RandomNumberGenerator& random, const UINT& numKeys)
+	{
+		std::vector<float> times(numKeys);
+		float time = random.NextFloat(0.0f, 1.0f);
+		for (float& t : times)
+		{
+			t = time;
+			time += random.NextFloat(0.01f, 1.0f);
+		}
+		return times;
+	}
+}
+
+TEST_CASE(KeyframeSamplerEdges)
+{
+	const std::vector<float> times = { 0.0f, 1.0f, 2.0f, 3.0f };
+	UINT cursor = 0;
+	CHECK(KeyframeSampler::FindKey(-1.0f, times.data(), 4, cursor) == 0); // before the first key
+	CHECK(KeyframeSampler::FindKey(1.0f, times.data(), 4, cursor) == 1); // exactly on a key is that key
+	CHECK(KeyframeSampler::FindKey(2.999f, times.data(), 4, cursor) == 2);
+	CHECK(KeyframeSampler::FindKey(3.0f, times.data(), 4, cursor) == 0); // past the last key wraps like the scan did
+	CHECK(cursor == 2); // and leaves the cursor where it was
+
+	// a cursor from a longer track, it must not read past this one
+	cursor = 50;
+	CHECK(KeyframeSampler::FindKey(0.5f, times.data(), 4, cursor) == 0);
+}
+
+TEST_CASE(KeyframeSamplerMatchesLinearScan)
+{
+	RandomNumberGenerator random;
+	random.SetSeed(41);
+	UINT mismatched = 0;
+	for (UINT track = 0; track < 50; track++)
+	{
+		const std::vector<float> times = RandomTimes(random, random.NextInt(2, 200));
+		const UINT numKeys = static_cast<UINT>(times.size());
+		const float start = times.front() - 0.5f;
+		const float end = times.back() + 0.5f;
+
+		// forward playback, backward playback, then seeks, all through one cursor like a bone's channel
+		UINT cursor = 0;
+		for (float t = start; t < end; t += 0.05f)
+		{
+			mismatched += KeyframeSampler::FindKey(t, times.data(), numKeys, cursor) != ScanKey(t, times) ? 1 : 0;
+		}
+		for (float t = end; t > start; t -= 0.05f)
+		{
+			mismatched += KeyframeSampler::FindKey(t, times.data(), numKeys, cursor) != ScanKey(t, times) ? 1 : 0;
+		}
+		for (UINT seek = 0; seek < 200; seek++)
+		{
+			const float t = random.NextFloat(start, end);
+			mismatched += KeyframeSampler::FindKey(t, times.data(), numKeys, cursor) != ScanKey(t, times) ? 1 : 0;
+		}
+	}
+	CHECK(mismatched == 0);
+}
+
+// one long track sampled every frame, the cursor against the scan it replaced
+BENCHMARK_CASE(KeyframeSamplerBenchmark)
+{
+	RandomNumberGenerator random;
+	random.SetSeed(42);
+	const std::vector<float> times = RandomTimes(random, 2000);
+	const UINT numKeys = static_cast<UINT>(times.size());
+	const float step = (times.back() - times.front()) / 10000.0f;
+
+	UINT sink = 0; // printed so neither loop is optimised away
+	const double scan = CPyburnRTXEngineTests::MeasureMilliseconds(5, [&]()
+		{
+			for (float t = times.front(); t < times.back(); t += step)
+			{
+				sink += ScanKey(t, times);
+			}
+		});
+	const double cursor = CPyburnRTXEngineTests::MeasureMilliseconds(5, [&]()
+		{
+			UINT keyCursor = 0;
+			for (float t = times.front(); t < times.back(); t += step)
+			{
+				sink += KeyframeSampler::FindKey(t, times.data(), numKeys, keyCursor);
+			}
+		});
+	printf("    %u keys, 10000 samples: linear scan %.3f ms, cursor %.3f ms (%u)\n", numKeys, scan, cursor, sink & 1);
+}
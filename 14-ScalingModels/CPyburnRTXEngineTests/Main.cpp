@@ -0,0 +1,68 @@
+//
+// Main.cpp
+//
+
+#include "pch.h"
+
+#include <string>
+
+using namespace CPyburnRTXEngineTests;
+
+// CPyburnRTXEngineTests [--benchmark] [filter]
+// runs every test case whose name contains filter, --benchmark runs the benchmark cases as well
+// the exit code is the number of failed cases so a build step can run it
+int main(int argc, char* argv[])
+{
+	bool runBenchmarks = false;
+	std::string filter;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument == "--benchmark")
+		{
+			runBenchmarks = true;
+		}
+		else
+		{
+			filter = argument;
+		}
+	}
+
+	int failedCases = 0;
+	int ranCases = 0;
+	for (const TestCase& testCase : GetTestCases())
+	{
+		if (testCase.benchmark && !runBenchmarks)
+			continue;
+
+		if (!filter.empty() && std::string(testCase.name).find(filter) == std::string::npos)
+			continue;
+
+		printf("[ RUN  ] %s\n", testCase.name);
+		GetFailureCount() = 0;
+
+		try
+		{
+			testCase.function();
+		}
+		catch (const std::exception& e)
+		{
+			printf("    threw %s\n", e.what());
+			GetFailureCount()++;
+		}
+
+		if (GetFailureCount() > 0)
+		{
+			printf("[ FAIL ] %s\n", testCase.name);
+			failedCases++;
+		}
+		else
+		{
+			printf("[  OK  ] %s\n", testCase.name);
+		}
+		ranCases++;
+	}
+
+	printf("%d of %d cases passed\n", ranCases - failedCases, ranCases);
+	return failedCases;
+}
@@ -0,0 +1,29 @@
+#include "pch.h"
+
+#include <AssimpFactory.h>
+#include <ModelCache.h>
+
+#include "TestAssets.h"
+
+using namespace CPyburnRTXEngine;
+
+// what TestGame -bakemodels reports, the cold Assimp import against the cached load every launch after it does
+BENCHMARK_CASE(ModelCacheLoadBenchmark)
+{
+	AssimpFactory::Model model;
+	CPyburnRTXEngineTests::DescribeAnimatedModel(model);
+	const std::string modelPath = model.GetAssetPath(model.name);
+
+	// the cache is removed first every time, so each of these imports through Assimp and writes it again
+	const double imported = CPyburnRTXEngineTests::MeasureMilliseconds(3, [&]()
+		{
+			std::error_code error;
+			std::filesystem::remove(ModelCache::GetCachePath(modelPath), error);
+			AssimpFactory factory(&model, modelPath);
+		});
+	const double cached = CPyburnRTXEngineTests::MeasureMilliseconds(10, [&]()
+		{
+			AssimpFactory factory(&model, modelPath);
+		});
+	printf("    %s: assimp import and save %.2f ms, cached load %.2f ms\n", modelPath.c_str(), imported, cached);
+}
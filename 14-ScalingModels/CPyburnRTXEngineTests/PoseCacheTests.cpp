@@ -0,0 +1,119 @@
+#include "pch.h"
+
+#include <AssimpAnimations.h>
+#include <PoseCache.h>
+
+#include "TestAssets.h"
+
+using namespace CPyburnRTXEngine;
+
+namespace
+{
+	bool SamePalette(const std::vector<XMMATRIX>& a, const std::vector<XMMATRIX>& b)
+	{
+		return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(XMMATRIX)) == 0;
+	}
+
+	// a unit on the elf's run clip at time, posed through the cache
+	bool Pose(PoseCache& cache, AssimpAnimations& unit, const float& time, const UINT& minSampledHeight, std::vector<XMMATRIX>& bones)
+	{
+		AnimationPlayer::AnimationClip* clip = unit.GetAnimationPlayer()->GetCurrentClip();
+		clip->time = time;
+		bones.assign(unit.GetAssimpFactory()->GetNumBones(), XMMatrixIdentity());
+		return cache.Pose(&unit, *clip, minSampledHeight, bones.data());
+	}
+}
+
+TEST_CASE(PoseCacheSharesQuantizedKeys)
+{
+	AssimpFactory* factory = CPyburnRTXEngineTests::GetAnimatedModel();
+	AssimpAnimations first(factory);
+	AssimpAnimations second(factory);
+	AssimpAnimations third(factory);
+	AssimpAnimations culled(factory);
+	AssimpAnimations reference(factory);
+
+	PoseCache cache;
+	CHECK(cache.GetSamplesPerSecond() == 30.0f);
+
+	// a few samples into the run clip, quarter steps either side of the middle of one 1/30 s step
+	const Animation& run = *first.GetAnimationPlayer()->GetCurrentClip()->animation;
+	const float sample = floorf(run.startTime * cache.GetSamplesPerSecond()) + 3.0f;
+	const float step = 1.0f / cache.GetSamplesPerSecond();
+
+	cache.BeginFrame();
+	std::vector<XMMATRIX> firstBones;
+	std::vector<XMMATRIX> secondBones;
+	std::vector<XMMATRIX> thirdBones;
+	std::vector<XMMATRIX> culledBones;
+	CHECK(Pose(cache, first, (sample + 0.25f) * step, 0, firstBones));
+	CHECK(Pose(cache, second, (sample + 0.75f) * step, 0, secondBones));
+	CHECK(Pose(cache, third, (sample + 1.25f) * step, 0, thirdBones));
+	CHECK(Pose(cache, culled, (sample + 0.25f) * step, 2, culledBones));
+
+	// both units in the step get the pose at its start, whoever came first, evaluated at the time the cache works it out as
+	std::vector<XMMATRIX> expected(factory->GetNumBones());
+	std::vector<XMMATRIX> noGlobalBones(factory->GetNumBones());
+	std::vector<XMMATRIX> global(factory->GetNumBones());
+	reference.BoneTransform(sample / cache.GetSamplesPerSecond(), 0, expected.data(), noGlobalBones.data(), global.data());
+	CHECK(SamePalette(firstBones, expected));
+	CHECK(SamePalette(secondBones, expected));
+
+	// the next step and an LOD cut off are keys of their own
+	reference.BoneTransform((sample + 1.0f) / cache.GetSamplesPerSecond(), 0, expected.data(), noGlobalBones.data(), global.data());
+	CHECK(SamePalette(thirdBones, expected));
+	CHECK(!SamePalette(thirdBones, firstBones));
+	reference.BoneTransform(sample / cache.GetSamplesPerSecond(), 2, expected.data(), noGlobalBones.data(), global.data());
+	CHECK(SamePalette(culledBones, expected));
+
+	// a follower takes the node transforms too, so what hangs off its bones follows the shared pose
+	CHECK(second.GetPose().GetGlobalNodeTransforms().size() == first.GetPose().GetGlobalNodeTransforms().size());
+	CHECK(memcmp(second.GetPose().GetGlobalNodeTransforms().data(), first.GetPose().GetGlobalNodeTransforms().data(), first.GetPose().GetGlobalNodeTransforms().size() * sizeof(XMMATRIX)) == 0);
+
+	// a frame's counts show up once the next one begins
+	CHECK(cache.GetLastFrameStats().lookups == 0);
+	cache.BeginFrame();
+	CHECK(cache.GetLastFrameStats().lookups == 4);
+	CHECK(cache.GetLastFrameStats().hits == 1);
+	CHECK(cache.GetLastFrameStats().poses == 3);
+	CHECK_NEAR(cache.GetTotalHitRate(), 0.25f, 1e-6f);
+
+	// poses only live for their frame, the same key evaluates again
+	CHECK(Pose(cache, second, (sample + 0.75f) * step, 0, secondBones));
+	cache.BeginFrame();
+	CHECK(cache.GetLastFrameStats().lookups == 1);
+	CHECK(cache.GetLastFrameStats().hits == 0);
+	CHECK(cache.GetLastFrameStats().poses == 1);
+	CHECK_NEAR(cache.GetTotalHitRate(), 0.2f, 1e-6f);
+}
+
+TEST_CASE(PoseCacheBypass)
+{
+	AssimpFactory* factory = CPyburnRTXEngineTests::GetAnimatedModel();
+	AssimpAnimations unit(factory);
+	const float time = unit.GetAnimationPlayer()->GetCurrentClip()->animation->startTime + 0.1f;
+	const std::vector<XMMATRIX> untouched(factory->GetNumBones(), XMMatrixIdentity());
+	std::vector<XMMATRIX> bones;
+
+	// 0 samples per second turns sharing off, the caller evaluates and nothing is counted
+	PoseCache cache;
+	cache.SetSamplesPerSecond(0.0f);
+	cache.BeginFrame();
+	CHECK(!Pose(cache, unit, time, 0, bones));
+	CHECK(SamePalette(bones, untouched));
+
+	// and so does turning the cache off
+	cache.SetSamplesPerSecond(30.0f);
+	cache.SetEnabled(false);
+	CHECK(!Pose(cache, unit, time, 0, bones));
+	CHECK(SamePalette(bones, untouched));
+
+	cache.BeginFrame();
+	CHECK(cache.GetLastFrameStats().lookups == 0);
+	CHECK(cache.GetTotalHitRate() == 0.0f);
+
+	// back on, it answers again
+	cache.SetEnabled(true);
+	CHECK(Pose(cache, unit, time, 0, bones));
+	CHECK(!SamePalette(bones, untouched));
+}
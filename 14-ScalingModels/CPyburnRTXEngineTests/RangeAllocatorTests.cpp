@@ -0,0 +1,103 @@
+#include "pch.h"
+
+#include <RangeAllocator.h>
+#include <Random.h>
+
+using namespace CPyburnRTXEngine;
+
+TEST_CASE(RangeAllocatorAlignsAndMerges)
+{
+	RangeAllocator allocator(4096);
+	UINT64 a = allocator.Allocate(100, 256);
+	UINT64 b = allocator.Allocate(300, 256);
+	UINT64 c = allocator.Allocate(256, 256);
+	CHECK(a == 0);
+	CHECK(b == 256);
+	CHECK(c == 768);
+	CHECK(allocator.GetUsedBytes() == 656);
+
+	// out of order so the merge has to happen on both sides
+	CHECK(allocator.Free(b, 300));
+	CHECK(allocator.Free(a, 100));
+	CHECK(allocator.Free(c, 256));
+	CHECK(allocator.GetFreeRangeCount() == 1);
+	CHECK(allocator.GetLargestFreeRange() == 4096);
+	CHECK(allocator.GetUsedBytes() == 0);
+}
+
+TEST_CASE(RangeAllocatorFull)
+{
+	RangeAllocator allocator(64);
+	CHECK(allocator.Allocate(64) == 0);
+	CHECK(allocator.Allocate(1) == RangeAllocator::c_invalidOffset);
+	CHECK(allocator.Allocate(0) == RangeAllocator::c_invalidOffset);
+}
+
+TEST_CASE(RangeAllocatorRejectsDoubleFree)
+{
+	RangeAllocator allocator(1024);
+	UINT64 a = allocator.Allocate(128);
+	UINT64 b = allocator.Allocate(128);
+	UINT64 c = allocator.Allocate(128);
+	CHECK(allocator.Free(b, 128));
+
+	const UINT ranges = allocator.GetFreeRangeCount();
+	const UINT64 used = allocator.GetUsedBytes();
+
+	CHECK(!allocator.Free(b, 128)); // the same range again
+	CHECK(!allocator.Free(b + 64, 16)); // inside it
+	CHECK(!allocator.Free(a + 64, 128)); // reaching into it from the one before
+	CHECK(!allocator.Free(b + 64, 128)); // reaching out of it into the one after
+	CHECK(!allocator.Free(384, 128)); // the tail that was never handed out
+	CHECK(!allocator.Free(1000, 100)); // past the capacity
+	CHECK(!allocator.Free(RangeAllocator::c_invalidOffset, 1));
+
+	// none of those touched anything
+	CHECK(allocator.GetFreeRangeCount() == ranges);
+	CHECK(allocator.GetUsedBytes() == used);
+	CHECK(allocator.IsAllocated(a, 128));
+	CHECK(!allocator.IsAllocated(b, 1));
+	CHECK(allocator.IsAllocated(c, 128));
+
+	CHECK(allocator.Free(a, 128));
+	CHECK(allocator.Free(c, 128));
+	CHECK(allocator.GetFreeRangeCount() == 1);
+	CHECK(allocator.GetUsedBytes() == 0);
+}
+
+TEST_CASE(RangeAllocatorRandomChurn)
+{
+	RandomNumberGenerator random;
+	random.SetSeed(1);
+	RangeAllocator allocator(4096);
+	std::vector<std::pair<UINT64, UINT64>> live;
+	bool freed = true;
+	for (UINT i = 0; i < 100000; i++)
+	{
+		if (live.empty() || random.NextInt(1) == 0)
+		{
+			UINT64 size = random.NextInt(1, 300);
+			UINT64 offset = allocator.Allocate(size, 1ull << random.NextInt(4));
+			if (offset != RangeAllocator::c_invalidOffset)
+			{
+				live.push_back({ offset, size });
+			}
+		}
+		else
+		{
+			size_t k = random.NextInt(static_cast<int32_t>(live.size()) - 1);
+			freed = freed && allocator.Free(live[k].first, live[k].second);
+			live.erase(live.begin() + k);
+		}
+	}
+
+	for (const std::pair<UINT64, UINT64>& allocation : live)
+	{
+		freed = freed && allocator.Free(allocation.first, allocation.second);
+	}
+
+	CHECK(freed);
+	CHECK(allocator.GetFreeRangeCount() == 1);
+	CHECK(allocator.GetLargestFreeRange() == 4096);
+	CHECK(allocator.GetUsedBytes() == 0);
+}
@@ -0,0 +1,229 @@
+#include "pch.h"
+
+#include <BakedAnimation.h>
+#include <SkeletonPose.h>
+
+#include "TestAnimation.h"
+
+using namespace CPyburnRTXEngine;
+
+namespace
+{
+	struct Palette
+	{
+		std::vector<XMMATRIX> bones;
+		std::vector<XMMATRIX> noGlobalBones;
+		std::vector<XMMATRIX> global;
+		std::vector<XMMATRIX> globalNodeTransforms;
+
+		Palette(const UINT& boneCount, const UINT& nodeCount) : bones(boneCount, XMMatrixIdentity()), noGlobalBones(boneCount, XMMatrixIdentity()), global(boneCount, XMMatrixIdentity()), globalNodeTransforms(nodeCount, XMMatrixIdentity()) {}
+	};
+
+	// the pose pass as it was before the skeleton was flattened, a walk down the node tree carrying the parent's global transform
+	class RecursivePose
+	{
+	private:
+		const Skeleton& m_skeleton;
+		const std::vector<XMMATRIX>& m_boneInfo;
+		const BakedAnimation& m_animation;
+		std::vector<std::vector<UINT>> m_children;
+		std::vector<UINT> m_heights;
+
+		UINT MeasureHeight(const UINT& node)
+		{
+			UINT height = 0;
+			for (const UINT& child : m_children[node])
+			{
+				height = std::max(height, MeasureHeight(child) + 1);
+			}
+			m_heights[node] = height;
+			return height;
+		}
+
+		XMMATRIX Sample(const UINT& track, const float& time) const
+		{
+			KeyframeCursor cursor;
+			return XMMatrixScalingFromVector(m_animation.SampleScaling(time, track, cursor.scaling))
+				* XMMatrixRotationQuaternion(m_animation.SampleRotation(time, track, cursor.rotation))
+				* XMMatrixTranslationFromVector(m_animation.SamplePosition(time, track, cursor.position));
+		}
+
+		XMMATRIX SampleBlended(const UINT& track, const float& blendFactor, const float& timeCurrent, const float& timeTarget) const
+		{
+			KeyframeCursor current;
+			KeyframeCursor target;
+			const XMVECTOR scaling = XMVectorLerp(m_animation.SampleScaling(timeCurrent, track, current.scaling), m_animation.SampleScaling(timeTarget, track, target.scaling), blendFactor);
+			const XMVECTOR rotationQ = XMQuaternionSlerp(m_animation.SampleRotation(timeCurrent, track, current.rotation), m_animation.SampleRotation(timeTarget, track, target.rotation), blendFactor);
+			const XMVECTOR translation = XMVectorLerp(m_animation.SamplePosition(timeCurrent, track, current.position), m_animation.SamplePosition(timeTarget, track, target.position), blendFactor);
+			return XMMatrixScalingFromVector(scaling) * XMMatrixRotationQuaternion(rotationQ) * XMMatrixTranslationFromVector(translation);
+		}
+
+		template<typename SampleNode>
+		void Read(const UINT& node, const XMMATRIX& parent, const UINT& minSampledHeight, const SampleNode& sampleNode, Palette& palette) const
+		{
+			XMMATRIX nodeTransformation = m_skeleton.GetBindTransform(node);
+			const UINT& track = m_skeleton.GetAnimationTrack(node);
+			if (track != MAXUINT && m_heights[node] >= minSampledHeight)
+			{
+				nodeTransformation = sampleNode(track);
+			}
+
+			const XMMATRIX transposedNodeTransformation = XMMatrixTranspose(nodeTransformation);
+			const XMMATRIX globalTransformation = parent * transposedNodeTransformation;
+
+			const UINT& bone = m_skeleton.GetBoneIndex(node);
+			if (bone != MAXUINT)
+			{
+				palette.noGlobalBones[bone] = transposedNodeTransformation * m_boneInfo[bone];
+				palette.global[bone] = parent;
+				palette.bones[bone] = XMMatrixTranspose(parent * palette.noGlobalBones[bone]);
+				palette.globalNodeTransforms[node] = XMMatrixTranspose(globalTransformation);
+			}
+			else if (track != MAXUINT)
+			{
+				palette.globalNodeTransforms[node] = XMMatrixTranspose(globalTransformation);
+			}
+
+			for (const UINT& child : m_children[node])
+			{
+				Read(child, globalTransformation, minSampledHeight, sampleNode, palette);
+			}
+		}
+
+	public:
+		RecursivePose(const Skeleton& skeleton, const std::vector<XMMATRIX>& boneInfo, const BakedAnimation& animation) : m_skeleton(skeleton), m_boneInfo(boneInfo), m_animation(animation)
+		{
+			m_children.resize(skeleton.GetNodeCount());
+			m_heights.resize(skeleton.GetNodeCount());
+			for (UINT node = 1; node < skeleton.GetNodeCount(); node++)
+			{
+				m_children[skeleton.GetParent(node)].push_back(node);
+			}
+			MeasureHeight(0);
+		}
+
+		void Read(const float& time, const UINT& minSampledHeight, Palette& palette) const
+		{
+			Read(0, XMMatrixIdentity(), minSampledHeight, [&](const UINT& track) { return Sample(track, time); }, palette);
+		}
+
+		void ReadBlended(const float& blendFactor, const float& timeCurrent, const float& timeTarget, const UINT& minSampledHeight, Palette& palette) const
+		{
+			Read(0, XMMatrixIdentity(), minSampledHeight, [&](const UINT& track) { return SampleBlended(track, blendFactor, timeCurrent, timeTarget); }, palette);
+		}
+	};
+
+	// the synthetic skeleton with a node that isn't a bone and a bone that isn't animated, the two cases the flags split on
+	Skeleton WithGaps(const Skeleton& source, const UINT& unboundNode, const UINT& unanimatedNode)
+	{
+		Skeleton skeleton;
+		for (UINT node = 0; node < source.GetNodeCount(); node++)
+		{
+			XMFLOAT4X4 bindTransform;
+			XMStoreFloat4x4(&bindTransform, source.GetBindTransform(node));
+			skeleton.AddNode(source.GetParent(node), bindTransform, node == unboundNode ? MAXUINT : source.GetBoneIndex(node), node == unanimatedNode ? MAXUINT : source.GetAnimationTrack(node));
+		}
+		return skeleton;
+	}
+
+	float MaxDifference(const std::vector<XMMATRIX>& a, const std::vector<XMMATRIX>& b)
+	{
+		float difference = 0.0f;
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			XMFLOAT4X4 left;
+			XMFLOAT4X4 right;
+			XMStoreFloat4x4(&left, a[i]);
+			XMStoreFloat4x4(&right, b[i]);
+			for (UINT row = 0; row < 4; row++)
+			{
+				for (UINT column = 0; column < 4; column++)
+				{
+					difference = std::max(difference, fabsf(left.m[row][column] - right.m[row][column]));
+				}
+			}
+		}
+		return difference;
+	}
+
+	void CheckSame(const Palette& flat, const Palette& reference)
+	{
+		CHECK(MaxDifference(flat.bones, reference.bones) < 1e-5f);
+		CHECK(MaxDifference(flat.noGlobalBones, reference.noGlobalBones) < 1e-5f);
+		CHECK(MaxDifference(flat.global, reference.global) < 1e-5f);
+		CHECK(MaxDifference(flat.globalNodeTransforms, reference.globalNodeTransforms) < 1e-5f);
+	}
+}
+
+TEST_CASE(SkeletonPoseMatchesRecursiveWalk)
+{
+	const CPyburnRTXEngineTests::SyntheticAnimation synthetic = CPyburnRTXEngineTests::MakeSyntheticAnimation(15, 41, 91);
+	BakedAnimation baked;
+	baked.Bake(synthetic.animation.get());
+
+	const Skeleton skeletons[] = { WithGaps(synthetic.skeleton, MAXUINT, MAXUINT), WithGaps(synthetic.skeleton, 3, 5) };
+	for (const Skeleton& skeleton : skeletons)
+	{
+		const UINT boneCount = static_cast<UINT>(synthetic.boneInfo.size());
+		const RecursivePose reference(skeleton, synthetic.boneInfo, baked);
+		SkeletonPose pose;
+		pose.Reset(skeleton);
+
+		// forward, a jump back and past the last key, so the cursors walk, search and wrap; 2 leaves the leaves and their parents at bind
+		const float times[] = { 0.0f, 0.5f, 1.25f, 7.0f, 3.5f, 39.9f, 40.0f, 12.75f };
+		const UINT minSampledHeights[] = { 0, 2 };
+		for (const UINT& minSampledHeight : minSampledHeights)
+		{
+			for (const float& time : times)
+			{
+				Palette flat(boneCount, skeleton.GetNodeCount());
+				pose.Read(skeleton, synthetic.boneInfo, baked, time, minSampledHeight, flat.bones.data(), flat.noGlobalBones.data(), flat.global.data());
+				flat.globalNodeTransforms = pose.GetGlobalNodeTransforms();
+
+				Palette expected(boneCount, skeleton.GetNodeCount());
+				reference.Read(time, minSampledHeight, expected);
+				CheckSame(flat, expected);
+
+				Palette flatBlended(boneCount, skeleton.GetNodeCount());
+				pose.ReadBlended(skeleton, synthetic.boneInfo, baked, 0.3f, time, 40.0f - time, minSampledHeight, flatBlended.bones.data(), flatBlended.noGlobalBones.data(), flatBlended.global.data());
+				flatBlended.globalNodeTransforms = pose.GetGlobalNodeTransforms();
+
+				Palette expectedBlended(boneCount, skeleton.GetNodeCount());
+				reference.ReadBlended(0.3f, time, 40.0f - time, minSampledHeight, expectedBlended);
+				CheckSame(flatBlended, expectedBlended);
+			}
+		}
+	}
+}
+
+// one pose of a skeleton the size of a character's, a finger rig and a dense rig, the flat pass against the walk it replaced
+BENCHMARK_CASE(SkeletonPoseBenchmark)
+{
+	const UINT nodeCounts[] = { 31, 63, 255 };
+	for (const UINT& nodeCount : nodeCounts)
+	{
+		const CPyburnRTXEngineTests::SyntheticAnimation synthetic = CPyburnRTXEngineTests::MakeSyntheticAnimation(nodeCount, 121, 93);
+		BakedAnimation baked;
+		baked.Bake(synthetic.animation.get());
+
+		const RecursivePose reference(synthetic.skeleton, synthetic.boneInfo, baked);
+		SkeletonPose pose;
+		pose.Reset(synthetic.skeleton);
+		Palette palette(nodeCount, nodeCount);
+
+		// a 60 fps step in 30 tick per second keys, so the cursors move the way they do in play
+		const UINT poses = 1000;
+		float time = 0.0f;
+		const double flatMs = CPyburnRTXEngineTests::MeasureMilliseconds(poses, [&]()
+			{
+				time = fmodf(time + 0.5f, baked.GetDuration());
+				pose.Read(synthetic.skeleton, synthetic.boneInfo, baked, time, 0, palette.bones.data(), palette.noGlobalBones.data(), palette.global.data());
+			});
+		const double recursiveMs = CPyburnRTXEngineTests::MeasureMilliseconds(poses, [&]()
+			{
+				time = fmodf(time + 0.5f, baked.GetDuration());
+				reference.Read(time, 0, palette);
+			});
+		printf("    %u nodes: %.2f us per pose flat, %.2f us recursive\n", nodeCount, flatMs * 1000.0, recursiveMs * 1000.0);
+	}
+}
@@ -0,0 +1,117 @@
+#include "pch.h"
+
+#include <SkinningBatch.h>
+#include <Random.h>
+
+using namespace CPyburnRTXEngine;
+
+namespace
+{
+	// what Add does for each entity, without the animation it reads the vertex count from
+	std::vector<SkinningBatch::Entry> PlaceEntries(const std::vector<UINT>& vertexCounts, UINT& groupCount)
+	{
+		std::vector<SkinningBatch::Entry> entries(vertexCounts.size());
+		groupCount = 0;
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			entries[i].vertexCount = vertexCounts[i];
+			SkinningBatch::PlaceEntry(entries[i], groupCount);
+		}
+		return entries;
+	}
+
+	// runs every thread of every dispatch the way skinnedComputeBatched.hlsl does and counts the vertices each entry got
+	bool EveryVertexOnce(const std::vector<SkinningBatch::Entry>& entries, const UINT& groupCount, const UINT& maxGroupsPerDispatch)
+	{
+		std::vector<std::vector<UINT>> hits(entries.size());
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			hits[i].assign(entries[i].vertexCount, 0);
+		}
+
+		UINT groupsDispatched = 0;
+		const UINT dispatchCount = SkinningBatch::GetDispatchCount(groupCount, maxGroupsPerDispatch);
+		for (UINT dispatch = 0; dispatch < dispatchCount; dispatch++)
+		{
+			const SkinningBatch::DispatchRange range = SkinningBatch::GetDispatchRange(groupCount, dispatch, maxGroupsPerDispatch);
+			if (range.groupCount == 0 || range.groupCount > maxGroupsPerDispatch)
+				return false;
+			groupsDispatched += range.groupCount;
+
+			for (UINT groupId = 0; groupId < range.groupCount; groupId++)
+			{
+				const UINT group = groupId + range.groupOffset;
+				const UINT e = SkinningBatch::FindEntry(entries.data(), static_cast<UINT>(entries.size()), group);
+				for (UINT thread = 0; thread < SkinningBatch::c_groupSize; thread++)
+				{
+					const UINT v = (group - entries[e].firstGroup) * SkinningBatch::c_groupSize + thread;
+					if (v < entries[e].vertexCount)
+					{
+						hits[e][v]++;
+					}
+				}
+			}
+		}
+
+		bool once = groupsDispatched == groupCount;
+		for (const std::vector<UINT>& entryHits : hits)
+		{
+			for (const UINT& hit : entryHits)
+			{
+				once = once && hit == 1;
+			}
+		}
+		return once;
+	}
+}
+
+TEST_CASE(SkinningBatchPlacesEntriesByGroup)
+{
+	UINT groupCount = 0;
+	std::vector<SkinningBatch::Entry> entries = PlaceEntries({ 1, 256, 257, 0, 1000 }, groupCount);
+	CHECK(entries[0].firstGroup == 0);
+	CHECK(entries[1].firstGroup == 1);
+	CHECK(entries[2].firstGroup == 2);
+	CHECK(entries[3].firstGroup == 4);
+	CHECK(entries[4].firstGroup == 4); // the empty entry takes no groups, its neighbour starts where it does
+	CHECK(groupCount == 8);
+
+	// a group belongs to the last entry starting at or before it, never to the empty one
+	CHECK(SkinningBatch::FindEntry(entries.data(), 5, 0) == 0);
+	CHECK(SkinningBatch::FindEntry(entries.data(), 5, 3) == 2);
+	CHECK(SkinningBatch::FindEntry(entries.data(), 5, 4) == 4);
+	CHECK(SkinningBatch::FindEntry(entries.data(), 5, 7) == 4);
+	CHECK(EveryVertexOnce(entries, groupCount, SkinningBatch::c_maxGroupsPerDispatch));
+}
+
+TEST_CASE(SkinningBatchSplitsDispatches)
+{
+	const UINT max = SkinningBatch::c_maxGroupsPerDispatch;
+	CHECK(SkinningBatch::GetDispatchCount(0) == 0); // Record returns before this, but nothing would be dispatched anyway
+	CHECK(SkinningBatch::GetDispatchCount(1) == 1);
+	CHECK(SkinningBatch::GetDispatchCount(max) == 1);
+	CHECK(SkinningBatch::GetDispatchCount(max + 1) == 2);
+
+	SkinningBatch::DispatchRange last = SkinningBatch::GetDispatchRange(2 * max + 5, 2);
+	CHECK(last.groupOffset == 2 * max);
+	CHECK(last.groupCount == 5);
+}
+
+TEST_CASE(SkinningBatchRandomBatchesCoverEveryVertex)
+{
+	RandomNumberGenerator random;
+	random.SetSeed(7);
+	for (UINT batch = 0; batch < 50; batch++)
+	{
+		std::vector<UINT> vertexCounts(random.NextInt(1, 40));
+		for (UINT& vertexCount : vertexCounts)
+		{
+			vertexCount = random.NextInt(0, 3000);
+		}
+
+		// a small dispatch limit so entries straddle dispatches the way the largest crowds do with the real one
+		UINT groupCount = 0;
+		std::vector<SkinningBatch::Entry> entries = PlaceEntries(vertexCounts, groupCount);
+		CHECK(EveryVertexOnce(entries, groupCount, random.NextInt(1, 9)));
+	}
+}
@@ -0,0 +1,120 @@
+#include "pch.h"
+
+#include <StagingArena.h>
+
+using namespace CPyburnRTXEngine;
+
+// without CreateDeviceDependentResources the arena packs and builds barriers without making any resources, the resources below are only compared by address
+namespace
+{
+	ID3D12Resource* FakeResource(const UINT& i)
+	{
+		return reinterpret_cast<ID3D12Resource*>(static_cast<uintptr_t>(0x1000 * (i + 1)));
+	}
+}
+
+TEST_CASE(StagingArenaClosedRefusesUploads)
+{
+	StagingArena arena;
+	arena.SetChunkSize(1024);
+	CHECK(!arena.Stage(FakeResource(0), 0, nullptr, 10));
+	CHECK(!arena.Allocate(10).IsValid());
+
+	arena.Begin();
+	CHECK(arena.IsOpen());
+	CHECK(!arena.Allocate(0).IsValid());
+	arena.End(1);
+	CHECK(!arena.IsOpen());
+}
+
+TEST_CASE(StagingArenaChunkRollover)
+{
+	StagingArena arena;
+	arena.SetChunkSize(1024);
+	arena.Begin();
+
+	StagingArena::Region first = arena.Allocate(10);
+	StagingArena::Region second = arena.Allocate(10);
+	CHECK(first.chunk == 0 && first.offset == 0);
+	CHECK(second.chunk == 0 && second.offset == StagingArena::c_copyAlignment); // packed at the copy alignment
+
+	StagingArena::Region fill = arena.Allocate(1024 - 2 * StagingArena::c_copyAlignment);
+	CHECK(fill.chunk == 0);
+
+	// nothing left in chunk 0, the next upload opens chunk 1
+	StagingArena::Region next = arena.Allocate(1);
+	CHECK(next.chunk == 1 && next.offset == 0);
+	CHECK(arena.GetChunkCount() == 2);
+	arena.End(1);
+}
+
+TEST_CASE(StagingArenaOversizeChunk)
+{
+	StagingArena arena;
+	arena.SetChunkSize(1024);
+	arena.Begin();
+
+	CHECK(arena.Allocate(100).chunk == 0);
+
+	// larger than a chunk, it gets a chunk of its own size
+	StagingArena::Region big = arena.Allocate(5000);
+	CHECK(big.chunk == 1 && big.offset == 0 && big.size == 5000);
+
+	// that chunk is full, so the one after it starts another default sized chunk
+	StagingArena::Region after = arena.Allocate(100);
+	CHECK(after.chunk == 2 && after.offset == 0);
+	CHECK(arena.GetChunkCount() == 3);
+	arena.End(1);
+}
+
+TEST_CASE(StagingArenaOneBarrierPerDestination)
+{
+	StagingArena arena;
+	arena.SetChunkSize(1024);
+	arena.Begin();
+
+	ID3D12Resource* vertices = FakeResource(0);
+	ID3D12Resource* indices = FakeResource(1);
+	ID3D12Resource* stays = FakeResource(2);
+	CHECK(arena.Stage(vertices, 0, nullptr, 100));
+	CHECK(arena.Stage(indices, 0, nullptr, 100, D3D12_RESOURCE_STATE_INDEX_BUFFER));
+	CHECK(arena.Stage(vertices, 100, nullptr, 50));
+	CHECK(arena.Stage(vertices, 150, nullptr, 50));
+	CHECK(arena.Stage(stays, 0, nullptr, 10, D3D12_RESOURCE_STATE_COPY_DEST)); // staying in COPY_DEST needs no transition
+	CHECK(arena.GetPendingCopyCount() == 5);
+
+	// three copies into vertices still make one transition, in the order the destinations were first staged
+	std::vector<D3D12_RESOURCE_BARRIER> barriers = arena.BuildBarriers();
+	CHECK(barriers.size() == 2);
+	CHECK(barriers[0].Transition.pResource == vertices);
+	CHECK(barriers[0].Transition.StateBefore == D3D12_RESOURCE_STATE_COPY_DEST);
+	CHECK(barriers[0].Transition.StateAfter == D3D12_RESOURCE_STATE_GENERIC_READ);
+	CHECK(barriers[1].Transition.pResource == indices);
+	CHECK(barriers[1].Transition.StateAfter == D3D12_RESOURCE_STATE_INDEX_BUFFER);
+
+	CHECK(arena.GetStagedCount() == 5);
+	CHECK(arena.GetStagedBytes() == 310);
+	arena.End(1);
+}
+
+TEST_CASE(StagingArenaReclaimWaitsForFence)
+{
+	StagingArena arena;
+	arena.SetChunkSize(1024);
+
+	arena.Begin();
+	arena.Allocate(2000);
+	arena.Allocate(10);
+	arena.End(5);
+
+	arena.Begin();
+	arena.Allocate(10);
+	arena.End(6);
+
+	CHECK(arena.GetChunkCount() == 3);
+	CHECK(arena.Reclaim(4) == 0);
+	CHECK(arena.Reclaim(5) == 2);
+	CHECK(arena.GetChunkCount() == 1);
+	CHECK(arena.Reclaim(6) == 1);
+	CHECK(arena.GetChunkCount() == 0);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <assimp/scene.h>
+#include <Random.h>
+#include <Skeleton.h>
+
+// a made up clip on a made up skeleton for the animation tests, no model file needed
+namespace CPyburnRTXEngineTests
+{
+	struct SyntheticAnimation
+	{
+		std::unique_ptr<aiAnimation> animation; // owns its channels and keys the way an aiScene does
+		CPyburnRTXEngine::Skeleton skeleton; // node i is bone i and plays track i
+		std::vector<XMMATRIX> boneInfo; // inverse bind pose per bone in assimp's layout, what AssimpFactory::GetBoneInfo holds, the bind pose skins to identity
+	};
+
+	// node i hangs off node (i - 1) / 2, so there is depth and branching
+	// smooth curves plus a little noise so key reduction has keys to drop and keys it has to keep
+	// keys land on whole ticks and every channel gets its own count, so the three key tracks of a node don't line up
+	inline SyntheticAnimation MakeSyntheticAnimation(const UINT& nodeCount, const UINT& keyCount, const UINT& seed)
+	{
+		CPyburnRTXEngine::RandomNumberGenerator random;
+		random.SetSeed(seed);
+
+		SyntheticAnimation synthetic;
+		synthetic.animation = std::make_unique<aiAnimation>();
+		aiAnimation& animation = *synthetic.animation;
+		animation.mName = aiString("synthetic");
+		animation.mTicksPerSecond = 30.0;
+		animation.mDuration = keyCount - 1;
+		animation.mNumChannels = nodeCount;
+		animation.mChannels = new aiNodeAnim*[nodeCount];
+
+		std::vector<XMMATRIX> bindGlobals(nodeCount);
+		for (UINT node = 0; node < nodeCount; node++)
+		{
+			const UINT parent = node > 0 ? (node - 1) / 2 : MAXUINT;
+			const XMFLOAT3 offset(random.NextFloat(-0.2f, 0.2f), node > 0 ? random.NextFloat(0.2f, 0.5f) : 0.0f, random.NextFloat(-0.2f, 0.2f));
+
+			// assimp's column vector layout, the translation is the last column
+			XMFLOAT4X4 bindTransform;
+			XMStoreFloat4x4(&bindTransform, XMMatrixTranspose(XMMatrixTranslation(offset.x, offset.y, offset.z)));
+			synthetic.skeleton.AddNode(parent, bindTransform, node, node);
+			bindGlobals[node] = parent != MAXUINT ? XMMatrixTranslation(offset.x, offset.y, offset.z) * bindGlobals[parent] : XMMatrixTranslation(offset.x, offset.y, offset.z);
+			synthetic.boneInfo.push_back(XMMatrixTranspose(XMMatrixInverse(nullptr, bindGlobals[node])));
+
+			aiNodeAnim* channel = new aiNodeAnim();
+			animation.mChannels[node] = channel;
+			channel->mNodeName = aiString("node" + std::to_string(node));
+
+			const float phase = random.NextFloat(0.0f, XM_2PI);
+			const float swing = random.NextFloat(0.1f, 1.0f);
+			const XMVECTOR axis = XMVector3Normalize(XMVectorSet(random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f), 0.0f) + XMVectorSet(0.0f, 0.0f, 0.01f, 0.0f));
+			auto curve = [keyCount, phase](const UINT& key) { return sinf(XM_2PI * key / std::max(keyCount - 1, 1u) + phase); };
+
+			channel->mNumScalingKeys = std::max(keyCount / 4, 1u);
+			channel->mScalingKeys = new aiVectorKey[channel->mNumScalingKeys];
+			for (UINT key = 0; key < channel->mNumScalingKeys; key++)
+			{
+				const float scale = 1.0f + 0.02f * curve(key * 4);
+				channel->mScalingKeys[key] = aiVectorKey(key * 4.0, aiVector3D(scale, scale, scale));
+			}
+
+			channel->mNumRotationKeys = keyCount;
+			channel->mRotationKeys = new aiQuatKey[keyCount];
+			for (UINT key = 0; key < keyCount; key++)
+			{
+				XMFLOAT4 q;
+				XMStoreFloat4(&q, XMQuaternionRotationAxis(axis, swing * curve(key) + random.NextFloat(-0.002f, 0.002f)));
+				channel->mRotationKeys[key] = aiQuatKey(key, aiQuaternion(q.w, q.x, q.y, q.z));
+			}
+
+			channel->mNumPositionKeys = std::max(keyCount / 2, 1u);
+			channel->mPositionKeys = new aiVectorKey[channel->mNumPositionKeys];
+			for (UINT key = 0; key < channel->mNumPositionKeys; key++)
+			{
+				const float bob = 0.05f * curve(key * 2) + random.NextFloat(-0.001f, 0.001f);
+				channel->mPositionKeys[key] = aiVectorKey(key * 2.0, aiVector3D(offset.x, offset.y + bob, offset.z));
+			}
+		}
+
+		return synthetic;
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <AssimpFactory.h>
+
+// what the tests on real assets share, they run from the project directory like the game so ../../Assets is the repo's
+namespace CPyburnRTXEngineTests
+{
+	// Assets/Models/Elf, the animated model Animations.json's clips are written for
+	inline void DescribeAnimatedModel(CPyburnRTXEngine::AssimpFactory::Model& model)
+	{
+		model.modelId = 1;
+		model.name = "Elf-ranger.X";
+		model.contentLocation = "Elf\\";
+	}
+
+	// the animated model imported once through the model cache and shared by every test after
+	inline CPyburnRTXEngine::AssimpFactory* GetAnimatedModel()
+	{
+		static CPyburnRTXEngine::AssimpFactory::Model model;
+		static std::once_flag loaded;
+		std::call_once(loaded, []()
+			{
+				DescribeAnimatedModel(model);
+				model.CreateAssimpFactory(model.GetAssetPath(model.name));
+			});
+		return model.GetAssimpFactoryPtr();
+	}
+
+	// the software adapter, enough to create resources and map upload heaps on a machine without a gpu
+	inline Microsoft::WRL::ComPtr<ID3D12Device5> CreateWarpDevice()
+	{
+		Microsoft::WRL::ComPtr<IDXGIFactory4> dxgiFactory;
+		DX::ThrowIfFailed(CreateDXGIFactory2(0, IID_PPV_ARGS(&dxgiFactory)));
+		Microsoft::WRL::ComPtr<IDXGIAdapter1> adapter;
+		DX::ThrowIfFailed(dxgiFactory->EnumWarpAdapter(IID_PPV_ARGS(&adapter)));
+		Microsoft::WRL::ComPtr<ID3D12Device5> device;
+		DX::ThrowIfFailed(D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device)));
+		return device;
+	}
+}
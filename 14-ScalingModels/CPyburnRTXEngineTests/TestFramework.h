@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// just enough of a test runner for the engine without a window, the few cases that need a device make a warp one
+// TEST_CASE always runs, BENCHMARK_CASE only with --benchmark, both register themselves at static init
+namespace CPyburnRTXEngineTests
+{
+	struct TestCase
+	{
+		const char* name;
+		void (*function)();
+		bool benchmark;
+	};
+
+	inline std::vector<TestCase>& GetTestCases()
+	{
+		static std::vector<TestCase> testCases;
+		return testCases;
+	}
+
+	struct TestRegistrar
+	{
+		TestRegistrar(const char* name, void (*function)(), const bool& benchmark)
+		{
+			GetTestCases().push_back(TestCase{ name, function, benchmark });
+		}
+	};
+
+	// failed checks of the running case, Main resets it before every case
+	inline int& GetFailureCount()
+	{
+		static int failureCount = 0;
+		return failureCount;
+	}
+
+	inline void ReportFailure(const char* file, const int& line, const char* expression)
+	{
+		printf("    %s(%d): CHECK(%s) failed\n", file, line, expression);
+		GetFailureCount()++;
+	}
+
+	// average milliseconds per call of function over iterations calls, after one untimed warm up call
+	template<typename Function>
+	double MeasureMilliseconds(const unsigned int& iterations, Function&& function)
+	{
+		function();
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (unsigned int i = 0; i < iterations; i++)
+		{
+			function();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+	}
+}
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static CPyburnRTXEngineTests::TestRegistrar name##Registrar(#name, &name, false); \
+	static void name()
+
+#define BENCHMARK_CASE(name) \
+	static void name(); \
+	static CPyburnRTXEngineTests::TestRegistrar name##Registrar(#name, &name, true); \
+	static void name()
+
+#define CHECK(expression) \
+	do { if (!(expression)) CPyburnRTXEngineTests::ReportFailure(__FILE__, __LINE__, #expression); } while (false)
+
+#define CHECK_NEAR(a, b, tolerance) \
+	do { if (!(fabs(static_cast<double>(a) - static_cast<double>(b)) <= static_cast<double>(tolerance))) CPyburnRTXEngineTests::ReportFailure(__FILE__, __LINE__, #a " ~= " #b); } while (false)
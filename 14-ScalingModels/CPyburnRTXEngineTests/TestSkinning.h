@@ -0,0 +1,72 @@
+#pragma once
+
+#include <AssimpFactory.h>
+#include <Random.h>
+
+// a made up skeleton and mesh for the skinning tests, the skinning math doesn't care where the palette came from
+namespace CPyburnRTXEngineTests
+{
+	struct SyntheticMesh
+	{
+		std::vector<XMMATRIX> bones;
+		std::vector<CPyburnRTXEngine::AssimpFactory::VSVertices> vertices;
+		std::vector<CPyburnRTXEngine::AssimpFactory::VertexBoneData> boneData;
+	};
+
+	inline XMFLOAT3 RandomDirection(CPyburnRTXEngine::RandomNumberGenerator& random)
+	{
+		XMFLOAT3 direction;
+		XMStoreFloat3(&direction, XMVector3Normalize(XMVectorSet(random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f), 0.0f) + XMVectorSet(0.0f, 0.0f, 0.01f, 0.0f)));
+		return direction;
+	}
+
+	// scale only when asked, dual quaternions drop it
+	// rotations stay within 45 degrees of the bind pose so four blended normals never come close to cancelling out
+	inline XMMATRIX RandomBone(CPyburnRTXEngine::RandomNumberGenerator& random, const bool& scaled)
+	{
+		const float scale = scaled ? random.NextFloat(0.5f, 2.0f) : 1.0f;
+		const XMFLOAT3 axis = RandomDirection(random);
+		return XMMatrixScaling(scale, scale, scale) * XMMatrixRotationAxis(XMLoadFloat3(&axis), random.NextFloat(-XM_PIDIV4, XM_PIDIV4)) * XMMatrixTranslation(random.NextFloat(-5.0f, 5.0f), random.NextFloat(-5.0f, 5.0f), random.NextFloat(-5.0f, 5.0f));
+	}
+
+	// oneBonePerVertex puts all four influences of a vertex on the same bone, so every skinning has one rigid transform to apply and they have to agree
+	inline SyntheticMesh MakeMesh(const UINT& boneCount, const UINT& vertexCount, const UINT& seed, const bool& scaled, const bool& oneBonePerVertex = false)
+	{
+		CPyburnRTXEngine::RandomNumberGenerator random;
+		random.SetSeed(seed);
+
+		SyntheticMesh mesh;
+		for (UINT b = 0; b < boneCount; b++)
+		{
+			mesh.bones.push_back(RandomBone(random, scaled));
+		}
+
+		mesh.vertices.resize(vertexCount);
+		mesh.boneData.resize(vertexCount);
+		for (UINT v = 0; v < vertexCount; v++)
+		{
+			CPyburnRTXEngine::AssimpFactory::VSVertices& vertex = mesh.vertices[v];
+			vertex.position = XMFLOAT3(random.NextFloat(-1.0f, 1.0f), random.NextFloat(0.0f, 2.0f), random.NextFloat(-1.0f, 1.0f));
+			vertex.texture = XMFLOAT2(random.NextFloat(1.0f), random.NextFloat(1.0f));
+			vertex.normal = RandomDirection(random);
+			vertex.tangent = RandomDirection(random);
+
+			// four influences that add up to 1 the way the importer leaves them, sometimes only one is used
+			CPyburnRTXEngine::AssimpFactory::VertexBoneData& influences = mesh.boneData[v];
+			const UINT used = random.NextInt(1, 4);
+			const UINT sharedBone = oneBonePerVertex ? random.NextInt(boneCount - 1) : 0;
+			float total = 0.0f;
+			for (UINT i = 0; i < 4; i++)
+			{
+				influences.IDs[i] = oneBonePerVertex ? sharedBone : random.NextInt(boneCount - 1);
+				influences.Weights[i] = i < used ? random.NextFloat(0.05f, 1.0f) : 0.0f;
+				total += influences.Weights[i];
+			}
+			for (UINT i = 0; i < 4; i++)
+			{
+				influences.Weights[i] /= total;
+			}
+		}
+		return mesh;
+	}
+}
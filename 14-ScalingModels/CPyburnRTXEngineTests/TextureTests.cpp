@@ -0,0 +1,147 @@
+#include "pch.h"
+
+#include <JobSystem.h>
+#include <Texture.h>
+
+#include "TestAssets.h"
+
+using namespace CPyburnRTXEngine;
+
+namespace CPyburnRTXEngine
+{
+	// what LoadTextureHeap does before it records anything, reached without a command list or the descriptor heap
+	class TextureTestAccess
+	{
+	public:
+		static bool ResolveTextureFile(const std::string& path, std::wstring& wFileName, std::wstring& szFile, std::wstring& extension)
+		{
+			return Texture::ResolveTextureFile(path, wFileName, szFile, extension);
+		}
+
+		// the default resource's description, false when nothing was decoded or a resource is missing
+		static bool Decode(const std::wstring& szFile, const std::wstring& extension, D3D12_RESOURCE_DESC& desc)
+		{
+			return Describe(Texture::DecodeTexture(szFile, extension), desc);
+		}
+
+		// takes what PrefetchTexture left for szFile, the same way LoadCustomFileTexture does
+		static bool TakePrefetched(const std::wstring& szFile, D3D12_RESOURCE_DESC& desc)
+		{
+			Texture::DecodedTexture decoded;
+			return Texture::TakeDecodedTexture(szFile, decoded) && Describe(decoded, desc);
+		}
+
+	private:
+		static bool Describe(const Texture::DecodedTexture& decoded, D3D12_RESOURCE_DESC& desc)
+		{
+			if (!decoded.texture || !decoded.upload || decoded.subresources.empty())
+			{
+				return false;
+			}
+			desc = decoded.texture->GetDesc();
+			return true;
+		}
+	};
+}
+
+namespace
+{
+	// the elf's textures, relative to the project directory the tests run from
+	const std::string c_elfTextures[] =
+	{
+		"..\\..\\Assets\\Models\\Elf\\elf_ranger_t01.jpg",
+		"..\\..\\Assets\\Models\\Elf\\elf_ranger_t02.jpg",
+		"..\\..\\Assets\\Models\\Elf\\elf_ranger_t03.jpg",
+		"..\\..\\Assets\\Models\\Elf\\elf_ranger_t04.jpg",
+	};
+}
+
+TEST_CASE(TextureResolvesFilesAndFallsBack)
+{
+	std::wstring wFileName;
+	std::wstring szFile;
+	std::wstring extension;
+
+	CHECK(TextureTestAccess::ResolveTextureFile(c_elfTextures[0], wFileName, szFile, extension));
+	CHECK(wFileName == L"elf_ranger_t01.jpg");
+	CHECK(szFile == L"..\\..\\Assets\\Models\\Elf\\elf_ranger_t01.jpg");
+	CHECK(extension == L".jpg");
+
+	// the line ending of a path read from a windows file goes, the extension is lowered for picking the loader but the name keeps its case
+	CHECK(TextureTestAccess::ResolveTextureFile("..\\..\\Assets\\Models\\Elf\\elf_ranger_t01.JPG\r", wFileName, szFile, extension));
+	CHECK(wFileName == L"elf_ranger_t01.JPG");
+	CHECK(szFile == L"..\\..\\Assets\\Models\\Elf\\elf_ranger_t01.JPG");
+	CHECK(extension == L".jpg");
+
+	// white is made in memory, there is no file to find
+	CHECK(TextureTestAccess::ResolveTextureFile("white", wFileName, szFile, extension));
+	CHECK(wFileName == L"white");
+
+	// a missing file is swapped for the test image, every missing texture lands on the same one
+	CHECK(!TextureTestAccess::ResolveTextureFile("..\\..\\Assets\\Models\\Elf\\missing.png", wFileName, szFile, extension));
+	CHECK(wFileName == L"test.tga");
+	CHECK(szFile == L"Assets\\test.tga");
+	CHECK(extension == L".tga");
+
+	std::wstring otherFile;
+	CHECK(!TextureTestAccess::ResolveTextureFile("Models\\Nowhere\\also_missing.dds", wFileName, otherFile, extension));
+	CHECK(otherFile == szFile);
+}
+
+TEST_CASE(TexturePrefetchDecodesOnWorkers)
+{
+	Microsoft::WRL::ComPtr<ID3D12Device5> device = CPyburnRTXEngineTests::CreateWarpDevice();
+	Texture::CreateDeviceDependentResources(device.Get());
+
+	// every texture twice, the way two models sharing a texture both prefetch it during EntitiesManager's load
+	std::vector<std::string> paths;
+	for (const std::string& path : c_elfTextures)
+	{
+		paths.push_back(path);
+		paths.push_back(path);
+	}
+	paths.push_back("white");
+
+	JobSystem jobSystem(3);
+	jobSystem.ParallelFor(static_cast<UINT>(paths.size()), 1, [&paths](UINT begin, UINT end)
+		{
+			for (UINT i = begin; i < end; i++)
+			{
+				Texture::PrefetchTexture(paths[i]);
+			}
+		});
+
+	// decoded on the main thread for comparison, with com set up the way PrefetchTexture does it on a worker
+	HRESULT comResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+	for (const std::string& path : c_elfTextures)
+	{
+		std::wstring wFileName;
+		std::wstring szFile;
+		std::wstring extension;
+		TextureTestAccess::ResolveTextureFile(path, wFileName, szFile, extension);
+
+		D3D12_RESOURCE_DESC prefetched = {};
+		CHECK(TextureTestAccess::TakePrefetched(szFile, prefetched));
+		CHECK(prefetched.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D);
+		CHECK(prefetched.Width > 0 && prefetched.Height > 0);
+
+		// one decode per file however many asked, the second take finds nothing
+		D3D12_RESOURCE_DESC again = {};
+		CHECK(!TextureTestAccess::TakePrefetched(szFile, again));
+
+		D3D12_RESOURCE_DESC decoded = {};
+		CHECK(TextureTestAccess::Decode(szFile, extension, decoded));
+		CHECK(decoded.Width == prefetched.Width && decoded.Height == prefetched.Height && decoded.Format == prefetched.Format && decoded.MipLevels == prefetched.MipLevels);
+	}
+	if (SUCCEEDED(comResult))
+	{
+		CoUninitialize();
+	}
+
+	// white never went through a decode
+	D3D12_RESOURCE_DESC white = {};
+	CHECK(!TextureTestAccess::TakePrefetched(L"white", white));
+
+	Texture::Release();
+	Texture::CreateDeviceDependentResources(nullptr);
+}
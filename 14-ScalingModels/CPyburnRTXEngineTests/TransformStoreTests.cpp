@@ -0,0 +1,180 @@
+#include "pch.h"
+
+#include <TransformStore.h>
+#include <JobSystem.h>
+#include <Random.h>
+
+using namespace CPyburnRTXEngine;
+
+namespace
+{
+	bool IsPending(const TransformStore& transforms, const UINT& slot)
+	{
+		const std::vector<UINT>& pending = transforms.GetPendingSlots();
+		return std::find(pending.begin(), pending.end(), slot) != pending.end();
+	}
+
+	void ClearAllFrames(TransformStore& transforms)
+	{
+		for (UINT frameIndex = 0; frameIndex < DX::DeviceResources::c_backBufferCount; frameIndex++)
+		{
+			transforms.ClearFrameDirty(frameIndex);
+		}
+	}
+
+	bool IsWorldNear(const XMMATRIX& a, const XMMATRIX& b, const float& tolerance)
+	{
+		for (UINT row = 0; row < 4; row++)
+		{
+			if (!XMVector4NearEqual(a.r[row], b.r[row], XMVectorReplicate(tolerance)))
+				return false;
+		}
+		return true;
+	}
+}
+
+TEST_CASE(TransformStoreRemoveMovesLastSlot)
+{
+	TransformStore transforms;
+	transforms.Add(10, XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(), XMFLOAT3(1.0f, 1.0f, 1.0f));
+	transforms.Add(20, XMFLOAT3(2.0f, 0.0f, 0.0f), XMFLOAT3(), XMFLOAT3(1.0f, 1.0f, 1.0f));
+	transforms.Add(30, XMFLOAT3(3.0f, 0.0f, 0.0f), XMFLOAT3(), XMFLOAT3(1.0f, 1.0f, 1.0f));
+	ClearAllFrames(transforms);
+
+	const UINT movedSlot = transforms.Remove(10);
+
+	CHECK(movedSlot == 0);
+	CHECK(transforms.GetCount() == 2);
+	CHECK(!transforms.Contains(10));
+	CHECK(transforms.GetSlot(30) == 0);
+	CHECK(transforms.GetIdBySlot(0) == 30);
+	CHECK(transforms.GetSlot(20) == 1);
+	CHECK(transforms.GetPosition(30).x == 3.0f);
+	CHECK(XMVectorGetX(transforms.GetWorldBySlot(0).r[3]) == 3.0f);
+
+	// the moved entity has a new instance index, every back buffer has to write it again
+	CHECK(IsPending(transforms, 0));
+	for (UINT frameIndex = 0; frameIndex < DX::DeviceResources::c_backBufferCount; frameIndex++)
+	{
+		CHECK(transforms.IsFrameDirty(0, frameIndex));
+	}
+	CHECK(!IsPending(transforms, 1));
+}
+
+TEST_CASE(TransformStoreRemoveLastMovesNothing)
+{
+	TransformStore transforms;
+	transforms.Add(1, XMFLOAT3(), XMFLOAT3(), XMFLOAT3(1.0f, 1.0f, 1.0f));
+	transforms.Add(2, XMFLOAT3(), XMFLOAT3(), XMFLOAT3(1.0f, 1.0f, 1.0f));
+
+	CHECK(transforms.Remove(2) == MAXUINT);
+	CHECK(transforms.GetCount() == 1);
+	CHECK(transforms.Remove(2) == MAXUINT); // not in the store anymore
+	CHECK(transforms.GetSlot(1) == 0);
+
+	// the removed slot is dropped from the pending list, the other one is still waiting
+	CHECK(transforms.GetPendingSlots().size() == 1);
+	CHECK(IsPending(transforms, 0));
+	CHECK(transforms.Remove(1) == MAXUINT);
+	CHECK(transforms.GetPendingSlots().empty());
+}
+
+TEST_CASE(TransformStoreDirtyTracking)
+{
+	TransformStore transforms;
+	transforms.Add(0, XMFLOAT3(), XMFLOAT3(), XMFLOAT3(1.0f, 1.0f, 1.0f));
+	transforms.Add(1, XMFLOAT3(), XMFLOAT3(), XMFLOAT3(1.0f, 1.0f, 1.0f));
+	CHECK(IsPending(transforms, 0) && IsPending(transforms, 1));
+
+	ClearAllFrames(transforms);
+	CHECK(transforms.GetPendingSlots().empty());
+
+	transforms.SetPosition(1, XMFLOAT3(5.0f, 6.0f, 7.0f));
+	transforms.SetPosition(1, XMFLOAT3(5.0f, 6.0f, 8.0f)); // a second setter doesn't queue the slot twice
+	CHECK(transforms.GetPendingSlots().size() == 1);
+
+	transforms.ComposeDirtyWorldMatrices();
+	CHECK(XMVectorGetZ(transforms.GetWorld(1).r[3]) == 8.0f);
+
+	// each back buffer clears its own bit, the slot leaves the list with the last one
+	transforms.ClearFrameDirty(0);
+	CHECK(!transforms.IsFrameDirty(1, 0));
+	ClearAllFrames(transforms);
+	CHECK(transforms.GetPendingSlots().empty());
+}
+
+TEST_CASE(TransformStoreFourWideMatchesScalar)
+{
+	RandomNumberGenerator random;
+	random.SetSeed(7);
+	TransformStore transforms;
+	const UINT count = 10; // two full vectors and a left over pair
+	for (UINT id = 0; id < count; id++)
+	{
+		XMFLOAT3 position(random.NextFloat(-50.0f, 50.0f), random.NextFloat(-50.0f, 50.0f), random.NextFloat(-50.0f, 50.0f));
+		XMFLOAT3 rotation(random.NextFloat(-XM_PI, XM_PI), random.NextFloat(-XM_PI, XM_PI), random.NextFloat(-XM_PI, XM_PI));
+		XMFLOAT3 scale(random.NextFloat(0.5f, 2.0f), random.NextFloat(0.5f, 2.0f), random.NextFloat(0.5f, 2.0f));
+		transforms.Add(id, position, rotation, scale);
+	}
+
+	transforms.ComposeWorldMatrices();
+
+	for (UINT id = 0; id < count; id++)
+	{
+		XMFLOAT3 position = transforms.GetPosition(id);
+		XMFLOAT3 rotation = transforms.GetRotation(id);
+		XMFLOAT3 scale = transforms.GetScale(id);
+		XMMATRIX expected = XMMatrixScaling(scale.x, scale.y, scale.z) * XMMatrixRotationRollPitchYaw(rotation.x, rotation.y, rotation.z) * XMMatrixTranslation(position.x, position.y, position.z);
+		CHECK(IsWorldNear(transforms.GetWorld(id), expected, 1e-4f));
+	}
+}
+
+// one simulated frame: some entities move, the dirty ones are recomposed and this frame's instances are cleared
+BENCHMARK_CASE(TransformStoreUpdateBenchmark)
+{
+	const UINT count = 8192;
+	const float movingFractions[] = { 0.01f, 0.1f, 1.0f };
+
+	JobSystem jobSystem;
+	printf("    %u entities, %u job threads\n", count, jobSystem.GetThreadCount());
+
+	for (const float& movingFraction : movingFractions)
+	{
+		TransformStore transforms;
+		transforms.Reserve(count);
+		for (UINT id = 0; id < count; id++)
+		{
+			transforms.Add(id, XMFLOAT3(static_cast<float>(id), 0.0f, 0.0f), XMFLOAT3(), XMFLOAT3(1.0f, 1.0f, 1.0f));
+		}
+		ClearAllFrames(transforms);
+
+		const UINT moving = std::max(1u, static_cast<UINT>(count * movingFraction));
+		const UINT stride = count / moving;
+		UINT frame = 0;
+		float offset = 0.0f;
+
+		auto update = [&](bool parallel)
+			{
+				offset += 0.01f;
+				for (UINT i = 0; i < moving; i++)
+				{
+					transforms.SetPosition(i * stride, XMFLOAT3(static_cast<float>(i * stride), offset, 0.0f));
+				}
+
+				if (parallel)
+				{
+					transforms.ComposeDirtyWorldMatrices(jobSystem);
+				}
+				else
+				{
+					transforms.ComposeDirtyWorldMatrices();
+				}
+
+				transforms.ClearFrameDirty(frame++ % DX::DeviceResources::c_backBufferCount);
+			};
+
+		const double serial = CPyburnRTXEngineTests::MeasureMilliseconds(200, [&]() { update(false); });
+		const double parallel = CPyburnRTXEngineTests::MeasureMilliseconds(200, [&]() { update(true); });
+		printf("    %5.1f%% moving: serial %.4f ms, job system %.4f ms\n", movingFraction * 100.0f, serial, parallel);
+	}
+}
@@ -0,0 +1,108 @@
+#include "pch.h"
+
+#include <UploadRing.h>
+#include <thread>
+
+using namespace CPyburnRTXEngine;
+
+TEST_CASE(UploadRingAlignsInsideThePartition)
+{
+	UploadRing ring;
+	ring.Reset(1024, 3);
+	CHECK(ring.BeginFrame(1, 0, 1));
+
+	UploadRing::Allocation a = ring.Allocate(10);
+	UploadRing::Allocation b = ring.Allocate(100, UploadRing::c_constantBufferAlignment);
+	UploadRing::Allocation c = ring.Allocate(64, 64);
+	CHECK(a.offset == 1024); // offsets are from the start of the whole ring, partition 1 starts at 1024
+	CHECK(b.offset == 1024 + 256);
+	CHECK(c.offset == 1024 + 384);
+	CHECK(!a.cpu); // headless
+	CHECK(ring.GetUsedBytes() == 384 + 64);
+	CHECK(ring.GetSize() == 3072);
+}
+
+TEST_CASE(UploadRingFullPartition)
+{
+	UploadRing ring;
+	ring.Reset(256, 2);
+	CHECK(ring.BeginFrame(0, 0, 1));
+	CHECK(ring.Allocate(200).IsValid());
+	CHECK(!ring.Allocate(64).IsValid());
+	CHECK(ring.Allocate(48).IsValid()); // what still fits is handed out after a failure
+	CHECK(!ring.Allocate(1).IsValid());
+	CHECK(ring.GetFailedCount() == 2);
+
+	// the next frame starts empty and forgets the failures
+	CHECK(ring.BeginFrame(1, 0, 2));
+	CHECK(ring.GetFailedCount() == 0);
+	CHECK(ring.GetUsedBytes() == 0);
+	CHECK(ring.GetHighWater() == 256);
+}
+
+TEST_CASE(UploadRingWaitsForFence)
+{
+	UploadRing ring;
+	ring.Reset(512, 2);
+	CHECK(ring.BeginFrame(0, 0, 1));
+	CHECK(ring.Allocate(16).IsValid());
+	CHECK(ring.BeginFrame(1, 0, 2));
+	const UINT64 frameCount = ring.GetFrameCount();
+
+	// partition 0 is read by the frame that signals 1, nothing completed yet
+	CHECK(!ring.BeginFrame(0, 0, 3));
+	CHECK(ring.GetFrameCount() == frameCount + 1); // what was handed out last frame is stale either way
+	CHECK(!ring.Allocate(16).IsValid()); // not even from partition 1, which the last frame is still using
+	CHECK(ring.GetFailedCount() == 0); // a refused frame is not a full one
+
+	CHECK(ring.BeginFrame(0, 1, 3));
+	CHECK(ring.Allocate(16).offset == 0);
+	CHECK(!ring.BeginFrame(1, 1, 4));
+	CHECK(ring.BeginFrame(1, 2, 4));
+	CHECK(ring.Allocate(16).offset == 512);
+
+	CHECK(!ring.BeginFrame(2, 10, 5)); // there is no partition 2
+}
+
+TEST_CASE(UploadRingConcurrentAllocate)
+{
+	// AnimationCompute::BeginPose runs on every job system worker at once
+	static constexpr UINT threadCount = 8;
+	static constexpr UINT perThread = 1000;
+	UploadRing ring;
+	ring.Reset(threadCount * perThread * 64, 3);
+	CHECK(ring.BeginFrame(0, 0, 1));
+
+	std::vector<UINT64> offsets[threadCount];
+	std::vector<std::thread> threads;
+	for (UINT t = 0; t < threadCount; t++)
+	{
+		threads.emplace_back([&ring, &offsets, t]()
+			{
+				for (UINT i = 0; i < perThread; i++)
+				{
+					offsets[t].push_back(ring.Allocate(48 + (i % 3) * 8, 64).offset);
+				}
+			});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	// every allocation got its own 64 byte block, so the sorted offsets are all different and aligned
+	std::vector<UINT64> all;
+	for (const std::vector<UINT64>& threadOffsets : offsets)
+	{
+		all.insert(all.end(), threadOffsets.begin(), threadOffsets.end());
+	}
+	std::sort(all.begin(), all.end());
+	bool distinct = true;
+	for (size_t i = 0; i < all.size(); i++)
+	{
+		distinct = distinct && all[i] % 64 == 0 && (i == 0 || all[i] != all[i - 1]);
+	}
+	CHECK(distinct);
+	CHECK(ring.GetFailedCount() == 0);
+	CHECK(!ring.Allocate(64, 64).IsValid()); // sized so every block is used
+}
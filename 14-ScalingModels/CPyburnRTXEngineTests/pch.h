@@ -0,0 +1,10 @@
+//
+// pch.h
+// Header for standard system include files.
+//
+
+#pragma once
+
+#include <pchlib.h>
+
+#include "TestFramework.h"
@@ -4,6 +4,7 @@
 
 #include "pch.h"
 #include "Game.h"
+#include <ModelCache.h>
 
 using namespace DirectX;
 
@@ -37,11 +38,24 @@ void ExitGame() noexcept;
 int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPWSTR lpCmdLine, _In_ int nCmdShow)
 {
     UNREFERENCED_PARAMETER(hPrevInstance);
-    UNREFERENCED_PARAMETER(lpCmdLine);
 
     if (!XMVerifyCPUSupport())
         return 1;
 
+    // TestGame.exe -bakemodels rebuilds every model cache and exits without creating a window
+    if (lpCmdLine && wcsstr(lpCmdLine, L"-bakemodels"))
+    {
+        // a windows subsystem exe starts without stdout, borrow the console it was run from so the timings show up there
+        if (AttachConsole(ATTACH_PARENT_PROCESS) || AllocConsole())
+        {
+            FILE* console = nullptr;
+            freopen_s(&console, "CONOUT$", "w", stdout);
+        }
+
+        CPyburnRTXEngine::ModelCache::BakeAll();
+        return 0;
+    }
+
 #ifdef __MINGW32__
     if (FAILED(CoInitializeEx(nullptr, COINITBASE_MULTITHREADED)))
         return 1;